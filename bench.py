@@ -0,0 +1,375 @@
+#!/usr/bin/env python3
+"""
+End-to-end throughput benchmark for Vidicant.
+
+This script generates a deterministic synthetic corpus of images and
+videos, runs vidicant_cli and the Python API over it at several worker
+counts, and records throughput, per-file latency percentiles and peak
+RSS as JSON. A stored baseline can be compared against, failing when a
+metric regresses by more than a threshold.
+
+Usage:
+    python3 bench.py                              # generate, run, report
+    python3 bench.py --save-baseline base.json    # record a baseline
+    python3 bench.py --baseline base.json         # compare against it
+"""
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import time
+
+CORPUS_VERSION = 1
+
+# Image formats, resolutions and (name, fourcc, extension) video codecs.
+IMAGE_FORMATS = ["jpg", "png", "bmp", "tiff", "webp"]
+IMAGE_SIZES = {
+    "small": [(320, 240), (1920, 1080)],
+    "full": [(320, 240), (1920, 1080), (4000, 3000)],
+}
+VIDEO_CODECS = [("mp4v", "mp4v", "mp4"), ("mjpg", "MJPG", "avi"),
+                ("xvid", "XVID", "avi")]
+
+# Video lengths chosen around the analysis frame caps: motion reads 50
+# frames, brightness 101 and scene detection 1000.
+VIDEO_SHAPES = {
+    "small": [((320, 240), 30), ((320, 240), 150), ((640, 360), 1100)],
+    "full": [((320, 240), 30), ((1280, 720), 150), ((640, 360), 1100),
+             ((1920, 1080), 300)],
+}
+VIDEO_FPS = 25.0
+SCENE_LENGTH = 90  # Frames between synthetic hard cuts
+
+
+def synthetic_frame(np, rng_seed, width, height, t=0):
+    """Render a deterministic frame: gradients, blocks, a moving disc, noise."""
+    rng = np.random.default_rng(rng_seed)
+    y, x = np.mgrid[0:height, 0:width].astype(np.float32)
+    base = rng.uniform(0, 255, size=3).astype(np.float32)
+    frame = np.empty((height, width, 3), dtype=np.float32)
+    frame[..., 0] = base[0] * x / max(width - 1, 1)
+    frame[..., 1] = base[1] * y / max(height - 1, 1)
+    frame[..., 2] = base[2]
+    for _ in range(6):
+        x0, y0 = rng.integers(0, width), rng.integers(0, height)
+        w, h = rng.integers(width // 10 + 1, width // 3 + 2), rng.integers(
+            height // 10 + 1, height // 3 + 2)
+        frame[y0:y0 + h, x0:x0 + w] = rng.uniform(0, 255, size=3)
+    cx = (t * 7) % width
+    cy = height // 2 + int((height // 4) * np.sin(t / 10.0))
+    radius = max(4, min(width, height) // 8)
+    frame[(x - cx) ** 2 + (y - cy) ** 2 < radius ** 2] = (255, 255, 255)
+    frame += rng.normal(0, 6, size=frame.shape).astype(np.float32)
+    return np.clip(frame, 0, 255).astype(np.uint8)
+
+
+def load_corpus(root, scale):
+    """Return the corpus manifest, or None if it is missing or stale."""
+    manifest_path = os.path.join(root, "manifest.json")
+    if not os.path.exists(manifest_path):
+        return None
+    with open(manifest_path) as f:
+        manifest = json.load(f)
+    if (manifest.get("version") != CORPUS_VERSION
+            or manifest.get("scale") != scale):
+        return None
+    manifest["root"] = os.path.abspath(root)
+    return manifest
+
+
+def generate_corpus(root, scale):
+    """Write the corpus under root unless a matching manifest is present."""
+    manifest = load_corpus(root, scale)
+    if manifest is not None:
+        return manifest
+    import cv2
+    import numpy as np
+
+    if os.path.exists(root):
+        shutil.rmtree(root)
+    os.makedirs(root, exist_ok=True)
+    manifest_path = os.path.join(root, "manifest.json")
+
+    files = []
+    seed = 0
+    for width, height in IMAGE_SIZES[scale]:
+        for fmt in IMAGE_FORMATS:
+            seed += 1
+            name = f"image_{width}x{height}.{fmt}"
+            path = os.path.join(root, name)
+            image = synthetic_frame(np, seed, width, height)
+            if not cv2.imwrite(path, image):
+                print(f"Skipping unsupported image format: {fmt}")
+                continue
+            files.append({"name": name, "kind": "image", "frames": 1,
+                          "width": width, "height": height})
+
+    for name, fourcc, ext in VIDEO_CODECS:
+        for (width, height), frames in VIDEO_SHAPES[scale]:
+            seed += 1
+            filename = f"video_{name}_{width}x{height}_{frames}f.{ext}"
+            path = os.path.join(root, filename)
+            writer = cv2.VideoWriter(path, cv2.VideoWriter_fourcc(*fourcc),
+                                     VIDEO_FPS, (width, height))
+            if not writer.isOpened():
+                print(f"Skipping unsupported codec: {name}")
+                break
+            for t in range(frames):
+                # A new scene every SCENE_LENGTH frames gives hard cuts
+                scene = seed * 1000 + t // SCENE_LENGTH
+                writer.write(synthetic_frame(np, scene, width, height, t))
+            writer.release()
+            files.append({"name": filename, "kind": "video",
+                          "frames": frames,
+                          "width": width, "height": height})
+
+    manifest = {"version": CORPUS_VERSION, "scale": scale, "files": files}
+    with open(manifest_path, "w") as f:
+        json.dump(manifest, f, indent=2)
+    manifest["root"] = os.path.abspath(root)
+    return manifest
+
+
+def percentiles(values):
+    """Return p50/p90/p99 of a list of latencies in milliseconds."""
+    if not values:
+        return None
+    ordered = sorted(values)
+
+    def pick(q):
+        index = min(len(ordered) - 1, int(round(q * (len(ordered) - 1))))
+        return round(ordered[index], 3)
+
+    return {"p50": pick(0.50), "p90": pick(0.90), "p99": pick(0.99)}
+
+
+def corpus_paths(manifest):
+    """Return the absolute path of every corpus file."""
+    return [os.path.join(manifest["root"], entry["name"])
+            for entry in manifest["files"]]
+
+
+def run_measured(command, cwd):
+    """Run a command, returning (wall seconds, peak RSS MiB, stdout)."""
+    start = time.perf_counter()
+    process = subprocess.Popen(command, stdout=subprocess.PIPE,
+                               stderr=subprocess.DEVNULL, cwd=cwd)
+    stdout = process.stdout.read()
+    _, status, usage = os.wait4(process.pid, 0)
+    process.returncode = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -1
+    wall = time.perf_counter() - start
+    if process.returncode != 0:
+        raise RuntimeError(f"{command[0]} exited with {process.returncode}")
+    # ru_maxrss is in KiB on Linux and bytes on macOS
+    divisor = 1024 * 1024 if sys.platform == "darwin" else 1024
+    return wall, usage.ru_maxrss / divisor, stdout
+
+
+def summarize(tool, workers, manifest, wall, rss, latencies):
+    """Build the result record of one run."""
+    files = manifest["files"]
+    frames = sum(f["frames"] for f in files if f["kind"] == "video")
+    return {
+        "tool": tool,
+        "workers": workers,
+        "files": len(files),
+        "wall_seconds": round(wall, 3),
+        "files_per_sec": round(len(files) / wall, 3),
+        "frames_per_sec": round(frames / wall, 3),
+        "latency_ms": percentiles(latencies),
+        "peak_rss_mib": round(rss, 1),
+    }
+
+
+def bench_cli(cli, manifest, workers, scratch):
+    """Analyze the corpus with one vidicant_cli run using `workers` jobs."""
+    # Run inside scratch: video analysis saves first frames to the cwd
+    list_path = os.path.join(scratch, "inputs.txt")
+    with open(list_path, "w") as f:
+        f.writelines(path + "\n" for path in corpus_paths(manifest))
+    # The trace's per-file spans time each file inside the run, as the
+    # Python child times each call
+    trace_path = os.path.join(scratch, f"cli_{workers}.trace.json")
+    command = [os.path.abspath(cli), "--input-list", list_path, "--output",
+               f"cli_{workers}.json", "--jobs", str(workers),
+               "--trace", os.path.abspath(trace_path)]
+    wall, rss, _ = run_measured(command, scratch)
+    with open(trace_path) as f:
+        events = json.load(f)["traceEvents"]
+    latencies = [event["dur"] / 1000.0 for event in events
+                 if event.get("name") == "file" and event.get("ph") == "X"]
+    return summarize("cli", workers, manifest, wall, rss, latencies)
+
+
+def bench_python(manifest_path, manifest, workers, scratch):
+    """Analyze the corpus from Python in a child process, so RSS is its own."""
+    command = [sys.executable, os.path.abspath(__file__), "--python-child",
+               "--manifest", os.path.abspath(manifest_path),
+               "--workers", str(workers)]
+    _, rss, stdout = run_measured(command, scratch)
+    # Time the analysis itself, not interpreter startup and imports
+    child = json.loads(stdout.decode().strip().splitlines()[-1])
+    return summarize("python", workers, manifest, child["wall"], rss,
+                     child["latencies"])
+
+
+def python_child(manifest_path, workers):
+    """Child mode: analyze every file and print per-file latencies as JSON."""
+    from concurrent.futures import ThreadPoolExecutor
+
+    import vidicant
+
+    with open(manifest_path) as f:
+        manifest = json.load(f)
+    manifest["root"] = os.path.dirname(manifest_path)
+    vidicant.set_parallelism("hybrid", jobs=workers)
+
+    def analyze(job):
+        path, entry = job
+        start = time.perf_counter()
+        if entry["kind"] == "image":
+            vidicant.process_image(path)
+        else:
+            vidicant.process_video(path)
+        return (time.perf_counter() - start) * 1000.0
+
+    jobs = zip(corpus_paths(manifest), manifest["files"])
+    start = time.perf_counter()
+    with ThreadPoolExecutor(max_workers=workers) as pool:
+        latencies = list(pool.map(analyze, jobs))
+    wall = time.perf_counter() - start
+    print(json.dumps({"wall": wall, "latencies": latencies}))
+    return 0
+
+
+def compare(results, baseline, threshold):
+    """Return regression messages for runs that also appear in baseline."""
+    previous = {(r["tool"], r["workers"]): r for r in baseline["runs"]}
+    regressions = []
+    for run in results["runs"]:
+        old = previous.get((run["tool"], run["workers"]))
+        if old is None:
+            continue
+        label = f"{run['tool']} x{run['workers']}"
+        if run["files_per_sec"] < old["files_per_sec"] * (1 - threshold):
+            regressions.append(
+                f"{label}: files/sec {old['files_per_sec']} -> "
+                f"{run['files_per_sec']}")
+        if run["peak_rss_mib"] > old["peak_rss_mib"] * (1 + threshold):
+            regressions.append(
+                f"{label}: peak RSS {old['peak_rss_mib']} MiB -> "
+                f"{run['peak_rss_mib']} MiB")
+        if run["latency_ms"] and old.get("latency_ms"):
+            before, after = old["latency_ms"]["p90"], run["latency_ms"]["p90"]
+            if after > before * (1 + threshold):
+                regressions.append(
+                    f"{label}: p90 latency {before} ms -> {after} ms")
+    return regressions
+
+
+def find_cli():
+    """Locate vidicant_cli in the usual build directories or on PATH."""
+    for candidate in ["build/vidicant_cli", "_gate_build/vidicant_cli"]:
+        if os.access(candidate, os.X_OK):
+            return candidate
+    return shutil.which("vidicant_cli")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--corpus", default="bench_corpus",
+                        help="corpus directory (generated if missing)")
+    parser.add_argument("--scale", choices=sorted(IMAGE_SIZES),
+                        default="small", help="corpus size")
+    parser.add_argument("--workers", default="",
+                        help="comma-separated worker counts "
+                             "(default: 1, 2, 4, ... up to the CPU count)")
+    parser.add_argument("--cli", default=None,
+                        help="path to vidicant_cli (default: build/ or PATH)")
+    parser.add_argument("--skip-cli", action="store_true")
+    parser.add_argument("--skip-python", action="store_true")
+    parser.add_argument("--output", default="bench_results.json")
+    parser.add_argument("--baseline", help="baseline JSON to compare against")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="allowed relative regression (default: 0.10)")
+    parser.add_argument("--save-baseline",
+                        help="also write the results to this baseline file")
+    parser.add_argument("--generate-only", action="store_true",
+                        help="generate the corpus and exit")
+    parser.add_argument("--python-child", action="store_true",
+                        help=argparse.SUPPRESS)
+    parser.add_argument("--manifest", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.python_child:
+        return python_child(args.manifest, int(args.workers))
+
+    if args.workers:
+        worker_counts = [int(w) for w in args.workers.split(",")]
+    else:
+        worker_counts, count = [], 1
+        while count <= (os.cpu_count() or 1):
+            worker_counts.append(count)
+            count *= 2
+
+    if args.generate_only:
+        generate_corpus(args.corpus, args.scale)
+        return 0
+
+    # Generate in a child so this process never loads OpenCV and NumPy:
+    # children forked from it would otherwise report its RSS as their peak
+    manifest = load_corpus(args.corpus, args.scale)
+    if manifest is None:
+        print(f"Generating corpus in {args.corpus} ({args.scale})...")
+        subprocess.run([sys.executable, os.path.abspath(__file__),
+                        "--generate-only", "--corpus", args.corpus,
+                        "--scale", args.scale], check=True)
+        manifest = load_corpus(args.corpus, args.scale)
+    manifest_path = os.path.join(args.corpus, "manifest.json")
+    scratch = os.path.join(args.corpus, "_runs")
+    os.makedirs(scratch, exist_ok=True)
+
+    cli = args.cli or find_cli()
+    if not args.skip_cli and cli is None:
+        print("vidicant_cli not found; pass --cli or --skip-cli")
+        return 1
+
+    results = {
+        "corpus": {"scale": args.scale, "version": CORPUS_VERSION,
+                   "files": len(manifest["files"])},
+        "cpu_count": os.cpu_count(),
+        "runs": [],
+    }
+    for workers in worker_counts:
+        if not args.skip_cli:
+            results["runs"].append(bench_cli(cli, manifest, workers, scratch))
+            print(json.dumps(results["runs"][-1]))
+        if not args.skip_python:
+            results["runs"].append(
+                bench_python(manifest_path, manifest, workers, scratch))
+            print(json.dumps(results["runs"][-1]))
+
+    with open(args.output, "w") as f:
+        json.dump(results, f, indent=2)
+    print(f"Results written to: {args.output}")
+    if args.save_baseline:
+        shutil.copyfile(args.output, args.save_baseline)
+        print(f"Baseline written to: {args.save_baseline}")
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        regressions = compare(results, baseline, args.threshold)
+        for message in regressions:
+            print(f"✗ REGRESSION: {message}")
+        if regressions:
+            return 1
+        print(f"✓ No regressions beyond {args.threshold:.0%}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
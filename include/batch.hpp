@@ -0,0 +1,57 @@
+// batch.hpp
+// Header file for batch processing of media files.
+//
+// This file contains the declaration of the function that analyzes
+// a discovered list of media files on the file workers of the
+// process-wide parallelism policy.
+
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "controller.hpp"
+#include "crawler.hpp"
+#include "vidicant/prefetch.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// Struct to hold options for scheduling a batch
+struct BatchOptions {
+  std::uintmax_t memoryBudget = 0; // Decoded bytes in flight, 0 for no limit
+  PrefetchOptions prefetch;        // Read-ahead of the files next in line
+};
+
+// Function to analyze media files, skipping those the checkpoint (if any)
+// marks done and recording the rest in it; with several file workers the
+// files are probed and started longest-first while their estimated decoded
+// size fits the memory budget; with read-ahead, reader threads fetch the
+// files next in line while the current ones are analyzed, and images read
+// whole are decoded from memory; results are appended to the "images" and
+// "videos" arrays in input order
+void processBatch(const std::vector<MediaEntry> &entries,
+                  const ProcessOptions &options,
+                  const BatchOptions &batchOptions, Checkpoint *checkpoint,
+                  nlohmann::json &results);
+
+// Function to summarize the "memory" objects of a batch's results: the
+// peak RSS and Mat memory of the process, the file with the highest Mat
+// peak, and the allocations of each stage summed over the files
+nlohmann::json summarizeMemory(const nlohmann::json &results);
+
+// Function to parse a byte count with an optional K, M or G suffix
+bool parseByteSize(const std::string &text, std::uintmax_t &bytes);
+
+// Functions to parse a whole decimal integer of at least a minimum value;
+// signs, trailing text and values the type cannot hold are rejected, and
+// value is left unchanged on failure
+bool parseInteger(const std::string &text, int minimum, int &value);
+bool parseInteger(const std::string &text, std::size_t minimum,
+                  std::size_t &value);
+
+// Function to parse a whole finite decimal number of at least a minimum
+// value; value is left unchanged on failure
+bool parseNumber(const std::string &text, double minimum, double &value);
+
+#endif // BATCH_HPP
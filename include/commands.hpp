@@ -0,0 +1,21 @@
+// commands.hpp
+// Header file for the vidicant_cli subcommands.
+//
+// This file contains declarations for subcommands that work on
+// analysis results (indexes, queries) rather than analyzing media
+// files directly. Each takes the arguments following the program
+// name, so argv[0] is the subcommand itself.
+
+#ifndef COMMANDS_HPP
+#define COMMANDS_HPP
+
+// Function to build or query a near-duplicate perceptual hash index
+int runDedupCommand(int argc, char *argv[]);
+
+// Function to build or search a columnar index over scalar results
+int runQueryCommand(int argc, char *argv[]);
+
+// Function to merge the results of sharded runs into one result set
+int runMergeCommand(int argc, char *argv[]);
+
+#endif // COMMANDS_HPP
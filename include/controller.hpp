@@ -8,8 +8,35 @@
 #ifndef CONTROLLER_HPP
 #define CONTROLLER_HPP
 
+#include "vidicant/frame_series.hpp"
+#include <cstdint>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <vector>
+
+class ImageHandler;
+
+// Options controlling how media files are analyzed
+struct ProcessOptions {
+  bool tiled = false; // Analyze images strip by strip in bounded memory
+  int tileRows = 256; // Rows decoded per strip in tiled mode
+  bool perceptualHashes = false; // Add dHash/pHash fingerprints to results
+  std::vector<std::string> metrics; // Metrics to compute, empty for all
+  int histogramBins = 256; // Bins per channel of image histograms
+  std::string seriesFormat; // Per-frame side file: "csv", "binary" or none
+  int seriesWindow = 0;     // Frames per series summary, 0 for one second
+  std::vector<double> sceneThresholds; // Scene cut thresholds to evaluate
+  bool scenePalettes = false; // Add a dominant color palette per scene
+  bool cropBars = false; // Analyze only the picture inside black bars
+  bool qcEvents = false; // Report black, frozen and flash frame ranges
+  QcOptions qc;          // Thresholds of those detectors
+  double timeBudget = 0.0; // Seconds of analysis per file, 0 for no limit
+  bool jpegDct = false; // Estimate JPEG metrics from DCT coefficients
+  bool memoryStats = false; // Report Mat memory taken per file and stage
+  std::string proxyCache; // Directory of video proxies, empty for none
+  int proxyHeight = 144;  // Rows of proxy frames
+  std::uintmax_t proxyCacheLimit = 0; // Bytes of proxies kept, 0 for no limit
+};
 
 // Function to determine if a file is an image based on extension
 bool isImageFile(const std::string &filename);
@@ -17,10 +44,40 @@ bool isImageFile(const std::string &filename);
 // Function to determine if a file is a video based on extension
 bool isVideoFile(const std::string &filename);
 
+// Function to determine if an image source plays as a video: an animated
+// GIF or WebP file, or an image sequence pattern such as frame_%05d.png
+bool isMultiFrameImage(const std::string &filename);
+
+// Function to list the metric names accepted for images
+std::vector<std::string> getImageMetricNames();
+
+// Function to list the metric names accepted for videos
+std::vector<std::string> getVideoMetricNames();
+
+// Function to check the ranges of analysis options, shared by the CLI, the
+// daemon and the Python module; returns what is wrong, or an empty string
+std::string checkProcessOptions(const ProcessOptions &options);
+
 // Function to process an image file and return JSON result
-nlohmann::json processImage(const std::string &filename);
+nlohmann::json processImage(const std::string &filename,
+                            const ProcessOptions &options = {});
+
+// Function to process an image through a given handler, so callers can
+// supply their own loader (e.g. for in-memory bytes)
+nlohmann::json processImage(ImageHandler &handler, const std::string &filename,
+                            const ProcessOptions &options = {});
+
+// Function to process an image file strip by strip in bounded memory
+nlohmann::json processImageTiled(const std::string &filename,
+                                 const ProcessOptions &options = {});
 
 // Function to process a video file and return JSON result
-nlohmann::json processVideo(const std::string &filename);
+nlohmann::json processVideo(const std::string &filename,
+                            const ProcessOptions &options = {});
+
+// Function to analyze a per-frame series saved with --series binary, for
+// retuning scene and QC thresholds or windows without decoding the video
+nlohmann::json processSeries(const std::string &filename,
+                             const ProcessOptions &options = {});
 
 #endif // CONTROLLER_HPP
@@ -0,0 +1,81 @@
+// crawler.hpp
+// Header file for corpus discovery and checkpointing.
+//
+// This file contains declarations for functions that find media
+// files in directory trees and input lists, and for the checkpoint
+// manifest that lets an interrupted run resume where it stopped.
+
+#ifndef CRAWLER_HPP
+#define CRAWLER_HPP
+
+#include "vidicant/shard.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Kind of media a file was classified as
+enum class MediaKind { Unknown, Image, Video };
+
+// One media file discovered by the crawler
+struct MediaEntry {
+  std::string path;                   // Path as it will appear in results
+  MediaKind kind = MediaKind::Unknown; // Image or video
+  std::uintmax_t size = 0;            // File size in bytes
+};
+
+// Options controlling corpus discovery
+struct CrawlOptions {
+  bool sniff = false;      // Classify by magic bytes, not only extension
+  std::size_t threads = 0; // Directory walker threads, 0 for all cores
+};
+
+// Function to classify a file by its leading magic bytes
+MediaKind sniffMediaKind(const std::string &filename);
+
+// Function to classify a file by extension, optionally confirmed by sniffing
+MediaKind classifyMediaFile(const std::string &filename, bool sniff);
+
+// Function to walk a directory tree in parallel and collect media files,
+// sorted by path
+std::vector<MediaEntry> crawlDirectory(const std::string &root,
+                                       const CrawlOptions &options = {});
+
+// Function to read paths from an input list, one per line; blank lines
+// and lines starting with '#' are skipped
+std::vector<std::string> readInputList(std::istream &input);
+
+// Class to record finished files in an append-only NDJSON manifest;
+// record() and isDone() may be called from several workers
+class Checkpoint {
+public:
+  // Opens the manifest, loading finished entries first when resuming; a
+  // new manifest of a sharded run starts with a {"shard": {"index",
+  // "count"}} line, so merge can place it even if it records no files
+  bool open(const std::string &filename, bool resume,
+            const Shard *shard = nullptr);
+
+  // Returns true if the file was finished by an earlier run
+  bool isDone(const std::string &path) const;
+
+  // Appends one finished file and its result, flushed immediately
+  void record(const std::string &path, MediaKind kind,
+              const nlohmann::json &result);
+
+  // Returns the results loaded from the manifest, grouped like results.json
+  const nlohmann::json &getResumedResults() const;
+
+private:
+  mutable std::mutex mutex_;
+  std::ofstream output_;
+  std::unordered_set<std::string> done_;
+  nlohmann::json resumed_ = {{"images", nlohmann::json::array()},
+                             {"videos", nlohmann::json::array()}};
+};
+
+#endif // CRAWLER_HPP
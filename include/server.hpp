@@ -0,0 +1,32 @@
+// server.hpp
+// Header file for the vidicant_cli analysis daemon.
+//
+// This file contains declarations for a long-running server that
+// keeps OpenCV and its codecs loaded and answers analysis requests
+// over a Unix domain socket or a localhost TCP port. Requests and
+// responses are newline-delimited JSON, one object per line.
+
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "controller.hpp"
+#include <cstddef>
+#include <nlohmann/json.hpp>
+#include <string>
+
+// Options controlling the analysis daemon
+struct ServerOptions {
+  std::size_t workers = 0;        // Analysis threads, 0 for the policy's
+  std::size_t queueCapacity = 64; // Pending requests before reads block
+  ProcessOptions defaults;        // Options for fields a request omits
+};
+
+// Function to answer one request object with one response object
+nlohmann::json handleServerRequest(const nlohmann::json &request,
+                                   const ProcessOptions &defaults);
+
+// Function to serve requests on "unix:<path>", "<host>:<port>" or
+// "<port>" (bound to 127.0.0.1) until SIGINT or SIGTERM
+int runServer(const std::string &endpoint, const ServerOptions &options);
+
+#endif // SERVER_HPP
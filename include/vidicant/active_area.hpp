@@ -0,0 +1,82 @@
+// File: active_area.hpp
+// Header file for letterbox and pillarbox detection in the Vidicant library.
+//
+// This file defines helpers that find the active picture area of a frame:
+// the rectangle inside black bars added to fit a picture to a different
+// aspect ratio. Only the border rows and columns are read, a few hundred
+// samples per line, so detection costs far less than analyzing the frame.
+// Analyses can then run on the area alone, which saves the pixel work spent
+// on the bars and keeps the bars from biasing brightness and colors.
+//
+// A line is part of a bar if almost none of its samples is brighter than
+// the threshold in any channel. Bars are assumed to be symmetric, so the
+// narrower of the top and bottom bars (and of the left and right ones) is
+// taken for both sides; subtitles in one bar, or a dark scene lit from one
+// side, then reduce the crop rather than cutting into the picture.
+
+#ifndef VIDICANT_ACTIVE_AREA_HPP
+#define VIDICANT_ACTIVE_AREA_HPP
+
+#include <opencv2/core.hpp>
+
+// Struct: ActiveArea
+// The picture area of a frame and the size of the frame around it.
+struct ActiveArea {
+  cv::Rect rect;      // Picture area inside the bars.
+  cv::Size frameSize; // Size of the full frame.
+
+  // Checks whether bars were found.
+  // @return True if the area is smaller than the frame.
+  bool isCropped() const {
+    return rect.width < frameSize.width || rect.height < frameSize.height;
+  }
+};
+
+// Class: ActiveAreaDetector
+// Combines the picture areas of several frames of a video.
+//
+// The result is the union of the areas of every frame added, so content
+// that reaches into a bar in any sampled frame is kept. Frames that are
+// dark all over (fades, black frames) carry no information and are ignored.
+class ActiveAreaDetector {
+public:
+  // Brightest value, on the 0-255 scale, counted as part of a bar.
+  static constexpr double kDefaultThreshold = 24.0;
+
+  // Constructs a detector.
+  // @param threshold Brightest value counted as black.
+  explicit ActiveAreaDetector(double threshold = kDefaultThreshold);
+
+  // Finds the picture area of one frame and adds it to the union.
+  // @param frame A decoded frame with 8-bit, 16-bit or float samples.
+  void addFrame(const cv::Mat &frame);
+
+  // Gets the number of frames that contributed an area.
+  int getFrameCount() const;
+
+  // Gets the union of the areas found so far.
+  // @return The area; the full frame if no frame contributed.
+  ActiveArea getArea() const;
+
+private:
+  double threshold_;  // Brightest value counted as black.
+  cv::Rect area_;     // Union of the areas found.
+  cv::Size size_;     // Size of the last frame added.
+  int frames_ = 0;    // Frames that contributed an area.
+};
+
+// Namespace: vidicant
+// Namespace containing letterbox detection helpers.
+namespace vidicant {
+
+// Finds the picture area inside the black bars of one image.
+// @param image A decoded image with 8-bit, 16-bit or float samples.
+// @param threshold Brightest value, on the 0-255 scale, counted as black.
+// @return The area; the full image if it has no bars or is dark all over.
+ActiveArea detectActiveArea(
+    const cv::Mat &image,
+    double threshold = ActiveAreaDetector::kDefaultThreshold);
+
+} // namespace vidicant
+
+#endif // VIDICANT_ACTIVE_AREA_HPP
@@ -0,0 +1,102 @@
+// File: color_model.hpp
+// Header file for streaming color palettes in the Vidicant library.
+//
+// This file defines a fixed-size quantized color histogram that frames are
+// folded into one at a time, and the weighted clustering that turns it into
+// a palette. Memory stays constant however many frames are added, so a
+// palette can summarize a whole video (or each of its scenes) instead of its
+// opening frames. It also declares the k-means clustering of raw pixel
+// samples used for image palettes, which can be stopped at a deadline.
+
+#ifndef VIDICANT_COLOR_MODEL_HPP
+#define VIDICANT_COLOR_MODEL_HPP
+
+#include "vidicant/deadline.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace cv {
+class Mat;
+} // namespace cv
+
+// Struct: PaletteColor
+// One color of a palette and its share of the sampled pixels.
+struct PaletteColor {
+  std::array<double, 3> color{}; // Mean color, in the frames' channel order.
+  double weight = 0.0;           // Fraction of samples nearest to it (0-1).
+};
+
+// Class: ColorHistogramModel
+// Quantized color histogram that accumulates pixels incrementally.
+//
+// Each channel is quantized to kBitsPerChannel bits. Every bin keeps its
+// sample count and the exact sum of the colors that fell into it, so a
+// palette is clustered from bin means rather than bin corners and loses
+// little precision to the quantization.
+class ColorHistogramModel {
+public:
+  // Bits kept per channel; the model holds 2^(3 * bits) bins.
+  static constexpr int kBitsPerChannel = 5;
+
+  // Constructs an empty model.
+  ColorHistogramModel();
+
+  // Folds the pixels of an 8-bit frame into the model.
+  // @param frame A 1-, 3- or 4-channel CV_8U frame; gray pixels count as
+  // equal channels and a fourth channel is ignored.
+  // @param pixelStride Sample every pixelStride-th row and column.
+  void addFrame(const cv::Mat &frame, int pixelStride = 1);
+
+  // Folds one color into the model.
+  // @param color The color, in the frames' channel order.
+  // @param count How many samples of this color to add.
+  void addColor(const std::array<std::uint8_t, 3> &color,
+                std::uint64_t count = 1);
+
+  // Combines another model into this one.
+  // @param other A model built from other pixels.
+  void merge(const ColorHistogramModel &other);
+
+  // Removes every sample, keeping the allocation.
+  void clear();
+
+  // Gets the number of samples folded so far.
+  // @return The sample count.
+  std::uint64_t getSampleCount() const;
+
+  // Clusters the histogram into a palette with weighted k-means.
+  // @param colors Number of palette colors wanted.
+  // @param deadline When to stop refining; the palette then comes from the
+  // iterations done so far.
+  // @return Up to `colors` entries, heaviest first; fewer if the model has
+  // fewer occupied bins, empty if it has no samples.
+  std::vector<PaletteColor> getPalette(int colors,
+                                       const Deadline &deadline = {}) const;
+
+private:
+  std::vector<std::uint64_t> counts_;       // Samples per bin.
+  std::vector<std::array<double, 3>> sums_; // Color sums per bin.
+  std::uint64_t samples_ = 0;               // Total samples.
+};
+
+// Namespace: vidicant
+// Namespace containing pixel clustering functions.
+namespace vidicant {
+
+// Clusters color samples with k-means: k-means++ seeding, three attempts
+// of at most 10 iterations each, keeping the most compact. With a deadline
+// set, iterations run one at a time and the clustering stops once it
+// passes, returning the best centers found so far; at least one iteration
+// always runs.
+// @param samples CV_32F samples, one row per pixel of 3 channels, or of 1
+// for a grayscale image, whose centers are returned as gray colors.
+// @param k Number of clusters.
+// @param deadline When to stop iterating.
+// @return k centers, or none if there are fewer than k samples.
+std::vector<std::array<double, 3>>
+clusterColors(const cv::Mat &samples, int k, const Deadline &deadline = {});
+
+} // namespace vidicant
+
+#endif // VIDICANT_COLOR_MODEL_HPP
@@ -0,0 +1,53 @@
+// File: deadline.hpp
+// Header file for per-file time budgets in the Vidicant library.
+//
+// This file defines the deadline that long-running analyses check between
+// frames and strips. OpenCV calls cannot be interrupted, so work stops at
+// the next check after the deadline passes: the result then covers the
+// frames or rows analyzed so far rather than the whole file.
+
+#ifndef VIDICANT_DEADLINE_HPP
+#define VIDICANT_DEADLINE_HPP
+
+#include <chrono>
+#include <string>
+
+// Class: Deadline
+// A point in time after which analysis of a file should stop.
+class Deadline {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Constructs a deadline that never passes.
+  Deadline();
+
+  // Constructs a deadline a time budget from now.
+  // @param seconds The budget; zero or less for no deadline.
+  explicit Deadline(double seconds);
+
+  // Checks whether a deadline was set.
+  // @return True unless the deadline never passes.
+  bool isSet() const;
+
+  // Checks whether the deadline has passed.
+  // @return True once the budget is spent.
+  bool expired() const;
+
+private:
+  bool set_ = false;      // Whether the deadline can pass.
+  Clock::time_point end_; // When the budget runs out.
+};
+
+// Namespace: vidicant
+// Namespace containing time budget helpers.
+namespace vidicant {
+
+// Parses a duration such as "2s", "500ms", "1.5m" or "3" (seconds).
+// @param text The duration.
+// @param seconds Receives the duration in seconds.
+// @return True if the text was a non-negative duration.
+bool parseDuration(const std::string &text, double &seconds);
+
+} // namespace vidicant
+
+#endif // VIDICANT_DEADLINE_HPP
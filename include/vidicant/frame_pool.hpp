@@ -0,0 +1,74 @@
+// File: frame_pool.hpp
+// Header file for reusable frame buffers in the Vidicant library.
+//
+// This file defines a per-analysis arena of named cv::Mat slots. Video
+// analysis loops decode into and compute on these slots, so once the first
+// frame has sized every buffer the per-frame loop reuses memory instead of
+// allocating it. The arena also counts the Mats allocated during each
+// frame so that the steady state can be checked to be allocation-free.
+
+#ifndef VIDICANT_FRAME_POOL_HPP
+#define VIDICANT_FRAME_POOL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <opencv2/core.hpp>
+
+// Enum: FrameSlot
+// Names of the buffers held by a FrameArena.
+enum class FrameSlot {
+  Frame,        // Decoded frame.
+  Gray,         // Grayscale version of the current frame.
+  PreviousGray, // Grayscale version of the previous frame.
+  Diff,         // Absolute difference between consecutive frames.
+  Hsv,          // HSV version of the current frame.
+  Scratch,      // Metric-specific temporary.
+  Count         // Number of slots; not a slot itself.
+};
+
+// Class: FrameArena
+// Pool of reusable buffers for one video analysis.
+//
+// Slots keep their allocation between frames and between passes. Call
+// beginPass() before a decode loop and endFrame() after each frame; the
+// arena then counts every Mat the calling thread allocated during the
+// frame, in its slots or not. Counting uses the allocator installed by
+// vidicant::enableMemoryTracking(), and sees no allocations without it;
+// a pass must run on one thread.
+class FrameArena {
+public:
+  // Frames per pass that may allocate while buffers are being sized.
+  static constexpr int kWarmupFrames = 1;
+
+  // Gets the buffer for a slot; the same slot always returns the same Mat.
+  // @param slot The slot to access.
+  // @return A reference valid for the lifetime of the arena.
+  cv::Mat &slot(FrameSlot slot);
+
+  // Starts a new decode pass, resetting the per-pass frame counter.
+  void beginPass();
+
+  // Marks the end of one frame and records the Mats allocated in it.
+  void endFrame();
+
+  // Gets the number of Mat allocations seen across all frames.
+  // @return The total allocation count.
+  std::size_t getAllocationCount() const;
+
+  // Gets the number of Mat allocations seen after the warm-up frames.
+  // @return The steady-state allocation count; zero when buffers are reused.
+  std::size_t getSteadyStateAllocationCount() const;
+
+private:
+  static constexpr std::size_t kSlotCount =
+      static_cast<std::size_t>(FrameSlot::Count);
+
+  std::array<cv::Mat, kSlotCount> slots_;  // Pooled buffers.
+  std::uint64_t mark_ = 0;                 // Thread allocations at last check.
+  int framesInPass_ = 0;                   // Frames since beginPass().
+  std::size_t allocations_ = 0;            // All allocations.
+  std::size_t steadyStateAllocations_ = 0; // Allocations after warm-up.
+};
+
+#endif // VIDICANT_FRAME_POOL_HPP
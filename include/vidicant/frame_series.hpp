@@ -0,0 +1,171 @@
+// File: frame_series.hpp
+// Header file for per-frame video time series in the Vidicant library.
+//
+// This file defines a compact record of a few measurements per decoded frame
+// and the analyses that can be derived from it without decoding the video
+// again: scene cuts for any number of thresholds, fixed-size window
+// summaries, black, frozen and flash frame events for quality control, the
+// brightness, motion and consistency scores of the opening frames, and CSV
+// or binary side files for charting and offline tuning.
+
+#ifndef VIDICANT_FRAME_SERIES_HPP
+#define VIDICANT_FRAME_SERIES_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Struct: FrameSample
+// Measurements taken from one decoded frame.
+//
+// The histogram distance is the total variation distance between the
+// normalized 32-bin gray histograms of this and the previous frame. Both
+// differences are 0 for the first frame.
+struct FrameSample {
+  int frame = 0;                  // Zero-based frame index.
+  float brightness = 0.0f;        // Mean of the channel means (0-255).
+  float meanDiff = 0.0f;          // Mean gray difference to the last frame.
+  float histogramDistance = 0.0f; // Gray histogram change (0-1).
+  float saturation = 0.0f;        // Mean HSV saturation (0-255).
+};
+
+// Struct: SeriesWindow
+// Summary of the samples in one window of consecutive frames.
+struct SeriesWindow {
+  int startFrame = 0;                // First frame in the window.
+  int endFrame = 0;                  // One past the last frame.
+  double brightness = 0.0;           // Mean brightness.
+  double meanDiff = 0.0;             // Mean frame difference.
+  double maxDiff = 0.0;              // Largest frame difference.
+  double histogramDistance = 0.0;    // Mean histogram distance.
+  double maxHistogramDistance = 0.0; // Largest histogram distance.
+  double saturation = 0.0;           // Mean saturation.
+};
+
+// Enum: QcEventType
+// Kinds of frame ranges reported for quality control.
+enum class QcEventType {
+  Black,  // Frames that are black all over.
+  Freeze, // Frames that repeat the one before them.
+  Flash   // A brief jump in brightness that falls back.
+};
+
+// Struct: QcOptions
+// Thresholds of the quality control detectors.
+//
+// Durations are in seconds and need the series' frame rate; a series
+// without one counts every frame as a second.
+struct QcOptions {
+  double blackBrightness = 10.0;  // Brightest mean counted as black.
+  double blackMinSeconds = 0.5;   // Shortest black range reported.
+  double freezeDiff = 0.5;        // Largest mean difference of a repeat.
+  double freezeMinSeconds = 2.0;  // Shortest frozen range reported.
+  double flashBrightness = 60.0;  // Brightness jump that starts a flash.
+  double flashMaxSeconds = 0.25;  // Longest range still counted as a flash.
+};
+
+// Struct: QcEvent
+// A range of frames found by a quality control detector.
+struct QcEvent {
+  QcEventType type = QcEventType::Black; // What was found.
+  int startFrame = 0;                    // First frame of the range.
+  int endFrame = 0;                      // One past the last frame.
+};
+
+// Class: FrameSeries
+// Per-frame measurements of one video, in frame order.
+//
+// A series is filled by a single decode pass (see
+// VideoHandler::getFrameSeries) and afterwards answers scene and window
+// queries from memory. The binary format is a "VFS1" magic, the frame rate
+// as a double and the sample count as a uint32, followed by one packed
+// int32 + 4 x float32 record per frame, all in little-endian order.
+class FrameSeries {
+public:
+  // Constructs an empty series.
+  // @param fps Frame rate of the video, used for timestamps; 0 if unknown.
+  explicit FrameSeries(double fps = 0.0);
+
+  // Appends the measurements of the next frame.
+  // @param sample The frame's measurements.
+  void add(const FrameSample &sample);
+
+  // Gets the samples in frame order.
+  // @return The samples.
+  const std::vector<FrameSample> &getSamples() const;
+
+  // Gets the number of samples.
+  // @return The sample count.
+  std::size_t size() const;
+
+  // Gets the frame rate the series was recorded with.
+  // @return The frame rate, or 0 if unknown.
+  double getFPS() const;
+
+  // Finds the frames whose mean difference exceeds a threshold, matching
+  // VideoHandler::detectSceneChanges.
+  // @param threshold Mean gray difference that marks a scene change.
+  // @param maxFrame Last frame index to consider; negative for all.
+  // @return The frame indices of the scene changes.
+  std::vector<int> detectSceneChanges(double threshold,
+                                      int maxFrame = -1) const;
+
+  // Finds scene changes for several thresholds in one scan of the series.
+  // @param thresholds Mean gray differences that mark a scene change.
+  // @param maxFrame Last frame index to consider; negative for all.
+  // @return One list of frame indices per threshold, in the given order.
+  std::vector<std::vector<int>>
+  detectSceneChanges(const std::vector<double> &thresholds,
+                     int maxFrame = -1) const;
+
+  // Gets the mean brightness of the opening frames, matching
+  // VideoHandler::getAverageBrightness.
+  // @param frames Frames at the start of the video to average.
+  // @return The mean brightness, or -1 if no sample lies in them.
+  double getAverageBrightness(int frames = 101) const;
+
+  // Gets the mean frame difference of the opening frames, matching
+  // VideoHandler::getMotionScore.
+  // @param frames Frames at the start of the video to consider; the first
+  // has no difference.
+  // @return The mean difference, or 0 if no difference lies in them.
+  double getMotionScore(int frames = 50) const;
+
+  // Gets the coefficient of variation of the brightness of the opening
+  // frames, matching VideoHandler::getColorConsistency.
+  // @param frames Frames at the start of the video to consider.
+  // @return The coefficient of variation, or -1 if no sample lies in them.
+  double getColorConsistency(int frames = 50) const;
+
+  // Finds black, frozen and flash frame ranges.
+  // @param options Detector thresholds.
+  // @return The events ordered by start frame, black before freeze before
+  // flash where they start together.
+  std::vector<QcEvent> detectQcEvents(const QcOptions &options = {}) const;
+
+  // Summarizes consecutive windows of frames.
+  // @param windowFrames Frames per window; the last window may be shorter.
+  // @return One summary per window, empty if windowFrames is not positive.
+  std::vector<SeriesWindow> summarize(int windowFrames) const;
+
+  // Writes the series as CSV with a header row.
+  // @param path The file to write.
+  // @return True if the file was written.
+  bool writeCsv(const std::string &path) const;
+
+  // Writes the series in the binary format.
+  // @param path The file to write.
+  // @return True if the file was written.
+  bool writeBinary(const std::string &path) const;
+
+  // Replaces this series with one read from a binary file.
+  // @param path The file to read.
+  // @return True if the file was a complete series.
+  bool readBinary(const std::string &path);
+
+private:
+  double fps_;                       // Frame rate, 0 if unknown.
+  std::vector<FrameSample> samples_; // Samples in frame order.
+};
+
+#endif // VIDICANT_FRAME_SERIES_HPP
@@ -0,0 +1,80 @@
+// File: hash_index.hpp
+// Header file for the near-duplicate index in the Vidicant library.
+//
+// This file defines an on-disk multi-index hash table over 64-bit perceptual
+// hashes. Each hash is split into four 16-bit chunks with one sorted table
+// per chunk; by the pigeonhole principle any hash within Hamming distance d
+// of a query matches it in at least one chunk within distance d / 4. Queries
+// probe only those chunk neighborhoods in the memory-mapped tables, so they
+// touch a few thousand entries even in a corpus of tens of millions.
+
+#ifndef VIDICANT_HASH_INDEX_HPP
+#define VIDICANT_HASH_INDEX_HPP
+
+#include "vidicant/mapped_file.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Struct: HashMatch
+// One neighbor returned by a HashIndex query.
+struct HashMatch {
+  std::string path;       // Path (and keyframe suffix) of the indexed item.
+  std::uint64_t hash = 0; // Indexed hash.
+  int distance = 0;       // Hamming distance to the query.
+};
+
+// Class: HashIndexWriter
+// Collects hashes in memory and writes them as an index file.
+class HashIndexWriter {
+public:
+  // Adds one hash to the index.
+  // @param hash The perceptual hash.
+  // @param path The path reported for matches of this hash.
+  void add(std::uint64_t hash, const std::string &path);
+
+  // Gets the number of hashes added so far.
+  std::size_t size() const;
+
+  // Writes the index file.
+  // @param filename The path of the index file to create.
+  // @return True if the file was written successfully, false otherwise.
+  bool write(const std::string &filename) const;
+
+private:
+  std::vector<std::uint64_t> hashes_; // Hashes in insertion order.
+  std::vector<std::string> paths_;    // Paths parallel to hashes_.
+};
+
+// Class: HashIndex
+// Read-only, memory-mapped view of an index file.
+class HashIndex {
+public:
+  // Number of 16-bit chunks each hash is split into.
+  static constexpr int kChunks = 4;
+
+  // Opens and maps an index file.
+  // @param filename The path to the index file.
+  // @return True if the file is a valid index, false otherwise.
+  bool open(const std::string &filename);
+
+  // Gets the number of indexed hashes.
+  std::size_t size() const;
+
+  // Finds all indexed hashes within a Hamming distance of a query.
+  // @param hash The query hash.
+  // @param maxDistance The largest Hamming distance to report.
+  // @return The matches, nearest first.
+  std::vector<HashMatch> query(std::uint64_t hash, int maxDistance) const;
+
+private:
+  MappedFile file_;                            // Mapped index file.
+  std::uint64_t count_ = 0;                    // Number of indexed hashes.
+  const std::uint64_t *hashes_ = nullptr;      // Hashes by entry id.
+  const std::uint64_t *pathOffsets_ = nullptr; // Path start per entry id.
+  const std::uint64_t *tables_[kChunks] = {};  // Sorted (chunk, id) keys.
+  const char *paths_ = nullptr;                // Concatenated path bytes.
+  std::uint64_t pathsSize_ = 0;                // Bytes in paths_.
+};
+
+#endif // VIDICANT_HASH_INDEX_HPP
@@ -9,6 +9,9 @@
 #ifndef VIDICANT_IMAGE_HPP
 #define VIDICANT_IMAGE_HPP
 
+#include "vidicant/active_area.hpp"
+#include "vidicant/metrics.hpp"
+#include "vidicant/phash.hpp"
 #include <array>
 #include <memory>
 #include <string>
@@ -29,6 +32,10 @@ public:
   // Loads an image from the specified file.
   virtual cv::Mat imread(const std::string &filename) = 0;
 
+  // Gets the encoded bytes, for loaders that hold them in memory.
+  // @return The bytes, or null if the loader reads files.
+  virtual const std::vector<unsigned char> *getEncodedBytes() const;
+
   // Virtual destructor for proper cleanup of derived classes.
   virtual ~IImageLoader() = default;
 };
@@ -36,13 +43,49 @@ public:
 // Class: OpenCVImageLoader
 // Concrete implementation of IImageLoader using OpenCV.
 //
-// This class uses OpenCV's imread function to load images from files.
+// This class uses OpenCV's imread function to load images from files. Images
+// keep their bit depth (8-bit, 16-bit or float) and are decoded as one
+// channel if the file is grayscale and three otherwise.
 class OpenCVImageLoader : public IImageLoader {
 public:
   // Loads an image using OpenCV's imread function.
   cv::Mat imread(const std::string &filename) override;
 };
 
+// Class: MemoryImageLoader
+// Implementation of IImageLoader over an encoded image held in memory.
+//
+// This class decodes the bytes of a JPEG, PNG or other supported file with
+// OpenCV's imdecode, once, and returns that image for every imread call
+// regardless of the filename. It serves requests that carry image bytes
+// rather than a path.
+class MemoryImageLoader : public IImageLoader {
+public:
+  // Constructs a loader over a copy of the encoded bytes.
+  explicit MemoryImageLoader(std::vector<unsigned char> bytes);
+
+  ~MemoryImageLoader() override;
+
+  // Returns the decoded image, or an empty image if the bytes are invalid.
+  cv::Mat imread(const std::string &filename) override;
+
+  // Gets the bytes the loader was given, which are released once decoded.
+  const std::vector<unsigned char> *getEncodedBytes() const override;
+
+private:
+  std::vector<unsigned char> bytes_; // Encoded image bytes.
+  std::unique_ptr<cv::Mat> decoded_; // Decoded image, set on first use.
+};
+
+// Struct: AnalysisProgress
+// How far a budgeted image analysis got.
+struct AnalysisProgress {
+  cv::Size frameSize;       // Size of the picture analyzed, before any
+                            // downscaling.
+  double coverage = 1.0;    // Share of its pixels the results read.
+  bool interrupted = false; // Whether the deadline passed during analysis.
+};
+
 // Class: ImageHandler
 // High-level handler for image analysis operations.
 //
@@ -58,6 +101,10 @@ public:
   // Constructs an ImageHandler with the specified loader.
   explicit ImageHandler(std::unique_ptr<IImageLoader> loader);
 
+  // Gets the encoded bytes the loader holds in memory.
+  // @return The bytes, or null if the loader reads files.
+  const std::vector<unsigned char> *getEncodedBytes() const;
+
   // Retrieves the dimensions of the image.
   std::pair<int, int> getDimensions(const std::string &filename);
 
@@ -86,14 +133,36 @@ public:
   // Calculates the average saturation of the image.
   double getSaturationLevel(const std::string &filename);
 
-  // Gets the RGB histogram data for the image.
-  std::vector<std::vector<int>> getHistogram(const std::string &filename);
+  // Gets the per-channel histograms of the image over its full sample
+  // range, e.g. 0-65535 for 16-bit images.
+  std::vector<std::vector<int>> getHistogram(const std::string &filename,
+                                             int bins = 256);
 
   // Calculates the aspect ratio (width/height) of the image.
   double getAspectRatio(const std::string &filename);
 
   // Calculates the entropy (information content) of the image.
   double getImageEntropy(const std::string &filename);
+
+  // Computes the dHash and pHash fingerprints of the image.
+  PerceptualHash getPerceptualHash(const std::string &filename);
+
+  // Loads the image once and runs an engine's selected metrics over it.
+  // With a deadline set, a large image is first analyzed downscaled, and
+  // the full image replaces those results only if time remains after them,
+  // so the engine always holds a result when the budget runs out. The
+  // decode itself cannot be stopped.
+  // @param filename The path to the image.
+  // @param engine The engine to feed; read its results with finish().
+  // @param activeArea If set, receives the picture area inside any black
+  // bars, and the engine sees only that area.
+  // @param deadline When to stop refining.
+  // @param progress If set, receives the size analyzed and the coverage.
+  // @return True if the image was loaded, false otherwise.
+  bool analyze(const std::string &filename, ImageMetricEngine &engine,
+               ActiveArea *activeArea = nullptr,
+               const Deadline &deadline = {},
+               AnalysisProgress *progress = nullptr);
 };
 
 // Namespace: vidicant
@@ -132,7 +201,8 @@ double getImageContrastRatio(const std::string &filename);
 double getImageSaturationLevel(const std::string &filename);
 
 // Convenience function to get histogram.
-std::vector<std::vector<int>> getImageHistogram(const std::string &filename);
+std::vector<std::vector<int>> getImageHistogram(const std::string &filename,
+                                                int bins = 256);
 
 // Convenience function to get aspect ratio.
 double getImageAspectRatio(const std::string &filename);
@@ -140,6 +210,9 @@ double getImageAspectRatio(const std::string &filename);
 // Convenience function to get image entropy.
 double getImageEntropy(const std::string &filename);
 
+// Convenience function to get image perceptual hashes.
+PerceptualHash getImagePerceptualHash(const std::string &filename);
+
 } // namespace vidicant
 
 #endif // VIDICANT_IMAGE_HPP
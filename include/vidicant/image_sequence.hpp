@@ -0,0 +1,149 @@
+// File: image_sequence.hpp
+// Header file for multi-frame image sources in the Vidicant library.
+//
+// This file defines video loaders for media that are stored as images but
+// play as videos: animated GIF and WebP files, and numbered image sequences
+// such as frame_%05d.png. Both stream frames one at a time through the
+// IVideoLoader interface, so every VideoHandler analysis (motion, scene
+// changes, consistency, series) works on them without holding all frames in
+// memory. Image sequences decode several frames ahead in parallel, since
+// each frame is an independent file.
+
+#ifndef VIDICANT_IMAGE_SEQUENCE_HPP
+#define VIDICANT_IMAGE_SEQUENCE_HPP
+
+#include "vidicant/video.hpp"
+#include <deque>
+#include <future>
+#include <memory>
+#include <opencv2/imgcodecs.hpp>
+#include <string>
+#include <utility>
+
+class ThreadPool;
+
+// Class: AnimatedImageLoader
+// IVideoLoader over the frames of an animated GIF or WebP file.
+//
+// Frames are decoded lazily with cv::ImageCollection where the image codecs
+// can iterate the animation, and with the FFmpeg video backend otherwise.
+// The frame count and rate come from the file's blocks (see probeImage).
+class AnimatedImageLoader : public IVideoLoader {
+public:
+  // Frame rate reported when the file has no frame delays.
+  static constexpr double kDefaultFPS = 10.0;
+
+  // Opens an animated image.
+  // @param filename The path to the GIF or WebP file.
+  // @return True if its frames can be decoded, false otherwise.
+  bool open(const std::string &filename) override;
+
+  // Gets the number of frames counted in the file.
+  int getFrameCount() override;
+
+  // Gets the mean frame rate implied by the frame delays.
+  double getFPS() override;
+
+  // Gets the canvas size.
+  std::pair<int, int> getResolution() override;
+
+  // Decodes the next frame.
+  cv::Mat readFrame() override;
+
+  // Decodes the next frame into an existing buffer.
+  bool readFrame(cv::Mat &frame) override;
+
+private:
+  int frameCount_ = 0;             // Frames counted by the probe.
+  double fps_ = kDefaultFPS;       // Mean frame rate.
+  std::pair<int, int> resolution_; // Canvas width and height.
+  int index_ = 0;                  // Next frame to decode.
+  bool useCollection_ = false;     // True if decoding with collection_.
+  cv::ImageCollection collection_; // Lazy page decoder.
+  OpenCVVideoLoader video_;        // FFmpeg fallback decoder.
+};
+
+// Class: ImageSequenceLoader
+// IVideoLoader over numbered image files named by a printf-style pattern.
+//
+// The pattern holds one integer conversion such as %d or %05d; numbering
+// starts at 0 or 1 and ends before the first missing file. Up to twice the
+// policy's threads per file frames are decoded ahead on a private pool and
+// handed out in order.
+class ImageSequenceLoader : public IVideoLoader {
+public:
+  // Frame rate reported for sequences, which carry no timing.
+  static constexpr double kDefaultFPS = 25.0;
+
+  // Constructs a loader.
+  // @param fps Frame rate to report for the sequence.
+  // @param decodeThreads Threads decoding ahead; 0 uses the parallelism
+  // policy's threads per file.
+  explicit ImageSequenceLoader(double fps = kDefaultFPS,
+                               int decodeThreads = 0);
+
+  // Waits for frames still being decoded.
+  ~ImageSequenceLoader() override;
+
+  // Opens a sequence by finding its first frame and counting the rest.
+  // @param pattern The path pattern, e.g. "shots/frame_%05d.png".
+  // @return True if the first frame exists and its header is readable.
+  bool open(const std::string &pattern) override;
+
+  // Gets the number of frames in the sequence.
+  int getFrameCount() override;
+
+  // Gets the frame rate given at construction.
+  double getFPS() override;
+
+  // Gets the size of the first frame.
+  std::pair<int, int> getResolution() override;
+
+  // Decodes the next frame.
+  cv::Mat readFrame() override;
+
+  // Takes the next decoded frame into an existing buffer.
+  bool readFrame(cv::Mat &frame) override;
+
+  // Skips the next frame without decoding it, if it has not been started.
+  bool skipFrame() override;
+
+private:
+  // Starts decoding frames until the read-ahead window is full.
+  void fill();
+
+  std::string pattern_;                    // Path pattern.
+  int first_ = 0;                          // Number of the first frame.
+  int frameCount_ = 0;                     // Frames in the sequence.
+  int scheduled_ = 0;                      // Frames started or skipped.
+  double fps_;                             // Reported frame rate.
+  int threads_;                            // Decode threads, 0 for policy.
+  std::pair<int, int> resolution_;         // First frame's size.
+  std::unique_ptr<ThreadPool> pool_;       // Read-ahead decoders.
+  std::deque<std::future<cv::Mat>> ahead_; // Frames being decoded, in order.
+};
+
+// Namespace: vidicant
+// Namespace containing helpers for multi-frame image sources.
+namespace vidicant {
+
+// Checks whether a path is an image sequence pattern: an image extension
+// and exactly one integer conversion (%d or %0Nd).
+// @param path The path to check.
+// @return True if the path names an image sequence.
+bool isImageSequence(const std::string &path);
+
+// Formats the path of one frame of an image sequence.
+// @param pattern A path for which isImageSequence is true.
+// @param number The frame number.
+// @return The frame's path.
+std::string formatSequencePath(const std::string &pattern, int number);
+
+// Checks whether a GIF or WebP file has more than one frame.
+// @param filename The path to the image.
+// @return True if the file is animated.
+bool isAnimatedImage(const std::string &filename);
+
+} // namespace vidicant
+
+#endif // VIDICANT_IMAGE_SEQUENCE_HPP
@@ -0,0 +1,58 @@
+// File: jpeg_dct.hpp
+// Header file for compressed-domain JPEG analysis in the Vidicant library.
+//
+// This file defines a fast path that estimates image metrics from a JPEG's
+// quantized DCT coefficients, read with libjpeg's coefficient API. Neither
+// the inverse DCT, upsampling nor color conversion runs, which is most of
+// the cost of decoding a JPEG.
+//
+// The DCT of each 8x8 block is orthonormal, so the DC coefficient gives
+// the block's mean exactly and the coefficient energy gives its variance.
+// Brightness follows from the luma and chroma means by the linear YCbCr to
+// RGB transform. Inside a block the Laplacian scales each cosine basis
+// function by a fixed gain, so the blur score is the AC energy weighted by
+// those gains, plus the jumps between neighboring blocks, which come from
+// the 1-D transforms of their edge rows and columns. Contrast and entropy
+// are taken from the block means, a coarser view than the pixels the
+// regular path reads.
+
+#ifndef VIDICANT_JPEG_DCT_HPP
+#define VIDICANT_JPEG_DCT_HPP
+
+#include <cstddef>
+#include <string>
+
+// Struct: JpegDctStats
+// Metrics estimated from the DCT coefficients of one JPEG.
+struct JpegDctStats {
+  int width = 0;                   // Width, after EXIF orientation.
+  int height = 0;                  // Height, after EXIF orientation.
+  int channels = 0;                // 1 for grayscale, 3 for color.
+  double averageBrightness = -1.0; // Mean of the B, G, R means (0-255).
+  double blurScore = -1.0;         // Estimated Laplacian variance.
+  double contrastRatio = -1.0;     // Brightest over darkest block mean.
+  double entropy = -1.0;           // Entropy of the block mean histogram.
+};
+
+// Namespace: vidicant
+// Namespace containing the compressed-domain JPEG functions.
+namespace vidicant {
+
+// Estimates metrics of a JPEG from its DCT coefficients.
+// @param filename The path to the image.
+// @param stats Receives the estimates.
+// @return True on success; false if Vidicant was built without libjpeg, or
+// the file is not a grayscale or YCbCr JPEG.
+bool analyzeJpegDct(const std::string &filename, JpegDctStats &stats);
+
+// Estimates metrics of a JPEG held in memory from its DCT coefficients.
+// @param data The encoded bytes.
+// @param size The number of bytes.
+// @param stats Receives the estimates.
+// @return True on success, as for a file.
+bool analyzeJpegDct(const unsigned char *data, std::size_t size,
+                    JpegDctStats &stats);
+
+} // namespace vidicant
+
+#endif // VIDICANT_JPEG_DCT_HPP
@@ -0,0 +1,69 @@
+// File: kernels.hpp
+// Header file for the SIMD kernels of the Vidicant library.
+//
+// This file declares the inner loops Vidicant runs itself rather than
+// through OpenCV, which dispatches its own. Each kernel is built for several
+// instruction sets: a portable baseline, SSE4.2, AVX2 and AVX-512 on x86-64,
+// and NEON on 64-bit ARM. The best variant the CPU supports is chosen on
+// first use, so a library built for the baseline ISA still uses the wider
+// registers of newer servers and keeps running on older hosts.
+//
+// Setting VIDICANT_ISA to a variant name (baseline, sse4.2, avx2, avx512 or
+// neon) before the first use forces that variant, for benchmarking. A
+// variant the CPU or the build lacks is reported on stderr and replaced by
+// the best available one.
+
+#ifndef VIDICANT_KERNELS_HPP
+#define VIDICANT_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Struct: KernelTable
+// One variant of every kernel.
+struct KernelTable {
+  const char *isa; // Variant name, as accepted by VIDICANT_ISA.
+
+  // Sums bytes.
+  // @param data The bytes.
+  // @param count The number of bytes.
+  // @return The sum.
+  std::uint64_t (*sumBytes)(const unsigned char *data, std::size_t count);
+
+  // Sums the absolute differences of pairs of bytes.
+  // @param a The first bytes.
+  // @param b The second bytes.
+  // @param count The number of pairs.
+  // @return The sum.
+  std::uint64_t (*sumAbsDiff)(const unsigned char *a, const unsigned char *b,
+                              std::size_t count);
+};
+
+// Namespace: vidicant
+// Namespace containing the kernel dispatch functions.
+namespace vidicant {
+
+// Gets the kernels selected for this process, choosing them on first use.
+const KernelTable &kernels();
+
+// Gets the names of the variants this build and CPU can run, best first.
+std::vector<std::string> getAvailableIsas();
+
+// Finds a variant by name.
+// @param isa The variant name.
+// @return The variant, or nullptr if this build or CPU cannot run it.
+const KernelTable *findKernels(const std::string &isa);
+
+// Variant tables, defined only where the build compiles them; callers use
+// kernels() or findKernels() instead.
+const KernelTable &getBaselineKernels();
+const KernelTable &getSse42Kernels();
+const KernelTable &getAvx2Kernels();
+const KernelTable &getAvx512Kernels();
+const KernelTable &getNeonKernels();
+
+} // namespace vidicant
+
+#endif // VIDICANT_KERNELS_HPP
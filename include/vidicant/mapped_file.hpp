@@ -0,0 +1,49 @@
+// File: mapped_file.hpp
+// Header file for read-only memory-mapped files in the Vidicant library.
+//
+// This file defines a small RAII wrapper that maps a whole file into memory
+// so on-disk indexes and sidecars can be queried without reading them in
+// full. Platforms without mmap fall back to reading the file into a buffer.
+
+#ifndef VIDICANT_MAPPED_FILE_HPP
+#define VIDICANT_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Class: MappedFile
+// Read-only view of a file's contents.
+class MappedFile {
+public:
+  // Expected access pattern, passed to the kernel as a paging hint.
+  enum class Access { Random, Sequential };
+
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Maps a file into memory, replacing any previous mapping.
+  // @param filename The path to the file.
+  // @param access The expected access pattern.
+  // @return True if the file was mapped successfully, false otherwise.
+  bool open(const std::string &filename, Access access = Access::Random);
+
+  // Unmaps the file.
+  void close();
+
+  // Gets the first byte of the mapping, or nullptr if nothing is mapped.
+  const unsigned char *data() const;
+
+  // Gets the size of the mapping in bytes.
+  std::size_t size() const;
+
+private:
+  const unsigned char *data_ = nullptr; // Start of the mapped bytes.
+  std::size_t size_ = 0;                // Number of mapped bytes.
+  bool mapped_ = false;                 // True if data_ came from mmap.
+  std::vector<unsigned char> fallback_; // Contents when mmap is unavailable.
+};
+
+#endif // VIDICANT_MAPPED_FILE_HPP
@@ -0,0 +1,98 @@
+// File: memory_stats.hpp
+// Header file for opt-in memory telemetry in the Vidicant library.
+//
+// This file defines a counting layer over OpenCV's Mat allocator, so that
+// the memory an analysis really takes can be measured instead of guessed.
+// Once enabled, every cv::Mat allocated with the default allocator is
+// counted process-wide, and MemoryScope objects attribute allocations to
+// the file and the stage that made them: bytes allocated, allocations and
+// the peak of live bytes.
+//
+// Scopes are per thread, so files analyzed concurrently on different
+// workers are counted apart. Buffers OpenCV allocates on its own worker
+// threads (inside parallel_for_) count only towards the process totals.
+// Memory held outside Mats, such as std::vector, is not counted.
+
+#ifndef VIDICANT_MEMORY_STATS_HPP
+#define VIDICANT_MEMORY_STATS_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Struct: MemoryUsage
+// Mat memory taken by a scope or by the process.
+struct MemoryUsage {
+  std::uint64_t allocatedBytes = 0; // Bytes of Mats allocated.
+  std::uint64_t peakBytes = 0;      // Most bytes live at once.
+  std::uint64_t allocations = 0;    // Mats allocated.
+};
+
+// Class: MemoryScope
+// Counts the Mats allocated on the calling thread while it is alive.
+//
+// Scopes nest: allocations count towards every open scope of the thread,
+// and a scope that closes adds its usage to the stages of its parent. A
+// scope only counts while memory tracking is enabled, and costs a flag
+// check otherwise.
+class MemoryScope {
+public:
+  // Opens a scope on the calling thread.
+  // @param name The stage name; must outlive the scope.
+  explicit MemoryScope(const char *name);
+
+  // Closes the scope and reports it to its parent.
+  ~MemoryScope();
+
+  MemoryScope(const MemoryScope &) = delete;
+  MemoryScope &operator=(const MemoryScope &) = delete;
+
+  // Gets the memory taken since the scope opened.
+  MemoryUsage getUsage() const;
+
+  // Gets the usage of the scopes closed inside this one, by path such as
+  // "analyze/dominant_colors"; stages entered more than once are merged.
+  const std::vector<std::pair<std::string, MemoryUsage>> &getStages() const;
+
+private:
+  friend class CountingMatAllocator;
+
+  // Adds one stage's usage, merging it with a stage of the same path.
+  void addStage(const std::string &path, const MemoryUsage &usage);
+
+  const char *name_;            // Stage name.
+  MemoryScope *parent_;         // Enclosing scope on this thread, if any.
+  bool active_;                 // Whether tracking was on at opening.
+  MemoryUsage usage_;           // Memory taken so far.
+  std::int64_t liveBytes_ = 0;  // Bytes allocated less bytes freed.
+  std::vector<std::pair<std::string, MemoryUsage>> stages_; // Closed ones.
+};
+
+// Namespace: vidicant
+// Namespace containing memory telemetry functions.
+namespace vidicant {
+
+// Installs the counting allocator as OpenCV's default Mat allocator; once
+// installed it stays for the life of the process. Mats allocated earlier
+// are not counted.
+void enableMemoryTracking();
+
+// Checks whether the counting allocator is installed.
+bool isMemoryTrackingEnabled();
+
+// Gets the Mat memory taken on every thread since tracking was enabled.
+MemoryUsage getProcessMatUsage();
+
+// Gets the number of Mats allocated on the calling thread since tracking
+// was enabled. Buffers OpenCV allocates on its own worker threads are not
+// included.
+std::uint64_t getThreadMatAllocations();
+
+// Gets the peak resident set size of the process.
+// @return The size in bytes, or 0 where the platform does not report it.
+std::uint64_t getPeakRss();
+
+} // namespace vidicant
+
+#endif // VIDICANT_MEMORY_STATS_HPP
@@ -0,0 +1,707 @@
+// File: metrics.hpp
+// Header file for the compile-time metric registry in the Vidicant library.
+//
+// This file defines image metrics as small structs that declare, at compile
+// time, their name, the image views they read and either a per-pixel or a
+// per-frame kernel. A MetricEngine instantiated over a list of metrics
+// converts each frame to only the views its selected metrics need, runs the
+// per-frame kernels, and then makes one pass over the rows in which every
+// selected per-pixel kernel consumes the row while it is still in cache.
+// Kernels are called through templates, so the inner loops contain no
+// virtual dispatch.
+//
+// Frames may hold 8-bit, 16-bit or float samples. The engine picks the
+// sample type and channel count once per frame and instantiates the row
+// loop for it, so per-pixel kernels are compiled separately for each
+// combination and none of them tests the depth per pixel. Metrics report
+// on the 0-255 scale of 8-bit images whatever the input depth.
+//
+// To add a metric, define a struct with the members below and append it to
+// ImageMetricEngine; the JSON field, the --metrics name and the Python
+// available_metrics() entry all come from kName.
+//
+//   kName    Field and selection name.
+//   kInputs  MetricInput flags for the views the kernel reads.
+//   kKind    MetricKind::Pixel or MetricKind::Frame.
+//   State    Default-constructible accumulator.
+//   Result   Value reported for the metric.
+//   pixel(State &, const Row &, int x)     Kernel template of a Pixel
+//                                          metric; Row is a PixelRow.
+//   frame(State &, const FrameViews &)     Kernel of a Frame metric.
+//   finish(const State &) -> Result        Final value.
+//   configure(State &, const MetricOptions &)  Optional; applies options.
+//   row(State &, const Row &, int cols)    Optional; takes a whole row in
+//                                          place of pixel(), e.g. to call
+//                                          a SIMD kernel (kernels.hpp).
+
+#ifndef VIDICANT_METRICS_HPP
+#define VIDICANT_METRICS_HPP
+
+#include "vidicant/deadline.hpp"
+#include "vidicant/kernels.hpp"
+#include "vidicant/memory_stats.hpp"
+#include "vidicant/phash.hpp"
+#include "vidicant/trace.hpp"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <opencv2/core.hpp>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Enum: MetricInput
+// Views of a frame a metric can read, combined as bit flags. The decoded
+// image itself is always available.
+enum MetricInput : unsigned {
+  kInputImage = 0,      // Decoded image, 1 or 3 channels.
+  kInputGray = 1u << 0, // Single-channel version, at the image's depth.
+  kInputHsv = 1u << 1,  // HSV version; 3-channel images only.
+  kInputFloat = 1u << 2 // CV_32F samples on the 0-255 scale, one row per
+                        // pixel.
+};
+
+// Enum: MetricKind
+// Whether a metric's kernel runs once per pixel or once per frame.
+enum class MetricKind { Pixel, Frame };
+
+// Struct: FrameViews
+// The views of one frame, each computed only if some selected metric needs
+// it.
+struct FrameViews {
+  cv::Mat image;      // Decoded image.
+  cv::Mat gray;       // Grayscale view, if requested.
+  cv::Mat hsv;        // HSV view, if requested and the image has 3 channels.
+  cv::Mat samples;    // Float samples, if requested.
+  double scale = 1.0; // Factor from image samples to the 0-255 scale.
+};
+
+// Struct: MetricOptions
+// Settings that change the shape of some metrics' results or bound their
+// work.
+struct MetricOptions {
+  int histogramBins = 256; // Bins per channel of the histogram metric.
+  Deadline deadline;       // When iterative metrics stop refining.
+};
+
+// Struct: PixelDepth
+// Compile-time description of a sample type: the type of its HSV view, the
+// factor to the 0-255 scale and how values map to histogram bins.
+// Specialized for 8-bit, 16-bit and float (0-1) samples.
+template <typename T> struct PixelDepth;
+
+template <> struct PixelDepth<uchar> {
+  using Hsv = uchar;                    // HSV as OpenCV's 8-bit encoding.
+  static constexpr double kScale = 1.0; // Already on the 0-255 scale.
+  static int bin(uchar value, int bins) { return value * bins >> 8; }
+};
+
+template <> struct PixelDepth<ushort> {
+  using Hsv = float; // HSV with S and V on 0-1.
+  static constexpr double kScale = 255.0 / 65535.0;
+  static int bin(ushort value, int bins) {
+    return static_cast<int>(static_cast<unsigned>(value) * bins >> 16);
+  }
+};
+
+template <> struct PixelDepth<float> {
+  using Hsv = float; // HSV with S and V on 0-1.
+  static constexpr double kScale = 255.0;
+  static int bin(float value, int bins) {
+    if (!(value > 0.0f))
+      return 0; // Also NaN
+    return value >= 1.0f ? bins - 1 : static_cast<int>(value * bins);
+  }
+};
+
+// Struct: PixelRow
+// Pointers to one row of each view, passed to per-pixel kernels.
+//
+// T is the sample type of the image and its gray view. Channels is the
+// image's channel count, or 0 if it is only known at run time; loops over
+// channels() then have constant bounds for the common 1 and 3 channel
+// layouts.
+template <typename T, int Channels> struct PixelRow {
+  using Sample = T;
+  using Depth = PixelDepth<T>;
+  using Hsv = typename Depth::Hsv;
+
+  // True for 8-bit rows, whose values are already 0-255 integers.
+  static constexpr bool kNarrow = std::is_same<T, uchar>::value;
+
+  const T *image = nullptr;  // Row of the decoded image.
+  const T *gray = nullptr;   // Row of the gray view, or nullptr.
+  const Hsv *hsv = nullptr;  // Row of the HSV view, or nullptr.
+  int runtimeChannels = 0;   // Channels in the decoded image.
+
+  // Gets the number of channels in the decoded image.
+  constexpr int channels() const {
+    return Channels > 0 ? Channels : runtimeChannels;
+  }
+};
+
+// Struct: IsGrayscaleMetric
+// True if the image has a single channel.
+struct IsGrayscaleMetric {
+  static constexpr const char *kName = "is_grayscale";
+  static constexpr unsigned kInputs = kInputImage;
+  static constexpr MetricKind kKind = MetricKind::Frame;
+  struct State {
+    int channels = 0;
+  };
+  using Result = bool;
+  static void frame(State &state, const FrameViews &views) {
+    state.channels = views.image.channels();
+  }
+  static Result finish(const State &state) { return state.channels == 1; }
+};
+
+// Struct: ChannelsMetric
+// Number of channels in the image.
+struct ChannelsMetric {
+  static constexpr const char *kName = "channels";
+  static constexpr unsigned kInputs = kInputImage;
+  static constexpr MetricKind kKind = MetricKind::Frame;
+  struct State {
+    int channels = -1;
+  };
+  using Result = int;
+  static void frame(State &state, const FrameViews &views) {
+    state.channels = views.image.channels();
+  }
+  static Result finish(const State &state) { return state.channels; }
+};
+
+// Struct: AspectRatioMetric
+// Width divided by height.
+struct AspectRatioMetric {
+  static constexpr const char *kName = "aspect_ratio";
+  static constexpr unsigned kInputs = kInputImage;
+  static constexpr MetricKind kKind = MetricKind::Frame;
+  struct State {
+    int width = 0;
+    int height = 0;
+  };
+  using Result = double;
+  static void frame(State &state, const FrameViews &views) {
+    state.width = views.image.cols;
+    state.height = views.image.rows;
+  }
+  static Result finish(const State &state) {
+    return state.height > 0 ? static_cast<double>(state.width) / state.height
+                            : 0.0;
+  }
+};
+
+// Struct: AverageBrightnessMetric
+// Mean pixel value, averaged over the channels.
+struct AverageBrightnessMetric {
+  static constexpr const char *kName = "average_brightness";
+  static constexpr unsigned kInputs = kInputImage;
+  static constexpr MetricKind kKind = MetricKind::Pixel;
+  struct State {
+    std::uint64_t sum = 0; // 8-bit samples, summed exactly.
+    double levels = 0.0;   // Other samples, on the 0-255 scale.
+    std::uint64_t samples = 0;
+  };
+  using Result = double;
+  template <typename Row>
+  static void pixel(State &state, const Row &row, int x) {
+    const auto *px = row.image + x * row.channels();
+    for (int c = 0; c < row.channels(); ++c) {
+      if constexpr (Row::kNarrow)
+        state.sum += px[c];
+      else
+        state.levels += px[c] * Row::Depth::kScale;
+    }
+    state.samples += static_cast<std::uint64_t>(row.channels());
+  }
+  // 8-bit rows are summed whole by the SIMD kernel.
+  template <typename Row>
+  static void row(State &state, const Row &row, int cols) {
+    if constexpr (Row::kNarrow) {
+      auto count = static_cast<std::size_t>(cols) * row.channels();
+      state.sum += vidicant::kernels().sumBytes(row.image, count);
+      state.samples += count;
+    } else {
+      for (int x = 0; x < cols; ++x)
+        pixel(state, row, x);
+    }
+  }
+  static Result finish(const State &state) {
+    return state.samples > 0
+               ? (static_cast<double>(state.sum) + state.levels) /
+                     state.samples
+               : -1.0;
+  }
+};
+
+// Struct: HistogramMetric
+// Histogram of each channel over the full sample range; 256 bins unless
+// configured otherwise.
+struct HistogramMetric {
+  static constexpr const char *kName = "histogram";
+  static constexpr unsigned kInputs = kInputImage;
+  static constexpr MetricKind kKind = MetricKind::Pixel;
+  struct State {
+    int binCount = 256;
+    std::vector<std::vector<std::uint64_t>> bins;
+  };
+  using Result = std::vector<std::vector<int>>;
+  static void configure(State &state, const MetricOptions &options) {
+    state.binCount = std::max(1, options.histogramBins);
+  }
+  template <typename Row>
+  static void pixel(State &state, const Row &row, int x) {
+    if (state.bins.size() != static_cast<std::size_t>(row.channels()))
+      state.bins.assign(row.channels(),
+                        std::vector<std::uint64_t>(state.binCount));
+    const auto *px = row.image + x * row.channels();
+    for (int c = 0; c < row.channels(); ++c)
+      ++state.bins[c][Row::Depth::bin(px[c], state.binCount)];
+  }
+  static Result finish(const State &state) {
+    Result histograms;
+    for (const auto &bins : state.bins)
+      histograms.emplace_back(bins.begin(), bins.end());
+    return histograms;
+  }
+};
+
+// Struct: ContrastRatioMetric
+// Ratio of the brightest to the darkest gray level.
+struct ContrastRatioMetric {
+  static constexpr const char *kName = "contrast_ratio";
+  static constexpr unsigned kInputs = kInputGray;
+  static constexpr MetricKind kKind = MetricKind::Pixel;
+  struct State {
+    int minValue = 256; // 8-bit extremes.
+    int maxValue = -1;
+    double minLevel = std::numeric_limits<double>::infinity(); // Others, on
+    double maxLevel = -1.0;                                    // 0-255.
+  };
+  using Result = double;
+  template <typename Row>
+  static void pixel(State &state, const Row &row, int x) {
+    if constexpr (Row::kNarrow) {
+      int value = row.gray[x];
+      if (value < state.minValue)
+        state.minValue = value;
+      if (value > state.maxValue)
+        state.maxValue = value;
+    } else {
+      double level = row.gray[x] * Row::Depth::kScale;
+      if (level < state.minLevel)
+        state.minLevel = level;
+      if (level > state.maxLevel)
+        state.maxLevel = level;
+    }
+  }
+  static Result finish(const State &state) {
+    double minValue = std::min<double>(state.minValue, state.minLevel);
+    double maxValue = std::max<double>(state.maxValue, state.maxLevel);
+    if (maxValue < 0)
+      return -1.0;
+    return maxValue > 0 ? maxValue / (minValue + 1e-6)
+                        : 0.0; // Avoid division by zero
+  }
+};
+
+// Struct: EntropyMetric
+// Shannon entropy of the gray-level histogram, in bits.
+struct EntropyMetric {
+  static constexpr const char *kName = "entropy";
+  static constexpr unsigned kInputs = kInputGray;
+  static constexpr MetricKind kKind = MetricKind::Pixel;
+  struct State {
+    std::array<std::uint64_t, 256> bins{};
+    std::uint64_t total = 0;
+  };
+  using Result = double;
+  template <typename Row>
+  static void pixel(State &state, const Row &row, int x) {
+    ++state.bins[Row::Depth::bin(row.gray[x], 256)];
+    ++state.total;
+  }
+  static Result finish(const State &state);
+};
+
+// Struct: SaturationLevelMetric
+// Mean HSV saturation; -1 for images without color channels.
+struct SaturationLevelMetric {
+  static constexpr const char *kName = "saturation_level";
+  static constexpr unsigned kInputs = kInputHsv;
+  static constexpr MetricKind kKind = MetricKind::Pixel;
+  struct State {
+    std::uint64_t sum = 0; // 8-bit HSV saturation, summed exactly.
+    double levels = 0.0;   // Float HSV saturation, on the 0-255 scale.
+    std::uint64_t pixels = 0;
+  };
+  using Result = double;
+  template <typename Row>
+  static void pixel(State &state, const Row &row, int x) {
+    if (row.hsv == nullptr)
+      return;
+    if constexpr (Row::kNarrow)
+      state.sum += row.hsv[x * 3 + 1];
+    else
+      state.levels += row.hsv[x * 3 + 1] * 255.0;
+    ++state.pixels;
+  }
+  static Result finish(const State &state) {
+    return state.pixels > 0
+               ? (static_cast<double>(state.sum) + state.levels) /
+                     state.pixels
+               : -1.0;
+  }
+};
+
+// Struct: EdgeCountMetric
+// Number of Canny edge pixels.
+struct EdgeCountMetric {
+  static constexpr const char *kName = "edge_count";
+  static constexpr unsigned kInputs = kInputGray;
+  static constexpr MetricKind kKind = MetricKind::Frame;
+  struct State {
+    int edges = -1;
+  };
+  using Result = int;
+  static void frame(State &state, const FrameViews &views);
+  static Result finish(const State &state) { return state.edges; }
+};
+
+// Struct: BlurScoreMetric
+// Variance of the Laplacian; low values indicate a blurry image.
+struct BlurScoreMetric {
+  static constexpr const char *kName = "blur_score";
+  static constexpr unsigned kInputs = kInputGray;
+  static constexpr MetricKind kKind = MetricKind::Frame;
+  struct State {
+    double variance = -1.0;
+  };
+  using Result = double;
+  static void frame(State &state, const FrameViews &views);
+  static Result finish(const State &state) { return state.variance; }
+};
+
+// Struct: DominantColorsMetric
+// Three k-means cluster centers of the pixel colors; the clustering stops
+// iterating at the options' deadline.
+struct DominantColorsMetric {
+  static constexpr const char *kName = "dominant_colors";
+  static constexpr unsigned kInputs = kInputFloat;
+  static constexpr MetricKind kKind = MetricKind::Frame;
+  struct State {
+    Deadline deadline;
+    std::vector<std::array<double, 3>> colors;
+  };
+  using Result = std::vector<std::array<double, 3>>;
+  static void configure(State &state, const MetricOptions &options) {
+    state.deadline = options.deadline;
+  }
+  static void frame(State &state, const FrameViews &views);
+  static Result finish(const State &state) { return state.colors; }
+};
+
+// Struct: PerceptualHashMetric
+// dHash and pHash fingerprints of the gray view (see phash.hpp). Not part of
+// the default output; requested with --hashes or by name.
+struct PerceptualHashMetric {
+  static constexpr const char *kName = "perceptual_hash";
+  static constexpr unsigned kInputs = kInputGray;
+  static constexpr MetricKind kKind = MetricKind::Frame;
+  struct State {
+    PerceptualHash hash;
+  };
+  using Result = PerceptualHash;
+  static void frame(State &state, const FrameViews &views);
+  static Result finish(const State &state) { return state.hash; }
+};
+
+// Function: getLevelScale
+// Gets the factor from samples of a depth (CV_8U, CV_16U, CV_32F) to the
+// 0-255 scale metrics report on.
+double getLevelScale(int depth);
+
+// Function: makeFrameViews
+// Builds the views of a frame requested by a set of MetricInput flags.
+FrameViews makeFrameViews(const cv::Mat &image, unsigned inputs);
+
+// Struct: HasMetricConfigure
+// True if a metric declares configure(State &, const MetricOptions &).
+template <typename Metric, typename = void>
+struct HasMetricConfigure : std::false_type {};
+
+template <typename Metric>
+struct HasMetricConfigure<
+    Metric, std::void_t<decltype(Metric::configure(
+                std::declval<typename Metric::State &>(),
+                std::declval<const MetricOptions &>()))>> : std::true_type {};
+
+// Struct: HasMetricRow
+// True if a per-pixel metric also declares row(State &, const Row &, int),
+// which the engine then calls once per row instead of pixel() per pixel.
+template <typename Metric, typename Row, typename = void>
+struct HasMetricRow : std::false_type {};
+
+template <typename Metric, typename Row>
+struct HasMetricRow<Metric, Row,
+                    std::void_t<decltype(Metric::row(
+                        std::declval<typename Metric::State &>(),
+                        std::declval<const Row &>(), 0))>> : std::true_type {};
+
+// Class: MetricEngine
+// Runs a selected subset of a compile-time list of metrics over frames.
+template <typename... Metrics> class MetricEngine {
+public:
+  // Number of metrics in the registry.
+  static constexpr std::size_t kCount = sizeof...(Metrics);
+
+  // Which metrics to run, by position in the registry.
+  using Selection = std::bitset<kCount>;
+
+  // One optional result per metric; empty if not selected or no frames.
+  using Results = std::tuple<std::optional<typename Metrics::Result>...>;
+
+  // Constructs an engine running the selected metrics.
+  // @param selection The metrics to run; all of them by default.
+  // @param options Settings for the metrics that take any.
+  explicit MetricEngine(Selection selection = Selection().set(),
+                        const MetricOptions &options = MetricOptions())
+      : selection_(selection) {
+    configureAll(options, std::index_sequence_for<Metrics...>{});
+  }
+
+  // Gets the metric names, in registry order.
+  static std::vector<std::string> names() { return {Metrics::kName...}; }
+
+  // Gets the position of a metric in the registry, kCount if absent.
+  template <typename Metric> static constexpr std::size_t indexOf() {
+    constexpr bool matches[] = {std::is_same<Metric, Metrics>::value...};
+    for (std::size_t i = 0; i < kCount; ++i)
+      if (matches[i])
+        return i;
+    return kCount;
+  }
+
+  // Builds a selection from metric names; an empty list selects all.
+  // @param names The metric names to select.
+  // @param selection Receives the selection.
+  // @param unknown Receives the first name not in the registry, if any.
+  // @return True if every name was found, false otherwise.
+  static bool select(const std::vector<std::string> &names,
+                     Selection &selection, std::string *unknown = nullptr) {
+    selection.reset();
+    if (names.empty()) {
+      selection.set();
+      return true;
+    }
+    static const std::array<const char *, kCount> registry = {
+        Metrics::kName...};
+    for (const auto &name : names) {
+      std::size_t i = 0;
+      while (i < kCount && name != registry[i])
+        ++i;
+      if (i == kCount) {
+        if (unknown != nullptr)
+          *unknown = name;
+        return false;
+      }
+      selection.set(i);
+    }
+    return true;
+  }
+
+  // Gets the union of the views needed by the selected metrics.
+  unsigned requiredInputs() const {
+    return requiredInputsImpl(std::index_sequence_for<Metrics...>{});
+  }
+
+  // Runs the selected metrics over one frame.
+  // @param image The decoded frame with 8-bit, 16-bit or float (0-1)
+  // samples; other depths are converted to float. Empty frames are ignored.
+  void addFrame(const cv::Mat &image) {
+    if (image.empty())
+      return;
+    switch (image.depth()) {
+    case CV_8U:
+      addFrameOf<uchar>(image);
+      break;
+    case CV_16U:
+      addFrameOf<ushort>(image);
+      break;
+    case CV_32F:
+      addFrameOf<float>(image);
+      break;
+    default: {
+      cv::Mat samples;
+      image.convertTo(samples, CV_32F);
+      addFrameOf<float>(samples);
+    }
+    }
+  }
+
+  // Gets the number of frames processed.
+  int getFrameCount() const { return frames_; }
+
+  // Gets the size of the last frame processed.
+  cv::Size getFrameSize() const { return size_; }
+
+  // Gets the results of the selected metrics.
+  Results finish() const {
+    Results results;
+    if (frames_ > 0)
+      finishAll(results, std::index_sequence_for<Metrics...>{});
+    return results;
+  }
+
+  // Calls visit(name, value) for every metric present in a Results.
+  template <typename Visitor>
+  static void forEach(const Results &results, Visitor &&visit) {
+    forEachImpl(results, visit, std::index_sequence_for<Metrics...>{});
+  }
+
+private:
+  template <std::size_t I>
+  using MetricAt = std::tuple_element_t<I, std::tuple<Metrics...>>;
+
+  template <std::size_t... I>
+  void configureAll(const MetricOptions &options, std::index_sequence<I...>) {
+    (configureOne<I>(options), ...);
+  }
+
+  template <std::size_t I> void configureOne(const MetricOptions &options) {
+    if constexpr (HasMetricConfigure<MetricAt<I>>::value)
+      MetricAt<I>::configure(std::get<I>(states_), options);
+  }
+
+  template <typename T> void addFrameOf(const cv::Mat &image) {
+    size_ = image.size();
+    FrameViews views;
+    {
+      MemoryScope memory("frame_views");
+      TraceSpan span("color_conversion");
+      views = makeFrameViews(image, requiredInputs());
+    }
+    runFrameKernels(views, std::index_sequence_for<Metrics...>{});
+
+    // One pass over the rows shared by every per-pixel kernel, compiled
+    // for the frame's sample type and channel count
+    if (anyPixelMetricSelected(std::index_sequence_for<Metrics...>{})) {
+      TraceSpan span("pixel_metrics");
+      switch (image.channels()) {
+      case 1:
+        runRows<T, 1>(views);
+        break;
+      case 3:
+        runRows<T, 3>(views);
+        break;
+      default:
+        runRows<T, 0>(views);
+      }
+    }
+    ++frames_;
+  }
+
+  template <typename T, int Channels> void runRows(const FrameViews &views) {
+    using Row = PixelRow<T, Channels>;
+    using Hsv = typename Row::Hsv;
+    Row row;
+    row.runtimeChannels = views.image.channels();
+    for (int y = 0; y < views.image.rows; ++y) {
+      row.image = views.image.ptr<T>(y);
+      row.gray = views.gray.empty() ? nullptr : views.gray.ptr<T>(y);
+      row.hsv = views.hsv.empty() ? nullptr : views.hsv.ptr<Hsv>(y);
+      runPixelKernels(row, views.image.cols,
+                      std::index_sequence_for<Metrics...>{});
+    }
+  }
+
+  template <std::size_t... I>
+  unsigned requiredInputsImpl(std::index_sequence<I...>) const {
+    return ((selection_[I] ? MetricAt<I>::kInputs : 0u) | ... | 0u);
+  }
+
+  template <std::size_t... I>
+  void runFrameKernels(const FrameViews &views, std::index_sequence<I...>) {
+    (runFrameKernel<I>(views), ...);
+  }
+
+  template <std::size_t I> void runFrameKernel(const FrameViews &views) {
+    if constexpr (MetricAt<I>::kKind == MetricKind::Frame) {
+      if (selection_[I]) {
+        MemoryScope memory(MetricAt<I>::kName);
+        TraceSpan span(MetricAt<I>::kName);
+        MetricAt<I>::frame(std::get<I>(states_), views);
+      }
+    }
+  }
+
+  template <std::size_t... I>
+  bool anyPixelMetricSelected(std::index_sequence<I...>) const {
+    return ((MetricAt<I>::kKind == MetricKind::Pixel && selection_[I]) ||
+            ...);
+  }
+
+  template <typename Row, std::size_t... I>
+  void runPixelKernels(const Row &row, int cols, std::index_sequence<I...>) {
+    (runPixelKernel<I>(row, cols), ...);
+  }
+
+  template <std::size_t I, typename Row>
+  void runPixelKernel(const Row &row, int cols) {
+    if constexpr (MetricAt<I>::kKind == MetricKind::Pixel) {
+      if (!selection_[I])
+        return;
+      auto &state = std::get<I>(states_);
+      if constexpr (HasMetricRow<MetricAt<I>, Row>::value) {
+        MetricAt<I>::row(state, row, cols);
+      } else {
+        for (int x = 0; x < cols; ++x)
+          MetricAt<I>::pixel(state, row, x);
+      }
+    }
+  }
+
+  template <std::size_t... I>
+  void finishAll(Results &results, std::index_sequence<I...>) const {
+    (finishOne<I>(results), ...);
+  }
+
+  template <std::size_t I> void finishOne(Results &results) const {
+    if (selection_[I])
+      std::get<I>(results) = MetricAt<I>::finish(std::get<I>(states_));
+  }
+
+  template <typename Visitor, std::size_t... I>
+  static void forEachImpl(const Results &results, Visitor &visit,
+                          std::index_sequence<I...>) {
+    (visitOne<I>(results, visit), ...);
+  }
+
+  template <std::size_t I, typename Visitor>
+  static void visitOne(const Results &results, Visitor &visit) {
+    if (std::get<I>(results))
+      visit(MetricAt<I>::kName, *std::get<I>(results));
+  }
+
+  Selection selection_;                           // Metrics to run.
+  std::tuple<typename Metrics::State...> states_; // Per-metric accumulators.
+  int frames_ = 0;                                // Frames processed.
+  cv::Size size_;                                 // Last frame size.
+};
+
+// The registry of image metrics reported by ImageHandler::analyze.
+using ImageMetricEngine =
+    MetricEngine<IsGrayscaleMetric, AverageBrightnessMetric, ChannelsMetric,
+                 EdgeCountMetric, DominantColorsMetric, BlurScoreMetric,
+                 ContrastRatioMetric, SaturationLevelMetric, HistogramMetric,
+                 AspectRatioMetric, EntropyMetric, PerceptualHashMetric>;
+
+#endif // VIDICANT_METRICS_HPP
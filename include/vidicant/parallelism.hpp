@@ -0,0 +1,77 @@
+// File: parallelism.hpp
+// Header file for the process-wide threading policy in the Vidicant library.
+//
+// This file defines one policy that sizes every source of threads together:
+// vidicant's own file-level worker pools, OpenCV's internal parallel_for_
+// pool (cvtColor, Canny, kmeans, ...) and the FFmpeg decoder threads opened
+// by OpenCVVideoLoader. Sizing them independently oversubscribes the
+// machine as soon as several files are analyzed at once; the policy instead
+// splits the cores between files and the work inside each file.
+
+#ifndef VIDICANT_PARALLELISM_HPP
+#define VIDICANT_PARALLELISM_HPP
+
+#include <string>
+#include <vector>
+
+// Enum: ParallelismMode
+// How the available cores are divided.
+enum class ParallelismMode {
+  File,      // One file per core, each analyzed single-threaded.
+  IntraFile, // One file at a time, using every core inside it.
+  Hybrid     // A few files at once, each with a share of the cores.
+};
+
+// Struct: ParallelismPolicy
+// Resolved thread counts for every pool, plus pinning.
+struct ParallelismPolicy {
+  ParallelismMode mode = ParallelismMode::IntraFile; // Division of cores.
+  int cores = 1;           // Cores the policy was sized for.
+  int fileWorkers = 1;     // Files analyzed concurrently.
+  int threadsPerFile = 1;  // OpenCV and decoder threads per file.
+  bool pinThreads = false; // Pin file workers to disjoint CPU sets.
+};
+
+// Namespace: vidicant
+// Namespace containing the parallelism policy functions.
+namespace vidicant {
+
+// Resolves thread counts for a mode.
+// @param mode How to divide the cores.
+// @param jobs Files to analyze concurrently; 0 picks a default for the mode.
+// @param cores Cores to use; 0 uses the CPUs this process may run on.
+// @return The resolved policy.
+ParallelismPolicy makeParallelismPolicy(ParallelismMode mode, int jobs = 0,
+                                        int cores = 0);
+
+// Installs a policy process-wide and applies it to OpenCV's thread pool.
+// Video loaders opened afterwards use its decoder thread count.
+// @param policy The policy to install.
+void setParallelismPolicy(const ParallelismPolicy &policy);
+
+// Gets the installed policy; IntraFile over all cores until one is set.
+ParallelismPolicy getParallelismPolicy();
+
+// Parses "file", "intra" or "hybrid".
+// @param text The mode name.
+// @param mode Receives the parsed mode.
+// @return True if the name was recognized, false otherwise.
+bool parseParallelismMode(const std::string &text, ParallelismMode &mode);
+
+// Gets the name of a mode as accepted by parseParallelismMode.
+const char *parallelismModeName(ParallelismMode mode);
+
+// Gets the CPUs this process may run on, grouped by NUMA node.
+std::vector<int> getAvailableCpus();
+
+// Pins the calling thread to the CPU set of one file worker under the
+// installed policy: worker i gets threadsPerFile consecutive CPUs from
+// getAvailableCpus(), so workers stay within a NUMA node where the counts
+// allow. Threads the worker creates afterwards inherit the set.
+// @param workerIndex The index of the calling worker.
+// @return True if the thread was pinned, false if unsupported or failed.
+bool pinCurrentThread(int workerIndex);
+
+} // namespace vidicant
+
+#endif // VIDICANT_PARALLELISM_HPP
@@ -0,0 +1,54 @@
+// File: phash.hpp
+// Header file for perceptual hashing in the Vidicant library.
+//
+// This file defines 64-bit difference (dHash) and DCT (pHash) fingerprints
+// that stay stable under re-encoding, resizing and small edits. Analysis
+// computes them from frames it decodes anyway: images through the metric
+// engine (PerceptualHashMetric), and video keyframes in the frame series
+// pass (VideoHandler::getFrameSeries).
+
+#ifndef VIDICANT_PHASH_HPP
+#define VIDICANT_PHASH_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace cv {
+class Mat;
+} // namespace cv
+
+// Struct: PerceptualHash
+// The pair of fingerprints computed for one image or frame.
+struct PerceptualHash {
+  std::uint64_t dHash = 0; // Gradient-direction hash over a 9x8 thumbnail.
+  std::uint64_t pHash = 0; // Low-frequency DCT hash over a 32x32 thumbnail.
+};
+
+// Struct: FrameHash
+// Perceptual hash of one video keyframe.
+struct FrameHash {
+  int frameIndex = 0;      // Index of the hashed frame.
+  bool sceneStart = false; // True if the frame starts a new scene.
+  PerceptualHash hash;     // Fingerprints of the frame.
+};
+
+namespace vidicant {
+
+// Computes the dHash and pHash of a decoded image or frame.
+// @param image An 8-bit gray or BGR image.
+// @return The fingerprints, both zero for an empty image.
+PerceptualHash computePerceptualHash(const cv::Mat &image);
+
+// Counts the differing bits between two hashes.
+int hammingDistance(std::uint64_t a, std::uint64_t b);
+
+// Formats a hash as 16 lowercase hex digits.
+std::string formatHash(std::uint64_t hash);
+
+// Parses a hash from up to 16 hex digits.
+// @return True if the text was a valid hash.
+bool parseHash(const std::string &text, std::uint64_t &hash);
+
+} // namespace vidicant
+
+#endif // VIDICANT_PHASH_HPP
@@ -0,0 +1,116 @@
+// File: prefetch.hpp
+// Header file for read-ahead of input files in the Vidicant library.
+//
+// This file defines a prefetcher that reads the next files of a batch on
+// reader threads while workers analyze the current ones, so a worker
+// decoding from a network share finds its next file already fetched
+// instead of blocking on the read. Files small enough are read whole into
+// memory, for decoding from the buffer; larger ones, such as videos, have
+// their first and last bytes, where containers keep their headers and
+// indexes, pulled into the page cache before the decoder opens them.
+//
+// Reads on one storage device are limited to a few at once, so a batch
+// spread over several shares keeps each busy without flooding any, and
+// buffered bytes are capped.
+
+#ifndef VIDICANT_PREFETCH_HPP
+#define VIDICANT_PREFETCH_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Struct: PrefetchOptions
+// How far ahead and how hard to read.
+struct PrefetchOptions {
+  // Default cap on buffered bytes.
+  static constexpr std::uintmax_t kDefaultMaxBytes = 256ULL << 20;
+
+  // Default bytes warmed at each end of a file that is not buffered.
+  static constexpr std::uintmax_t kDefaultWarmBytes = 16ULL << 20;
+
+  std::size_t depth = 0;       // Files read ahead, 0 for none.
+  std::size_t deviceReads = 2; // Reads at once per storage device.
+  std::uintmax_t maxBytes = kDefaultMaxBytes;   // Buffered bytes at once.
+  std::uintmax_t warmBytes = kDefaultWarmBytes; // Bytes warmed per end.
+};
+
+// Struct: PrefetchRequest
+// One file to read ahead.
+struct PrefetchRequest {
+  std::string path;        // The file.
+  std::uintmax_t size = 0; // Its size in bytes, 0 if unknown.
+  bool buffer = false;     // Read it into memory rather than only warm it.
+};
+
+// Class: Prefetcher
+// Reads a list of files ahead of the workers that take them.
+//
+// Files are read in list order, at most depth files past the number taken
+// so far. A file is buffered only if its size is known and fits the
+// buffer cap; otherwise it is warmed. Its reads are not started if its
+// worker takes it first.
+class Prefetcher {
+public:
+  // Starts the reader threads.
+  // @param files The files, in the order workers are expected to take them.
+  // @param options Read-ahead depth, per-device reads and byte limits.
+  Prefetcher(std::vector<PrefetchRequest> files,
+             const PrefetchOptions &options);
+
+  // Stops reading, lets reads in progress finish and joins the readers.
+  ~Prefetcher();
+
+  Prefetcher(const Prefetcher &) = delete;
+  Prefetcher &operator=(const Prefetcher &) = delete;
+
+  // Takes a file, waiting for its read if one is in progress. Each file
+  // may be taken once.
+  // @param index The file's position in the list.
+  // @param bytes Receives the contents of a buffered file.
+  // @return True if bytes holds the whole file; false if it was warmed,
+  // not reached yet or unreadable, and the caller should open it itself.
+  bool take(std::size_t index, std::vector<unsigned char> &bytes);
+
+  // Gets the number of bytes read so far, buffered or warmed.
+  std::uintmax_t getBytesRead() const;
+
+private:
+  // Progress of one file.
+  enum class State { Queued, Reading, Done, Taken };
+
+  // One file and its read.
+  struct Item {
+    PrefetchRequest request;          // The file.
+    std::uint64_t device = 0;         // Storage device holding it.
+    State state = State::Queued;      // Progress.
+    bool ok = false;                  // Whether the read succeeded.
+    std::uintmax_t reserved = 0;      // Buffered bytes counted for it.
+    std::vector<unsigned char> bytes; // Contents, if buffered.
+  };
+
+  // Finds the next file a reader may start; the lock must be held.
+  bool findReadable(std::size_t &index);
+
+  // Reads files until stopped.
+  void readerLoop();
+
+  PrefetchOptions options_;      // Limits.
+  std::vector<Item> items_;      // Files in list order.
+  std::size_t first_ = 0;        // First file that may still be queued.
+  std::size_t taken_ = 0;        // Files taken so far.
+  std::uintmax_t buffered_ = 0;  // Bytes held or being read into items.
+  std::uintmax_t bytesRead_ = 0; // Bytes read so far.
+  std::map<std::uint64_t, std::size_t> deviceReads_; // Reads per device.
+  bool stopping_ = false;            // Set by the destructor.
+  mutable std::mutex mutex_;         // Guards all state above.
+  std::condition_variable changed_;  // Signals readers and takers.
+  std::vector<std::thread> readers_; // Reader threads.
+};
+
+#endif // VIDICANT_PREFETCH_HPP
@@ -0,0 +1,58 @@
+// File: probe.hpp
+// Header file for cheap media probes in the Vidicant library.
+//
+// This file defines functions that read just enough of a file to estimate
+// the cost of analyzing it: image dimensions from the format header (JPEG,
+// PNG, GIF, BMP, WebP, TIFF) without decoding any pixels, the frame count
+// and duration of animated GIF and WebP files, and video resolution and
+// frame count from the MP4, QuickTime or AVI headers, without opening a
+// decoder. Schedulers use them to
+// order work and to bound the memory of concurrently decoded files.
+
+#ifndef VIDICANT_PROBE_HPP
+#define VIDICANT_PROBE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Struct: MediaProbe
+// What a probe learned about one file.
+struct MediaProbe {
+  bool ok = false;             // True if the dimensions are known.
+  int width = -1;              // Width in pixels.
+  int height = -1;             // Height in pixels.
+  int frameCount = 1;          // Frames; 1 for still images.
+  double duration = 0.0;       // Seconds an animation plays, 0 if unknown.
+  int bitDepth = 8;            // Bits per sample; 8 unless the header says.
+  std::uintmax_t fileSize = 0; // Size of the file in bytes.
+};
+
+// Namespace: vidicant
+// Namespace containing the probe functions.
+namespace vidicant {
+
+// Reads image dimensions from the file header without decoding pixels.
+// For GIF and animated WebP the frames are counted by walking the file's
+// blocks, still without decoding them.
+// @param filename The path to the image.
+// @return The probe; ok is false for unrecognized or truncated headers.
+MediaProbe probeImage(const std::string &filename);
+
+// Reads video resolution, frame count and duration from the container
+// headers of MP4, QuickTime and AVI files, or from the headers of an
+// animated image, image sequence or video proxy. No decoder is opened.
+// @param filename The path to the video.
+// @return The probe; ok is false for other containers and for unreadable
+// or truncated headers.
+MediaProbe probeVideo(const std::string &filename);
+
+// Reads the EXIF orientation tag from the payload of a JPEG APP1 segment.
+// @param data The segment payload, starting at "Exif".
+// @param length Bytes in the payload.
+// @return The orientation (1-8); 1 if the segment has no such tag.
+int readExifOrientation(const unsigned char *data, std::size_t length);
+
+} // namespace vidicant
+
+#endif // VIDICANT_PROBE_HPP
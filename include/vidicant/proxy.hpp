@@ -0,0 +1,186 @@
+// File: proxy.hpp
+// Header file for the video proxy cache in the Vidicant library.
+//
+// This file defines proxies: sidecar files that hold every frame of a video
+// downscaled to a few hundred rows, with each frame's timestamp. A proxy is
+// built in one decode of the source; later analyses read its memory-mapped
+// frames through ProxyVideoLoader instead of decoding H.264 or HEVC again,
+// so re-running a video with other thresholds or metrics costs a copy per
+// frame. Proxies hold luma only unless the analyses that build them need
+// color, which triples their size.
+//
+// Proxies live in a cache directory, named after a hash of the source path,
+// and record the source's size and modification time; a source that changed
+// is decoded again. The directory is kept under a size limit by deleting
+// the least recently used proxies, and a proxy's modification time marks
+// its last use.
+//
+// The proxy layout, all fields in host byte order, is
+//   header | frames[frameCount] | timestamps[frameCount]
+// where each frame is width * height * channels bytes of 8-bit pixels, and
+// each timestamp a double in milliseconds.
+
+#ifndef VIDICANT_PROXY_HPP
+#define VIDICANT_PROXY_HPP
+
+#include "vidicant/deadline.hpp"
+#include "vidicant/mapped_file.hpp"
+#include "vidicant/video.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Struct: ProxyOptions
+// Where proxies are kept and how they are built.
+struct ProxyOptions {
+  // Default rows of proxy frames.
+  static constexpr int kDefaultHeight = 144;
+
+  std::string directory;       // Cache directory; created if missing.
+  int height = kDefaultHeight; // Rows of proxy frames.
+  bool color = false;          // Keep BGR frames, not luma alone.
+  std::uintmax_t maxBytes = 0; // Cache size limit, 0 for no limit.
+};
+
+// Struct: ProxyInfo
+// What a proxy holds and which source it was built from.
+struct ProxyInfo {
+  std::uint64_t sourceBytes = 0; // Size of the source file.
+  std::int64_t sourceTime = 0;   // Modification time of the source.
+  cv::Size sourceSize;           // Frame size of the source.
+  cv::Size frameSize;            // Frame size of the proxy.
+  int channels = 0;              // 1 for luma, 3 for BGR.
+  int frameCount = 0;            // Frames stored.
+  double fps = 0.0;              // Frame rate of the source.
+};
+
+// Class: ProxyWriter
+// Writes a proxy file one frame at a time.
+class ProxyWriter {
+public:
+  // Creates a proxy file; its header is written by finish().
+  // @param filename The path of the proxy file.
+  // @param info The source's size, time, frame size and rate, and the
+  // proxy's frame size and channels; the frame count is counted.
+  // @return True if the file was created.
+  bool open(const std::string &filename, const ProxyInfo &info);
+
+  // Downscales a decoded frame to the proxy's size and appends it.
+  // @param frame An 8-bit frame of the source.
+  // @param timestamp Presentation time of the frame, in milliseconds.
+  // @return True if the frame was written.
+  bool addFrame(const cv::Mat &frame, double timestamp);
+
+  // Appends the timestamps and writes the header.
+  // @return True if the proxy is complete.
+  bool finish();
+
+private:
+  std::ofstream output_;           // The proxy being written.
+  ProxyInfo info_;                 // Header fields.
+  std::vector<double> timestamps_; // Timestamps of the frames written.
+  cv::Mat scaled_;                 // Downscaled frame.
+  cv::Mat gray_;                   // Luma of the downscaled frame.
+};
+
+// Class: ProxyVideoLoader
+// IVideoLoader over the frames of a proxy file.
+//
+// The frame count, rate and resolution reported are those of the source;
+// frames come at the proxy's size.
+class ProxyVideoLoader : public IVideoLoader {
+public:
+  // Maps a proxy file.
+  // @param filename The path to the proxy.
+  // @return True if the file is a complete proxy, false otherwise.
+  bool open(const std::string &filename) override;
+
+  // Gets the number of frames stored.
+  int getFrameCount() override;
+
+  // Gets the frame rate of the source.
+  double getFPS() override;
+
+  // Gets the resolution of the source.
+  std::pair<int, int> getResolution() override;
+
+  // Copies the next frame out of the mapping.
+  cv::Mat readFrame() override;
+
+  // Copies the next frame into an existing buffer.
+  bool readFrame(cv::Mat &frame) override;
+
+  // Advances past the next frame without copying it.
+  bool skipFrame() override;
+
+  // Gets the timestamp stored with the last frame read.
+  double getTimestamp() override;
+
+  // Moves to a stored frame.
+  bool seekFrame(int index) override;
+
+  // Gets the proxy's header fields.
+  const ProxyInfo &getInfo() const;
+
+private:
+  MappedFile file_;                           // The mapped proxy.
+  ProxyInfo info_;                            // Header fields.
+  const unsigned char *frames_ = nullptr;     // First frame in the mapping.
+  const unsigned char *timestamps_ = nullptr; // First timestamp.
+  int index_ = 0;                             // Next frame to read.
+};
+
+// Namespace: vidicant
+// Namespace containing video proxy cache functions.
+namespace vidicant {
+
+// Checks whether a path names a proxy file, by its .vproxy extension.
+bool isVideoProxy(const std::string &filename);
+
+// Gets the path of a source's proxy in a cache directory.
+// @param source The path to the video.
+// @param directory The cache directory.
+// @return The proxy path, named after a hash of the absolute source path.
+std::string getProxyPath(const std::string &source,
+                         const std::string &directory);
+
+// Decodes a video once and writes its proxy.
+// @param source The path to the video.
+// @param proxyPath The path of the proxy to write.
+// @param options Frame height and color of the proxy, and the size limit
+// the estimated proxy must fit.
+// @param deadline When to give up; an unfinished proxy is deleted.
+// @return True if the proxy was written.
+bool buildVideoProxy(const std::string &source, const std::string &proxyPath,
+                     const ProxyOptions &options,
+                     const Deadline &deadline = Deadline());
+
+// Finds an up-to-date proxy of a video in the cache, building it if there
+// is none or the one there is stale, of another height or lacks color, and
+// evicts the least recently used proxies beyond the size limit.
+// @param source The path to the video file.
+// @param options The cache directory, proxy format and size limit.
+// @param deadline When to stop building.
+// @param built Set to whether this call built the proxy, if given.
+// @return The proxy path, or empty if the source cannot be proxied (not a
+// regular file, undecodable, larger than the limit, or out of time).
+std::string ensureVideoProxy(const std::string &source,
+                             const ProxyOptions &options,
+                             const Deadline &deadline = Deadline(),
+                             bool *built = nullptr);
+
+// Deletes the least recently used proxies of a cache directory until the
+// rest fit a size limit, and partial proxies that crashed builds left
+// behind, untouched for an hour.
+// @param directory The cache directory.
+// @param maxBytes The size limit; 0 deletes only stale partial proxies.
+// @param keep A proxy that is never deleted, e.g. the one in use.
+// @return The number of files deleted.
+int evictVideoProxies(const std::string &directory, std::uintmax_t maxBytes,
+                      const std::string &keep = {});
+
+} // namespace vidicant
+
+#endif // VIDICANT_PROXY_HPP
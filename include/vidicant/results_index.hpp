@@ -0,0 +1,142 @@
+// File: results_index.hpp
+// Header file for the queryable results index in the Vidicant library.
+//
+// This file defines an on-disk columnar index over scalar analysis results.
+// Every metric becomes a column holding a dense per-row array and the same
+// values sorted with their row ids, next to a path dictionary. Range
+// predicates are binary searches into the sorted arrays and top-k queries
+// walk them from either end, so queries over millions of memory-mapped rows
+// touch only the rows they return.
+
+#ifndef VIDICANT_RESULTS_INDEX_HPP
+#define VIDICANT_RESULTS_INDEX_HPP
+
+#include "vidicant/mapped_file.hpp"
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Enum: ResultKind
+// Media type of an indexed result.
+enum class ResultKind : std::uint8_t { Image = 0, Video = 1 };
+
+// Struct: ColumnPredicate
+// Bounds on one column; a row matches if its value lies between them.
+struct ColumnPredicate {
+  std::string column; // Column name.
+  double min = -std::numeric_limits<double>::infinity(); // Lower bound.
+  double max = std::numeric_limits<double>::infinity();  // Upper bound.
+  bool minInclusive = true; // True if min itself matches.
+  bool maxInclusive = true; // True if max itself matches.
+};
+
+// Class: ResultsIndexWriter
+// Collects result rows in memory and writes them as an index file.
+class ResultsIndexWriter {
+public:
+  // Adds a row for one analyzed file.
+  // @param path The file's path.
+  // @param kind The file's media type.
+  // @return The row id.
+  std::uint32_t addRow(const std::string &path, ResultKind kind);
+
+  // Sets a scalar value of a row, creating the column on first use.
+  // @param row A row id returned by addRow.
+  // @param column The column name.
+  // @param value The value; NaN is treated as missing.
+  void set(std::uint32_t row, const std::string &column, double value);
+
+  // Gets the number of rows added so far.
+  std::size_t size() const;
+
+  // Writes the index file.
+  // @param filename The path of the index file to create.
+  // @return True if the file was written successfully, false otherwise.
+  bool write(const std::string &filename) const;
+
+private:
+  std::vector<std::string> paths_; // Path per row.
+  std::vector<ResultKind> kinds_;  // Media type per row.
+  std::map<std::string, std::vector<std::pair<std::uint32_t, double>>>
+      columns_; // Present (row, value) pairs per column.
+};
+
+// Class: ResultsIndex
+// Read-only, memory-mapped view of a results index file.
+class ResultsIndex {
+public:
+  // Opens and maps an index file.
+  // @param filename The path to the index file.
+  // @return True if the file is a valid index, false otherwise.
+  bool open(const std::string &filename);
+
+  // Gets the number of indexed rows.
+  std::size_t size() const;
+
+  // Gets the column names in sorted order.
+  std::vector<std::string> getColumns() const;
+
+  // Finds a column by name.
+  // @param name The column name.
+  // @return The column number, or -1 if there is no such column.
+  int findColumn(const std::string &name) const;
+
+  // Gets the number of rows that have a value in a column.
+  std::size_t getPresentCount(int column) const;
+
+  // Finds the rows matching every predicate.
+  // @param predicates Bounds on columns; rows without a value never match.
+  // @return Matching row ids in ascending order; all rows if there are no
+  // predicates, none if a predicate names an unknown column.
+  std::vector<std::uint32_t>
+  query(const std::vector<ColumnPredicate> &predicates) const;
+
+  // Finds the rows with the largest or smallest values of a column.
+  // @param column The column number.
+  // @param k The number of rows wanted.
+  // @param largest True for the largest values, false for the smallest.
+  // @param candidates Ascending row ids to choose from, or nullptr for all.
+  // @return Up to k row ids, best first.
+  std::vector<std::uint32_t>
+  top(int column, std::size_t k, bool largest,
+      const std::vector<std::uint32_t> *candidates = nullptr) const;
+
+  // Gets a row's value in a column.
+  // @return The value, or NaN if the row has none.
+  double getValue(std::uint32_t row, int column) const;
+
+  // Gets a row's path.
+  // @return The path, or an empty string if the row or its offsets are
+  // out of range.
+  std::string getPath(std::uint32_t row) const;
+
+  // Gets a row's media type.
+  ResultKind getKind(std::uint32_t row) const;
+
+private:
+  // Column arrays inside the mapping.
+  struct Column {
+    std::string name;                    // Column name.
+    std::uint64_t present = 0;           // Rows with a value.
+    const double *dense = nullptr;       // Value per row, NaN if missing.
+    const double *sorted = nullptr;      // Present values, ascending.
+    const std::uint32_t *rows = nullptr; // Row id of each sorted value.
+  };
+
+  // Finds the sorted positions [begin, end) of a predicate's values.
+  std::pair<std::size_t, std::size_t>
+  sortedRange(const Column &column, const ColumnPredicate &predicate) const;
+
+  MappedFile file_;                            // Mapped index file.
+  std::uint64_t rowCount_ = 0;                 // Number of rows.
+  const std::uint8_t *kinds_ = nullptr;        // Media type per row.
+  const std::uint64_t *pathOffsets_ = nullptr; // Path start per row.
+  const char *paths_ = nullptr;                // Concatenated path bytes.
+  std::uint64_t pathsSize_ = 0;                // Bytes of path data.
+  std::vector<Column> columns_;                // Columns sorted by name.
+};
+
+#endif // VIDICANT_RESULTS_INDEX_HPP
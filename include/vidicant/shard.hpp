@@ -0,0 +1,52 @@
+// File: shard.hpp
+// Header file for splitting a corpus across machines in the Vidicant
+// library.
+//
+// This file defines shards: the N disjoint parts of an input set that N
+// independent runs analyze, with no coordinator between them. A file's
+// shard depends only on its path, hashed with a function fixed across
+// builds and platforms, so every run computes the same split and a file
+// keeps its shard as others are added to or removed from the corpus.
+
+#ifndef VIDICANT_SHARD_HPP
+#define VIDICANT_SHARD_HPP
+
+#include <cstdint>
+#include <string>
+
+// Struct: Shard
+// One of the parts an input set is split into.
+struct Shard {
+  int index = 0; // Part analyzed, from 0 to count - 1.
+  int count = 1; // Number of parts.
+};
+
+// Namespace: vidicant
+// Namespace containing sharding functions.
+namespace vidicant {
+
+// Parses a shard written as "i/N", such as "0/50".
+// @param text The shard.
+// @param shard Receives the shard.
+// @return True if N is positive and i lies in [0, N).
+bool parseShard(const std::string &text, Shard &shard);
+
+// Hashes a path for sharding. Paths that are equal after lexical
+// normalization ("./a/../b" and "b") hash alike; no filesystem access is
+// made, so the same file must be named by the same path on every machine.
+// @param path The path as it appears in results.
+// @return The 64-bit hash.
+std::uint64_t hashShardPath(const std::string &path);
+
+// Gets the shard a path falls in.
+// @param path The path as it appears in results.
+// @param count The number of shards.
+// @return The shard index, from 0 to count - 1.
+int getPathShard(const std::string &path, int count);
+
+// Checks whether a path falls in a shard.
+bool isInShard(const std::string &path, const Shard &shard);
+
+} // namespace vidicant
+
+#endif // VIDICANT_SHARD_HPP
@@ -0,0 +1,74 @@
+// File: thread_pool.hpp
+// Header file for the worker thread pool in the Vidicant library.
+//
+// This file defines a fixed-size pool of worker threads fed from a FIFO
+// task queue. The queue can be bounded, in which case submit() blocks while
+// it is full; that gives producers (directory walkers, socket readers)
+// natural backpressure instead of unbounded memory growth.
+
+#ifndef VIDICANT_THREAD_POOL_HPP
+#define VIDICANT_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Class: ThreadPool
+// Fixed set of worker threads executing submitted tasks in FIFO order.
+class ThreadPool {
+public:
+  // Creates the pool and starts its workers.
+  // @param workers Number of worker threads; 0 uses the hardware
+  // concurrency.
+  // @param queueCapacity Maximum number of pending tasks; 0 is unbounded.
+  // @param onStart Called on each worker thread with its index before it
+  // takes any task, e.g. to pin the thread to CPUs.
+  explicit ThreadPool(std::size_t workers = 0, std::size_t queueCapacity = 0,
+                      std::function<void(std::size_t)> onStart = nullptr);
+
+  // Finishes all pending tasks and joins the workers.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Queues a task, blocking while the queue is at capacity.
+  // Must not be called from a worker of a bounded pool, which could
+  // deadlock waiting on itself.
+  // @param task The task to run on a worker thread.
+  void submit(std::function<void()> task);
+
+  // Queues a task if there is room, without blocking.
+  // @param task The task to run on a worker thread.
+  // @return True if the task was queued, false if the queue was full.
+  bool trySubmit(std::function<void()> task);
+
+  // Blocks until the queue is empty and no task is running.
+  void wait();
+
+  // Gets the number of worker threads.
+  std::size_t size() const;
+
+  // Gets the number of queued tasks not yet picked up by a worker.
+  std::size_t pending() const;
+
+private:
+  void workerLoop(std::size_t index);
+
+  std::function<void(std::size_t)> onStart_; // Worker start hook.
+  std::vector<std::thread> workers_;         // Worker threads.
+  std::deque<std::function<void()>> queue_;  // Pending tasks.
+  std::size_t capacity_;                     // Queue bound, 0 if unbounded.
+  std::size_t active_ = 0;                   // Tasks currently running.
+  bool stopping_ = false;                    // Set by the destructor.
+  mutable std::mutex mutex_;                 // Guards all state above.
+  std::condition_variable taskReady_;        // Signals workers.
+  std::condition_variable spaceReady_;       // Signals blocked submitters.
+  std::condition_variable idle_;             // Signals wait().
+};
+
+#endif // VIDICANT_THREAD_POOL_HPP
@@ -0,0 +1,257 @@
+// File: tiled.hpp
+// Header file for bounded-memory image analysis in the Vidicant library.
+//
+// This file defines interfaces and classes for decoding an image as a
+// sequence of horizontal strips and folding each strip into mergeable
+// accumulators. Peak memory stays proportional to the strip size rather than
+// the full image, which keeps very large scans and TIFFs analyzable.
+
+#ifndef VIDICANT_TILED_HPP
+#define VIDICANT_TILED_HPP
+
+#include "vidicant/deadline.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cv {
+class Mat;
+} // namespace cv
+
+// Struct: ImageTileStats
+// Mergeable accumulators for whole-image metrics.
+//
+// Each field is a sum, count or histogram that can be combined across strips
+// without revisiting pixels. The accessor methods turn the accumulated state
+// into the same values ImageHandler reports for a fully decoded image.
+struct ImageTileStats {
+  int width = 0;    // Image width in pixels.
+  int height = 0;   // Image height in pixels.
+  int channels = 0; // Number of color channels in the decoded strips.
+
+  std::uint64_t pixelCount = 0;        // Pixels folded so far.
+  std::array<double, 3> channelSums{}; // Per-channel value sums.
+  std::vector<std::array<std::uint64_t, 256>>
+      histogram; // Per-channel value histograms.
+  std::array<std::uint64_t, 256> grayHistogram{}; // Luma histogram.
+  double saturationSum = 0.0;  // Sum of HSV saturation values.
+  double laplacianSum = 0.0;   // Sum of Laplacian responses.
+  double laplacianSumSq = 0.0; // Sum of squared responses.
+  std::uint64_t edgeCount = 0; // Canny edge pixels.
+  std::vector<std::array<float, 3>>
+      colorSamples; // Subsampled pixels for dominant color clustering.
+
+  // Combines another set of accumulators into this one.
+  // @param other Accumulators from a disjoint set of rows.
+  void merge(const ImageTileStats &other);
+
+  // Gets the share of the image's pixels folded, below 1 when analysis
+  // stopped at a deadline.
+  // @return The coverage (0-1), or 0 for an empty image.
+  double getCoverage() const;
+
+  // Gets the average brightness across all channels.
+  // @return The average brightness (0-255), or -1 if nothing was folded.
+  double getAverageBrightness() const;
+
+  // Gets the Laplacian variance blur score.
+  // @return The blur score, or -1 if nothing was folded.
+  double getBlurScore() const;
+
+  // Gets the max/min luma contrast ratio.
+  // @return The contrast ratio, or -1 if nothing was folded.
+  double getContrastRatio() const;
+
+  // Gets the average HSV saturation.
+  // @return The saturation level (0-255), or -1 for non-color images.
+  double getSaturationLevel() const;
+
+  // Gets the Shannon entropy of the luma histogram.
+  // @return The entropy in bits, or -1 if nothing was folded.
+  double getEntropy() const;
+
+  // Gets the per-channel histograms as plain counts, with the 8-bit values
+  // binned as the histogram metric bins them.
+  // @param bins Bins per channel.
+  // @return One histogram per channel.
+  std::vector<std::vector<int>> getHistogram(int bins = 256) const;
+
+  // Clusters the sampled pixels into dominant colors.
+  // @param k The number of colors to extract.
+  // @param deadline When the clustering stops iterating.
+  // @return A vector of BGR color centers.
+  std::vector<std::array<double, 3>>
+  getDominantColors(int k = 3, const Deadline &deadline = {}) const;
+};
+
+// Class: IImageStripReader
+// Abstract interface for decoding an image a band of rows at a time.
+//
+// Implementations decode as little of the image as their format allows
+// and hand out consecutive 8-bit BGR strips from top to bottom.
+class IImageStripReader {
+public:
+  // Virtual destructor for proper cleanup of derived classes.
+  virtual ~IImageStripReader() = default;
+
+  // Opens an image file for strip reading.
+  // @param filename The path to the image file.
+  // @return True if the image was opened successfully, false otherwise.
+  virtual bool open(const std::string &filename) = 0;
+
+  // Gets the dimensions (width, height) of the opened image.
+  virtual std::pair<int, int> getDimensions() = 0;
+
+  // Reads the next strip of rows into the given matrix.
+  // @param strip Destination for the strip; its buffer may be reused.
+  // @return True if a strip was read, false at the end of the image.
+  virtual bool readStrip(cv::Mat &strip) = 0;
+};
+
+// Class: OpenCVImageStripReader
+// Fallback strip reader that decodes the whole image with OpenCV.
+//
+// This reader is used for formats without native strip decoding. The
+// decoded image is still held in full, but every derived buffer (gray,
+// HSV, float copies) is only ever strip-sized.
+class OpenCVImageStripReader : public IImageStripReader {
+public:
+  // Constructs a reader that hands out strips of the given height.
+  explicit OpenCVImageStripReader(int stripRows = 256);
+  ~OpenCVImageStripReader() override;
+
+  bool open(const std::string &filename) override;
+  std::pair<int, int> getDimensions() override;
+  bool readStrip(cv::Mat &strip) override;
+
+private:
+  std::unique_ptr<cv::Mat> image_; // Fully decoded image.
+  int stripRows_;                  // Rows per strip.
+  int nextRow_ = 0;                // First row of the next strip.
+};
+
+// Class: TiffImageStripReader
+// Strip reader over libtiff's native strips and tiles.
+//
+// Available when Vidicant is built with libtiff; otherwise open() always
+// fails. Memory is bounded by one row of tiles or one TIFF strip.
+class TiffImageStripReader : public IImageStripReader {
+public:
+  TiffImageStripReader();
+  ~TiffImageStripReader() override;
+
+  bool open(const std::string &filename) override;
+  std::pair<int, int> getDimensions() override;
+  bool readStrip(cv::Mat &strip) override;
+
+private:
+  struct State;
+  std::unique_ptr<State> state_; // libtiff handle and read position.
+};
+
+// Class: JpegImageStripReader
+// Strip reader over libjpeg's scanline decoder.
+//
+// Available when Vidicant is built with libjpeg; otherwise open() always
+// fails. Baseline JPEGs decode in bands of scanlines; progressive JPEGs
+// buffer coefficients internally but never a full decoded pixel image.
+class JpegImageStripReader : public IImageStripReader {
+public:
+  // Constructs a reader that hands out strips of the given height.
+  explicit JpegImageStripReader(int stripRows = 256);
+  ~JpegImageStripReader() override;
+
+  bool open(const std::string &filename) override;
+  std::pair<int, int> getDimensions() override;
+  bool readStrip(cv::Mat &strip) override;
+
+private:
+  struct State;
+  std::unique_ptr<State> state_; // libjpeg decompressor and read position.
+  int stripRows_;                // Rows per strip.
+};
+
+// Class: PngImageStripReader
+// Strip reader over libpng's row decoder.
+//
+// Available when Vidicant is built with libpng; otherwise open() always
+// fails. Interlaced PNGs cannot be read row by row, so open() rejects them
+// and callers fall back to OpenCV.
+class PngImageStripReader : public IImageStripReader {
+public:
+  // Constructs a reader that hands out strips of the given height.
+  explicit PngImageStripReader(int stripRows = 256);
+  ~PngImageStripReader() override;
+
+  bool open(const std::string &filename) override;
+  std::pair<int, int> getDimensions() override;
+  bool readStrip(cv::Mat &strip) override;
+
+private:
+  struct State;
+  std::unique_ptr<State> state_; // libpng reader and read position.
+  int stripRows_;                // Rows per strip.
+};
+
+// Class: TiledImageHandler
+// Analyzes an image strip by strip using a strip reader.
+//
+// Strips are folded into ImageTileStats with a small halo of neighboring
+// rows, so neighborhood metrics (blur, edges) see the same pixels they
+// would on the full image. The Laplacian blur score is exact; Canny edge
+// counts can differ slightly because hysteresis cannot follow an edge
+// further than the halo across a strip boundary.
+class TiledImageHandler {
+private:
+  std::unique_ptr<IImageStripReader>
+      reader_; // Pointer to the strip reader implementation.
+
+public:
+  // Rows of context kept above and below each folded band.
+  static constexpr int kHaloRows = 8;
+
+  // Constructs a TiledImageHandler with the specified reader.
+  explicit TiledImageHandler(std::unique_ptr<IImageStripReader> reader);
+
+  // Analyzes the image strip by strip.
+  // @param filename The path to the image file.
+  // @param maxColorSamples Upper bound on pixels kept for dominant colors.
+  // @param deadline When to stop reading strips; the statistics then cover
+  // the rows above the last strip read.
+  // @return The accumulated statistics; width is -1 if the image failed to
+  // open.
+  ImageTileStats analyze(const std::string &filename,
+                         int maxColorSamples = 65536,
+                         const Deadline &deadline = Deadline());
+
+  // Folds rows [begin, end) of a band into the statistics.
+  // @param band Decoded rows including any halo context.
+  // @param bandTop Image row index of the band's first row.
+  // @param begin First image row to fold.
+  // @param end One past the last image row to fold.
+  // @param sampleStep Pixel stride used for dominant color samples.
+  // @param stats Accumulators to update.
+  static void foldRows(const cv::Mat &band, int bandTop, int begin, int end,
+                       int sampleStep, ImageTileStats &stats);
+};
+
+namespace vidicant {
+
+// Creates the most memory-efficient strip reader available for a file.
+// @param filename The path to the image file.
+// @param stripRows Rows per strip for readers that support it.
+// @return A native reader for TIFF/JPEG/PNG when built in, else OpenCV.
+std::unique_ptr<IImageStripReader>
+makeImageStripReader(const std::string &filename, int stripRows = 256);
+
+// Convenience function to analyze an image in bounded memory.
+ImageTileStats analyzeImageTiled(const std::string &filename,
+                                 int stripRows = 256,
+                                 const Deadline &deadline = Deadline());
+
+} // namespace vidicant
+
+#endif // VIDICANT_TILED_HPP
@@ -0,0 +1,69 @@
+// File: trace.hpp
+// Header file for timeline tracing in the Vidicant library.
+//
+// This file defines spans that record when each step of an analysis ran
+// and on which thread: opening and decoding files, color conversion, each
+// metric, serialization and waits on queues. The recorded timeline is
+// written in the Chrome trace-event format, which Perfetto and
+// chrome://tracing load, so decoder stalls, idle workers and contention
+// show up where aggregate timings would average them away.
+//
+// Each thread appends its events to a buffer of its own, so recording
+// takes no lock; a thread's first event registers its buffer once. While
+// tracing is off a span costs one flag check.
+
+#ifndef VIDICANT_TRACE_HPP
+#define VIDICANT_TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Class: TraceSpan
+// Records the time from its construction to its destruction as one event
+// on the calling thread's timeline.
+class TraceSpan {
+public:
+  // Opens a span if tracing is on.
+  // @param name The event name; must outlive the process's tracing, as
+  // string literals and registry names do.
+  // @param detail Optional text shown with the event, such as a filename.
+  explicit TraceSpan(const char *name, const std::string &detail = {});
+
+  // Closes the span and records it.
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+  const char *name_;   // Event name.
+  std::string detail_; // Text shown with the event.
+  std::int64_t start_; // Start, in nanoseconds since tracing started.
+  bool active_;        // Whether tracing was on at opening.
+};
+
+// Namespace: vidicant
+// Namespace containing timeline tracing functions.
+namespace vidicant {
+
+// Starts recording spans; the first call sets time zero of the timeline,
+// later calls do nothing.
+void startTracing();
+
+// Checks whether spans are being recorded.
+bool isTracingEnabled();
+
+// Gets the number of events recorded on every thread so far.
+std::size_t getTraceEventCount();
+
+// Writes every event recorded so far as a Chrome trace-event JSON file.
+// Threads may keep recording while it runs; their later events are left
+// out.
+// @param path The file to write.
+// @return True if the file was written.
+bool writeTrace(const std::string &path);
+
+} // namespace vidicant
+
+#endif // VIDICANT_TRACE_HPP
@@ -9,6 +9,12 @@
 #ifndef VIDICANT_VIDEO_HPP
 #define VIDICANT_VIDEO_HPP
 
+#include "vidicant/active_area.hpp"
+#include "vidicant/color_model.hpp"
+#include "vidicant/deadline.hpp"
+#include "vidicant/frame_pool.hpp"
+#include "vidicant/frame_series.hpp"
+#include "vidicant/phash.hpp"
 #include <memory>
 #include <opencv2/core.hpp>
 #include <opencv2/videoio.hpp>
@@ -45,6 +51,29 @@ public:
 
   // Reads the next frame from the video.
   virtual cv::Mat readFrame() = 0;
+
+  // Reads the next frame into an existing buffer, reusing its memory when
+  // the frame size is unchanged. The default implementation falls back to
+  // readFrame() and therefore allocates.
+  // @param frame Destination for the decoded frame.
+  // @return True if a frame was read, false at the end of the video.
+  virtual bool readFrame(cv::Mat &frame);
+
+  // Advances past the next frame without returning it. Implementations
+  // that can skip the color conversion of unused frames should override
+  // this; the default reads and discards the frame.
+  // @return True if a frame was skipped, false at the end of the video.
+  virtual bool skipFrame();
+
+  // Gets the presentation time of the last frame read or skipped.
+  // @return The time in milliseconds, or -1 if the loader does not know.
+  virtual double getTimestamp();
+
+  // Moves to a frame, so the next read returns it. Loaders that cannot
+  // seek keep the default, which fails and stays in place.
+  // @param index Zero-based frame index.
+  // @return True if the next read returns that frame.
+  virtual bool seekFrame(int index);
 };
 
 // Class: OpenCVVideoLoader
@@ -70,10 +99,31 @@ public:
   // Reads the next frame using OpenCV.
   cv::Mat readFrame() override;
 
+  // Reads the next frame into an existing buffer using OpenCV.
+  bool readFrame(cv::Mat &frame) override;
+
+  // Skips the next frame with VideoCapture::grab, which does not convert
+  // it to BGR.
+  bool skipFrame() override;
+
+  // Gets the position VideoCapture reports for the last frame.
+  double getTimestamp() override;
+
+  // Seeks with VideoCapture's frame position property.
+  bool seekFrame(int index) override;
+
 private:
   cv::VideoCapture cap_; // OpenCV VideoCapture object for video operations.
 };
 
+// Struct: ScenePalette
+// Dominant colors of one scene of a video.
+struct ScenePalette {
+  int startFrame = 0;               // First frame of the scene.
+  int endFrame = 0;                 // One past the last frame read.
+  std::vector<PaletteColor> colors; // Palette, heaviest color first.
+};
+
 // Class: VideoHandler
 // High-level handler for video analysis operations.
 //
@@ -83,8 +133,24 @@ private:
 class VideoHandler {
 private:
   std::unique_ptr<IVideoLoader>
-      loader_;           // Pointer to the video loader implementation.
-  std::string filename_; // Stored filename for reopening if needed.
+      loader_;               // Pointer to the video loader implementation.
+  std::string filename_;     // Stored filename for reopening if needed.
+  FrameArena arena_;         // Reusable frame and scratch buffers.
+  cv::Rect area_;            // Area analyzed, empty for the full frame.
+  Deadline deadline_;        // When frame loops stop early.
+  bool interrupted_ = false; // Whether a loop stopped at the deadline.
+  double coverage_ = 1.0;    // Share of the frames a cut loop reached.
+
+  // Gets the part of a frame that analyses read: a view of the active
+  // area if one is set, the frame itself otherwise.
+  cv::Mat activeView(const cv::Mat &frame) const;
+
+  // Checks the deadline before a frame loop reads its next frame, and
+  // records how far the loop got if it has passed.
+  // @param done Frames the loop has read.
+  // @param planned Frames the loop would read without a deadline.
+  // @return True if the loop should stop.
+  bool outOfTime(int done, int planned);
 
 public:
   // Constructs a VideoHandler with the specified loader.
@@ -133,10 +199,23 @@ public:
   // @return A motion score (higher values indicate more motion).
   double getMotionScore();
 
-  // Extracts dominant colors from the video frames.
+  // Extracts dominant colors from frames sampled across the whole video.
+  // Sampled pixels are folded into a fixed-size ColorHistogramModel, so
+  // memory does not grow with the resolution or duration. With a deadline
+  // set and a loader that can seek, the samples are visited coarse to fine
+  // (first, middle, quarters, ...), so a pass cut short still spans the
+  // video.
   // @return A vector of arrays representing dominant colors in RGB format.
   std::vector<std::array<double, 3>> getDominantColors();
 
+  // Extracts a palette per scene, splitting the video where the mean gray
+  // difference between consecutive frames exceeds the threshold.
+  // @param threshold Mean gray difference that marks a scene change.
+  // @param colors Colors per palette.
+  // @return One palette per scene, in frame order.
+  std::vector<ScenePalette> getScenePalettes(double threshold = 30.0,
+                                             int colors = 3);
+
   // Detects scene changes in the video.
   // @return A vector of frame indices where scene changes occur.
   std::vector<int> detectSceneChanges(double threshold = 30.0);
@@ -148,6 +227,60 @@ public:
   // Calculates color consistency across frames.
   // @return Color consistency score (higher means more consistent).
   double getColorConsistency();
+
+  // Detects scene changes and fingerprints keyframes in the same pass.
+  // Keyframes are the first frame, the first frame of every scene, and
+  // every keyframeInterval-th frame in between.
+  // @param threshold Mean gray difference that marks a scene change.
+  // @param keyframeInterval Frames between periodic keyframes; 0 disables.
+  // @return One entry per keyframe, in frame order.
+  std::vector<FrameHash> getKeyframeHashes(double threshold = 30.0,
+                                           int keyframeInterval = 0);
+
+  // Measures brightness, frame difference, histogram change and saturation
+  // for every frame in one decode pass, so scene thresholds and charts can
+  // be evaluated later without decoding again.
+  // @param maxFrames Frames to measure; 0 measures the whole video.
+  // @param keyframes If not null, receives the keyframes getKeyframeHashes
+  // would find with the two parameters below, fingerprinted in this pass.
+  // @param threshold Mean gray difference that marks a scene change.
+  // @param keyframeInterval Frames between periodic keyframes; 0 disables.
+  // @return The series, empty if the video could not be read.
+  FrameSeries getFrameSeries(int maxFrames = 0,
+                             std::vector<FrameHash> *keyframes = nullptr,
+                             double threshold = 30.0,
+                             int keyframeInterval = 0);
+
+  // Detects black letterbox or pillarbox bars from frames sampled over the
+  // first half minute of the video.
+  // @param samples Frames to sample.
+  // @return The union of the sampled frames' picture areas; the full frame
+  // if no bars were found.
+  ActiveArea detectActiveArea(int samples = 10);
+
+  // Restricts later brightness, motion, color, scene, hash and series
+  // analyses to an area of the frame; the first frame is still extracted
+  // whole.
+  // @param area The area, e.g. from detectActiveArea(); an empty rectangle
+  // analyzes the full frame.
+  void setActiveArea(const cv::Rect &area);
+
+  // Sets the deadline every later frame loop checks between frames. A loop
+  // that reaches it returns its result over the frames read so far.
+  // @param deadline The deadline.
+  void setDeadline(const Deadline &deadline);
+
+  // Checks whether a frame loop stopped at the deadline.
+  // @return True if any result so far covers only part of its frames.
+  bool isInterrupted() const;
+
+  // Gets how much of its frames the loops cut by the deadline read.
+  // @return The smallest share (0-1) among cut loops; 1 if none was cut.
+  double getCoverage() const;
+
+  // Gets the buffer arena shared by this handler's frame loops.
+  // @return The arena, whose allocation counters cover every pass so far.
+  const FrameArena &getFrameArena() const;
 };
 
 // Namespace: vidicant
@@ -157,6 +290,14 @@ public:
 // methods, allowing for easier use without creating handler objects.
 namespace vidicant {
 
+// Creates the loader for a video source: an ImageSequenceLoader for image
+// sequence patterns, an AnimatedImageLoader for animated GIF and WebP files,
+// a ProxyVideoLoader for proxy files, and an OpenCVVideoLoader for
+// everything else.
+// @param filename The path or sequence pattern to be opened.
+// @return An unopened loader.
+std::unique_ptr<IVideoLoader> makeVideoLoader(const std::string &filename);
+
 // Convenience function to get video frame count.
 int getVideoFrameCount(const std::string &filename);
 
@@ -189,6 +330,11 @@ double getVideoMotionScore(const std::string &filename);
 std::vector<std::array<double, 3>>
 getVideoDominantColors(const std::string &filename);
 
+// Convenience function to get per-scene palettes.
+std::vector<ScenePalette> getVideoScenePalettes(const std::string &filename,
+                                                double threshold = 30.0,
+                                                int colors = 3);
+
 // Convenience function to detect scene changes.
 std::vector<int> detectVideoSceneChanges(const std::string &filename,
                                          double threshold = 30.0);
@@ -199,6 +345,15 @@ double getVideoFrameRateStability(const std::string &filename);
 // Convenience function to get color consistency.
 double getVideoColorConsistency(const std::string &filename);
 
+// Convenience function to fingerprint keyframes.
+std::vector<FrameHash> getVideoKeyframeHashes(const std::string &filename,
+                                              double threshold = 30.0,
+                                              int keyframeInterval = 0);
+
+// Convenience function to measure the per-frame series.
+FrameSeries getVideoFrameSeries(const std::string &filename,
+                                int maxFrames = 0);
+
 } // namespace vidicant
 
 #endif // VIDICANT_VIDEO_HPP
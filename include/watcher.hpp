@@ -0,0 +1,70 @@
+// watcher.hpp
+// Header file for continuous ingest of watched directories.
+//
+// This file contains declarations for a long-running mode that
+// analyzes media files as they land in a directory tree, driven by
+// filesystem notifications instead of repeated directory scans.
+// Results are appended to a newline-delimited JSON file as each
+// file finishes.
+
+#ifndef WATCHER_HPP
+#define WATCHER_HPP
+
+#include "controller.hpp"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Options controlling watch mode
+struct WatchOptions {
+  int settleMilliseconds = 200; // Quiet time after a write before analysis
+  bool existing = false;        // Also analyze files present at startup
+  bool sniff = false;           // Classify files by magic bytes
+  ProcessOptions process;       // Options for analyzing each file
+};
+
+// Class to hold candidate files until their writes settle: a file is
+// settled once it has been quiet for the settle time with an unchanged
+// size
+class SettleQueue {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit SettleQueue(std::chrono::milliseconds settle) : settle_(settle) {}
+
+  // Function to make a file a candidate, or restart its settle time;
+  // a file that cannot be sized is ignored
+  void arm(const std::string &path, Clock::time_point now);
+
+  // Function to check whether a file is waiting to settle
+  bool contains(const std::string &path) const {
+    return pending_.count(path) > 0;
+  }
+
+  // Function to take the (path, size) pairs of the settled files. Files
+  // removed meanwhile are dropped and files whose size changed are armed
+  // again; next is lowered to the earliest deadline still waiting
+  std::vector<std::pair<std::string, std::uintmax_t>>
+  takeSettled(Clock::time_point now, Clock::time_point &next);
+
+private:
+  // A file waiting for its writes to settle
+  struct PendingFile {
+    Clock::time_point deadline; // When the file may be analyzed
+    std::uintmax_t size = 0;    // Size when last armed
+  };
+
+  std::chrono::milliseconds settle_;
+  std::map<std::string, PendingFile> pending_;
+};
+
+// Function to watch directory trees and append one result line per
+// finished file to the output until SIGINT or SIGTERM; each line has
+// the same {"path", "kind", "result"} form as a checkpoint record
+int runWatch(const std::vector<std::string> &roots,
+             const std::string &outputFile, const WatchOptions &options);
+
+#endif // WATCHER_HPP
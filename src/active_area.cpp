@@ -0,0 +1,121 @@
+#include "vidicant/active_area.hpp"
+#include "vidicant/metrics.hpp"
+#include <algorithm>
+
+namespace {
+
+// Samples read along each line, at most
+constexpr int kLineSamples = 256;
+
+// Fraction of a line's samples that may be lit in a bar, for noise and
+// compression ringing at the picture's edge
+constexpr int kLitSampleDivisor = 50;
+
+// Checks whether a line of samples is dark. The line starts at `start` and
+// takes `count` steps of `step`.
+template <typename T>
+bool isDarkLine(const cv::Mat &frame, cv::Point start, cv::Point step,
+                int count, double limit) {
+  int channels = frame.channels();
+  int lit = 0;
+  for (int i = 0; i < count; ++i) {
+    const T *px = frame.ptr<T>(start.y + step.y * i) +
+                  (start.x + step.x * i) * channels;
+    for (int c = 0; c < channels; ++c) {
+      if (px[c] > limit) {
+        ++lit;
+        break;
+      }
+    }
+  }
+  return lit <= count / kLitSampleDivisor;
+}
+
+// Finds the picture area of a frame, or an empty rectangle if every line
+// is dark.
+template <typename T>
+cv::Rect findPictureArea(const cv::Mat &frame, double limit) {
+  int rows = frame.rows;
+  int cols = frame.cols;
+  int xStride = std::max(1, cols / kLineSamples);
+  int xCount = (cols + xStride - 1) / xStride;
+  auto darkRow = [&](int y) {
+    return isDarkLine<T>(frame, {0, y}, {xStride, 0}, xCount, limit);
+  };
+  int top = 0;
+  while (top < rows && darkRow(top))
+    ++top;
+  if (top == rows)
+    return cv::Rect();
+  int bottom = rows;
+  while (bottom > top && darkRow(bottom - 1))
+    --bottom;
+  int bar = std::min(top, rows - bottom);
+  top = bar;
+  bottom = rows - bar;
+
+  int yStride = std::max(1, (bottom - top) / kLineSamples);
+  int yCount = (bottom - top + yStride - 1) / yStride;
+  auto darkColumn = [&](int x) {
+    return isDarkLine<T>(frame, {x, top}, {0, yStride}, yCount, limit);
+  };
+  int left = 0;
+  while (left < cols && darkColumn(left))
+    ++left;
+  if (left == cols)
+    return cv::Rect();
+  int right = cols;
+  while (right > left && darkColumn(right - 1))
+    --right;
+  bar = std::min(left, cols - right);
+  return cv::Rect(bar, top, cols - 2 * bar, bottom - top);
+}
+
+// Finds the picture area of a frame of any supported sample type; the
+// threshold is on the 0-255 scale.
+cv::Rect pictureArea(const cv::Mat &frame, double threshold) {
+  double limit = threshold / getLevelScale(frame.depth());
+  switch (frame.depth()) {
+  case CV_8U:
+    return findPictureArea<uchar>(frame, limit);
+  case CV_16U:
+    return findPictureArea<ushort>(frame, limit);
+  case CV_32F:
+    return findPictureArea<float>(frame, limit);
+  default:
+    return cv::Rect(0, 0, frame.cols, frame.rows);
+  }
+}
+
+} // namespace
+
+ActiveAreaDetector::ActiveAreaDetector(double threshold)
+    : threshold_(threshold) {}
+
+void ActiveAreaDetector::addFrame(const cv::Mat &frame) {
+  if (frame.empty())
+    return;
+  size_ = frame.size();
+  cv::Rect area = pictureArea(frame, threshold_);
+  if (area.empty())
+    return;
+  area_ = frames_ == 0 ? area : (area_ | area);
+  ++frames_;
+}
+
+int ActiveAreaDetector::getFrameCount() const { return frames_; }
+
+ActiveArea ActiveAreaDetector::getArea() const {
+  cv::Rect full(0, 0, size_.width, size_.height);
+  return {frames_ > 0 ? (area_ & full) : full, size_};
+}
+
+namespace vidicant {
+
+ActiveArea detectActiveArea(const cv::Mat &image, double threshold) {
+  ActiveAreaDetector detector(threshold);
+  detector.addFrame(image);
+  return detector.getArea();
+}
+
+} // namespace vidicant
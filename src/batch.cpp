@@ -0,0 +1,335 @@
+// batch.cpp
+// Implementation file for batch processing of media files.
+//
+// This file contains the implementation of the batch loop. With one
+// file worker it runs on the calling thread; otherwise files are
+// analyzed on a ThreadPool sized by the parallelism policy, whose
+// workers are optionally pinned to disjoint CPU sets. Before such a
+// run every file is probed for its dimensions, so the longest files
+// start first and the tail of the batch is made of short ones, and a
+// file is only admitted while its estimated decoded size fits in the
+// memory budget. With read-ahead, a Prefetcher reads files in the order
+// they will start, so I/O on slow shares overlaps the analysis of the
+// files before them.
+
+#include "batch.hpp"
+#include "vidicant/image.hpp"
+#include "vidicant/memory_stats.hpp"
+#include "vidicant/parallelism.hpp"
+#include "vidicant/probe.hpp"
+#include "vidicant/thread_pool.hpp"
+#include "vidicant/tiled.hpp"
+#include "vidicant/trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
+namespace {
+
+// Bytes per pixel held while analyzing an 8-bit image: the decoded BGR
+// image plus its HSV and grayscale views; deeper images hold
+// proportionally more
+constexpr std::uintmax_t kImageBytesPerPixel = 7;
+
+// Bytes per pixel held while analyzing a video: the current and previous
+// frames with their converted views
+constexpr std::uintmax_t kVideoBytesPerPixel = 14;
+
+// Struct to hold the scheduling estimate for one file
+struct BatchCost {
+  std::uintmax_t work = 0;   // Pixels to analyze, or file size if unknown
+  std::uintmax_t memory = 0; // Peak decoded bytes, 0 if unknown
+};
+
+// Function to estimate the work and peak memory of analyzing one file
+BatchCost estimateCost(const MediaEntry &entry,
+                       const ProcessOptions &options) {
+  bool image = entry.kind == MediaKind::Image;
+  MediaProbe probe = image ? vidicant::probeImage(entry.path)
+                           : vidicant::probeVideo(entry.path);
+  BatchCost cost;
+  if (!probe.ok) {
+    cost.work = probe.fileSize;
+    return cost;
+  }
+  std::uintmax_t width = static_cast<std::uintmax_t>(probe.width);
+  std::uintmax_t height = static_cast<std::uintmax_t>(probe.height);
+  std::uintmax_t frames =
+      static_cast<std::uintmax_t>(std::max(probe.frameCount, 1));
+  cost.work = width * height * frames;
+  if (!image) {
+    cost.memory = width * height * kVideoBytesPerPixel;
+  } else if (options.tiled && options.tileRows > 0) {
+    // A strip is held with its halo above and below
+    std::uintmax_t rows = std::min<std::uintmax_t>(
+        height, static_cast<std::uintmax_t>(options.tileRows) +
+                    2 * TiledImageHandler::kHaloRows);
+    cost.memory = width * rows * kImageBytesPerPixel;
+  } else {
+    std::uintmax_t sampleBytes =
+        static_cast<std::uintmax_t>(std::max((probe.bitDepth + 7) / 8, 1));
+    cost.memory = width * height * kImageBytesPerPixel * sampleBytes;
+  }
+  return cost;
+}
+
+// Function to start reading files ahead in the order they will be taken;
+// images are read whole unless tiled analysis reads them strip by strip,
+// and videos have their container headers warmed
+std::unique_ptr<Prefetcher>
+startPrefetch(const std::vector<const MediaEntry *> &pending,
+              const std::vector<std::size_t> &order,
+              const ProcessOptions &options, const PrefetchOptions &prefetch) {
+  if (prefetch.depth == 0)
+    return nullptr;
+  std::vector<PrefetchRequest> files;
+  for (std::size_t index : order) {
+    const MediaEntry &entry = *pending[index];
+    files.push_back({entry.path, entry.size,
+                     entry.kind == MediaKind::Image && !options.tiled});
+  }
+  return std::make_unique<Prefetcher>(std::move(files), prefetch);
+}
+
+// Function to parse a whole unsigned decimal integer up to a maximum
+bool parseDecimal(const std::string &text, unsigned long long maximum,
+                  unsigned long long &value) {
+  if (text.empty() || text.find_first_not_of("0123456789") != text.npos)
+    return false;
+  errno = 0;
+  unsigned long long parsed = std::strtoull(text.c_str(), nullptr, 10);
+  if (errno == ERANGE || parsed > maximum)
+    return false;
+  value = parsed;
+  return true;
+}
+
+} // namespace
+
+void processBatch(const std::vector<MediaEntry> &entries,
+                  const ProcessOptions &options,
+                  const BatchOptions &batchOptions, Checkpoint *checkpoint,
+                  nlohmann::json &results) {
+  std::vector<const MediaEntry *> pending;
+  for (const auto &entry : entries) {
+    if (checkpoint == nullptr || !checkpoint->isDone(entry.path))
+      pending.push_back(&entry);
+  }
+  std::vector<nlohmann::json> slots(pending.size());
+  std::mutex logMutex;
+  std::unique_ptr<Prefetcher> prefetcher;
+  std::vector<std::size_t> position(pending.size()); // Place in read order
+
+  auto analyze = [&](std::size_t index) {
+    const MediaEntry &entry = *pending[index];
+    bool image = entry.kind == MediaKind::Image;
+    {
+      std::lock_guard<std::mutex> lock(logMutex);
+      std::cout << (image ? "Processing image: " : "Processing video: ")
+                << entry.path << std::endl;
+    }
+    std::vector<unsigned char> bytes;
+    if (prefetcher && prefetcher->take(position[index], bytes)) {
+      ImageHandler handler(
+          std::make_unique<MemoryImageLoader>(std::move(bytes)));
+      slots[index] = processImage(handler, entry.path, options);
+    } else {
+      slots[index] = image ? processImage(entry.path, options)
+                           : processVideo(entry.path, options);
+    }
+    if (checkpoint != nullptr)
+      checkpoint->record(entry.path, entry.kind, slots[index]);
+  };
+
+  ParallelismPolicy policy = vidicant::getParallelismPolicy();
+  if (policy.fileWorkers <= 1 || pending.size() <= 1) {
+    std::iota(position.begin(), position.end(), 0);
+    prefetcher =
+        startPrefetch(pending, position, options, batchOptions.prefetch);
+    for (std::size_t i = 0; i < pending.size(); ++i)
+      analyze(i);
+  } else {
+    std::function<void(std::size_t)> onStart;
+    if (policy.pinThreads)
+      onStart = [](std::size_t worker) {
+        vidicant::pinCurrentThread(static_cast<int>(worker));
+      };
+    // A short queue keeps the producer just ahead of the workers
+    std::size_t workers = static_cast<std::size_t>(policy.fileWorkers);
+    ThreadPool pool(workers, workers * 2, onStart);
+
+    // Probe every file, then order the batch longest-first
+    std::vector<BatchCost> costs(pending.size());
+    for (std::size_t i = 0; i < pending.size(); ++i)
+      pool.submit([&, i] { costs[i] = estimateCost(*pending[i], options); });
+    pool.wait();
+    std::vector<std::size_t> order(pending.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&costs](std::size_t a, std::size_t b) {
+                       return costs[a].work > costs[b].work;
+                     });
+    for (std::size_t i = 0; i < order.size(); ++i)
+      position[order[i]] = i;
+    prefetcher = startPrefetch(pending, order, options, batchOptions.prefetch);
+
+    // Admit files in order while a worker is free and the budget allows;
+    // a file larger than the whole budget runs once nothing else does
+    std::mutex admitMutex;
+    std::condition_variable admitted;
+    std::size_t inFlight = 0;
+    std::uintmax_t memoryInFlight = 0;
+    std::uintmax_t budget = batchOptions.memoryBudget;
+    for (std::size_t index : order) {
+      std::uintmax_t memory = costs[index].memory;
+      {
+        std::unique_lock<std::mutex> lock(admitMutex);
+        auto admissible = [&] {
+          return inFlight == 0 ||
+                 (inFlight < workers &&
+                  (budget == 0 || memoryInFlight + memory <= budget));
+        };
+        if (!admissible()) {
+          TraceSpan span("admit_wait");
+          admitted.wait(lock, admissible);
+        }
+        ++inFlight;
+        memoryInFlight += memory;
+      }
+      pool.submit([&, index, memory] {
+        analyze(index);
+        std::lock_guard<std::mutex> lock(admitMutex);
+        --inFlight;
+        memoryInFlight -= memory;
+        admitted.notify_one();
+      });
+    }
+    pool.wait();
+  }
+
+  for (std::size_t i = 0; i < pending.size(); ++i) {
+    const char *group =
+        pending[i]->kind == MediaKind::Image ? "images" : "videos";
+    results[group].push_back(std::move(slots[i]));
+  }
+}
+
+nlohmann::json summarizeMemory(const nlohmann::json &results) {
+  MemoryUsage process = vidicant::getProcessMatUsage();
+  nlohmann::json summary;
+  summary["files"] = 0;
+  summary["peak_rss_bytes"] = vidicant::getPeakRss();
+  summary["mat_allocated_bytes"] = process.allocatedBytes;
+  summary["mat_peak_bytes"] = process.peakBytes;
+  summary["stages"] = nlohmann::json::object();
+
+  std::uint64_t largest = 0;
+  for (const char *group : {"images", "videos"}) {
+    if (!results.contains(group))
+      continue;
+    for (const auto &result : results[group]) {
+      if (!result.contains("memory"))
+        continue;
+      const auto &memory = result["memory"];
+      summary["files"] = summary["files"].get<int>() + 1;
+      std::uint64_t peak = memory.value("peak_bytes", std::uint64_t{0});
+      if (peak >= largest) {
+        largest = peak;
+        summary["largest_file"] = {{"filename", result.value("filename", "")},
+                                   {"peak_bytes", peak}};
+      }
+      for (const auto &[path, usage] : memory["stages"].items()) {
+        auto &total = summary["stages"][path];
+        if (total.is_null())
+          total = {{"allocated_bytes", 0}, {"peak_bytes", 0},
+                   {"allocations", 0}};
+        total["allocated_bytes"] =
+            total["allocated_bytes"].get<std::uint64_t>() +
+            usage.value("allocated_bytes", std::uint64_t{0});
+        total["allocations"] = total["allocations"].get<std::uint64_t>() +
+                               usage.value("allocations", std::uint64_t{0});
+        total["peak_bytes"] =
+            std::max(total["peak_bytes"].get<std::uint64_t>(),
+                     usage.value("peak_bytes", std::uint64_t{0}));
+      }
+    }
+  }
+  return summary;
+}
+
+bool parseByteSize(const std::string &text, std::uintmax_t &bytes) {
+  std::size_t digits = 0;
+  while (digits < text.size() && text[digits] >= '0' && text[digits] <= '9')
+    ++digits;
+  if (digits == 0 || digits > 15 || text.size() > digits + 1)
+    return false;
+  std::uintmax_t value = std::stoull(text.substr(0, digits));
+  if (text.size() == digits) {
+    bytes = value;
+    return true;
+  }
+  int shift = 0;
+  switch (text[digits]) {
+  case 'K':
+  case 'k':
+    shift = 10;
+    break;
+  case 'M':
+  case 'm':
+    shift = 20;
+    break;
+  case 'G':
+  case 'g':
+    shift = 30;
+    break;
+  default:
+    return false;
+  }
+  if (value > std::numeric_limits<std::uintmax_t>::max() >> shift)
+    return false;
+  bytes = value << shift;
+  return true;
+}
+
+bool parseInteger(const std::string &text, int minimum, int &value) {
+  unsigned long long parsed = 0;
+  if (!parseDecimal(text, std::numeric_limits<int>::max(), parsed) ||
+      static_cast<long long>(parsed) < minimum)
+    return false;
+  value = static_cast<int>(parsed);
+  return true;
+}
+
+bool parseInteger(const std::string &text, std::size_t minimum,
+                  std::size_t &value) {
+  unsigned long long parsed = 0;
+  if (!parseDecimal(text, std::numeric_limits<std::size_t>::max(), parsed) ||
+      parsed < minimum)
+    return false;
+  value = static_cast<std::size_t>(parsed);
+  return true;
+}
+
+bool parseNumber(const std::string &text, double minimum, double &value) {
+  // strtod skips leading spaces and reads hex and infinities; accept only
+  // plain decimals
+  if (text.empty() ||
+      text.find_first_not_of("0123456789.eE+-") != text.npos)
+    return false;
+  char *end = nullptr;
+  errno = 0;
+  double parsed = std::strtod(text.c_str(), &end);
+  if (end != text.c_str() + text.size() || errno == ERANGE ||
+      !std::isfinite(parsed) || parsed < minimum)
+    return false;
+  value = parsed;
+  return true;
+}
@@ -0,0 +1,240 @@
+#include "vidicant/color_model.hpp"
+#include <algorithm>
+#include <limits>
+#include <opencv2/core.hpp>
+
+namespace {
+
+constexpr int kShift = 8 - ColorHistogramModel::kBitsPerChannel;
+constexpr std::size_t kBins = std::size_t(1)
+                              << (3 * ColorHistogramModel::kBitsPerChannel);
+constexpr int kMaxIterations = 20;
+
+// Attempts, iterations per attempt and center movement at which pixel
+// k-means stops.
+constexpr int kKMeansAttempts = 3;
+constexpr int kKMeansIterations = 10;
+constexpr double kKMeansEpsilon = 1.0;
+
+// Maps a color to its histogram bin.
+std::size_t binOf(std::uint8_t c0, std::uint8_t c1, std::uint8_t c2) {
+  constexpr int bits = ColorHistogramModel::kBitsPerChannel;
+  return (static_cast<std::size_t>(c0 >> kShift) << (2 * bits)) |
+         (static_cast<std::size_t>(c1 >> kShift) << bits) |
+         static_cast<std::size_t>(c2 >> kShift);
+}
+
+// Gets the squared Euclidean distance between two colors.
+double squaredDistance(const std::array<double, 3> &a,
+                       const std::array<double, 3> &b) {
+  double d0 = a[0] - b[0];
+  double d1 = a[1] - b[1];
+  double d2 = a[2] - b[2];
+  return d0 * d0 + d1 * d1 + d2 * d2;
+}
+
+} // namespace
+
+ColorHistogramModel::ColorHistogramModel()
+    : counts_(kBins, 0), sums_(kBins, std::array<double, 3>{}) {}
+
+void ColorHistogramModel::addFrame(const cv::Mat &frame, int pixelStride) {
+  if (frame.empty() || frame.depth() != CV_8U)
+    return;
+  int channels = frame.channels();
+  if (channels != 1 && channels != 3 && channels != 4)
+    return;
+  int stride = std::max(1, pixelStride);
+  for (int y = 0; y < frame.rows; y += stride) {
+    const std::uint8_t *row = frame.ptr<std::uint8_t>(y);
+    for (int x = 0; x < frame.cols; x += stride) {
+      const std::uint8_t *pixel = row + x * channels;
+      std::uint8_t c0 = pixel[0];
+      std::uint8_t c1 = channels == 1 ? pixel[0] : pixel[1];
+      std::uint8_t c2 = channels == 1 ? pixel[0] : pixel[2];
+      std::size_t bin = binOf(c0, c1, c2);
+      counts_[bin]++;
+      sums_[bin][0] += c0;
+      sums_[bin][1] += c1;
+      sums_[bin][2] += c2;
+      samples_++;
+    }
+  }
+}
+
+void ColorHistogramModel::addColor(const std::array<std::uint8_t, 3> &color,
+                                   std::uint64_t count) {
+  std::size_t bin = binOf(color[0], color[1], color[2]);
+  counts_[bin] += count;
+  for (int c = 0; c < 3; ++c)
+    sums_[bin][c] += static_cast<double>(color[c]) * count;
+  samples_ += count;
+}
+
+void ColorHistogramModel::merge(const ColorHistogramModel &other) {
+  for (std::size_t bin = 0; bin < kBins; ++bin) {
+    counts_[bin] += other.counts_[bin];
+    for (int c = 0; c < 3; ++c)
+      sums_[bin][c] += other.sums_[bin][c];
+  }
+  samples_ += other.samples_;
+}
+
+void ColorHistogramModel::clear() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  std::fill(sums_.begin(), sums_.end(), std::array<double, 3>{});
+  samples_ = 0;
+}
+
+std::uint64_t ColorHistogramModel::getSampleCount() const { return samples_; }
+
+std::vector<PaletteColor>
+ColorHistogramModel::getPalette(int colors, const Deadline &deadline) const {
+  // Occupied bins become weighted points at the mean of their colors
+  std::vector<std::array<double, 3>> points;
+  std::vector<double> weights;
+  for (std::size_t bin = 0; bin < kBins; ++bin) {
+    if (counts_[bin] == 0)
+      continue;
+    double count = static_cast<double>(counts_[bin]);
+    points.push_back(
+        {sums_[bin][0] / count, sums_[bin][1] / count, sums_[bin][2] / count});
+    weights.push_back(count);
+  }
+  std::size_t k = std::min(points.size(),
+                           static_cast<std::size_t>(std::max(colors, 0)));
+  if (k == 0)
+    return {};
+
+  // Deterministic k-means++ seeding: start from the heaviest bin, then
+  // repeatedly take the bin with the most weight far from every center
+  std::vector<std::array<double, 3>> centers;
+  centers.push_back(points[std::max_element(weights.begin(), weights.end()) -
+                           weights.begin()]);
+  std::vector<double> nearest(points.size(),
+                              std::numeric_limits<double>::max());
+  while (centers.size() < k) {
+    std::size_t best = 0;
+    double bestScore = -1.0;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      double distance = squaredDistance(points[i], centers.back());
+      nearest[i] = std::min(nearest[i], distance);
+      double score = weights[i] * nearest[i];
+      if (score > bestScore) {
+        bestScore = score;
+        best = i;
+      }
+    }
+    centers.push_back(points[best]);
+  }
+
+  // Weighted Lloyd iterations over the bins
+  std::vector<std::size_t> labels(points.size(), 0);
+  std::vector<double> clusterWeights(k);
+  for (int iteration = 0; iteration < kMaxIterations; ++iteration) {
+    if (iteration > 0 && deadline.expired())
+      break;
+    bool changed = iteration == 0;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      std::size_t label = 0;
+      double best = squaredDistance(points[i], centers[0]);
+      for (std::size_t c = 1; c < k; ++c) {
+        double distance = squaredDistance(points[i], centers[c]);
+        if (distance < best) {
+          best = distance;
+          label = c;
+        }
+      }
+      changed = changed || label != labels[i];
+      labels[i] = label;
+    }
+    if (!changed)
+      break;
+    std::vector<std::array<double, 3>> sums(k, std::array<double, 3>{});
+    std::fill(clusterWeights.begin(), clusterWeights.end(), 0.0);
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      for (int c = 0; c < 3; ++c)
+        sums[labels[i]][c] += points[i][c] * weights[i];
+      clusterWeights[labels[i]] += weights[i];
+    }
+    for (std::size_t c = 0; c < k; ++c) {
+      if (clusterWeights[c] > 0)
+        for (int channel = 0; channel < 3; ++channel)
+          centers[c][channel] = sums[c][channel] / clusterWeights[c];
+    }
+  }
+
+  std::fill(clusterWeights.begin(), clusterWeights.end(), 0.0);
+  for (std::size_t i = 0; i < points.size(); ++i)
+    clusterWeights[labels[i]] += weights[i];
+  std::vector<PaletteColor> palette;
+  for (std::size_t c = 0; c < k; ++c)
+    palette.push_back(
+        {centers[c], clusterWeights[c] / static_cast<double>(samples_)});
+  std::stable_sort(palette.begin(), palette.end(),
+                   [](const PaletteColor &a, const PaletteColor &b) {
+                     return a.weight > b.weight;
+                   });
+  return palette;
+}
+
+namespace vidicant {
+
+std::vector<std::array<double, 3>>
+clusterColors(const cv::Mat &samples, int k, const Deadline &deadline) {
+  if (k <= 0 || samples.rows < k)
+    return {};
+  std::vector<int> labels;
+  cv::Mat centers;
+  if (!deadline.isSet()) {
+    cv::kmeans(samples, k, labels,
+               cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT,
+                                kKMeansIterations, kKMeansEpsilon),
+               kKMeansAttempts, cv::KMEANS_PP_CENTERS, centers);
+  } else {
+    // Each call makes one assignment step from the labels of the last, so
+    // the deadline is checked between iterations; attempts keep the most
+    // compact result as cv::kmeans does
+    const cv::TermCriteria step(cv::TermCriteria::COUNT, 1, 0.0);
+    double best = std::numeric_limits<double>::max();
+    for (int attempt = 0;
+         attempt < kKMeansAttempts && (attempt == 0 || !deadline.expired());
+         ++attempt) {
+      cv::Mat attemptCenters, previous;
+      double compactness = cv::kmeans(samples, k, labels, step, 1,
+                                      cv::KMEANS_PP_CENTERS, attemptCenters);
+      for (int iteration = 1;
+           iteration < kKMeansIterations && !deadline.expired(); ++iteration) {
+        attemptCenters.copyTo(previous);
+        compactness = cv::kmeans(samples, k, labels, step, 1,
+                                 cv::KMEANS_USE_INITIAL_LABELS, attemptCenters);
+        double shift = 0.0;
+        for (int c = 0; c < k; ++c)
+          shift = std::max(shift, cv::norm(attemptCenters.row(c),
+                                           previous.row(c), cv::NORM_L2));
+        if (shift <= kKMeansEpsilon)
+          break;
+      }
+      if (compactness < best) {
+        best = compactness;
+        centers = attemptCenters;
+      }
+    }
+  }
+
+  // Samples of a grayscale image have one column; its centers are gray
+  bool gray = centers.cols < 3;
+  std::vector<std::array<double, 3>> colors;
+  for (int i = 0; i < k; ++i) {
+    if (gray) {
+      double value = centers.at<float>(i, 0);
+      colors.push_back({value, value, value});
+    } else {
+      colors.push_back({centers.at<float>(i, 0), centers.at<float>(i, 1),
+                        centers.at<float>(i, 2)});
+    }
+  }
+  return colors;
+}
+
+} // namespace vidicant
@@ -0,0 +1,800 @@
+// commands.cpp
+// Implementation file for the vidicant_cli subcommands.
+//
+// This file contains the implementation of subcommands that build
+// and query indexes over analysis results, and merge the results of
+// sharded runs.
+
+#include "commands.hpp"
+#include "batch.hpp"
+#include "controller.hpp"
+#include "crawler.hpp"
+#include "vidicant/hash_index.hpp"
+#include "vidicant/image.hpp"
+#include "vidicant/phash.hpp"
+#include "vidicant/results_index.hpp"
+#include "vidicant/shard.hpp"
+#include "vidicant/video.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Function to print dedup subcommand usage
+static void printDedupUsage() {
+  std::cout << "Usage: vidicant_cli dedup build <index.vdx> <results.json> "
+               "[results2.json] ... [--hash phash|dhash]"
+            << std::endl;
+  std::cout << "       vidicant_cli dedup query <index.vdx> <file|hex-hash> "
+               "[--distance D] [--hash phash|dhash]"
+            << std::endl;
+  std::cout << "Results must come from a run with --hashes" << std::endl;
+}
+
+// Function to read one hash field from a result entry
+static bool readResultHash(const nlohmann::json &entry, const std::string &key,
+                           std::uint64_t &hash) {
+  return entry.contains(key) && entry[key].is_string() &&
+         vidicant::parseHash(entry[key].get<std::string>(), hash);
+}
+
+// Function to add the hashes from one results file to an index
+static bool addResultsToIndex(const std::string &resultsFile,
+                              const std::string &key,
+                              HashIndexWriter &writer) {
+  std::ifstream input(resultsFile);
+  if (!input.is_open()) {
+    std::cerr << "Error: Could not open results file: " << resultsFile
+              << std::endl;
+    return false;
+  }
+  nlohmann::json results = nlohmann::json::parse(input, nullptr, false);
+  if (results.is_discarded()) {
+    std::cerr << "Error: Invalid JSON in results file: " << resultsFile
+              << std::endl;
+    return false;
+  }
+
+  std::uint64_t hash;
+  for (const auto &image : results.value("images", nlohmann::json::array())) {
+    if (readResultHash(image, key, hash))
+      writer.add(hash, image.value("filename", ""));
+  }
+  for (const auto &video : results.value("videos", nlohmann::json::array())) {
+    std::string filename = video.value("filename", "");
+    for (const auto &keyframe :
+         video.value("keyframe_hashes", nlohmann::json::array())) {
+      if (readResultHash(keyframe, key, hash))
+        writer.add(hash, filename + "#frame=" +
+                             std::to_string(keyframe.value("frame", 0)));
+    }
+  }
+  return true;
+}
+
+// Function to hash a query given as a media file or a hex string; a file
+// that cannot be decoded is an error, since its all-zero hash would match
+// every blank entry in the index
+static bool queryHashes(const std::string &query, bool useDHash,
+                        std::vector<std::uint64_t> &hashes,
+                        std::string &error) {
+  auto pick = [useDHash](const PerceptualHash &hash) {
+    return useDHash ? hash.dHash : hash.pHash;
+  };
+  std::uint64_t hash;
+  if (isImageFile(query)) {
+    constexpr std::size_t kHash =
+        ImageMetricEngine::indexOf<PerceptualHashMetric>();
+    ImageMetricEngine::Selection selection;
+    selection.set(kHash);
+    ImageMetricEngine engine(selection);
+    ImageHandler handler(std::make_unique<OpenCVImageLoader>());
+    auto result = handler.analyze(query, engine)
+                      ? std::get<kHash>(engine.finish())
+                      : std::nullopt;
+    if (!result) {
+      error = "Could not read query image: " + query;
+      return false;
+    }
+    hashes = {pick(*result)};
+    return true;
+  }
+  if (isVideoFile(query)) {
+    for (const auto &keyframe : vidicant::getVideoKeyframeHashes(query))
+      hashes.push_back(pick(keyframe.hash));
+    if (hashes.empty())
+      error = "Could not read query video: " + query;
+    return !hashes.empty();
+  }
+  if (vidicant::parseHash(query, hash)) {
+    hashes = {hash};
+    return true;
+  }
+  error = "Not a media file or hex hash: " + query;
+  return false;
+}
+
+int runDedupCommand(int argc, char *argv[]) {
+  if (argc < 4) {
+    printDedupUsage();
+    return 1;
+  }
+  std::string action = argv[1];
+  std::string indexFile = argv[2];
+  std::string hashKey = "phash";
+  int distance = 8;
+  std::vector<std::string> inputs;
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--hash" && i + 1 < argc) {
+      hashKey = argv[++i];
+    } else if (arg == "--distance" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], 0, distance)) {
+        std::cerr << "Error: Invalid distance: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else {
+      inputs.push_back(arg);
+    }
+  }
+  if (hashKey != "phash" && hashKey != "dhash") {
+    std::cerr << "Error: --hash must be phash or dhash" << std::endl;
+    return 1;
+  }
+
+  if (action == "build") {
+    HashIndexWriter writer;
+    for (const auto &resultsFile : inputs) {
+      if (!addResultsToIndex(resultsFile, hashKey, writer))
+        return 1;
+    }
+    if (!writer.write(indexFile)) {
+      std::cerr << "Error: Could not write index file: " << indexFile
+                << std::endl;
+      return 1;
+    }
+    std::cout << "Indexed " << writer.size() << " hashes into: " << indexFile
+              << std::endl;
+    return 0;
+  }
+
+  if (action == "query") {
+    HashIndex index;
+    if (!index.open(indexFile)) {
+      std::cerr << "Error: Could not open index file: " << indexFile
+                << std::endl;
+      return 1;
+    }
+    for (const auto &query : inputs) {
+      std::vector<std::uint64_t> hashes;
+      std::string error;
+      if (!queryHashes(query, hashKey == "dhash", hashes, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+      }
+      for (std::uint64_t hash : hashes) {
+        auto start = std::chrono::steady_clock::now();
+        auto matches = index.query(hash, distance);
+        std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        std::cout << "# " << query << " " << vidicant::formatHash(hash)
+                  << ": " << matches.size() << " matches within distance "
+                  << distance << " of " << index.size() << " ("
+                  << elapsed.count() << " us)" << std::endl;
+        for (const auto &match : matches)
+          std::cout << match.distance << "\t" << match.path << std::endl;
+      }
+    }
+    return 0;
+  }
+
+  printDedupUsage();
+  return 1;
+}
+
+// Function to print query subcommand usage
+static void printQueryUsage() {
+  std::cout << "Usage: vidicant_cli query build <index.vdr> <results.json> "
+               "[results2.json] ..."
+            << std::endl;
+  std::cout << "       vidicant_cli query columns <index.vdr>" << std::endl;
+  std::cout << "       vidicant_cli query find <index.vdr> [column>value] "
+               "[column<=value] ... [--top column N] [--bottom column N] "
+               "[--kind image|video] [--limit N]"
+            << std::endl;
+  std::cout << "Conditions use >, >=, <, <= or = and must all match"
+            << std::endl;
+}
+
+// Function to add one result field to a row, flattening nested objects
+static void addResultField(ResultsIndexWriter &writer, std::uint32_t row,
+                           const std::string &name,
+                           const nlohmann::json &value, bool nested) {
+  if (value.is_number()) {
+    writer.set(row, name, value.get<double>());
+  } else if (value.is_boolean()) {
+    writer.set(row, name, value.get<bool>() ? 1.0 : 0.0);
+  } else if (value.is_object() && !nested) {
+    for (const auto &field : value.items())
+      addResultField(writer, row, name + "." + field.key(), field.value(),
+                     true);
+  }
+}
+
+// Function to add the scalar fields of one results file to an index
+static bool addScalarResults(const std::string &resultsFile,
+                             ResultsIndexWriter &writer) {
+  std::ifstream input(resultsFile);
+  if (!input.is_open()) {
+    std::cerr << "Error: Could not open results file: " << resultsFile
+              << std::endl;
+    return false;
+  }
+  nlohmann::json results = nlohmann::json::parse(input, nullptr, false);
+  if (results.is_discarded()) {
+    std::cerr << "Error: Invalid JSON in results file: " << resultsFile
+              << std::endl;
+    return false;
+  }
+
+  for (const auto &group : {std::make_pair("images", ResultKind::Image),
+                            std::make_pair("videos", ResultKind::Video)}) {
+    for (const auto &entry :
+         results.value(group.first, nlohmann::json::array())) {
+      if (!entry.is_object())
+        continue;
+      std::uint32_t row =
+          writer.addRow(entry.value("filename", ""), group.second);
+      for (const auto &field : entry.items())
+        addResultField(writer, row, field.key(), field.value(), false);
+    }
+  }
+  return true;
+}
+
+// Function to parse a condition such as "motion_score>=20"
+static bool parseCondition(const std::string &text,
+                           ColumnPredicate &predicate) {
+  std::size_t op = text.find_first_of("<>=");
+  if (op == std::string::npos || op == 0)
+    return false;
+  std::size_t valueStart = op + 1;
+  if (text[op] != '=' && valueStart < text.size() && text[valueStart] == '=')
+    ++valueStart;
+  double value = 0;
+  if (!parseNumber(text.substr(valueStart),
+                   std::numeric_limits<double>::lowest(), value))
+    return false;
+
+  predicate = ColumnPredicate{};
+  predicate.column = text.substr(0, op);
+  bool inclusive = valueStart == op + 2;
+  if (text[op] == '>' || text[op] == '=') {
+    predicate.min = value;
+    predicate.minInclusive = inclusive || text[op] == '=';
+  }
+  if (text[op] == '<' || text[op] == '=') {
+    predicate.max = value;
+    predicate.maxInclusive = inclusive || text[op] == '=';
+  }
+  return true;
+}
+
+int runQueryCommand(int argc, char *argv[]) {
+  if (argc < 3) {
+    printQueryUsage();
+    return 1;
+  }
+  std::string action = argv[1];
+  std::string indexFile = argv[2];
+
+  if (action == "build") {
+    ResultsIndexWriter writer;
+    for (int i = 3; i < argc; ++i) {
+      if (!addScalarResults(argv[i], writer))
+        return 1;
+    }
+    if (!writer.write(indexFile)) {
+      std::cerr << "Error: Could not write index file: " << indexFile
+                << std::endl;
+      return 1;
+    }
+    std::cout << "Indexed " << writer.size() << " results into: " << indexFile
+              << std::endl;
+    return 0;
+  }
+
+  ResultsIndex index;
+  if (action != "columns" && action != "find") {
+    printQueryUsage();
+    return 1;
+  }
+  if (!index.open(indexFile)) {
+    std::cerr << "Error: Could not open index file: " << indexFile
+              << std::endl;
+    return 1;
+  }
+
+  if (action == "columns") {
+    for (const auto &name : index.getColumns())
+      std::cout << name << "\t"
+                << index.getPresentCount(index.findColumn(name)) << std::endl;
+    return 0;
+  }
+
+  std::vector<ColumnPredicate> predicates;
+  std::string rankColumn;
+  std::size_t rankCount = 0;
+  std::size_t limit = 0;
+  bool largest = true;
+  std::string kind;
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    if ((arg == "--top" || arg == "--bottom") && i + 2 < argc) {
+      largest = arg == "--top";
+      rankColumn = argv[++i];
+      if (!parseInteger(argv[++i], std::size_t{1}, rankCount)) {
+        std::cerr << "Error: Invalid row count: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--kind" && i + 1 < argc) {
+      kind = argv[++i];
+    } else if (arg == "--limit" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], std::size_t{0}, limit)) {
+        std::cerr << "Error: Invalid limit: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else {
+      ColumnPredicate predicate;
+      if (!parseCondition(arg, predicate)) {
+        std::cerr << "Error: Invalid condition: " << arg << std::endl;
+        return 1;
+      }
+      predicates.push_back(predicate);
+    }
+  }
+  if (!kind.empty() && kind != "image" && kind != "video") {
+    std::cerr << "Error: --kind must be image or video" << std::endl;
+    return 1;
+  }
+
+  // Print the value of every referenced column, each once
+  std::vector<std::string> names;
+  for (const auto &predicate : predicates)
+    names.push_back(predicate.column);
+  if (!rankColumn.empty())
+    names.push_back(rankColumn);
+  std::vector<int> columns;
+  for (const auto &name : names) {
+    int column = index.findColumn(name);
+    if (column < 0) {
+      std::cerr << "Error: Unknown column: " << name << std::endl;
+      return 1;
+    }
+    if (std::find(columns.begin(), columns.end(), column) == columns.end())
+      columns.push_back(column);
+  }
+  int rankIndex = rankColumn.empty() ? -1 : index.findColumn(rankColumn);
+
+  auto start = std::chrono::steady_clock::now();
+  bool filtered = !predicates.empty() || !kind.empty();
+  std::vector<std::uint32_t> rows;
+  if (filtered || rankIndex < 0)
+    rows = index.query(predicates);
+  if (!kind.empty()) {
+    ResultKind wanted = kind == "video" ? ResultKind::Video : ResultKind::Image;
+    rows.erase(std::remove_if(rows.begin(), rows.end(),
+                              [&](std::uint32_t row) {
+                                return index.getKind(row) != wanted;
+                              }),
+               rows.end());
+  }
+  std::size_t matches = filtered ? rows.size() : index.size();
+  if (rankIndex >= 0) {
+    rows =
+        index.top(rankIndex, rankCount, largest, filtered ? &rows : nullptr);
+  }
+  if (limit > 0 && rows.size() > limit) {
+    rows.resize(limit);
+  }
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::cout << "# " << matches << " of " << index.size()
+            << " results match, showing " << rows.size() << " ("
+            << elapsed.count() << " us)" << std::endl;
+  for (std::uint32_t row : rows) {
+    std::cout << index.getPath(row);
+    for (int column : columns)
+      std::cout << "\t" << index.getValue(row, column);
+    std::cout << std::endl;
+  }
+  return 0;
+}
+
+// Function to print merge subcommand usage
+static void printMergeUsage() {
+  std::cout << "Usage: vidicant_cli merge <output> <shard-output> "
+               "[shard-output] ... [--shards N] [--expect <list|->] "
+               "[--allow-incomplete]"
+            << std::endl;
+  std::cout << "Shard outputs are results JSON, checkpoint or watch NDJSON, "
+               "or query indexes (.vdr)"
+            << std::endl;
+  std::cout << "The output is written as NDJSON if it ends in .ndjson, as a "
+               "query index if it ends in .vdr, and as results JSON otherwise"
+            << std::endl;
+}
+
+// One result read from a shard output
+struct ShardResult {
+  std::string path;      // File the result is for
+  bool video = false;    // True for a video result
+  nlohmann::json result; // The result object
+};
+
+// One shard output read by merge
+struct ShardOutput {
+  std::string filename;             // Path of the output file
+  int shardIndex = -1;              // Shard it records, or -1 if none
+  int shardCount = 0;               // Shard count it records, or 0
+  std::vector<ShardResult> results; // Results in file order
+};
+
+// Function to check whether a path has an extension, ignoring case
+static bool hasExtension(const std::string &path, const std::string &ext) {
+  std::string actual = std::filesystem::path(path).extension().string();
+  std::transform(actual.begin(), actual.end(), actual.begin(), ::tolower);
+  return actual == ext;
+}
+
+// Function to read the rows of a query index as flat result objects
+static bool readIndexOutput(const std::string &filename, ShardOutput &output) {
+  ResultsIndex index;
+  if (!index.open(filename)) {
+    std::cerr << "Error: Could not open index file: " << filename
+              << std::endl;
+    return false;
+  }
+  std::vector<std::string> columns = index.getColumns();
+  for (std::uint32_t row = 0; row < index.size(); ++row) {
+    ShardResult entry;
+    entry.path = index.getPath(row);
+    entry.video = index.getKind(row) == ResultKind::Video;
+    entry.result = {{"filename", entry.path}};
+    for (std::size_t column = 0; column < columns.size(); ++column) {
+      double value = index.getValue(row, static_cast<int>(column));
+      if (!std::isnan(value))
+        entry.result[columns[column]] = value;
+    }
+    output.results.push_back(std::move(entry));
+  }
+  return true;
+}
+
+// Function to read a shard output in any of the formats runs write
+static bool readShardOutput(const std::string &filename,
+                            ShardOutput &output) {
+  output.filename = filename;
+  if (hasExtension(filename, ".vdr"))
+    return readIndexOutput(filename, output);
+
+  std::ifstream input(filename);
+  if (!input.is_open()) {
+    std::cerr << "Error: Could not open results file: " << filename
+              << std::endl;
+    return false;
+  }
+  std::string text((std::istreambuf_iterator<char>(input)),
+                   std::istreambuf_iterator<char>());
+
+  // A results JSON file groups results by kind
+  nlohmann::json results = nlohmann::json::parse(text, nullptr, false);
+  if (results.is_object() &&
+      (results.contains("images") || results.contains("videos"))) {
+    if (results.contains("shard") && results["shard"].is_object()) {
+      output.shardIndex = results["shard"].value("index", -1);
+      output.shardCount = results["shard"].value("count", 0);
+    }
+    for (const auto &group : {std::make_pair("images", false),
+                              std::make_pair("videos", true)}) {
+      for (const auto &entry :
+           results.value(group.first, nlohmann::json::array())) {
+        if (entry.is_object())
+          output.results.push_back(
+              {entry.value("filename", ""), group.second, entry});
+      }
+    }
+    return true;
+  }
+
+  // Otherwise one {"path", "kind", "result"} record per line, after the
+  // shard record of a sharded run; a run that was killed mid-write leaves
+  // a truncated last line, which is skipped
+  std::size_t start = 0;
+  std::size_t invalid = 0;
+  while (start < text.size()) {
+    std::size_t end = text.find('\n', start);
+    if (end == std::string::npos)
+      end = text.size();
+    std::string line = text.substr(start, end - start);
+    start = end + 1;
+    if (line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+    nlohmann::json record = nlohmann::json::parse(line, nullptr, false);
+    if (record.is_object() && record.contains("shard") &&
+        record["shard"].is_object() && !record.contains("result")) {
+      // The shard a checkpoint was written for, ahead of its results
+      output.shardIndex = record["shard"].value("index", -1);
+      output.shardCount = record["shard"].value("count", 0);
+      continue;
+    }
+    if (record.is_discarded() || !record.is_object() ||
+        !record.contains("result") || !record["result"].is_object()) {
+      ++invalid;
+      continue;
+    }
+    output.results.push_back({record.value("path", ""),
+                              record.value("kind", "") == "video",
+                              record["result"]});
+  }
+  if (output.results.empty() && invalid > 0) {
+    std::cerr << "Error: Not a results, checkpoint or watch file: "
+              << filename << std::endl;
+    return false;
+  }
+  if (invalid > 0)
+    std::cerr << "Warning: Skipped " << invalid << " unreadable lines in: "
+              << filename << std::endl;
+  return true;
+}
+
+// Function to key a result by its path, so that spellings of one path such
+// as "./a.jpg" and "a.jpg" merge
+static std::string mergeKey(const std::string &path) {
+  return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+// Function to check whether a result was cut short by a time budget; a
+// result read back from an index holds the flag as 1
+static bool isPartialResult(const nlohmann::json &result) {
+  auto partial = result.find("partial");
+  return partial != result.end() && (*partial == true || *partial == 1);
+}
+
+// Function to find which shard an output holds and count its results that
+// belong to another shard; -1 if it records none and cannot be told
+static int resolveShard(const ShardOutput &output, int count,
+                        std::size_t &misplaced) {
+  int index = output.shardIndex;
+  if (index < 0 && !output.results.empty()) {
+    // Outputs without a shard record (NDJSON, indexes) are placed by the
+    // shard their results hash to, when they all agree
+    index = vidicant::getPathShard(output.results.front().path, count);
+    for (const auto &entry : output.results) {
+      if (vidicant::getPathShard(entry.path, count) != index)
+        return -1;
+    }
+  }
+  if (index < 0 || index >= count)
+    return -1;
+  for (const auto &entry : output.results) {
+    if (vidicant::getPathShard(entry.path, count) != index)
+      ++misplaced;
+  }
+  return index;
+}
+
+// Function to print up to ten items of a list, and how many more there are
+static void printSome(const std::vector<std::string> &items) {
+  const std::size_t shown = 10;
+  for (std::size_t i = 0; i < items.size() && i < shown; ++i)
+    std::cerr << "  " << items[i] << std::endl;
+  if (items.size() > shown)
+    std::cerr << "  ... and " << items.size() - shown << " more"
+              << std::endl;
+}
+
+// Function to write merged results in the format the output name asks for
+static bool
+writeMergedResults(const std::string &filename,
+                   const std::map<std::string, ShardResult> &merged) {
+  if (hasExtension(filename, ".vdr")) {
+    ResultsIndexWriter writer;
+    for (const auto &item : merged) {
+      const ShardResult &entry = item.second;
+      std::uint32_t row = writer.addRow(
+          entry.path, entry.video ? ResultKind::Video : ResultKind::Image);
+      for (const auto &field : entry.result.items())
+        addResultField(writer, row, field.key(), field.value(), false);
+    }
+    return writer.write(filename);
+  }
+
+  std::ofstream output(filename);
+  if (!output.is_open())
+    return false;
+  if (hasExtension(filename, ".ndjson")) {
+    for (const auto &item : merged) {
+      const ShardResult &entry = item.second;
+      nlohmann::json record = {{"path", entry.path},
+                               {"kind", entry.video ? "video" : "image"},
+                               {"result", entry.result}};
+      output << record.dump() << '\n';
+    }
+  } else {
+    nlohmann::json results;
+    results["images"] = nlohmann::json::array();
+    results["videos"] = nlohmann::json::array();
+    for (const auto &item : merged)
+      results[item.second.video ? "videos" : "images"].push_back(
+          item.second.result);
+    output << results.dump(2);
+  }
+  return static_cast<bool>(output);
+}
+
+int runMergeCommand(int argc, char *argv[]) {
+  if (argc < 3) {
+    printMergeUsage();
+    return 1;
+  }
+  std::string outputFile = argv[1];
+  std::vector<std::string> inputs;
+  int shardCount = 0;
+  std::string expectList;
+  bool allowIncomplete = false;
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--shards" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], 1, shardCount)) {
+        std::cerr << "Error: Invalid shard count: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--expect" && i + 1 < argc) {
+      expectList = argv[++i];
+    } else if (arg == "--allow-incomplete") {
+      allowIncomplete = true;
+    } else {
+      inputs.push_back(arg);
+    }
+  }
+  if (inputs.empty()) {
+    printMergeUsage();
+    return 1;
+  }
+
+  std::vector<ShardOutput> outputs(inputs.size());
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    if (!readShardOutput(inputs[i], outputs[i]))
+      return 1;
+  }
+
+  // Every output that records its shard must agree on the shard count
+  for (const auto &output : outputs) {
+    if (output.shardCount <= 0)
+      continue;
+    if (shardCount == 0)
+      shardCount = output.shardCount;
+    if (output.shardCount != shardCount) {
+      std::cerr << "Error: " << output.filename << " is shard "
+                << output.shardIndex << "/" << output.shardCount
+                << ", but the merge has " << shardCount << " shards"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  bool complete = true;
+  if (shardCount > 0) {
+    std::vector<int> seen(shardCount, 0);
+    std::size_t misplaced = 0;
+    for (const auto &output : outputs) {
+      int index = resolveShard(output, shardCount, misplaced);
+      if (index >= 0) {
+        ++seen[index];
+      } else if (!output.results.empty()) {
+        std::cerr << "Warning: Cannot tell which shard " << output.filename
+                  << " holds" << std::endl;
+      }
+    }
+    std::vector<std::string> missing;
+    for (int index = 0; index < shardCount; ++index) {
+      if (seen[index] == 0)
+        missing.push_back(std::to_string(index) + "/" +
+                          std::to_string(shardCount));
+      else if (seen[index] > 1)
+        std::cerr << "Warning: Shard " << index << "/" << shardCount
+                  << " appears in " << seen[index] << " outputs" << std::endl;
+    }
+    if (misplaced > 0)
+      std::cerr << "Warning: " << misplaced
+                << " results are not in their output's shard; were the "
+                   "shards run over different paths?"
+                << std::endl;
+    if (!missing.empty()) {
+      std::cerr << "Missing " << missing.size() << " of " << shardCount
+                << " shards:" << std::endl;
+      printSome(missing);
+      complete = false;
+    }
+  }
+
+  // One result per file, keyed by path so the output is sorted
+  // and independent of the order outputs were given in; a complete result
+  // replaces one cut short by a time budget, otherwise the first is kept
+  std::map<std::string, ShardResult> merged;
+  std::size_t duplicates = 0;
+  for (auto &output : outputs) {
+    for (auto &entry : output.results) {
+      std::string key = mergeKey(entry.path);
+      auto found = merged.find(key);
+      if (found == merged.end()) {
+        merged.emplace(key, std::move(entry));
+        continue;
+      }
+      ++duplicates;
+      if (isPartialResult(found->second.result) &&
+          !isPartialResult(entry.result))
+        found->second = std::move(entry);
+    }
+  }
+
+  if (!expectList.empty()) {
+    std::vector<std::string> expected;
+    if (expectList == "-") {
+      expected = readInputList(std::cin);
+    } else {
+      std::ifstream list(expectList);
+      if (!list.is_open()) {
+        std::cerr << "Error: Could not open input list: " << expectList
+                  << std::endl;
+        return 1;
+      }
+      expected = readInputList(list);
+    }
+    std::vector<std::string> missing;
+    for (const auto &path : expected) {
+      if (!merged.count(mergeKey(path)))
+        missing.push_back(path);
+    }
+    if (!missing.empty()) {
+      std::cerr << "Missing results for " << missing.size() << " of "
+                << expected.size() << " expected files:" << std::endl;
+      printSome(missing);
+      complete = false;
+    }
+  } else if (shardCount == 0) {
+    std::cout << "No shard records or --shards given; coverage not checked"
+              << std::endl;
+  }
+
+  if (!complete && !allowIncomplete) {
+    std::cerr << "Error: Merge is incomplete; rerun the missing shards or "
+                 "pass --allow-incomplete"
+              << std::endl;
+    return 1;
+  }
+
+  if (!writeMergedResults(outputFile, merged)) {
+    std::cerr << "Error: Could not write output file: " << outputFile
+              << std::endl;
+    return 1;
+  }
+  std::cout << "Merged " << merged.size() << " results from "
+            << outputs.size() << " outputs into: " << outputFile;
+  if (duplicates > 0)
+    std::cout << " (" << duplicates << " duplicates dropped)";
+  std::cout << std::endl;
+  return 0;
+}
@@ -7,13 +7,24 @@
 
 #include "controller.hpp"
 #include "vidicant/image.hpp"
+#include "vidicant/image_sequence.hpp"
+#include "vidicant/jpeg_dct.hpp"
+#include "vidicant/memory_stats.hpp"
+#include "vidicant/metrics.hpp"
+#include "vidicant/proxy.hpp"
+#include "vidicant/tiled.hpp"
+#include "vidicant/trace.hpp"
 #include "vidicant/video.hpp"
 #include <algorithm>
+#include <cmath>
 #include <filesystem>
 #include <iostream>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <opencv2/core.hpp>
+#include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 bool isImageFile(const std::string &filename) {
@@ -37,134 +48,682 @@ bool isVideoFile(const std::string &filename) {
          videoExtensions.end();
 }
 
-// Function to process an image file
-nlohmann::json processImage(const std::string &filename) {
-  nlohmann::json result;
-  result["filename"] = filename;
+bool isMultiFrameImage(const std::string &filename) {
+  return vidicant::isImageSequence(filename) ||
+         vidicant::isAnimatedImage(filename);
+}
 
-  // Get image dimensions
-  auto [width, height] = vidicant::getImageDimensions(filename);
-  if (width == -1) {
-    result["error"] = "Failed to load image";
-    return result;
+// Function to check whether a metric was selected
+static bool wantsMetric(const ProcessOptions &options,
+                        const std::string &name) {
+  return options.metrics.empty() ||
+         std::find(options.metrics.begin(), options.metrics.end(), name) !=
+             options.metrics.end();
+}
+
+// Function to check whether a JPEG's DCT coefficients give every selected
+// metric
+static bool isJpegDctSelection(const ImageMetricEngine::Selection &selection) {
+  ImageMetricEngine::Selection estimated;
+  ImageMetricEngine::select({"is_grayscale", "average_brightness", "channels",
+                             "blur_score", "contrast_ratio", "aspect_ratio",
+                             "entropy"},
+                            estimated);
+  return (selection & ~estimated).none();
+}
+
+// Function to add the metrics estimated from a JPEG's DCT coefficients
+static void addJpegDctResults(const JpegDctStats &stats,
+                              const ProcessOptions &options,
+                              nlohmann::json &result) {
+  result["width"] = stats.width;
+  result["height"] = stats.height;
+  if (wantsMetric(options, "is_grayscale"))
+    result["is_grayscale"] = stats.channels == 1;
+  if (wantsMetric(options, "average_brightness"))
+    result["average_brightness"] = stats.averageBrightness;
+  if (wantsMetric(options, "channels"))
+    result["channels"] = stats.channels;
+  if (wantsMetric(options, "blur_score"))
+    result["blur_score"] = stats.blurScore;
+  if (wantsMetric(options, "contrast_ratio"))
+    result["contrast_ratio"] = stats.contrastRatio;
+  if (wantsMetric(options, "aspect_ratio"))
+    result["aspect_ratio"] = stats.height > 0
+                                 ? static_cast<double>(stats.width) /
+                                       stats.height
+                                 : 0.0;
+  if (wantsMetric(options, "entropy"))
+    result["entropy"] = stats.entropy;
+  result["jpeg_dct"] = true;
+}
+
+// Struct to time one stage of an analysis and count the memory it takes
+struct Stage {
+  explicit Stage(const char *name) : memory(name), span(name) {}
+
+  MemoryScope memory; // Mat memory taken by the stage
+  TraceSpan span;     // The stage on the trace timeline
+};
+
+// Function to describe the Mat memory taken by a scope
+static nlohmann::json memoryUsageJson(const MemoryUsage &usage) {
+  return {{"allocated_bytes", usage.allocatedBytes},
+          {"peak_bytes", usage.peakBytes},
+          {"allocations", usage.allocations}};
+}
+
+// Function to add the Mat memory a file's analysis took, by stage
+static void addMemoryResults(const MemoryScope &scope,
+                             nlohmann::json &result) {
+  nlohmann::json memory = memoryUsageJson(scope.getUsage());
+  memory["stages"] = nlohmann::json::object();
+  for (const auto &[path, usage] : scope.getStages())
+    memory["stages"][path] = memoryUsageJson(usage);
+  memory["process_peak_rss_bytes"] = vidicant::getPeakRss();
+  result["memory"] = memory;
+}
+
+// Function to check whether the selected video analyses read color, which
+// a luma-only proxy does not keep
+static bool needsColorFrames(const ProcessOptions &options) {
+  for (const char *name : {"first_frame", "average_brightness", "is_grayscale",
+                           "color_consistency", "dominant_colors"}) {
+    if (wantsMetric(options, name))
+      return true;
   }
+  return options.scenePalettes || options.qcEvents ||
+         !options.seriesFormat.empty() || !options.sceneThresholds.empty();
+}
 
-  result["width"] = width;
-  result["height"] = height;
+// Function to map a picture area found on proxy frames to the source's frame
+static ActiveArea sourceArea(const ActiveArea &area, cv::Size sourceSize) {
+  if (area.frameSize.width <= 0 || area.frameSize.height <= 0)
+    return area;
+  double sx = static_cast<double>(sourceSize.width) / area.frameSize.width;
+  double sy = static_cast<double>(sourceSize.height) / area.frameSize.height;
+  cv::Rect rect(static_cast<int>(std::lround(area.rect.x * sx)),
+                static_cast<int>(std::lround(area.rect.y * sy)),
+                static_cast<int>(std::lround(area.rect.width * sx)),
+                static_cast<int>(std::lround(area.rect.height * sy)));
+  return {rect & cv::Rect(0, 0, sourceSize.width, sourceSize.height),
+          sourceSize};
+}
 
-  // Additional analyses
-  bool grayscale = vidicant::isImageGrayscale(filename);
-  result["is_grayscale"] = grayscale;
+// Function to describe a detected picture area
+static nlohmann::json activeAreaJson(const ActiveArea &area) {
+  return {{"x", area.rect.x},
+          {"y", area.rect.y},
+          {"width", area.rect.width},
+          {"height", area.rect.height}};
+}
 
-  double brightness = vidicant::getImageAverageBrightness(filename);
-  result["average_brightness"] = brightness;
+// Function to mark results cut short by the time budget
+static void addPartialResults(bool interrupted, double coverage,
+                              const std::vector<std::string> &skipped,
+                              nlohmann::json &result) {
+  if (!interrupted && skipped.empty())
+    return;
+  result["partial"] = true;
+  result["coverage"] = coverage;
+  result["skipped"] = skipped;
+}
 
-  int channels = vidicant::getImageNumberOfChannels(filename);
-  result["channels"] = channels;
+// Function to list the selectable image metrics
+std::vector<std::string> getImageMetricNames() {
+  return ImageMetricEngine::names();
+}
 
-  int edgeCount = vidicant::getImageEdgeCount(filename);
-  result["edge_count"] = edgeCount;
+// Function to list the selectable video metrics
+std::vector<std::string> getVideoMetricNames() {
+  return {"average_brightness",   "is_grayscale",    "first_frame",
+          "motion_score",         "dominant_colors", "scene_changes",
+          "frame_rate_stability", "color_consistency"};
+}
 
-  auto dominantColors = vidicant::getImageDominantColors(filename, 3);
-  result["dominant_colors"] = nlohmann::json::array();
-  for (size_t i = 0; i < dominantColors.size(); ++i) {
-    result["dominant_colors"].push_back(
-        {dominantColors[i][0], dominantColors[i][1], dominantColors[i][2]});
+// Function to check the ranges of analysis options
+std::string checkProcessOptions(const ProcessOptions &options) {
+  auto number = [](double value) {
+    std::ostringstream text;
+    text << value;
+    return text.str();
+  };
+  if (options.tileRows < 1)
+    return "Invalid tile rows: " + std::to_string(options.tileRows);
+  if (options.histogramBins < 1)
+    return "Invalid histogram bins: " + std::to_string(options.histogramBins);
+  if (options.seriesWindow < 0)
+    return "Invalid series window: " + std::to_string(options.seriesWindow);
+  if (!std::isfinite(options.timeBudget) || options.timeBudget < 0)
+    return "Invalid time budget: " + number(options.timeBudget);
+  for (double threshold : options.sceneThresholds) {
+    if (!std::isfinite(threshold) || threshold < 0)
+      return "Invalid scene threshold: " + number(threshold);
+  }
+  const std::pair<const char *, double> qcThresholds[] = {
+      {"black", options.qc.blackBrightness},
+      {"freeze", options.qc.freezeDiff},
+      {"flash", options.qc.flashBrightness}};
+  for (const auto &[name, threshold] : qcThresholds) {
+    if (!std::isfinite(threshold) || threshold < 0)
+      return std::string("Invalid QC ") + name + " threshold: " +
+             number(threshold);
   }
+  if (options.proxyHeight < 1)
+    return "Invalid proxy height: " + std::to_string(options.proxyHeight);
+  if (options.tiled && options.perceptualHashes)
+    return "Perceptual hashes need whole images and cannot be combined with "
+           "tiled mode";
+  if (options.tiled && options.cropBars)
+    return "Bar cropping needs whole images and cannot be combined with "
+           "tiled mode";
+  if (options.tiled && options.jpegDct)
+    return "JPEG DCT estimates cannot be combined with tiled mode";
+  return {};
+}
 
-  double blurScore = vidicant::getImageBlurScore(filename);
-  result["blur_score"] = blurScore;
+// Function to process an image file
+nlohmann::json processImage(const std::string &filename,
+                            const ProcessOptions &options) {
+  if (options.tiled)
+    return processImageTiled(filename, options);
 
-  double contrastRatio = vidicant::getImageContrastRatio(filename);
-  result["contrast_ratio"] = contrastRatio;
+  ImageHandler handler(std::make_unique<OpenCVImageLoader>());
+  return processImage(handler, filename, options);
+}
 
-  double saturationLevel = vidicant::getImageSaturationLevel(filename);
-  result["saturation_level"] = saturationLevel;
+// Function to process an image through a given handler
+nlohmann::json processImage(ImageHandler &handler, const std::string &filename,
+                            const ProcessOptions &options) {
+  if (options.memoryStats)
+    vidicant::enableMemoryTracking();
+  MemoryScope fileMemory("file");
+  TraceSpan fileSpan("file", filename);
+  nlohmann::json result;
+  result["filename"] = filename;
+
+  // All registered metrics run over a single decode of the image
+  // (names of video-only metrics in the list are skipped)
+  // Fingerprints come from the same decode, but only when asked for
+  constexpr std::size_t kHash =
+      ImageMetricEngine::indexOf<PerceptualHashMetric>();
+  ImageMetricEngine::Selection selection;
+  if (options.metrics.empty())
+    selection.set().reset(kHash);
+  for (const auto &metric : options.metrics) {
+    ImageMetricEngine::Selection one;
+    if (ImageMetricEngine::select({metric}, one))
+      selection |= one;
+  }
+  if (options.perceptualHashes)
+    selection.set(kHash);
+  MetricOptions metricOptions;
+  metricOptions.histogramBins = options.histogramBins;
+  Deadline deadline(options.timeBudget);
+  metricOptions.deadline = deadline;
+  // JPEGs give several metrics from their DCT coefficients, used only when
+  // they give every selected metric: any other needs the pixels, and that
+  // decode gives all of them exactly (files that are not JPEGs, or that
+  // libjpeg cannot read, take the pixel path too). Bytes already in memory,
+  // prefetched or sent to the daemon, are read from there
+  JpegDctStats dct;
+  const std::vector<unsigned char> *bytes = handler.getEncodedBytes();
+  bool fromDct =
+      options.jpegDct && !options.cropBars && isJpegDctSelection(selection) &&
+      (bytes ? vidicant::analyzeJpegDct(bytes->data(), bytes->size(), dct)
+             : vidicant::analyzeJpegDct(filename, dct));
+  if (fromDct)
+    addJpegDctResults(dct, options, result);
+
+  if (!fromDct) {
+    Stage stage("analyze");
+    ImageMetricEngine engine(selection, metricOptions);
+    ActiveArea area;
+    AnalysisProgress progress;
+    if (!handler.analyze(filename, engine,
+                         options.cropBars ? &area : nullptr, deadline,
+                         &progress)) {
+      result["error"] = "Failed to load image";
+      return result;
+    }
+
+    cv::Size size = options.cropBars ? area.frameSize : progress.frameSize;
+    result["width"] = size.width;
+    result["height"] = size.height;
+    if (options.cropBars)
+      result["active_area"] = activeAreaJson(area);
+    ImageMetricEngine::forEach(
+        engine.finish(), [&result](const char *name, const auto &value) {
+          using Value = std::decay_t<decltype(value)>;
+          if constexpr (std::is_same<Value, PerceptualHash>::value) {
+            result["dhash"] = vidicant::formatHash(value.dHash);
+            result["phash"] = vidicant::formatHash(value.pHash);
+          } else {
+            result[name] = value;
+          }
+        });
+    // A preview's rounded size would skew the ratio, so take it from the
+    // picture itself
+    if (progress.coverage < 1.0 && result.contains("aspect_ratio"))
+      result["aspect_ratio"] =
+          progress.frameSize.height > 0
+              ? static_cast<double>(progress.frameSize.width) /
+                    progress.frameSize.height
+              : 0.0;
+    // Past the deadline, the results are the preview's
+    addPartialResults(progress.interrupted, progress.coverage, {}, result);
+  }
 
-  auto histogram = vidicant::getImageHistogram(filename);
-  result["histogram"] = histogram;
+  if (options.memoryStats)
+    addMemoryResults(fileMemory, result);
+  return result;
+}
+
+// Function to process an image file strip by strip
+nlohmann::json processImageTiled(const std::string &filename,
+                                 const ProcessOptions &options) {
+  if (options.memoryStats)
+    vidicant::enableMemoryTracking();
+  MemoryScope fileMemory("file");
+  TraceSpan fileSpan("file", filename);
+  nlohmann::json result;
+  result["filename"] = filename;
+  // Fingerprints are taken from a thumbnail of the whole image, which
+  // strips do not give
+  if (options.perceptualHashes) {
+    result["error"] = "Perceptual hashes are not available in tiled mode";
+    return result;
+  }
+
+  ImageTileStats stats;
+  Deadline deadline(options.timeBudget);
+  {
+    Stage stage("analyze");
+    stats = vidicant::analyzeImageTiled(filename, options.tileRows, deadline);
+  }
+  if (stats.width == -1) {
+    result["error"] = "Failed to load image";
+    return result;
+  }
 
-  double aspectRatio = vidicant::getImageAspectRatio(filename);
-  result["aspect_ratio"] = aspectRatio;
+  result["width"] = stats.width;
+  result["height"] = stats.height;
+  if (wantsMetric(options, "is_grayscale"))
+    result["is_grayscale"] = stats.channels == 1;
+  if (wantsMetric(options, "average_brightness"))
+    result["average_brightness"] = stats.getAverageBrightness();
+  if (wantsMetric(options, "channels"))
+    result["channels"] = stats.channels;
+  if (wantsMetric(options, "edge_count"))
+    result["edge_count"] = stats.edgeCount;
+
+  if (wantsMetric(options, "dominant_colors")) {
+    auto dominantColors = stats.getDominantColors(3, deadline);
+    result["dominant_colors"] = nlohmann::json::array();
+    for (size_t i = 0; i < dominantColors.size(); ++i) {
+      result["dominant_colors"].push_back(
+          {dominantColors[i][0], dominantColors[i][1], dominantColors[i][2]});
+    }
+  }
 
-  double entropy = vidicant::getImageEntropy(filename);
-  result["entropy"] = entropy;
+  if (wantsMetric(options, "blur_score"))
+    result["blur_score"] = stats.getBlurScore();
+  if (wantsMetric(options, "contrast_ratio"))
+    result["contrast_ratio"] = stats.getContrastRatio();
+  if (wantsMetric(options, "saturation_level"))
+    result["saturation_level"] = stats.getSaturationLevel();
+  if (wantsMetric(options, "histogram"))
+    result["histogram"] = stats.getHistogram(options.histogramBins);
+  if (wantsMetric(options, "aspect_ratio"))
+    result["aspect_ratio"] = stats.height > 0
+                                 ? static_cast<double>(stats.width) /
+                                       stats.height
+                                 : 0.0;
+  if (wantsMetric(options, "entropy"))
+    result["entropy"] = stats.getEntropy();
+  result["tiled"] = true;
+  // Strips stop at the deadline; the metrics then cover the rows read
+  double coverage = stats.getCoverage();
+  addPartialResults(coverage < 1.0, coverage, {}, result);
+  if (options.memoryStats)
+    addMemoryResults(fileMemory, result);
 
   return result;
 }
 
+// Function to add series windows, threshold sweeps and the side file
+static void addSeriesResults(const FrameSeries &series,
+                             const std::string &filename,
+                             const ProcessOptions &options,
+                             nlohmann::json &result) {
+  int window = options.seriesWindow;
+  if (window <= 0)
+    window = series.getFPS() > 0
+                 ? std::max(1, static_cast<int>(std::lround(series.getFPS())))
+                 : 30;
+  result["series_window_frames"] = window;
+  result["series_windows"] = nlohmann::json::array();
+  for (const auto &summary : series.summarize(window)) {
+    result["series_windows"].push_back(
+        {{"start_frame", summary.startFrame},
+         {"end_frame", summary.endFrame},
+         {"brightness", summary.brightness},
+         {"mean_diff", summary.meanDiff},
+         {"max_diff", summary.maxDiff},
+         {"histogram_distance", summary.histogramDistance},
+         {"max_histogram_distance", summary.maxHistogramDistance},
+         {"saturation", summary.saturation}});
+  }
+
+  if (!options.sceneThresholds.empty()) {
+    auto changes = series.detectSceneChanges(options.sceneThresholds);
+    result["scene_thresholds"] = nlohmann::json::array();
+    for (std::size_t i = 0; i < changes.size(); ++i) {
+      result["scene_thresholds"].push_back(
+          {{"threshold", options.sceneThresholds[i]},
+           {"scene_changes", changes[i]}});
+    }
+  }
+
+  if (!options.seriesFormat.empty()) {
+    bool binary = options.seriesFormat == "binary";
+    std::filesystem::path videoPath(filename);
+    std::string seriesOutput =
+        videoPath.stem().string() + (binary ? "_series.bin" : "_series.csv");
+    bool saved = binary ? series.writeBinary(seriesOutput)
+                        : series.writeCsv(seriesOutput);
+    result["series_saved"] = saved;
+    if (saved) {
+      result["series_path"] = seriesOutput;
+    }
+  }
+}
+
+// Function to add black, frozen and flash frame ranges found in a series
+static void addQcResults(const FrameSeries &series, const QcOptions &qc,
+                         nlohmann::json &result) {
+  static const char *const kTypeNames[] = {"black", "freeze", "flash"};
+  double fps = series.getFPS();
+  result["qc_events"] = nlohmann::json::array();
+  for (const auto &event : series.detectQcEvents(qc)) {
+    nlohmann::json entry = {
+        {"type", kTypeNames[static_cast<int>(event.type)]},
+        {"start_frame", event.startFrame},
+        {"end_frame", event.endFrame}};
+    if (fps > 0) {
+      entry["start_time"] = event.startFrame / fps;
+      entry["end_time"] = event.endFrame / fps;
+    }
+    result["qc_events"].push_back(entry);
+  }
+}
+
 // Function to process a video file
-nlohmann::json processVideo(const std::string &filename) {
+nlohmann::json processVideo(const std::string &filename,
+                            const ProcessOptions &options) {
+  if (options.memoryStats)
+    vidicant::enableMemoryTracking();
+  MemoryScope fileMemory("file");
+  TraceSpan fileSpan("file", filename);
   nlohmann::json result;
   result["filename"] = filename;
+  Deadline deadline(options.timeBudget);
+
+  // Passes read the cached proxy of the video, if there is one, instead of
+  // decoding it; the first run builds the proxy in one decode
+  std::string source = filename;
+  if (!options.proxyCache.empty()) {
+    Stage stage("proxy");
+    ProxyOptions proxyOptions;
+    proxyOptions.directory = options.proxyCache;
+    proxyOptions.height = options.proxyHeight;
+    proxyOptions.color = needsColorFrames(options);
+    proxyOptions.maxBytes = options.proxyCacheLimit;
+    bool built = false;
+    std::string proxyPath =
+        vidicant::ensureVideoProxy(filename, proxyOptions, deadline, &built);
+    ProxyVideoLoader proxy;
+    if (!proxyPath.empty() && proxy.open(proxyPath)) {
+      source = proxyPath;
+      const ProxyInfo &info = proxy.getInfo();
+      result["proxy"] = {{"path", proxyPath},
+                         {"built", built},
+                         {"width", info.frameSize.width},
+                         {"height", info.frameSize.height},
+                         {"channels", info.channels}};
+    }
+  }
+  bool proxied = source != filename;
 
-  int frameCount = vidicant::getVideoFrameCount(filename);
-  if (frameCount == -1) {
+  // One handler runs every pass, so the active area found below applies
+  // to all of them, and they share the time budget
+  VideoHandler handler(vidicant::makeVideoLoader(source));
+  handler.setDeadline(deadline);
+  if (!handler.open(source)) {
     result["error"] = "Failed to load video";
     return result;
   }
 
+  // Passes started after the deadline are skipped; the one it cuts short
+  // reports over the frames it read
+  std::vector<std::string> skipped;
+  auto due = [&deadline, &skipped](const char *name) {
+    if (!deadline.expired())
+      return true;
+    skipped.push_back(name);
+    return false;
+  };
+
+  int frameCount = handler.getFrameCount();
   result["frame_count"] = frameCount;
 
-  double fps = vidicant::getVideoFPS(filename);
+  double fps = handler.getFPS();
   result["fps"] = fps;
 
-  auto [vWidth, vHeight] = vidicant::getVideoResolution(filename);
+  auto [vWidth, vHeight] = handler.getResolution();
   result["width"] = vWidth;
   result["height"] = vHeight;
 
-  double duration = vidicant::getVideoDuration(filename);
+  double duration = handler.getDuration();
   result["duration_seconds"] = duration;
 
+  if (options.cropBars && due("active_area")) {
+    Stage stage("active_area");
+    ActiveArea area = handler.detectActiveArea();
+    handler.setActiveArea(area.rect);
+    if (proxied)
+      area = sourceArea(area, cv::Size(vWidth, vHeight));
+    result["active_area"] = activeAreaJson(area);
+  }
+
+  // The per-frame series is decoded for its own results, QC or keyframe
+  // hashes; brightness, motion and consistency are then derived from it
+  // instead of taking passes of their own
+  bool seriesResults =
+      !options.seriesFormat.empty() || !options.sceneThresholds.empty();
+  bool seriesPass =
+      seriesResults || options.qcEvents || options.perceptualHashes;
+
   // Advanced video processing
-  cv::Mat firstFrame = vidicant::extractFirstFrame(filename);
-  if (!firstFrame.empty()) {
-    result["first_frame_extracted"] = true;
-    result["first_frame_info"] = {{"width", firstFrame.cols},
-                                  {"height", firstFrame.rows},
-                                  {"channels", firstFrame.channels()}};
-  } else {
-    result["first_frame_extracted"] = false;
+  if (wantsMetric(options, "first_frame") && due("first_frame")) {
+    Stage stage("first_frame");
+    cv::Mat firstFrame = handler.extractFirstFrame();
+    if (!firstFrame.empty()) {
+      result["first_frame_extracted"] = true;
+      result["first_frame_info"] = {{"width", firstFrame.cols},
+                                    {"height", firstFrame.rows},
+                                    {"channels", firstFrame.channels()}};
+    } else {
+      result["first_frame_extracted"] = false;
+    }
   }
 
-  double videoBrightness = vidicant::getVideoAverageBrightness(filename);
-  result["average_brightness"] = videoBrightness;
+  if (!seriesPass && wantsMetric(options, "average_brightness") &&
+      due("average_brightness")) {
+    Stage stage("average_brightness");
+    double videoBrightness = handler.getAverageBrightness();
+    result["average_brightness"] = videoBrightness;
+  }
 
-  bool videoGrayscale = vidicant::isVideoGrayscale(filename);
-  result["is_grayscale"] = videoGrayscale;
+  if (wantsMetric(options, "is_grayscale") && due("is_grayscale")) {
+    Stage stage("is_grayscale");
+    bool videoGrayscale = handler.isGrayscale();
+    result["is_grayscale"] = videoGrayscale;
+  }
 
   // Save first frame as image
-  std::filesystem::path videoPath(filename);
-  std::string imageOutput = videoPath.stem().string() + "_first_frame.jpg";
-  bool saved = vidicant::saveFirstFrameAsImage(filename, imageOutput);
-  result["first_frame_saved"] = saved;
-  if (saved) {
-    result["first_frame_path"] = imageOutput;
+  if (wantsMetric(options, "first_frame") && due("first_frame_saved")) {
+    Stage stage("first_frame_saved");
+    std::filesystem::path videoPath(filename);
+    std::string imageOutput = videoPath.stem().string() + "_first_frame.jpg";
+    bool saved = handler.saveFirstFrameAsImage(imageOutput);
+    result["first_frame_saved"] = saved;
+    if (saved) {
+      result["first_frame_path"] = imageOutput;
+    }
   }
 
   // Motion score
-  double motionScore = vidicant::getVideoMotionScore(filename);
-  result["motion_score"] = motionScore;
+  if (!seriesPass && wantsMetric(options, "motion_score") &&
+      due("motion_score")) {
+    Stage stage("motion_score");
+    double motionScore = handler.getMotionScore();
+    result["motion_score"] = motionScore;
+  }
+
+  // Frame rate stability
+  if (wantsMetric(options, "frame_rate_stability") &&
+      due("frame_rate_stability")) {
+    Stage stage("frame_rate_stability");
+    double frStability = handler.getFrameRateStability();
+    result["frame_rate_stability"] = frStability;
+  }
+
+  // Color consistency
+  if (!seriesPass && wantsMetric(options, "color_consistency") &&
+      due("color_consistency")) {
+    Stage stage("color_consistency");
+    double colorConsistency = handler.getColorConsistency();
+    result["color_consistency"] = colorConsistency;
+  }
+
+  // Passes over the whole video come last, so a time budget spent on them
+  // still leaves the results above
 
   // Dominant colors from video
-  auto videoColors = vidicant::getVideoDominantColors(filename);
-  result["dominant_colors"] = nlohmann::json::array();
-  for (size_t i = 0; i < videoColors.size(); ++i) {
-    result["dominant_colors"].push_back(
-        {videoColors[i][0], videoColors[i][1], videoColors[i][2]});
+  if (wantsMetric(options, "dominant_colors") && due("dominant_colors")) {
+    Stage stage("dominant_colors");
+    auto videoColors = handler.getDominantColors();
+    result["dominant_colors"] = nlohmann::json::array();
+    for (size_t i = 0; i < videoColors.size(); ++i) {
+      result["dominant_colors"].push_back(
+          {videoColors[i][0], videoColors[i][1], videoColors[i][2]});
+    }
   }
 
-  // Scene change detection
-  auto sceneChanges = vidicant::detectVideoSceneChanges(filename);
-  result["scene_changes"] = sceneChanges;
+  // Palette per scene, accumulated in the same pass that finds the cuts
+  if (options.scenePalettes && due("scene_palettes")) {
+    Stage stage("scene_palettes");
+    result["scene_palettes"] = nlohmann::json::array();
+    for (const auto &scene : handler.getScenePalettes()) {
+      nlohmann::json colors = nlohmann::json::array();
+      for (const auto &entry : scene.colors)
+        colors.push_back({{"color", entry.color}, {"weight", entry.weight}});
+      result["scene_palettes"].push_back({{"start_frame", scene.startFrame},
+                                          {"end_frame", scene.endFrame},
+                                          {"colors", colors}});
+    }
+  }
 
-  // Frame rate stability
-  double frStability = vidicant::getVideoFrameRateStability(filename);
-  result["frame_rate_stability"] = frStability;
+  // Per-frame series, from which every threshold and window is derived;
+  // keyframes are fingerprinted and scenes found in the same pass
+  FrameSeries series;
+  std::vector<FrameHash> keyframes;
+  if (seriesPass && due("series")) {
+    Stage stage("series");
+    int keyframeInterval = fps > 0 ? static_cast<int>(std::lround(fps * 10))
+                                   : 0; // One keyframe per 10s of video
+    series = handler.getFrameSeries(
+        0, options.perceptualHashes ? &keyframes : nullptr, 30.0,
+        keyframeInterval);
+    if (seriesResults)
+      addSeriesResults(series, filename, options, result);
+    if (options.qcEvents)
+      addQcResults(series, options.qc, result);
+  }
+  if (seriesPass && series.size() == 0 && deadline.expired()) {
+    // The metrics derived from the series went with it
+    for (const char *name :
+         {"average_brightness", "motion_score", "color_consistency"}) {
+      if (wantsMetric(options, name))
+        skipped.push_back(name);
+    }
+    if (options.perceptualHashes)
+      skipped.push_back("keyframe_hashes");
+  }
+  if (series.size() > 0) {
+    if (wantsMetric(options, "average_brightness"))
+      result["average_brightness"] = series.getAverageBrightness();
+    if (wantsMetric(options, "motion_score"))
+      result["motion_score"] = series.getMotionScore();
+    if (wantsMetric(options, "color_consistency"))
+      result["color_consistency"] = series.getColorConsistency();
+  }
+  if (options.perceptualHashes && series.size() > 0) {
+    result["keyframe_hashes"] = nlohmann::json::array();
+    for (const auto &keyframe : keyframes) {
+      result["keyframe_hashes"].push_back(
+          {{"frame", keyframe.frameIndex},
+           {"scene_start", keyframe.sceneStart},
+           {"dhash", vidicant::formatHash(keyframe.hash.dHash)},
+           {"phash", vidicant::formatHash(keyframe.hash.pHash)}});
+    }
+  }
 
-  // Color consistency
-  double colorConsistency = vidicant::getVideoColorConsistency(filename);
-  result["color_consistency"] = colorConsistency;
+  if (wantsMetric(options, "scene_changes") && series.size() > 0) {
+    // Match detectVideoSceneChanges, which scans the first 1000 frames
+    result["scene_changes"] = series.detectSceneChanges(30.0, 1000);
+  } else if (wantsMetric(options, "scene_changes") && due("scene_changes")) {
+    Stage stage("scene_changes");
+    auto sceneChanges = handler.detectSceneChanges();
+    result["scene_changes"] = sceneChanges;
+  }
+
+  addPartialResults(handler.isInterrupted(), handler.getCoverage(), skipped,
+                    result);
+  if (options.memoryStats)
+    addMemoryResults(fileMemory, result);
+  return result;
+}
 
+// Function to analyze a saved per-frame series
+nlohmann::json processSeries(const std::string &filename,
+                             const ProcessOptions &options) {
+  TraceSpan fileSpan("file", filename);
+  nlohmann::json result;
+  result["filename"] = filename;
+  FrameSeries series;
+  if (!series.readBinary(filename)) {
+    result["error"] = "Failed to read series";
+    return result;
+  }
+  result["frame_count"] = series.size();
+  result["fps"] = series.getFPS();
+
+  // The series is the input here, so it is not written out again
+  ProcessOptions seriesOptions = options;
+  seriesOptions.seriesFormat.clear();
+  addSeriesResults(series, filename, seriesOptions, result);
+  if (options.sceneThresholds.empty())
+    result["scene_changes"] = series.detectSceneChanges(30.0);
+  addQcResults(series, options.qc, result);
+  if (series.size() > 0) {
+    if (wantsMetric(options, "average_brightness"))
+      result["average_brightness"] = series.getAverageBrightness();
+    if (wantsMetric(options, "motion_score"))
+      result["motion_score"] = series.getMotionScore();
+    if (wantsMetric(options, "color_consistency"))
+      result["color_consistency"] = series.getColorConsistency();
+  }
   return result;
 }
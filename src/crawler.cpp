@@ -0,0 +1,200 @@
+// crawler.cpp
+// Implementation file for corpus discovery and checkpointing.
+//
+// This file contains the implementation of the parallel directory
+// walker, magic-byte sniffing, input lists and checkpoint manifests.
+
+#include "crawler.hpp"
+#include "controller.hpp"
+#include "vidicant/thread_pool.hpp"
+#include "vidicant/trace.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <mutex>
+
+namespace fs = std::filesystem;
+
+MediaKind sniffMediaKind(const std::string &filename) {
+  unsigned char head[16] = {};
+  std::ifstream input(filename, std::ios::binary);
+  if (!input.read(reinterpret_cast<char *>(head), sizeof(head)) &&
+      input.gcount() < 4)
+    return MediaKind::Unknown;
+  auto at = [&head](std::size_t offset, const char *magic) {
+    return std::memcmp(head + offset, magic, std::strlen(magic)) == 0;
+  };
+
+  // Images
+  if (head[0] == 0xFF && head[1] == 0xD8 && head[2] == 0xFF)
+    return MediaKind::Image; // JPEG
+  if (at(0, "\x89PNG") || at(0, "GIF8") || at(0, "BM"))
+    return MediaKind::Image;
+  if ((at(0, "II*") && head[3] == 0) ||
+      (at(0, "MM") && head[2] == 0 && head[3] == '*'))
+    return MediaKind::Image; // TIFF, little or big endian
+  if (at(0, "RIFF") && at(8, "WEBP"))
+    return MediaKind::Image;
+
+  // Videos
+  if (at(0, "RIFF") && at(8, "AVI "))
+    return MediaKind::Video;
+  if (at(4, "ftyp") || at(4, "moov") || at(4, "mdat") || at(4, "wide") ||
+      at(4, "free") || at(4, "skip"))
+    return MediaKind::Video; // MP4, MOV, M4V
+  if (head[0] == 0x1A && head[1] == 0x45 && head[2] == 0xDF &&
+      head[3] == 0xA3)
+    return MediaKind::Video; // Matroska, WebM
+  if (head[0] == 0x30 && head[1] == 0x26 && head[2] == 0xB2 &&
+      head[3] == 0x75)
+    return MediaKind::Video; // ASF, WMV
+  if (at(0, "FLV"))
+    return MediaKind::Video;
+  return MediaKind::Unknown;
+}
+
+MediaKind classifyMediaFile(const std::string &filename, bool sniff) {
+  MediaKind kind = MediaKind::Unknown;
+  if (sniff)
+    kind = sniffMediaKind(filename);
+  else if (isImageFile(filename))
+    kind = MediaKind::Image;
+  else if (isVideoFile(filename))
+    kind = MediaKind::Video;
+  // Animations and sequences go through the frame pipeline
+  if (kind == MediaKind::Image && isMultiFrameImage(filename))
+    kind = MediaKind::Video;
+  return kind;
+}
+
+std::vector<MediaEntry> crawlDirectory(const std::string &root,
+                                       const CrawlOptions &options) {
+  std::vector<MediaEntry> entries;
+  std::mutex entriesMutex;
+  // Unbounded: walkers queue subdirectories from inside the pool
+  ThreadPool pool(options.threads);
+
+  // Each task lists one directory; subdirectories become new tasks so
+  // slow stat calls on network filesystems overlap across threads
+  std::function<void(fs::path)> walk = [&](fs::path directory) {
+    std::error_code ec;
+    fs::directory_iterator it(
+        directory, fs::directory_options::skip_permission_denied, ec);
+    if (ec) {
+      std::cerr << "Warning: Could not read directory: " << directory.string()
+                << std::endl;
+      return;
+    }
+    std::vector<MediaEntry> found;
+    for (; it != fs::directory_iterator(); it.increment(ec)) {
+      if (ec)
+        break;
+      const fs::directory_entry &entry = *it;
+      // Symlinked directories are not followed, which rules out cycles
+      if (entry.is_directory(ec) && !entry.is_symlink(ec)) {
+        fs::path subdirectory = entry.path();
+        pool.submit([&walk, subdirectory] { walk(subdirectory); });
+        continue;
+      }
+      if (!entry.is_regular_file(ec))
+        continue;
+      std::string path = entry.path().string();
+      MediaKind kind = classifyMediaFile(path, options.sniff);
+      if (kind == MediaKind::Unknown)
+        continue;
+      std::uintmax_t size = entry.file_size(ec);
+      found.push_back({path, kind, ec ? 0 : size});
+    }
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    entries.insert(entries.end(), found.begin(), found.end());
+  };
+
+  pool.submit([&walk, root] { walk(fs::path(root)); });
+  pool.wait();
+
+  std::sort(entries.begin(), entries.end(),
+            [](const MediaEntry &a, const MediaEntry &b) {
+              return a.path < b.path;
+            });
+  return entries;
+}
+
+std::vector<std::string> readInputList(std::istream &input) {
+  std::vector<std::string> paths;
+  std::string line;
+  while (std::getline(input, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.empty() || line[0] == '#')
+      continue;
+    paths.push_back(line);
+  }
+  return paths;
+}
+
+bool Checkpoint::open(const std::string &filename, bool resume,
+                      const Shard *shard) {
+  done_.clear();
+  resumed_ = {{"images", nlohmann::json::array()},
+              {"videos", nlohmann::json::array()}};
+  if (resume) {
+    std::ifstream input(filename);
+    std::string line;
+    while (std::getline(input, line)) {
+      // A crash mid-write leaves a truncated last line; skip it
+      nlohmann::json record = nlohmann::json::parse(line, nullptr, false);
+      if (record.is_discarded() || !record.is_object() ||
+          !record.contains("result"))
+        continue;
+      std::string path = record.value("path", "");
+      if (path.empty() || !done_.insert(path).second)
+        continue;
+      const char *group =
+          record.value("kind", "") == "video" ? "videos" : "images";
+      resumed_[group].push_back(record["result"]);
+    }
+  }
+  bool empty = true;
+  bool endsMidLine = false;
+  if (resume) {
+    std::ifstream tail(filename, std::ios::binary | std::ios::ate);
+    if (tail.is_open() && tail.tellg() > 0) {
+      empty = false;
+      tail.seekg(-1, std::ios::end);
+      endsMidLine = tail.get() != '\n';
+    }
+  }
+  output_.open(filename, resume ? std::ios::app : std::ios::trunc);
+  if (endsMidLine)
+    output_ << '\n'; // Terminate the truncated line before appending
+  if (empty && shard != nullptr) {
+    nlohmann::json header = {
+        {"shard", {{"index", shard->index}, {"count", shard->count}}}};
+    output_ << header.dump() << '\n' << std::flush;
+  }
+  return output_.is_open();
+}
+
+bool Checkpoint::isDone(const std::string &path) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return done_.count(path) != 0;
+}
+
+void Checkpoint::record(const std::string &path, MediaKind kind,
+                        const nlohmann::json &result) {
+  TraceSpan span("serialize", path);
+  nlohmann::json record = {
+      {"path", path},
+      {"kind", kind == MediaKind::Video ? "video" : "image"},
+      {"result", result}};
+  // One line per file, flushed so a crash loses at most the file in flight
+  std::lock_guard<std::mutex> lock(mutex_);
+  output_ << record.dump() << '\n' << std::flush;
+  done_.insert(path);
+}
+
+const nlohmann::json &Checkpoint::getResumedResults() const {
+  return resumed_;
+}
@@ -0,0 +1,49 @@
+#include "vidicant/deadline.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+// Longest budget honored, so the end time cannot overflow the clock.
+constexpr double kMaxBudgetSeconds = 1e9;
+
+} // namespace
+
+Deadline::Deadline() = default;
+
+Deadline::Deadline(double seconds) : set_(seconds > 0) {
+  if (set_)
+    end_ = Clock::now() +
+           std::chrono::duration_cast<Clock::duration>(
+               std::chrono::duration<double>(
+                   std::min(seconds, kMaxBudgetSeconds)));
+}
+
+bool Deadline::isSet() const { return set_; }
+
+bool Deadline::expired() const { return set_ && Clock::now() >= end_; }
+
+namespace vidicant {
+
+bool parseDuration(const std::string &text, double &seconds) {
+  if (text.empty())
+    return false;
+  char *end = nullptr;
+  double value = std::strtod(text.c_str(), &end);
+  if (end == text.c_str() || !std::isfinite(value) || value < 0)
+    return false;
+  std::string unit(end);
+  if (unit.empty() || unit == "s") {
+    seconds = value;
+  } else if (unit == "ms") {
+    seconds = value / 1000.0;
+  } else if (unit == "m") {
+    seconds = value * 60.0;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+} // namespace vidicant
@@ -0,0 +1,27 @@
+#include "vidicant/frame_pool.hpp"
+#include "vidicant/memory_stats.hpp"
+
+cv::Mat &FrameArena::slot(FrameSlot slot) {
+  return slots_[static_cast<std::size_t>(slot)];
+}
+
+void FrameArena::beginPass() {
+  framesInPass_ = 0;
+  mark_ = vidicant::getThreadMatAllocations();
+}
+
+void FrameArena::endFrame() {
+  std::uint64_t now = vidicant::getThreadMatAllocations();
+  auto count = static_cast<std::size_t>(now - mark_);
+  allocations_ += count;
+  if (framesInPass_ >= kWarmupFrames)
+    steadyStateAllocations_ += count;
+  mark_ = now;
+  ++framesInPass_;
+}
+
+std::size_t FrameArena::getAllocationCount() const { return allocations_; }
+
+std::size_t FrameArena::getSteadyStateAllocationCount() const {
+  return steadyStateAllocations_;
+}
@@ -0,0 +1,294 @@
+#include "vidicant/frame_series.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace {
+
+constexpr char kMagic[4] = {'V', 'F', 'S', '1'};
+constexpr std::size_t kHeaderBytes = 16; // Magic, fps, sample count
+constexpr std::size_t kRecordBytes = 20; // Frame index and four floats
+
+// Appends an integer to a buffer in little-endian order.
+void putLE(std::vector<unsigned char> &out, std::uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i)
+    out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+}
+
+// Reads a little-endian integer from a buffer.
+std::uint64_t getLE(const unsigned char *in, int bytes) {
+  std::uint64_t value = 0;
+  for (int i = bytes - 1; i >= 0; --i)
+    value = (value << 8) | in[i];
+  return value;
+}
+
+// Appends a float to a buffer as its little-endian IEEE 754 bits.
+void putFloat(std::vector<unsigned char> &out, float value) {
+  std::uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  putLE(out, bits, 4);
+}
+
+// Reads a float stored by putFloat.
+float getFloat(const unsigned char *in) {
+  std::uint32_t bits = static_cast<std::uint32_t>(getLE(in, 4));
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Counts the frames in a span of seconds at a frame rate, at least one.
+int framesIn(double seconds, double fps) {
+  double frames = fps > 0 ? seconds * fps : seconds;
+  return std::max(1, static_cast<int>(std::lround(frames)));
+}
+
+} // namespace
+
+FrameSeries::FrameSeries(double fps) : fps_(fps) {}
+
+void FrameSeries::add(const FrameSample &sample) { samples_.push_back(sample); }
+
+const std::vector<FrameSample> &FrameSeries::getSamples() const {
+  return samples_;
+}
+
+std::size_t FrameSeries::size() const { return samples_.size(); }
+
+double FrameSeries::getFPS() const { return fps_; }
+
+std::vector<int> FrameSeries::detectSceneChanges(double threshold,
+                                                 int maxFrame) const {
+  return detectSceneChanges(std::vector<double>{threshold}, maxFrame)[0];
+}
+
+std::vector<std::vector<int>>
+FrameSeries::detectSceneChanges(const std::vector<double> &thresholds,
+                                int maxFrame) const {
+  std::vector<std::vector<int>> changes(thresholds.size());
+  for (const auto &sample : samples_) {
+    if (maxFrame >= 0 && sample.frame > maxFrame)
+      break;
+    if (sample.frame == 0)
+      continue; // The first frame has nothing to differ from
+    for (std::size_t t = 0; t < thresholds.size(); ++t) {
+      if (sample.meanDiff > thresholds[t])
+        changes[t].push_back(sample.frame);
+    }
+  }
+  return changes;
+}
+
+double FrameSeries::getAverageBrightness(int frames) const {
+  double total = 0.0;
+  int count = 0;
+  for (const auto &sample : samples_) {
+    if (sample.frame >= frames)
+      break;
+    total += sample.brightness;
+    ++count;
+  }
+  return count > 0 ? total / count : -1.0;
+}
+
+double FrameSeries::getMotionScore(int frames) const {
+  double total = 0.0;
+  int count = 0;
+  for (const auto &sample : samples_) {
+    if (sample.frame >= frames)
+      break;
+    if (sample.frame == 0)
+      continue; // The first frame has nothing to differ from
+    total += sample.meanDiff;
+    ++count;
+  }
+  return count > 0 ? total / count : 0.0;
+}
+
+double FrameSeries::getColorConsistency(int frames) const {
+  std::size_t count = 0;
+  double total = 0.0;
+  while (count < samples_.size() && samples_[count].frame < frames)
+    total += samples_[count++].brightness;
+  if (count == 0)
+    return -1.0;
+  double mean = total / count;
+  double variance = 0.0;
+  for (std::size_t i = 0; i < count; ++i) {
+    double deviation = samples_[i].brightness - mean;
+    variance += deviation * deviation;
+  }
+  variance /= count;
+  return mean > 0 ? std::sqrt(variance) / mean : 0.0;
+}
+
+std::vector<QcEvent>
+FrameSeries::detectQcEvents(const QcOptions &options) const {
+  std::vector<QcEvent> events;
+  int blackMin = framesIn(options.blackMinSeconds, fps_);
+  int freezeMin = framesIn(options.freezeMinSeconds, fps_);
+  int flashMax = framesIn(options.flashMaxSeconds, fps_);
+
+  // Open ranges, -1 when none; a freeze starts at the frame being repeated
+  int blackStart = -1;
+  int freezeStart = -1;
+  int flashStart = -1;
+  float flashBase = 0.0f;
+  auto close = [&events](QcEventType type, int &start, int end, int min) {
+    if (start >= 0 && end - start >= min)
+      events.push_back({type, start, end});
+    start = -1;
+  };
+  for (std::size_t i = 0; i < samples_.size(); ++i) {
+    const FrameSample &sample = samples_[i];
+    // Ranges only span consecutive frames
+    if (i > 0 && sample.frame != samples_[i - 1].frame + 1) {
+      int end = samples_[i - 1].frame + 1;
+      close(QcEventType::Black, blackStart, end, blackMin);
+      close(QcEventType::Freeze, freezeStart, end, freezeMin);
+      flashStart = -1;
+    }
+
+    if (sample.brightness <= options.blackBrightness) {
+      if (blackStart < 0)
+        blackStart = sample.frame;
+    } else {
+      close(QcEventType::Black, blackStart, sample.frame, blackMin);
+    }
+
+    bool repeat = i > 0 && sample.frame == samples_[i - 1].frame + 1 &&
+                  sample.meanDiff <= options.freezeDiff;
+    if (repeat) {
+      if (freezeStart < 0)
+        freezeStart = sample.frame - 1;
+    } else {
+      close(QcEventType::Freeze, freezeStart, sample.frame, freezeMin);
+    }
+
+    // A flash ends when brightness falls back halfway to where it rose
+    // from; one that lasts too long is a cut to a brighter scene instead
+    if (flashStart >= 0) {
+      if (sample.brightness <= flashBase + options.flashBrightness / 2) {
+        events.push_back({QcEventType::Flash, flashStart, sample.frame});
+        flashStart = -1;
+      } else if (sample.frame - flashStart >= flashMax) {
+        flashStart = -1;
+      }
+    } else if (i > 0 && sample.frame == samples_[i - 1].frame + 1 &&
+               sample.brightness - samples_[i - 1].brightness >=
+                   options.flashBrightness) {
+      flashStart = sample.frame;
+      flashBase = samples_[i - 1].brightness;
+    }
+  }
+  if (!samples_.empty()) {
+    int end = samples_.back().frame + 1;
+    close(QcEventType::Black, blackStart, end, blackMin);
+    close(QcEventType::Freeze, freezeStart, end, freezeMin);
+  }
+
+  std::stable_sort(events.begin(), events.end(),
+                   [](const QcEvent &a, const QcEvent &b) {
+                     if (a.startFrame != b.startFrame)
+                       return a.startFrame < b.startFrame;
+                     return a.type < b.type;
+                   });
+  return events;
+}
+
+std::vector<SeriesWindow> FrameSeries::summarize(int windowFrames) const {
+  std::vector<SeriesWindow> windows;
+  if (windowFrames <= 0)
+    return windows;
+  std::size_t step = static_cast<std::size_t>(windowFrames);
+  for (std::size_t start = 0; start < samples_.size(); start += step) {
+    std::size_t end = std::min(samples_.size(), start + step);
+    SeriesWindow window;
+    window.startFrame = samples_[start].frame;
+    window.endFrame = samples_[end - 1].frame + 1;
+    for (std::size_t i = start; i < end; ++i) {
+      const FrameSample &sample = samples_[i];
+      window.brightness += sample.brightness;
+      window.meanDiff += sample.meanDiff;
+      window.maxDiff = std::max<double>(window.maxDiff, sample.meanDiff);
+      window.histogramDistance += sample.histogramDistance;
+      window.maxHistogramDistance = std::max<double>(
+          window.maxHistogramDistance, sample.histogramDistance);
+      window.saturation += sample.saturation;
+    }
+    double count = static_cast<double>(end - start);
+    window.brightness /= count;
+    window.meanDiff /= count;
+    window.histogramDistance /= count;
+    window.saturation /= count;
+    windows.push_back(window);
+  }
+  return windows;
+}
+
+bool FrameSeries::writeCsv(const std::string &path) const {
+  std::ofstream output(path);
+  if (!output.is_open())
+    return false;
+  output << "frame,time,brightness,mean_diff,histogram_distance,saturation\n";
+  for (const auto &sample : samples_) {
+    double time = fps_ > 0 ? sample.frame / fps_ : 0.0;
+    output << sample.frame << ',' << time << ',' << sample.brightness << ','
+           << sample.meanDiff << ',' << sample.histogramDistance << ','
+           << sample.saturation << '\n';
+  }
+  return static_cast<bool>(output);
+}
+
+bool FrameSeries::writeBinary(const std::string &path) const {
+  std::vector<unsigned char> bytes(kMagic, kMagic + sizeof(kMagic));
+  bytes.reserve(kHeaderBytes + samples_.size() * kRecordBytes);
+  std::uint64_t fpsBits;
+  std::memcpy(&fpsBits, &fps_, sizeof(fpsBits));
+  putLE(bytes, fpsBits, 8);
+  putLE(bytes, samples_.size(), 4);
+  for (const auto &sample : samples_) {
+    putLE(bytes, static_cast<std::uint32_t>(sample.frame), 4);
+    putFloat(bytes, sample.brightness);
+    putFloat(bytes, sample.meanDiff);
+    putFloat(bytes, sample.histogramDistance);
+    putFloat(bytes, sample.saturation);
+  }
+  std::ofstream output(path, std::ios::binary);
+  if (!output.is_open())
+    return false;
+  output.write(reinterpret_cast<const char *>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+  return static_cast<bool>(output);
+}
+
+bool FrameSeries::readBinary(const std::string &path) {
+  std::ifstream input(path, std::ios::binary);
+  unsigned char header[kHeaderBytes];
+  if (!input.read(reinterpret_cast<char *>(header), kHeaderBytes) ||
+      std::memcmp(header, kMagic, sizeof(kMagic)) != 0)
+    return false;
+  std::uint64_t fpsBits = getLE(header + 4, 8);
+  std::size_t count = static_cast<std::size_t>(getLE(header + 12, 4));
+
+  std::vector<FrameSample> samples;
+  unsigned char record[kRecordBytes];
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!input.read(reinterpret_cast<char *>(record), kRecordBytes))
+      return false;
+    FrameSample sample;
+    sample.frame = static_cast<std::int32_t>(getLE(record, 4));
+    sample.brightness = getFloat(record + 4);
+    sample.meanDiff = getFloat(record + 8);
+    sample.histogramDistance = getFloat(record + 12);
+    sample.saturation = getFloat(record + 16);
+    samples.push_back(sample);
+  }
+  std::memcpy(&fps_, &fpsBits, sizeof(fps_));
+  samples_ = std::move(samples);
+  return true;
+}
@@ -0,0 +1,180 @@
+#include "vidicant/hash_index.hpp"
+#include "vidicant/phash.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+// On-disk layout, all fields in host byte order:
+//   header | hashes[count] | pathOffsets[count + 1] | tables[4][count] | paths
+// Table entries are (chunk << 48 | id), sorted, so each chunk value is one
+// contiguous range found by binary search.
+const char kMagic[8] = {'V', 'D', 'H', 'A', 'S', 'H', '0', '1'};
+
+struct IndexHeader {
+  char magic[8];
+  std::uint64_t count;
+  std::uint64_t hashesOffset;
+  std::uint64_t pathOffsetsOffset;
+  std::uint64_t tablesOffset[HashIndex::kChunks];
+  std::uint64_t pathsOffset;
+  std::uint64_t pathsSize;
+};
+
+constexpr int kChunkBits = 16;
+constexpr std::uint64_t kIdMask = (std::uint64_t{1} << 48) - 1;
+
+// Checks that an 8-byte aligned region of `words` 64-bit values starting at
+// `offset` lies within a file of `size` bytes.
+bool wordsFit(std::uint64_t offset, std::uint64_t words, std::uint64_t size) {
+  return offset % 8 == 0 && offset <= size && words <= (size - offset) / 8;
+}
+
+std::uint64_t chunkOf(std::uint64_t hash, int chunk) {
+  return (hash >> (chunk * kChunkBits)) & 0xFFFF;
+}
+
+// Appends every 16-bit value within Hamming distance `radius` of `value`,
+// flipping bits at positions >= `from` only so each value appears once.
+void chunkNeighbors(std::uint64_t value, int radius, int from,
+                    std::vector<std::uint64_t> &out) {
+  out.push_back(value);
+  if (radius == 0)
+    return;
+  for (int bit = from; bit < kChunkBits; ++bit)
+    chunkNeighbors(value ^ (std::uint64_t{1} << bit), radius - 1, bit + 1, out);
+}
+
+} // namespace
+
+void HashIndexWriter::add(std::uint64_t hash, const std::string &path) {
+  hashes_.push_back(hash);
+  paths_.push_back(path);
+}
+
+std::size_t HashIndexWriter::size() const { return hashes_.size(); }
+
+bool HashIndexWriter::write(const std::string &filename) const {
+  IndexHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  std::uint64_t count = hashes_.size();
+  header.count = count;
+  header.hashesOffset = sizeof(IndexHeader);
+  header.pathOffsetsOffset = header.hashesOffset + count * 8;
+  std::uint64_t offset = header.pathOffsetsOffset + (count + 1) * 8;
+  for (int c = 0; c < HashIndex::kChunks; ++c) {
+    header.tablesOffset[c] = offset;
+    offset += count * 8;
+  }
+  header.pathsOffset = offset;
+
+  std::vector<std::uint64_t> pathOffsets;
+  pathOffsets.reserve(count + 1);
+  std::uint64_t pathsSize = 0;
+  for (const auto &path : paths_) {
+    pathOffsets.push_back(pathsSize);
+    pathsSize += path.size();
+  }
+  pathOffsets.push_back(pathsSize);
+  header.pathsSize = pathsSize;
+
+  std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+  if (!output.is_open())
+    return false;
+  output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  output.write(reinterpret_cast<const char *>(hashes_.data()), count * 8);
+  output.write(reinterpret_cast<const char *>(pathOffsets.data()),
+               (count + 1) * 8);
+  std::vector<std::uint64_t> table(count);
+  for (int c = 0; c < HashIndex::kChunks; ++c) {
+    for (std::uint64_t id = 0; id < count; ++id)
+      table[id] = (chunkOf(hashes_[id], c) << 48) | id;
+    std::sort(table.begin(), table.end());
+    output.write(reinterpret_cast<const char *>(table.data()), count * 8);
+  }
+  for (const auto &path : paths_)
+    output.write(path.data(), static_cast<std::streamsize>(path.size()));
+  return static_cast<bool>(output);
+}
+
+bool HashIndex::open(const std::string &filename) {
+  count_ = 0;
+  if (!file_.open(filename, MappedFile::Access::Random))
+    return false;
+  std::uint64_t size = file_.size();
+  if (size < sizeof(IndexHeader))
+    return false;
+  IndexHeader header;
+  std::memcpy(&header, file_.data(), sizeof(header));
+  std::uint64_t count = header.count;
+  // Every region must lie inside the file; count is bounded first so that
+  // count + 1 cannot wrap
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      count > size / 8 || !wordsFit(header.hashesOffset, count, size) ||
+      !wordsFit(header.pathOffsetsOffset, count + 1, size) ||
+      header.pathsOffset > size || header.pathsSize > size - header.pathsOffset)
+    return false;
+  for (int c = 0; c < kChunks; ++c)
+    if (!wordsFit(header.tablesOffset[c], count, size))
+      return false;
+  const unsigned char *base = file_.data();
+  hashes_ = reinterpret_cast<const std::uint64_t *>(base + header.hashesOffset);
+  pathOffsets_ = reinterpret_cast<const std::uint64_t *>(
+      base + header.pathOffsetsOffset);
+  for (int c = 0; c < kChunks; ++c)
+    tables_[c] = reinterpret_cast<const std::uint64_t *>(
+        base + header.tablesOffset[c]);
+  paths_ = reinterpret_cast<const char *>(base + header.pathsOffset);
+  pathsSize_ = header.pathsSize;
+  count_ = count;
+  return true;
+}
+
+std::size_t HashIndex::size() const { return count_; }
+
+std::vector<HashMatch> HashIndex::query(std::uint64_t hash,
+                                        int maxDistance) const {
+  std::vector<HashMatch> matches;
+  if (count_ == 0 || maxDistance < 0)
+    return matches;
+  int radius = std::min(maxDistance / kChunks, kChunkBits);
+
+  std::vector<std::uint64_t> ids;
+  std::vector<std::uint64_t> neighbors;
+  for (int c = 0; c < kChunks; ++c) {
+    neighbors.clear();
+    chunkNeighbors(chunkOf(hash, c), radius, 0, neighbors);
+    const std::uint64_t *table = tables_[c];
+    for (std::uint64_t value : neighbors) {
+      const std::uint64_t *first =
+          std::lower_bound(table, table + count_, value << 48);
+      for (; first != table + count_ && (*first >> 48) == value; ++first)
+        ids.push_back(*first & kIdMask);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  for (std::uint64_t id : ids) {
+    // Table entries and path offsets are checked here rather than at open,
+    // which would read the whole file
+    if (id >= count_)
+      continue;
+    int distance = vidicant::hammingDistance(hashes_[id], hash);
+    if (distance > maxDistance)
+      continue;
+    std::uint64_t begin = pathOffsets_[id];
+    std::uint64_t end = pathOffsets_[id + 1];
+    if (begin > end || end > pathsSize_)
+      continue;
+    matches.push_back({std::string(paths_ + begin, paths_ + end), hashes_[id],
+                       distance});
+  }
+  std::sort(matches.begin(), matches.end(),
+            [](const HashMatch &a, const HashMatch &b) {
+              return a.distance != b.distance ? a.distance < b.distance
+                                              : a.path < b.path;
+            });
+  return matches;
+}
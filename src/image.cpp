@@ -1,15 +1,72 @@
 #include "vidicant/image.hpp"
+#include "vidicant/color_model.hpp"
+#include "vidicant/trace.hpp"
+#include <cmath>
 #include <iostream>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/opencv.hpp>
 
+namespace {
+
+// Decode at the file's own bit depth and channel count, so 16-bit scans
+// and grayscale files are not converted to 8-bit BGR
+const int kReadFlags = cv::IMREAD_ANYDEPTH | cv::IMREAD_ANYCOLOR;
+
+// Pixels of the downscaled copy a budgeted analysis starts from
+constexpr double kPreviewPixels = 512.0 * 512.0;
+
+// Runs one metric of the registry over an image.
+// @return The metric's result, or nothing if the image is empty.
+template <typename Metric>
+std::optional<typename Metric::Result>
+measure(const cv::Mat &image, const MetricOptions &options = MetricOptions()) {
+  constexpr std::size_t index = ImageMetricEngine::indexOf<Metric>();
+  ImageMetricEngine::Selection selection;
+  selection.set(index);
+  ImageMetricEngine engine(selection, options);
+  engine.addFrame(image);
+  return std::get<index>(engine.finish());
+}
+
+} // namespace
+
 cv::Mat OpenCVImageLoader::imread(const std::string &filename) {
-  return cv::imread(filename);
+  TraceSpan span("decode", filename);
+  return cv::imread(filename, kReadFlags);
+}
+
+const std::vector<unsigned char> *IImageLoader::getEncodedBytes() const {
+  return nullptr;
+}
+
+MemoryImageLoader::MemoryImageLoader(std::vector<unsigned char> bytes)
+    : bytes_(std::move(bytes)) {}
+
+MemoryImageLoader::~MemoryImageLoader() = default;
+
+const std::vector<unsigned char> *MemoryImageLoader::getEncodedBytes() const {
+  return &bytes_;
+}
+
+cv::Mat MemoryImageLoader::imread(const std::string & /*filename*/) {
+  if (!decoded_) {
+    TraceSpan span("decode");
+    decoded_ = std::make_unique<cv::Mat>();
+    if (!bytes_.empty())
+      *decoded_ = cv::imdecode(bytes_, kReadFlags);
+    bytes_.clear(); // Only the decoded image is needed from here on
+    bytes_.shrink_to_fit();
+  }
+  return *decoded_;
 }
 
 ImageHandler::ImageHandler(std::unique_ptr<IImageLoader> loader)
     : loader_(std::move(loader)) {}
 
+const std::vector<unsigned char> *ImageHandler::getEncodedBytes() const {
+  return loader_->getEncodedBytes();
+}
+
 std::pair<int, int> ImageHandler::getDimensions(const std::string &filename) {
   cv::Mat image = loader_->imread(filename);
   if (image.empty()) {
@@ -28,12 +85,7 @@ bool ImageHandler::isGrayscale(const std::string &filename) {
 
 double ImageHandler::getAverageBrightness(const std::string &filename) {
   cv::Mat image = loader_->imread(filename);
-  if (image.empty())
-    return -1.0;
-  cv::Scalar mean = cv::mean(image);
-  if (image.channels() == 1)
-    return mean[0];
-  return (mean[0] + mean[1] + mean[2]) / 3.0;
+  return measure<AverageBrightnessMetric>(image).value_or(-1.0);
 }
 
 int ImageHandler::getNumberOfChannels(const std::string &filename) {
@@ -45,16 +97,7 @@ int ImageHandler::getNumberOfChannels(const std::string &filename) {
 
 int ImageHandler::getEdgeCount(const std::string &filename) {
   cv::Mat image = loader_->imread(filename);
-  if (image.empty())
-    return -1;
-  cv::Mat gray, edges;
-  if (image.channels() == 1) {
-    gray = image;
-  } else {
-    cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
-  }
-  cv::Canny(gray, edges, 100, 200);
-  return cv::countNonZero(edges);
+  return measure<EdgeCountMetric>(image).value_or(-1);
 }
 
 std::vector<std::array<double, 3>>
@@ -63,83 +106,33 @@ ImageHandler::getDominantColors(const std::string &filename, int k) {
   if (image.empty())
     return {};
   cv::Mat data;
-  image.convertTo(data, CV_32F);
+  image.convertTo(data, CV_32F, getLevelScale(image.depth()));
   data = data.reshape(1, data.total());
-
-  std::vector<int> labels;
-  cv::Mat centers;
-  cv::kmeans(data, k, labels,
-             cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT,
-                              10, 1.0),
-             3, cv::KMEANS_PP_CENTERS, centers);
-
-  std::vector<std::array<double, 3>> dominantColors;
-  for (int i = 0; i < k; ++i) {
-    dominantColors.push_back({centers.at<float>(i, 0), centers.at<float>(i, 1),
-                              centers.at<float>(i, 2)});
-  }
-  return dominantColors;
+  return vidicant::clusterColors(data, k);
 }
 
 double ImageHandler::getBlurScore(const std::string &filename) {
   cv::Mat image = loader_->imread(filename);
-  if (image.empty())
-    return -1.0;
-  cv::Mat gray, laplacian;
-  if (image.channels() == 1) {
-    gray = image;
-  } else {
-    cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
-  }
-  cv::Laplacian(gray, laplacian, CV_64F);
-  cv::Scalar mean, stddev;
-  cv::meanStdDev(laplacian, mean, stddev);
-  return stddev[0] * stddev[0]; // Variance
+  return measure<BlurScoreMetric>(image).value_or(-1.0);
 }
 
 double ImageHandler::getContrastRatio(const std::string &filename) {
   cv::Mat image = loader_->imread(filename);
-  if (image.empty())
-    return -1.0;
-  cv::Mat gray;
-  if (image.channels() == 1) {
-    gray = image;
-  } else {
-    cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
-  }
-  double minVal, maxVal;
-  cv::minMaxLoc(gray, &minVal, &maxVal);
-  return maxVal > 0 ? maxVal / (minVal + 1e-6) : 0.0; // Avoid division by zero
+  return measure<ContrastRatioMetric>(image).value_or(-1.0);
 }
 
 double ImageHandler::getSaturationLevel(const std::string &filename) {
   cv::Mat image = loader_->imread(filename);
-  if (image.empty() || image.channels() < 3)
-    return -1.0;
-  cv::Mat hsv;
-  cv::cvtColor(image, hsv, cv::COLOR_BGR2HSV);
-  cv::Scalar mean = cv::mean(hsv);
-  return mean[1]; // Saturation channel
+  return measure<SaturationLevelMetric>(image).value_or(-1.0);
 }
 
 std::vector<std::vector<int>>
-ImageHandler::getHistogram(const std::string &filename) {
+ImageHandler::getHistogram(const std::string &filename, int bins) {
   cv::Mat image = loader_->imread(filename);
-  if (image.empty())
-    return {};
-  std::vector<cv::Mat> channels;
-  cv::split(image, channels);
-  std::vector<std::vector<int>> histograms;
-  for (const auto &channel : channels) {
-    std::vector<int> hist(256, 0);
-    for (int i = 0; i < channel.rows; ++i) {
-      for (int j = 0; j < channel.cols; ++j) {
-        hist[channel.at<uchar>(i, j)]++;
-      }
-    }
-    histograms.push_back(hist);
-  }
-  return histograms;
+  MetricOptions options;
+  options.histogramBins = bins;
+  return measure<HistogramMetric>(image, options)
+      .value_or(std::vector<std::vector<int>>());
 }
 
 double ImageHandler::getAspectRatio(const std::string &filename) {
@@ -149,28 +142,57 @@ double ImageHandler::getAspectRatio(const std::string &filename) {
 
 double ImageHandler::getImageEntropy(const std::string &filename) {
   cv::Mat image = loader_->imread(filename);
-  if (image.empty())
-    return -1.0;
-  cv::Mat gray;
-  if (image.channels() == 1) {
-    gray = image;
-  } else {
-    cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+  return measure<EntropyMetric>(image).value_or(-1.0);
+}
+
+PerceptualHash ImageHandler::getPerceptualHash(const std::string &filename) {
+  cv::Mat image = loader_->imread(filename);
+  return measure<PerceptualHashMetric>(image).value_or(PerceptualHash());
+}
+
+bool ImageHandler::analyze(const std::string &filename,
+                           ImageMetricEngine &engine, ActiveArea *activeArea,
+                           const Deadline &deadline,
+                           AnalysisProgress *progress) {
+  cv::Mat image = loader_->imread(filename);
+  if (image.empty()) {
+    std::cerr << "Could not open or find the image: " << filename << std::endl;
+    return false;
+  }
+  cv::Mat view = image;
+  if (activeArea) {
+    *activeArea = vidicant::detectActiveArea(image);
+    view = image(activeArea->rect);
   }
-  cv::Mat hist;
-  int histSize = 256;
-  float range[] = {0, 256};
-  const float *histRange = {range};
-  cv::calcHist(&gray, 1, 0, cv::Mat(), hist, 1, &histSize, &histRange);
-  hist /= gray.total(); // Normalize
-  double entropy = 0.0;
-  for (int i = 0; i < histSize; ++i) {
-    float p = hist.at<float>(i);
-    if (p > 0) {
-      entropy -= p * log2(p);
+  AnalysisProgress done;
+  done.frameSize = view.size();
+
+  // A budgeted pass starts with a coarse result from a downscaled copy,
+  // which a fresh engine then refines over the full image while time
+  // remains
+  double pixels = static_cast<double>(view.total());
+  if (deadline.isSet() && pixels > kPreviewPixels) {
+    ImageMetricEngine full = engine;
+    double factor = std::sqrt(kPreviewPixels / pixels);
+    cv::Mat preview;
+    {
+      TraceSpan span("preview");
+      cv::resize(view, preview, cv::Size(), factor, factor, cv::INTER_AREA);
     }
+    engine.addFrame(preview);
+    done.coverage = static_cast<double>(preview.total()) / pixels;
+    if (!deadline.expired()) {
+      full.addFrame(view);
+      engine = std::move(full);
+      done.coverage = 1.0;
+    }
+  } else {
+    engine.addFrame(view);
   }
-  return entropy;
+  done.interrupted = deadline.expired();
+  if (progress)
+    *progress = done;
+  return true;
 }
 
 namespace vidicant {
@@ -230,10 +252,11 @@ double getImageSaturationLevel(const std::string &filename) {
   return handler.getSaturationLevel(filename);
 }
 
-std::vector<std::vector<int>> getImageHistogram(const std::string &filename) {
+std::vector<std::vector<int>> getImageHistogram(const std::string &filename,
+                                                int bins) {
   auto loader = std::make_unique<OpenCVImageLoader>();
   ImageHandler handler(std::move(loader));
-  return handler.getHistogram(filename);
+  return handler.getHistogram(filename, bins);
 }
 
 double getImageAspectRatio(const std::string &filename) {
@@ -248,4 +271,10 @@ double getImageEntropy(const std::string &filename) {
   return handler.getImageEntropy(filename);
 }
 
+PerceptualHash getImagePerceptualHash(const std::string &filename) {
+  auto loader = std::make_unique<OpenCVImageLoader>();
+  ImageHandler handler(std::move(loader));
+  return handler.getPerceptualHash(filename);
+}
+
 } // namespace vidicant
@@ -0,0 +1,257 @@
+#include "vidicant/image_sequence.hpp"
+#include "vidicant/parallelism.hpp"
+#include "vidicant/probe.hpp"
+#include "vidicant/thread_pool.hpp"
+#include "vidicant/trace.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <opencv2/core.hpp>
+
+namespace {
+
+const char *const kImageExtensions[] = {".jpg", ".jpeg", ".png",
+                                        ".bmp", ".tiff", ".tif",
+                                        ".webp"};
+
+// Finds the integer conversion of a sequence pattern.
+// @return True if there is exactly one, with its [begin, end) and width.
+bool findConversion(const std::string &pattern, std::size_t &begin,
+                    std::size_t &end, int &width, bool &zeroPad) {
+  int conversions = 0;
+  for (std::size_t i = 0; i < pattern.size(); ++i) {
+    if (pattern[i] != '%')
+      continue;
+    std::size_t j = i + 1;
+    bool zero = j < pattern.size() && pattern[j] == '0';
+    std::size_t digits = j;
+    while (digits < pattern.size() &&
+           std::isdigit(static_cast<unsigned char>(pattern[digits])))
+      ++digits;
+    if (digits >= pattern.size() || pattern[digits] != 'd')
+      return false; // Any other conversion, or a stray '%'
+    begin = i;
+    end = digits + 1;
+    width = digits > j ? std::stoi(pattern.substr(j, digits - j)) : 0;
+    zeroPad = zero;
+    ++conversions;
+    i = digits;
+  }
+  return conversions == 1;
+}
+
+// Checks whether frame `number` of a sequence exists.
+bool frameExists(const std::string &pattern, int number) {
+  std::error_code ec;
+  return std::filesystem::is_regular_file(
+      vidicant::formatSequencePath(pattern, number), ec);
+}
+
+} // namespace
+
+bool AnimatedImageLoader::open(const std::string &filename) {
+  MediaProbe probe = vidicant::probeImage(filename);
+  if (!probe.ok)
+    return false;
+  frameCount_ = probe.frameCount;
+  fps_ = probe.duration > 0 ? probe.frameCount / probe.duration : kDefaultFPS;
+  resolution_ = {probe.width, probe.height};
+  index_ = 0;
+
+  // Prefer the image codecs when they see every frame of the animation;
+  // older ones decode only the first
+  useCollection_ = false;
+  try {
+    collection_.init(filename, cv::IMREAD_COLOR);
+    useCollection_ =
+        collection_.size() == static_cast<std::size_t>(frameCount_);
+  } catch (const cv::Exception &) {
+    useCollection_ = false;
+  }
+  if (useCollection_)
+    return true;
+  if (video_.open(filename))
+    return true;
+  useCollection_ = collection_.size() > 0;
+  return useCollection_;
+}
+
+int AnimatedImageLoader::getFrameCount() { return frameCount_; }
+
+double AnimatedImageLoader::getFPS() { return fps_; }
+
+std::pair<int, int> AnimatedImageLoader::getResolution() {
+  return resolution_;
+}
+
+cv::Mat AnimatedImageLoader::readFrame() {
+  cv::Mat frame;
+  readFrame(frame);
+  return frame;
+}
+
+bool AnimatedImageLoader::readFrame(cv::Mat &frame) {
+  if (!useCollection_)
+    return video_.readFrame(frame);
+  if (index_ >= static_cast<int>(collection_.size()))
+    return false;
+  // Take the decoded page and drop the collection's reference to it, so
+  // only the current frame stays in memory
+  frame = collection_.at(index_);
+  collection_.releaseCache(index_);
+  ++index_;
+  return !frame.empty();
+}
+
+ImageSequenceLoader::ImageSequenceLoader(double fps, int decodeThreads)
+    : fps_(fps), threads_(decodeThreads) {}
+
+ImageSequenceLoader::~ImageSequenceLoader() {
+  ahead_.clear();
+  pool_.reset(); // Finishes decodes already started
+}
+
+bool ImageSequenceLoader::open(const std::string &pattern) {
+  ahead_.clear();
+  pool_.reset();
+  frameCount_ = 0;
+  scheduled_ = 0;
+  if (!vidicant::isImageSequence(pattern))
+    return false;
+  pattern_ = pattern;
+  if (frameExists(pattern, 0))
+    first_ = 0;
+  else if (frameExists(pattern, 1))
+    first_ = 1;
+  else
+    return false;
+
+  // Count contiguous frames with an exponential then a binary search, so
+  // opening a long sequence takes a few dozen stats instead of a listing
+  int present = 1; // Frames known to exist
+  int missing = 2; // A count known to exceed the sequence
+  while (frameExists(pattern, first_ + missing - 1)) {
+    present = missing;
+    if (missing > (1 << 29))
+      break;
+    missing *= 2;
+  }
+  while (missing - present > 1) {
+    int middle = present + (missing - present) / 2;
+    if (frameExists(pattern, first_ + middle - 1))
+      present = middle;
+    else
+      missing = middle;
+  }
+  frameCount_ = present;
+
+  MediaProbe probe =
+      vidicant::probeImage(vidicant::formatSequencePath(pattern, first_));
+  resolution_ = {probe.width, probe.height};
+
+  int threads = threads_ > 0
+                    ? threads_
+                    : vidicant::getParallelismPolicy().threadsPerFile;
+  if (threads > 1)
+    pool_ = std::make_unique<ThreadPool>(static_cast<std::size_t>(threads));
+  return true;
+}
+
+int ImageSequenceLoader::getFrameCount() { return frameCount_; }
+
+double ImageSequenceLoader::getFPS() { return fps_; }
+
+std::pair<int, int> ImageSequenceLoader::getResolution() {
+  return resolution_;
+}
+
+void ImageSequenceLoader::fill() {
+  std::size_t window = pool_ ? pool_->size() * 2 : 1;
+  while (ahead_.size() < window && scheduled_ < frameCount_) {
+    std::string path = vidicant::formatSequencePath(pattern_,
+                                                    first_ + scheduled_++);
+    auto decode = std::make_shared<std::packaged_task<cv::Mat()>>(
+        [path] {
+          TraceSpan span("decode", path);
+          return cv::imread(path, cv::IMREAD_COLOR);
+        });
+    ahead_.push_back(decode->get_future());
+    if (pool_)
+      pool_->submit([decode] { (*decode)(); });
+    else
+      (*decode)();
+  }
+}
+
+cv::Mat ImageSequenceLoader::readFrame() {
+  cv::Mat frame;
+  readFrame(frame);
+  return frame;
+}
+
+bool ImageSequenceLoader::readFrame(cv::Mat &frame) {
+  fill();
+  if (ahead_.empty())
+    return false;
+  {
+    // Time spent here is a decoder stall
+    TraceSpan span("decode_wait");
+    frame = ahead_.front().get();
+  }
+  ahead_.pop_front();
+  fill(); // Keep the decoders busy while the caller analyzes this frame
+  return !frame.empty();
+}
+
+bool ImageSequenceLoader::skipFrame() {
+  if (!ahead_.empty()) {
+    ahead_.pop_front(); // Already started; its result is discarded
+    return true;
+  }
+  if (scheduled_ >= frameCount_)
+    return false;
+  ++scheduled_;
+  return true;
+}
+
+namespace vidicant {
+
+bool isImageSequence(const std::string &path) {
+  std::string extension = std::filesystem::path(path).extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  bool image = std::find(std::begin(kImageExtensions),
+                         std::end(kImageExtensions),
+                         extension) != std::end(kImageExtensions);
+  std::size_t begin, end;
+  int width;
+  bool zeroPad;
+  return image && findConversion(path, begin, end, width, zeroPad);
+}
+
+std::string formatSequencePath(const std::string &pattern, int number) {
+  std::size_t begin, end;
+  int width;
+  bool zeroPad;
+  if (!findConversion(pattern, begin, end, width, zeroPad))
+    return pattern;
+  std::string digits = std::to_string(number);
+  if (static_cast<int>(digits.size()) < width)
+    digits.insert(0, width - digits.size(), zeroPad ? '0' : ' ');
+  return pattern.substr(0, begin) + digits + pattern.substr(end);
+}
+
+bool isAnimatedImage(const std::string &filename) {
+  // Check the magic first so other files cost one small read
+  char head[12] = {};
+  std::ifstream input(filename, std::ios::binary);
+  input.read(head, sizeof(head));
+  bool gif = std::memcmp(head, "GIF8", 4) == 0;
+  bool webp = std::memcmp(head, "RIFF", 4) == 0 &&
+              std::memcmp(head + 8, "WEBP", 4) == 0;
+  return (gif || webp) && probeImage(filename).frameCount > 1;
+}
+
+} // namespace vidicant
@@ -0,0 +1,281 @@
+#include "vidicant/jpeg_dct.hpp"
+#include "vidicant/probe.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <csetjmp>
+#include <cstdio>
+
+#ifdef VIDICANT_WITH_JPEG
+#include <jpeglib.h>
+#endif
+
+#ifdef VIDICANT_WITH_JPEG
+namespace {
+
+// libjpeg reports fatal errors through error_exit, which must not return.
+// Jump back to the setjmp in analyzeCoefficients instead.
+struct JpegErrorManager {
+  jpeg_error_mgr pub;
+  std::jmp_buf jump;
+};
+
+void jpegErrorExit(j_common_ptr cinfo) {
+  auto *err = reinterpret_cast<JpegErrorManager *>(cinfo->err);
+  std::longjmp(err->jump, 1);
+}
+
+// Weights of Cb and Cr in the mean of R, G and B, from the JFIF
+// YCbCr to RGB transform.
+constexpr double kCbBrightness = (1.772 - 0.34414) / 3.0;
+constexpr double kCrBrightness = (1.402 - 0.71414) / 3.0;
+
+// Sums over the blocks of one component, each block weighted by the
+// samples it covers inside the image.
+struct ComponentSums {
+  double samples = 0.0;   // Samples covered.
+  double meanSum = 0.0;   // Block means times samples.
+  double laplacian = 0.0; // Squared Laplacian responses.
+  double minMean = 255.0; // Darkest block mean.
+  double maxMean = 0.0;   // Brightest block mean.
+  std::array<double, 256> histogram{}; // Samples per rounded block mean.
+};
+
+// Gets the gain of the 4-neighbor Laplacian on each 8x8 cosine basis
+// function, in libjpeg's natural coefficient order. Within a block, whose
+// edges the DCT extends symmetrically, the basis functions are exactly the
+// Laplacian's eigenvectors.
+std::array<double, DCTSIZE2> laplacianGains() {
+  const double pi = std::acos(-1.0);
+  std::array<double, DCTSIZE2> gains{};
+  for (int v = 0; v < DCTSIZE; ++v) {
+    for (int u = 0; u < DCTSIZE; ++u) {
+      double sv = std::sin(pi * v / (2 * DCTSIZE));
+      double su = std::sin(pi * u / (2 * DCTSIZE));
+      gains[v * DCTSIZE + u] = 4.0 * (su * su + sv * sv);
+    }
+  }
+  return gains;
+}
+
+// Gets the value of each orthonormal 1-D cosine basis function at the first
+// sample of a block; at the last sample, odd functions change sign.
+std::array<double, DCTSIZE> edgeBasis() {
+  const double pi = std::acos(-1.0);
+  std::array<double, DCTSIZE> basis{};
+  for (int k = 0; k < DCTSIZE; ++k) {
+    double norm = std::sqrt((k == 0 ? 1.0 : 2.0) / DCTSIZE);
+    basis[k] = norm * std::cos(pi * k / (2 * DCTSIZE));
+  }
+  return basis;
+}
+
+// Frequencies along one edge of a block: the 1-D transforms of its first
+// or last row (or column) of samples and of Laplacian responses inside the
+// block. The transform is orthonormal, so sums of products along an edge
+// can be taken on the frequencies.
+struct BlockEdge {
+  std::array<double, DCTSIZE> values{};
+  std::array<double, DCTSIZE> laplacian{};
+};
+
+// Gets the part of the squared Laplacian that the jumps across the edge
+// between two blocks add: the Laplacian of each sample on the edge gains
+// the jump to its neighbor in the other block.
+double jumpEnergy(const BlockEdge &before, const BlockEdge &after) {
+  double energy = 0.0;
+  for (int k = 0; k < DCTSIZE; ++k) {
+    double jump = after.values[k] - before.values[k];
+    energy += 2.0 * jump * jump +
+              2.0 * jump * (before.laplacian[k] - after.laplacian[k]);
+  }
+  return energy;
+}
+
+// Folds the coefficient blocks of one component into its sums. The
+// dequantized coefficients are those of the orthonormal DCT of the
+// level-shifted samples, so the DC term is 8 times the block mean less 128
+// and the squared terms add up to the block's squared samples.
+//
+// The Laplacian splits into the part inside each block, which is diagonal
+// in the DCT, and the jumps between the samples on either side of a block
+// edge, which the symmetric extension hides. Both come from coefficients.
+void sumComponent(j_decompress_ptr cinfo, jvirt_barray_ptr coefficients,
+                  const jpeg_component_info &component, bool luma,
+                  ComponentSums &sums) {
+  static const std::array<double, DCTSIZE2> gains = laplacianGains();
+  static const std::array<double, DCTSIZE> basis = edgeBasis();
+  const UINT16 *quant = component.quant_table->quantval;
+  int width = static_cast<int>(component.downsampled_width);
+  int height = static_cast<int>(component.downsampled_height);
+  // Bottom edges of the previous block row; owned by libjpeg's image pool,
+  // so an error exit releases them too
+  auto *bottoms = static_cast<BlockEdge *>((*cinfo->mem->alloc_small)(
+      reinterpret_cast<j_common_ptr>(cinfo), JPOOL_IMAGE,
+      component.width_in_blocks * sizeof(BlockEdge)));
+  for (JDIMENSION by = 0; by < component.height_in_blocks; ++by) {
+    JBLOCKARRAY row = (*cinfo->mem->access_virt_barray)(
+        reinterpret_cast<j_common_ptr>(cinfo), coefficients, by, 1, FALSE);
+    int rows = std::min(DCTSIZE, height - static_cast<int>(by) * DCTSIZE);
+    BlockEdge right;
+    for (JDIMENSION bx = 0; bx < component.width_in_blocks; ++bx) {
+      const JCOEF *block = row[0][bx];
+      int cols = std::min(DCTSIZE, width - static_cast<int>(bx) * DCTSIZE);
+      if (rows <= 0 || cols <= 0)
+        continue;
+      // Partial blocks at the right and bottom edges hold padding too
+      double covered = static_cast<double>(rows * cols);
+      double mean = block[0] * quant[0] / 8.0 + 128.0;
+      sums.samples += covered;
+      sums.meanSum += mean * covered;
+      if (!luma)
+        continue;
+
+      double energy = 0.0;
+      BlockEdge top, bottom, left, rightEdge;
+      for (int v = 0; v < DCTSIZE; ++v) {
+        for (int u = 0; u < DCTSIZE; ++u) {
+          int k = v * DCTSIZE + u;
+          double value = static_cast<double>(block[k]) * quant[k];
+          double response = -value * gains[k];
+          energy += response * response;
+          // Odd basis functions change sign between the first and last
+          // sample
+          double vSign = v % 2 ? -1.0 : 1.0;
+          double uSign = u % 2 ? -1.0 : 1.0;
+          top.values[u] += value * basis[v];
+          top.laplacian[u] += response * basis[v];
+          bottom.values[u] += vSign * value * basis[v];
+          bottom.laplacian[u] += vSign * response * basis[v];
+          left.values[v] += value * basis[u];
+          left.laplacian[v] += response * basis[u];
+          rightEdge.values[v] += uSign * value * basis[u];
+          rightEdge.laplacian[v] += uSign * response * basis[u];
+        }
+      }
+      double jumps = 0.0;
+      if (bx > 0)
+        jumps += jumpEnergy(right, left);
+      if (by > 0)
+        jumps += jumpEnergy(bottoms[bx], top);
+      right = rightEdge;
+      bottoms[bx] = bottom;
+      sums.laplacian += energy * covered / DCTSIZE2 + jumps;
+
+      double level = std::clamp(mean, 0.0, 255.0);
+      sums.minMean = std::min(sums.minMean, level);
+      sums.maxMean = std::max(sums.maxMean, level);
+      sums.histogram[static_cast<int>(std::lround(level))] += covered;
+    }
+  }
+}
+
+// Estimates metrics from the JPEG a source gives.
+// @param setSource Sets the source of the decompressor.
+template <typename SetSource>
+bool analyzeCoefficients(SetSource setSource, JpegDctStats &stats) {
+  jpeg_decompress_struct cinfo{};
+  JpegErrorManager err{};
+  cinfo.err = jpeg_std_error(&err.pub);
+  err.pub.error_exit = jpegErrorExit;
+  if (setjmp(err.jump)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  jpeg_create_decompress(&cinfo);
+  setSource(&cinfo);
+  jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
+  jpeg_read_header(&cinfo, TRUE);
+  bool gray = cinfo.jpeg_color_space == JCS_GRAYSCALE &&
+              cinfo.num_components == 1;
+  bool ycc = cinfo.jpeg_color_space == JCS_YCbCr && cinfo.num_components == 3;
+  if (!gray && !ycc) {
+    // RGB, CMYK and YCCK JPEGs take the pixel path
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  int orientation = 1;
+  for (auto marker = cinfo.marker_list; marker; marker = marker->next) {
+    if (marker->marker == JPEG_APP0 + 1 && orientation == 1)
+      orientation =
+          vidicant::readExifOrientation(marker->data, marker->data_length);
+  }
+
+  jvirt_barray_ptr *coefficients = jpeg_read_coefficients(&cinfo);
+  std::array<ComponentSums, 3> sums{};
+  for (int c = 0; c < cinfo.num_components; ++c)
+    sumComponent(&cinfo, coefficients[c], cinfo.comp_info[c], c == 0,
+                 sums[c]);
+  bool transposed = orientation >= 5 && orientation <= 8;
+  stats.width = static_cast<int>(transposed ? cinfo.image_height
+                                            : cinfo.image_width);
+  stats.height = static_cast<int>(transposed ? cinfo.image_width
+                                             : cinfo.image_height);
+  stats.channels = cinfo.num_components;
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+
+  const ComponentSums &luma = sums[0];
+  if (luma.samples <= 0)
+    return false;
+  double mean = luma.meanSum / luma.samples;
+  if (ycc && sums[1].samples > 0 && sums[2].samples > 0) {
+    mean += kCbBrightness * (sums[1].meanSum / sums[1].samples - 128.0) +
+            kCrBrightness * (sums[2].meanSum / sums[2].samples - 128.0);
+  }
+  stats.averageBrightness = std::clamp(mean, 0.0, 255.0);
+  stats.blurScore = luma.laplacian / luma.samples;
+  stats.contrastRatio =
+      luma.maxMean > 0 ? luma.maxMean / (luma.minMean + 1e-6) : 0.0;
+  stats.entropy = 0.0;
+  for (double count : luma.histogram) {
+    if (count > 0) {
+      double p = count / luma.samples;
+      stats.entropy -= p * std::log2(p);
+    }
+  }
+  return true;
+}
+
+} // namespace
+#endif
+
+namespace vidicant {
+
+bool analyzeJpegDct(const std::string &filename, JpegDctStats &stats) {
+#ifdef VIDICANT_WITH_JPEG
+  std::FILE *file = std::fopen(filename.c_str(), "rb");
+  if (!file)
+    return false;
+  bool ok = analyzeCoefficients(
+      [file](j_decompress_ptr cinfo) { jpeg_stdio_src(cinfo, file); }, stats);
+  std::fclose(file);
+  return ok;
+#else
+  (void)filename;
+  (void)stats;
+  return false;
+#endif
+}
+
+bool analyzeJpegDct(const unsigned char *data, std::size_t size,
+                    JpegDctStats &stats) {
+#ifdef VIDICANT_WITH_JPEG
+  if (!data || size == 0)
+    return false;
+  // Older libjpeg declares the buffer non-const, but only reads it
+  return analyzeCoefficients(
+      [data, size](j_decompress_ptr cinfo) {
+        jpeg_mem_src(cinfo, const_cast<unsigned char *>(data),
+                     static_cast<unsigned long>(size));
+      },
+      stats);
+#else
+  (void)data;
+  (void)size;
+  (void)stats;
+  return false;
+#endif
+}
+
+} // namespace vidicant
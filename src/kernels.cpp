@@ -0,0 +1,83 @@
+#include "vidicant/kernels.hpp"
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+std::uint64_t sumBytes(const unsigned char *data, std::size_t count) {
+  std::uint64_t sum = 0;
+  for (std::size_t i = 0; i < count; ++i)
+    sum += data[i];
+  return sum;
+}
+
+std::uint64_t sumAbsDiff(const unsigned char *a, const unsigned char *b,
+                         std::size_t count) {
+  std::uint64_t sum = 0;
+  for (std::size_t i = 0; i < count; ++i)
+    sum += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+  return sum;
+}
+
+// Gets the variants this build and CPU can run, best first.
+std::vector<const KernelTable *> availableKernels() {
+  std::vector<const KernelTable *> tables;
+#if defined(VIDICANT_X86_KERNELS)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw"))
+    tables.push_back(&vidicant::getAvx512Kernels());
+  if (__builtin_cpu_supports("avx2"))
+    tables.push_back(&vidicant::getAvx2Kernels());
+  if (__builtin_cpu_supports("sse4.2"))
+    tables.push_back(&vidicant::getSse42Kernels());
+#elif defined(VIDICANT_NEON_KERNELS)
+  tables.push_back(&vidicant::getNeonKernels()); // Part of every AArch64 CPU
+#endif
+  tables.push_back(&vidicant::getBaselineKernels());
+  return tables;
+}
+
+// Picks the best variant, or the one VIDICANT_ISA names if it can run.
+const KernelTable &selectKernels() {
+  auto tables = availableKernels();
+  const char *forced = std::getenv("VIDICANT_ISA");
+  if (forced == nullptr || *forced == '\0')
+    return *tables.front();
+  if (const KernelTable *table = vidicant::findKernels(forced))
+    return *table;
+  std::cerr << "Warning: VIDICANT_ISA=" << forced
+            << " is not available here; using " << tables.front()->isa
+            << std::endl;
+  return *tables.front();
+}
+
+} // namespace
+
+namespace vidicant {
+
+const KernelTable &kernels() {
+  static const KernelTable &selected = selectKernels();
+  return selected;
+}
+
+std::vector<std::string> getAvailableIsas() {
+  std::vector<std::string> names;
+  for (const auto *table : availableKernels())
+    names.push_back(table->isa);
+  return names;
+}
+
+const KernelTable *findKernels(const std::string &isa) {
+  for (const auto *table : availableKernels()) {
+    if (isa == table->isa)
+      return table;
+  }
+  return nullptr;
+}
+
+const KernelTable &getBaselineKernels() {
+  static const KernelTable table = {"baseline", sumBytes, sumAbsDiff};
+  return table;
+}
+
+} // namespace vidicant
@@ -0,0 +1,58 @@
+#include "vidicant/kernels.hpp"
+#include <immintrin.h>
+
+// Built with -mavx2; only called once the CPU is known to support it.
+
+namespace {
+
+// Bytes per register.
+constexpr std::size_t kWidth = 32;
+
+// Adds up the four 64-bit lanes of a SAD accumulator.
+std::uint64_t addLanes(__m256i sums) {
+  __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums),
+                               _mm256_extracti128_si256(sums, 1));
+  return static_cast<std::uint64_t>(_mm_cvtsi128_si64(half)) +
+         static_cast<std::uint64_t>(_mm_extract_epi64(half, 1));
+}
+
+std::uint64_t sumBytes(const unsigned char *data, std::size_t count) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i sums = zero;
+  std::size_t i = 0;
+  for (; i + kWidth <= count; i += kWidth) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    sums = _mm256_add_epi64(sums, _mm256_sad_epu8(v, zero));
+  }
+  std::uint64_t sum = addLanes(sums);
+  for (; i < count; ++i)
+    sum += data[i];
+  return sum;
+}
+
+std::uint64_t sumAbsDiff(const unsigned char *a, const unsigned char *b,
+                         std::size_t count) {
+  __m256i sums = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + kWidth <= count; i += kWidth) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    sums = _mm256_add_epi64(sums, _mm256_sad_epu8(va, vb));
+  }
+  std::uint64_t sum = addLanes(sums);
+  for (; i < count; ++i)
+    sum += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+  return sum;
+}
+
+} // namespace
+
+namespace vidicant {
+
+const KernelTable &getAvx2Kernels() {
+  static const KernelTable table = {"avx2", sumBytes, sumAbsDiff};
+  return table;
+}
+
+} // namespace vidicant
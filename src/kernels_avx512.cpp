@@ -0,0 +1,73 @@
+#include "vidicant/kernels.hpp"
+#include <cstdint>
+#include <immintrin.h>
+
+// Built with -mavx512f -mavx512bw; only called once the CPU is known to
+// support both.
+
+namespace {
+
+// Bytes per register.
+constexpr std::size_t kWidth = 64;
+
+// Adds up the eight 64-bit lanes of a SAD accumulator. Stored rather than
+// reduced with _mm512_reduce_add_epi64, whose GCC 12 header trips
+// -Wuninitialized.
+std::uint64_t addLanes(__m512i sums) {
+  alignas(64) std::uint64_t lanes[8];
+  _mm512_store_si512(lanes, sums);
+  std::uint64_t sum = 0;
+  for (std::uint64_t lane : lanes)
+    sum += lane;
+  return sum;
+}
+
+// Gets the mask of the first count bytes of a register; count < kWidth.
+__mmask64 tailMask(std::size_t count) {
+  return (static_cast<__mmask64>(1) << count) - 1;
+}
+
+std::uint64_t sumBytes(const unsigned char *data, std::size_t count) {
+  const __m512i zero = _mm512_setzero_si512();
+  __m512i sums = zero;
+  std::size_t i = 0;
+  for (; i + kWidth <= count; i += kWidth) {
+    __m512i v = _mm512_loadu_si512(data + i);
+    sums = _mm512_add_epi64(sums, _mm512_sad_epu8(v, zero));
+  }
+  // Masked-off bytes load as zero and add nothing
+  if (i < count) {
+    __m512i v = _mm512_maskz_loadu_epi8(tailMask(count - i), data + i);
+    sums = _mm512_add_epi64(sums, _mm512_sad_epu8(v, zero));
+  }
+  return addLanes(sums);
+}
+
+std::uint64_t sumAbsDiff(const unsigned char *a, const unsigned char *b,
+                         std::size_t count) {
+  __m512i sums = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for (; i + kWidth <= count; i += kWidth) {
+    __m512i va = _mm512_loadu_si512(a + i);
+    __m512i vb = _mm512_loadu_si512(b + i);
+    sums = _mm512_add_epi64(sums, _mm512_sad_epu8(va, vb));
+  }
+  if (i < count) {
+    __mmask64 mask = tailMask(count - i);
+    __m512i va = _mm512_maskz_loadu_epi8(mask, a + i);
+    __m512i vb = _mm512_maskz_loadu_epi8(mask, b + i);
+    sums = _mm512_add_epi64(sums, _mm512_sad_epu8(va, vb));
+  }
+  return addLanes(sums);
+}
+
+} // namespace
+
+namespace vidicant {
+
+const KernelTable &getAvx512Kernels() {
+  static const KernelTable table = {"avx512", sumBytes, sumAbsDiff};
+  return table;
+}
+
+} // namespace vidicant
@@ -0,0 +1,55 @@
+#include "vidicant/kernels.hpp"
+#include <nmmintrin.h>
+
+// Built with -msse4.2; only called once the CPU is known to support it.
+
+namespace {
+
+// Bytes per register.
+constexpr std::size_t kWidth = 16;
+
+// Adds up the two 64-bit lanes of a SAD accumulator.
+std::uint64_t addLanes(__m128i sums) {
+  return static_cast<std::uint64_t>(_mm_cvtsi128_si64(sums)) +
+         static_cast<std::uint64_t>(_mm_extract_epi64(sums, 1));
+}
+
+std::uint64_t sumBytes(const unsigned char *data, std::size_t count) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sums = zero;
+  std::size_t i = 0;
+  for (; i + kWidth <= count; i += kWidth) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(v, zero));
+  }
+  std::uint64_t sum = addLanes(sums);
+  for (; i < count; ++i)
+    sum += data[i];
+  return sum;
+}
+
+std::uint64_t sumAbsDiff(const unsigned char *a, const unsigned char *b,
+                         std::size_t count) {
+  __m128i sums = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + kWidth <= count; i += kWidth) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(va, vb));
+  }
+  std::uint64_t sum = addLanes(sums);
+  for (; i < count; ++i)
+    sum += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+  return sum;
+}
+
+} // namespace
+
+namespace vidicant {
+
+const KernelTable &getSse42Kernels() {
+  static const KernelTable table = {"sse4.2", sumBytes, sumAbsDiff};
+  return table;
+}
+
+} // namespace vidicant
@@ -1,4 +1,17 @@
+#include "batch.hpp"
+#include "commands.hpp"
 #include "controller.hpp"
+#include "crawler.hpp"
+#include "server.hpp"
+#include "vidicant/deadline.hpp"
+#include "vidicant/image_sequence.hpp"
+#include "vidicant/kernels.hpp"
+#include "vidicant/memory_stats.hpp"
+#include "vidicant/parallelism.hpp"
+#include "vidicant/shard.hpp"
+#include "vidicant/trace.hpp"
+#include "watcher.hpp"
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -6,7 +19,78 @@
 #include <string>
 #include <vector>
 
+// Function to add one input path, crawling it if it is a directory
+static void addInput(const std::string &path, const CrawlOptions &options,
+                     std::vector<MediaEntry> &entries) {
+  std::error_code ec;
+  if (vidicant::isImageSequence(path)) {
+    entries.push_back({path, MediaKind::Video, 0});
+    return;
+  }
+  if (std::filesystem::is_directory(path, ec)) {
+    auto found = crawlDirectory(path, options);
+    entries.insert(entries.end(), found.begin(), found.end());
+    return;
+  }
+  if (!std::filesystem::exists(path, ec)) {
+    std::cout << "File does not exist: " << path << std::endl;
+    return;
+  }
+  MediaKind kind = classifyMediaFile(path, options.sniff);
+  if (kind == MediaKind::Unknown) {
+    std::cout << "Unsupported file type: " << path << std::endl;
+    return;
+  }
+  entries.push_back({path, kind, std::filesystem::file_size(path, ec)});
+}
+
+// Function to split a comma-separated list
+static std::vector<std::string> splitList(const std::string &list) {
+  std::vector<std::string> items;
+  std::size_t start = 0;
+  while (start <= list.size()) {
+    std::size_t comma = list.find(',', start);
+    if (comma == std::string::npos)
+      comma = list.size();
+    if (comma > start)
+      items.push_back(list.substr(start, comma - start));
+    start = comma + 1;
+  }
+  return items;
+}
+
+// Function to write the recorded timeline, if tracing, and pass on an exit
+// status
+static int finishTrace(const std::string &traceFile, int status) {
+  if (traceFile.empty())
+    return status;
+  if (!vidicant::writeTrace(traceFile)) {
+    std::cerr << "Error: Could not write trace file: " << traceFile
+              << std::endl;
+    return 1;
+  }
+  std::cout << "Trace written to: " << traceFile << std::endl;
+  return status;
+}
+
 int main(int argc, char *argv[]) {
+  if (argc >= 2 && std::string(argv[1]) == "--version") {
+    std::cout << "vidicant " << VIDICANT_VERSION << std::endl;
+    std::cout << "kernels: " << vidicant::kernels().isa << " (available:";
+    for (const auto &isa : vidicant::getAvailableIsas())
+      std::cout << " " << isa;
+    std::cout << ")" << std::endl;
+    return 0;
+  }
+
+  // Subcommands that work on analysis results
+  if (argc >= 2 && std::string(argv[1]) == "dedup")
+    return runDedupCommand(argc - 1, argv + 1);
+  if (argc >= 2 && std::string(argv[1]) == "query")
+    return runQueryCommand(argc - 1, argv + 1);
+  if (argc >= 2 && std::string(argv[1]) == "merge")
+    return runMergeCommand(argc - 1, argv + 1);
+
   if (argc < 2) {
     std::cout << "Usage: " << argv[0]
               << " <file1> [file2] [file3] ... [--output <output.json>]"
@@ -20,48 +104,445 @@ int main(int argc, char *argv[]) {
     std::cout
         << "Use --output to specify output JSON file (default: results.json)"
         << std::endl;
+    std::cout << "Use --tiled [--tile-rows N] to analyze images in bounded "
+                 "memory, N rows at a time (default: 256)"
+              << std::endl;
+    std::cout << "Use --hashes to add perceptual hashes (images and video "
+                 "keyframes) for near-duplicate search"
+              << std::endl;
+    std::cout << "Use --recursive <dir> to analyze every media file under a "
+                 "directory, and --input-list <file|-> to read paths one per "
+                 "line"
+              << std::endl;
+    std::cout << "Use --sniff to classify files by content instead of "
+                 "extension, and --crawl-threads N to bound directory walkers"
+              << std::endl;
+    std::cout << "Use --checkpoint <file> to record finished files, and "
+                 "--resume to skip them on a rerun (default checkpoint: "
+                 "<output>.checkpoint)"
+              << std::endl;
+    std::cout << "Use --metrics a,b,c to compute only the named metrics "
+                 "(--list-metrics shows them)"
+              << std::endl;
+    std::cout << "Use --histogram-bins N to set the bins per channel of "
+                 "image histograms (default: 256)"
+              << std::endl;
+    std::cout << "Use --series csv|binary [--series-window N] to save "
+                 "per-frame video measurements and summarize N-frame windows, "
+                 "and --scene-thresholds a,b,c to detect scene changes at "
+                 "several thresholds from one decode"
+              << std::endl;
+    std::cout << "Use --scene-palettes to add the dominant colors of each "
+                 "video scene"
+              << std::endl;
+    std::cout << "Use --qc to report black, frozen and flash frame ranges "
+                 "of videos, with --qc-black N, --qc-freeze N and --qc-flash "
+                 "N to set their thresholds (default: 10, 0.5, 60)"
+              << std::endl;
+    std::cout << "Use --series-input <file> to rerun scene, QC and window "
+                 "analysis on a series saved with --series binary, without "
+                 "decoding its video"
+              << std::endl;
+    std::cout << "Use --crop-bars to detect letterbox and pillarbox bars and "
+                 "analyze only the picture inside them"
+              << std::endl;
+    std::cout << "Use --jpeg-dct to estimate brightness, blur, contrast and "
+                 "entropy of JPEGs from their DCT coefficients"
+              << std::endl;
+    std::cout << "Use --proxy-cache <dir> [--proxy-height N] "
+                 "[--proxy-cache-limit N[K|M|G]] to keep downscaled frames "
+                 "of each video, so later runs on it skip decoding"
+              << std::endl;
+    std::cout << "Use --memory-stats to report the Mat memory each file and "
+                 "stage took, with peak RSS and a per-stage summary"
+              << std::endl;
+    std::cout << "Use --trace <file> to record a timeline of every thread's "
+                 "work and waits in Chrome trace-event format (Perfetto)"
+              << std::endl;
+    std::cout << "Use --shard i/N to analyze only the files whose path hash "
+                 "falls in part i of N (0 <= i < N), to split one corpus "
+                 "across machines"
+              << std::endl;
+    std::cout << "Use --serve <unix:/path|[host:]port> [--jobs N] "
+                 "[--queue N] to run as a daemon answering newline-delimited "
+                 "JSON requests"
+              << std::endl;
+    std::cout << "Use --watch <dir> [--watch-settle MS] [--watch-existing] "
+                 "to analyze files as they land and append each result to "
+                 "--output as a JSON line (default: results.ndjson)"
+              << std::endl;
+    std::cout << "Use --parallelism file|intra|hybrid [--jobs N] "
+                 "[--pin-threads] to split cores between files and the work "
+                 "inside each file (default: intra, or hybrid with --jobs, "
+                 "--serve or --watch)"
+              << std::endl;
+    std::cout << "Use --time-budget N[ms|s|m] to stop analyzing a file after "
+                 "N and report partial results (default: no limit)"
+              << std::endl;
+    std::cout << "Use --memory-budget N[K|M|G] to bound the decoded bytes "
+                 "of files analyzed at once (default: no limit)"
+              << std::endl;
+    std::cout << "Use --prefetch N [--prefetch-device-reads N] "
+                 "[--prefetch-memory N[K|M|G]] to read the next N files "
+                 "ahead while others are analyzed, for slow or network "
+                 "storage (default: off)"
+              << std::endl;
+    std::cout << "Use --version to show the version and the SIMD kernels "
+                 "in use (set VIDICANT_ISA to force a variant)"
+              << std::endl;
+    std::cout << "Run '" << argv[0]
+              << " dedup' for near-duplicate index commands" << std::endl;
+    std::cout << "Run '" << argv[0]
+              << " query' to index and search results by metric"
+              << std::endl;
+    std::cout << "Run '" << argv[0]
+              << " merge' to combine the results of sharded runs"
+              << std::endl;
     return 1;
   }
 
+  if (std::string(argv[1]) == "--list-metrics") {
+    for (const auto &metric : getImageMetricNames())
+      std::cout << "image\t" << metric << std::endl;
+    for (const auto &metric : getVideoMetricNames())
+      std::cout << "video\t" << metric << std::endl;
+    return 0;
+  }
+
   std::string outputFile = "results.json";
+  bool outputSet = false;
   std::vector<std::string> inputFiles;
+  std::vector<std::string> crawlRoots;
+  std::vector<std::string> inputLists;
+  std::vector<std::string> seriesInputs;
+  std::string checkpointFile;
+  bool resume = false;
+  std::string serveEndpoint;
+  ProcessOptions options;
+  CrawlOptions crawlOptions;
+  ServerOptions serverOptions;
+  std::string parallelism;
+  int jobs = 0;
+  bool pinThreads = false;
+  BatchOptions batchOptions;
+  std::vector<std::string> watchRoots;
+  WatchOptions watchOptions;
+  std::string traceFile;
+  Shard shard;
+  bool sharded = false;
 
   // Parse command line arguments
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
     if (arg == "--output" && i + 1 < argc) {
       outputFile = argv[++i];
+      outputSet = true;
+    } else if (arg == "--tiled") {
+      options.tiled = true;
+    } else if (arg == "--tile-rows" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], 0, options.tileRows)) {
+        std::cerr << "Error: Invalid tile rows: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--hashes") {
+      options.perceptualHashes = true;
+    } else if (arg == "--recursive" && i + 1 < argc) {
+      crawlRoots.push_back(argv[++i]);
+    } else if (arg == "--input-list" && i + 1 < argc) {
+      inputLists.push_back(argv[++i]);
+    } else if (arg == "--sniff") {
+      crawlOptions.sniff = true;
+    } else if (arg == "--crawl-threads" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], std::size_t{0}, crawlOptions.threads)) {
+        std::cerr << "Error: Invalid crawl threads: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--checkpoint" && i + 1 < argc) {
+      checkpointFile = argv[++i];
+    } else if (arg == "--resume") {
+      resume = true;
+    } else if (arg == "--metrics" && i + 1 < argc) {
+      options.metrics = splitList(argv[++i]);
+    } else if (arg == "--histogram-bins" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], 0, options.histogramBins)) {
+        std::cerr << "Error: Invalid histogram bins: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--serve" && i + 1 < argc) {
+      serveEndpoint = argv[++i];
+    } else if (arg == "--queue" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], std::size_t{1},
+                        serverOptions.queueCapacity)) {
+        std::cerr << "Error: Invalid queue size: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--parallelism" && i + 1 < argc) {
+      parallelism = argv[++i];
+    } else if (arg == "--jobs" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], 0, jobs)) {
+        std::cerr << "Error: Invalid jobs: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--pin-threads") {
+      pinThreads = true;
+    } else if (arg == "--series" && i + 1 < argc) {
+      options.seriesFormat = argv[++i];
+    } else if (arg == "--series-window" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], 0, options.seriesWindow)) {
+        std::cerr << "Error: Invalid series window: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--scene-thresholds" && i + 1 < argc) {
+      for (const auto &text : splitList(argv[++i])) {
+        double threshold = 0.0;
+        if (!parseNumber(text, 0.0, threshold)) {
+          std::cerr << "Error: Invalid scene threshold: " << text << std::endl;
+          return 1;
+        }
+        options.sceneThresholds.push_back(threshold);
+      }
+    } else if (arg == "--scene-palettes") {
+      options.scenePalettes = true;
+    } else if (arg == "--qc") {
+      options.qcEvents = true;
+    } else if ((arg == "--qc-black" || arg == "--qc-freeze" ||
+                arg == "--qc-flash") &&
+               i + 1 < argc) {
+      double &threshold = arg == "--qc-black"    ? options.qc.blackBrightness
+                          : arg == "--qc-freeze" ? options.qc.freezeDiff
+                                                 : options.qc.flashBrightness;
+      if (!parseNumber(argv[++i], 0.0, threshold)) {
+        std::cerr << "Error: Invalid QC threshold: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--series-input" && i + 1 < argc) {
+      seriesInputs.push_back(argv[++i]);
+    } else if (arg == "--crop-bars") {
+      options.cropBars = true;
+    } else if (arg == "--jpeg-dct") {
+      options.jpegDct = true;
+    } else if (arg == "--memory-stats") {
+      options.memoryStats = true;
+    } else if (arg == "--trace" && i + 1 < argc) {
+      traceFile = argv[++i];
+    } else if (arg == "--watch" && i + 1 < argc) {
+      watchRoots.push_back(argv[++i]);
+    } else if (arg == "--watch-settle" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], 0, watchOptions.settleMilliseconds)) {
+        std::cerr << "Error: Invalid watch settle time: " << argv[i]
+                  << std::endl;
+        return 1;
+      }
+    } else if (arg == "--watch-existing") {
+      watchOptions.existing = true;
+    } else if (arg == "--time-budget" && i + 1 < argc) {
+      if (!vidicant::parseDuration(argv[++i], options.timeBudget)) {
+        std::cerr << "Error: Invalid time budget: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--memory-budget" && i + 1 < argc) {
+      if (!parseByteSize(argv[++i], batchOptions.memoryBudget)) {
+        std::cerr << "Error: Invalid memory budget: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--shard" && i + 1 < argc) {
+      if (!vidicant::parseShard(argv[++i], shard)) {
+        std::cerr << "Error: Invalid shard (expected i/N with 0 <= i < N): "
+                  << argv[i] << std::endl;
+        return 1;
+      }
+      sharded = true;
+    } else if (arg == "--prefetch" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], std::size_t{0},
+                        batchOptions.prefetch.depth)) {
+        std::cerr << "Error: Invalid prefetch depth: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--prefetch-device-reads" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], std::size_t{1},
+                        batchOptions.prefetch.deviceReads)) {
+        std::cerr << "Error: Invalid prefetch device reads: " << argv[i]
+                  << std::endl;
+        return 1;
+      }
+    } else if (arg == "--prefetch-memory" && i + 1 < argc) {
+      if (!parseByteSize(argv[++i], batchOptions.prefetch.maxBytes)) {
+        std::cerr << "Error: Invalid prefetch memory: " << argv[i]
+                  << std::endl;
+        return 1;
+      }
+    } else if (arg == "--proxy-cache" && i + 1 < argc) {
+      options.proxyCache = argv[++i];
+    } else if (arg == "--proxy-height" && i + 1 < argc) {
+      if (!parseInteger(argv[++i], 0, options.proxyHeight)) {
+        std::cerr << "Error: Invalid proxy height: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--proxy-cache-limit" && i + 1 < argc) {
+      if (!parseByteSize(argv[++i], options.proxyCacheLimit)) {
+        std::cerr << "Error: Invalid proxy cache limit: " << argv[i]
+                  << std::endl;
+        return 1;
+      }
     } else {
       inputFiles.push_back(arg);
     }
   }
+  // Ranges are checked where the daemon and Python module check them too
+  std::string invalid = checkProcessOptions(options);
+  if (!invalid.empty()) {
+    std::cerr << "Error: " << invalid << std::endl;
+    return 1;
+  }
 
-  nlohmann::json results;
-  results["images"] = nlohmann::json::array();
-  results["videos"] = nlohmann::json::array();
-
-  for (const auto &filename : inputFiles) {
-    if (!std::filesystem::exists(filename)) {
-      std::cout << "File does not exist: " << filename << std::endl;
-      continue;
+  std::vector<std::string> knownMetrics = getImageMetricNames();
+  for (const auto &metric : getVideoMetricNames())
+    knownMetrics.push_back(metric);
+  for (const auto &metric : options.metrics) {
+    if (std::find(knownMetrics.begin(), knownMetrics.end(), metric) ==
+        knownMetrics.end()) {
+      std::cerr << "Error: Unknown metric: " << metric << std::endl;
+      return 1;
     }
+  }
+
+  if (!options.seriesFormat.empty() && options.seriesFormat != "csv" &&
+      options.seriesFormat != "binary") {
+    std::cerr << "Error: --series must be csv or binary" << std::endl;
+    return 1;
+  }
 
-    if (isImageFile(filename)) {
-      std::cout << "Processing image: " << filename << std::endl;
-      auto imageResult = processImage(filename);
-      results["images"].push_back(imageResult);
-    } else if (isVideoFile(filename)) {
-      std::cout << "Processing video: " << filename << std::endl;
-      auto videoResult = processVideo(filename);
-      results["videos"].push_back(videoResult);
+  if (sharded && (!serveEndpoint.empty() || !watchRoots.empty())) {
+    std::cerr << "Error: --shard applies to batch runs, not --serve or --watch"
+              << std::endl;
+    return 1;
+  }
+
+  if (!seriesInputs.empty() &&
+      (!serveEndpoint.empty() || !watchRoots.empty())) {
+    std::cerr << "Error: --series-input applies to batch runs, not --serve or "
+                 "--watch"
+              << std::endl;
+    return 1;
+  }
+
+  // Size file workers, OpenCV threads and decoder threads together
+  ParallelismMode mode = ParallelismMode::IntraFile;
+  if (jobs > 0 || !serveEndpoint.empty() || !watchRoots.empty())
+    mode = ParallelismMode::Hybrid;
+  if (!parallelism.empty() &&
+      !vidicant::parseParallelismMode(parallelism, mode)) {
+    std::cerr << "Error: Unknown parallelism mode: " << parallelism
+              << std::endl;
+    return 1;
+  }
+  ParallelismPolicy policy = vidicant::makeParallelismPolicy(mode, jobs);
+  policy.pinThreads = pinThreads;
+  vidicant::setParallelismPolicy(policy);
+  if (!traceFile.empty())
+    vidicant::startTracing();
+
+  if (!serveEndpoint.empty()) {
+    serverOptions.defaults = options;
+    return finishTrace(traceFile, runServer(serveEndpoint, serverOptions));
+  }
+
+  if (!watchRoots.empty()) {
+    watchOptions.sniff = crawlOptions.sniff;
+    watchOptions.process = options;
+    return finishTrace(
+        traceFile,
+        runWatch(watchRoots, outputSet ? outputFile : "results.ndjson",
+                 watchOptions));
+  }
+
+  // Collect the work list from argv, input lists and directory walks
+  std::vector<MediaEntry> entries;
+  for (const auto &filename : inputFiles)
+    addInput(filename, crawlOptions, entries);
+  for (const auto &listFile : inputLists) {
+    std::vector<std::string> paths;
+    if (listFile == "-") {
+      paths = readInputList(std::cin);
     } else {
-      std::cout << "Unsupported file type: " << filename << std::endl;
+      std::ifstream list(listFile);
+      if (!list.is_open()) {
+        std::cerr << "Error: Could not open input list: " << listFile
+                  << std::endl;
+        return 1;
+      }
+      paths = readInputList(list);
     }
+    for (const auto &path : paths)
+      addInput(path, crawlOptions, entries);
+  }
+  for (const auto &root : crawlRoots) {
+    std::cout << "Scanning directory: " << root << std::endl;
+    auto found = crawlDirectory(root, crawlOptions);
+    entries.insert(entries.end(), found.begin(), found.end());
+  }
+
+  // Keep this machine's part of the work list; every shard sees the same
+  // list, so the parts are disjoint and together cover it
+  if (sharded) {
+    std::size_t total = entries.size();
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [&shard](const MediaEntry &entry) {
+                                   return !vidicant::isInShard(entry.path,
+                                                               shard);
+                                 }),
+                  entries.end());
+    std::cout << "Shard " << shard.index << "/" << shard.count << ": "
+              << entries.size() << " of " << total << " files" << std::endl;
+  }
+
+  Checkpoint checkpoint;
+  bool checkpointing = !checkpointFile.empty() || resume;
+  if (checkpointFile.empty())
+    checkpointFile = outputFile + ".checkpoint";
+  if (checkpointing &&
+      !checkpoint.open(checkpointFile, resume, sharded ? &shard : nullptr)) {
+    std::cerr << "Error: Could not open checkpoint file: " << checkpointFile
+              << std::endl;
+    return 1;
+  }
+
+  nlohmann::json results;
+  results["images"] = nlohmann::json::array();
+  results["videos"] = nlohmann::json::array();
+  if (resume) {
+    results = checkpoint.getResumedResults();
+    std::cout << "Resuming from checkpoint: " << checkpointFile << " ("
+              << results["images"].size() + results["videos"].size()
+              << " files already done)" << std::endl;
+  }
+  if (sharded)
+    results["shard"] = {{"index", shard.index}, {"count", shard.count}};
+
+  // Install the counting allocator before any worker decodes a file
+  if (options.memoryStats)
+    vidicant::enableMemoryTracking();
+  processBatch(entries, options, batchOptions,
+               checkpointing ? &checkpoint : nullptr, results);
+  // Saved series are read, not decoded, so they run after the batch
+  if (!seriesInputs.empty()) {
+    results["series"] = nlohmann::json::array();
+    for (const auto &seriesInput : seriesInputs)
+      results["series"].push_back(processSeries(seriesInput, options));
+  }
+  if (options.memoryStats) {
+    results["memory_report"] = summarizeMemory(results);
+    const auto &report = results["memory_report"];
+    std::cout << "Peak RSS: " << report["peak_rss_bytes"].get<std::uint64_t>()
+              << " bytes, Mat peak: "
+              << report["mat_peak_bytes"].get<std::uint64_t>() << " bytes"
+              << std::endl;
   }
 
   // Write results to JSON file
   std::ofstream output(outputFile);
   if (output.is_open()) {
+    TraceSpan span("serialize", outputFile);
     output << results.dump(2); // Pretty print with 2-space indentation
     output.close();
     std::cout << "Results written to: " << outputFile << std::endl;
@@ -71,5 +552,5 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  return 0;
+  return finishTrace(traceFile, 0);
 }
@@ -0,0 +1,69 @@
+#include "vidicant/mapped_file.hpp"
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string &filename, Access access) {
+  close();
+#ifndef _WIN32
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    return false;
+  }
+  size_ = static_cast<std::size_t>(info.st_size);
+  if (size_ == 0) {
+    ::close(fd);
+    return true; // Nothing to map; an empty file is still a valid file
+  }
+  void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // The mapping keeps its own reference to the file
+  if (addr == MAP_FAILED) {
+    size_ = 0;
+    return false;
+  }
+  ::madvise(addr, size_,
+            access == Access::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+  data_ = static_cast<const unsigned char *>(addr);
+  mapped_ = true;
+  return true;
+#else
+  (void)access;
+  std::ifstream input(filename, std::ios::binary | std::ios::ate);
+  if (!input)
+    return false;
+  fallback_.resize(static_cast<std::size_t>(input.tellg()));
+  input.seekg(0);
+  if (!input.read(reinterpret_cast<char *>(fallback_.data()),
+                  static_cast<std::streamsize>(fallback_.size())))
+    return false;
+  data_ = fallback_.data();
+  size_ = fallback_.size();
+  return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+  if (mapped_)
+    ::munmap(const_cast<unsigned char *>(data_), size_);
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+  fallback_.clear();
+}
+
+const unsigned char *MappedFile::data() const { return data_; }
+
+std::size_t MappedFile::size() const { return size_; }
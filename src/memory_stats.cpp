@@ -0,0 +1,177 @@
+#include "vidicant/memory_stats.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <opencv2/core.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Innermost open scope of each thread.
+thread_local MemoryScope *currentScope = nullptr;
+
+// Mats allocated by each thread.
+thread_local std::uint64_t threadAllocations = 0;
+
+// Whether the counting allocator is installed.
+std::atomic<bool> trackingEnabled{false};
+
+// Process-wide counters, over every thread.
+std::atomic<std::uint64_t> processAllocated{0};
+std::atomic<std::uint64_t> processAllocations{0};
+std::atomic<std::int64_t> processLive{0};
+std::atomic<std::int64_t> processPeak{0};
+
+// Raises a peak to at least a value.
+void raisePeak(std::atomic<std::int64_t> &peak, std::int64_t value) {
+  std::int64_t seen = peak.load(std::memory_order_relaxed);
+  while (value > seen &&
+         !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+    ;
+}
+
+} // namespace
+
+// Wraps OpenCV's standard allocator, counting the buffers it hands out.
+// The UMatData it returns names this allocator as its owner, so Mat
+// release comes back here before the buffer is freed.
+class CountingMatAllocator : public cv::MatAllocator {
+public:
+  explicit CountingMatAllocator(cv::MatAllocator *base) : base_(base) {}
+
+  cv::UMatData *allocate(int dims, const int *sizes, int type, void *data,
+                         size_t *step, cv::AccessFlag flags,
+                         cv::UMatUsageFlags usageFlags) const override {
+    cv::UMatData *u =
+        base_->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    if (u == nullptr)
+      return u;
+    u->currAllocator = this;
+    u->prevAllocator = this;
+    // Mats wrapping caller memory own nothing
+    if (data == nullptr)
+      record(static_cast<std::int64_t>(u->size));
+    return u;
+  }
+
+  bool allocate(cv::UMatData *data, cv::AccessFlag flags,
+                cv::UMatUsageFlags usageFlags) const override {
+    return base_->allocate(data, flags, usageFlags);
+  }
+
+  void deallocate(cv::UMatData *u) const override {
+    if (u == nullptr)
+      return;
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED))
+      record(-static_cast<std::int64_t>(u->size));
+    base_->deallocate(u);
+  }
+
+private:
+  // Counts an allocation (positive bytes) or a release (negative bytes)
+  // in the process totals and every open scope of this thread.
+  static void record(std::int64_t bytes) {
+    if (bytes > 0) {
+      processAllocated += static_cast<std::uint64_t>(bytes);
+      ++processAllocations;
+      ++threadAllocations;
+    }
+    raisePeak(processPeak, processLive += bytes);
+    for (MemoryScope *scope = currentScope; scope != nullptr;
+         scope = scope->parent_) {
+      if (bytes > 0) {
+        scope->usage_.allocatedBytes += static_cast<std::uint64_t>(bytes);
+        ++scope->usage_.allocations;
+      }
+      scope->liveBytes_ += bytes;
+      if (scope->liveBytes_ > 0)
+        scope->usage_.peakBytes =
+            std::max(scope->usage_.peakBytes,
+                     static_cast<std::uint64_t>(scope->liveBytes_));
+    }
+  }
+
+  cv::MatAllocator *base_; // OpenCV's standard allocator.
+};
+
+MemoryScope::MemoryScope(const char *name)
+    : name_(name), parent_(currentScope), active_(trackingEnabled.load()) {
+  if (active_)
+    currentScope = this;
+}
+
+MemoryScope::~MemoryScope() {
+  if (!active_)
+    return;
+  currentScope = parent_;
+  if (parent_ == nullptr)
+    return;
+  parent_->addStage(name_, usage_);
+  for (const auto &[path, usage] : stages_)
+    parent_->addStage(std::string(name_) + "/" + path, usage);
+}
+
+MemoryUsage MemoryScope::getUsage() const { return usage_; }
+
+const std::vector<std::pair<std::string, MemoryUsage>> &
+MemoryScope::getStages() const {
+  return stages_;
+}
+
+void MemoryScope::addStage(const std::string &path,
+                           const MemoryUsage &usage) {
+  for (auto &[name, merged] : stages_) {
+    if (name == path) {
+      merged.allocatedBytes += usage.allocatedBytes;
+      merged.allocations += usage.allocations;
+      merged.peakBytes = std::max(merged.peakBytes, usage.peakBytes);
+      return;
+    }
+  }
+  stages_.emplace_back(path, usage);
+}
+
+namespace vidicant {
+
+void enableMemoryTracking() {
+  static std::once_flag installed;
+  std::call_once(installed, [] {
+    // Never destroyed: Mats allocated through it may outlive any owner
+    auto *allocator = new CountingMatAllocator(cv::Mat::getStdAllocator());
+    cv::Mat::setDefaultAllocator(allocator);
+    trackingEnabled = true;
+  });
+}
+
+bool isMemoryTrackingEnabled() { return trackingEnabled.load(); }
+
+MemoryUsage getProcessMatUsage() {
+  MemoryUsage usage;
+  usage.allocatedBytes = processAllocated.load();
+  usage.allocations = processAllocations.load();
+  usage.peakBytes =
+      static_cast<std::uint64_t>(std::max<std::int64_t>(processPeak, 0));
+  return usage;
+}
+
+std::uint64_t getThreadMatAllocations() { return threadAllocations; }
+
+std::uint64_t getPeakRss() {
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage {};
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(__APPLE__)
+  return static_cast<std::uint64_t>(usage.ru_maxrss); // Bytes
+#else
+  return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024; // Kilobytes
+#endif
+#else
+  return 0;
+#endif
+}
+
+} // namespace vidicant
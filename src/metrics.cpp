@@ -0,0 +1,87 @@
+#include "vidicant/metrics.hpp"
+#include "vidicant/color_model.hpp"
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/opencv.hpp>
+
+double getLevelScale(int depth) {
+  switch (depth) {
+  case CV_16U:
+    return PixelDepth<ushort>::kScale;
+  case CV_32F:
+  case CV_64F:
+    return PixelDepth<float>::kScale;
+  default:
+    return PixelDepth<uchar>::kScale;
+  }
+}
+
+FrameViews makeFrameViews(const cv::Mat &image, unsigned inputs) {
+  FrameViews views;
+  views.image = image;
+  views.scale = getLevelScale(image.depth());
+  if (inputs & kInputGray) {
+    if (image.channels() == 1) {
+      views.gray = image;
+    } else {
+      cv::cvtColor(image, views.gray, cv::COLOR_BGR2GRAY);
+    }
+  }
+  if ((inputs & kInputHsv) && image.channels() >= 3) {
+    if (image.depth() == CV_8U) {
+      cv::cvtColor(image, views.hsv, cv::COLOR_BGR2HSV);
+    } else {
+      // OpenCV converts only 8-bit and float images; float HSV wants 0-1
+      cv::Mat unit;
+      image.convertTo(unit, CV_32F, views.scale / 255.0);
+      cv::cvtColor(unit, views.hsv, cv::COLOR_BGR2HSV);
+    }
+  }
+  if (inputs & kInputFloat) {
+    image.convertTo(views.samples, CV_32F, views.scale);
+    views.samples = views.samples.reshape(1, views.samples.total());
+  }
+  return views;
+}
+
+double EntropyMetric::finish(const State &state) {
+  if (state.total == 0)
+    return -1.0;
+  double entropy = 0.0;
+  for (std::uint64_t count : state.bins) {
+    if (count > 0) {
+      double p = static_cast<double>(count) / state.total;
+      entropy -= p * std::log2(p);
+    }
+  }
+  return entropy;
+}
+
+void EdgeCountMetric::frame(State &state, const FrameViews &views) {
+  cv::Mat edges;
+  if (views.gray.depth() == CV_8U) {
+    cv::Canny(views.gray, edges, 100, 200);
+  } else {
+    // Canny takes 8-bit images; its thresholds are on that scale anyway
+    cv::Mat gray;
+    views.gray.convertTo(gray, CV_8U, views.scale);
+    cv::Canny(gray, edges, 100, 200);
+  }
+  state.edges = cv::countNonZero(edges);
+}
+
+void BlurScoreMetric::frame(State &state, const FrameViews &views) {
+  cv::Mat laplacian;
+  cv::Laplacian(views.gray, laplacian, CV_64F, 1, views.scale);
+  cv::Scalar mean, stddev;
+  cv::meanStdDev(laplacian, mean, stddev);
+  state.variance = stddev[0] * stddev[0];
+}
+
+void DominantColorsMetric::frame(State &state, const FrameViews &views) {
+  state.colors = vidicant::clusterColors(views.samples, 3, state.deadline);
+}
+
+void PerceptualHashMetric::frame(State &state, const FrameViews &views) {
+  state.hash = vidicant::computePerceptualHash(views.gray);
+}
@@ -0,0 +1,182 @@
+#include "vidicant/parallelism.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <mutex>
+#include <opencv2/core.hpp>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+std::mutex policyMutex;
+bool policySet = false;
+ParallelismPolicy installedPolicy;
+
+#ifdef __linux__
+// Parses a sysfs CPU list such as "0-3,8-11"
+std::vector<int> parseCpuList(const std::string &text) {
+  std::vector<int> cpus;
+  std::stringstream stream(text);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    std::size_t dash = range.find('-');
+    try {
+      int first = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? first
+                                           : std::stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; ++cpu)
+        cpus.push_back(cpu);
+    } catch (const std::exception &) {
+      continue; // Trailing newline or malformed entry
+    }
+  }
+  return cpus;
+}
+#endif
+
+} // namespace
+
+namespace vidicant {
+
+ParallelismPolicy makeParallelismPolicy(ParallelismMode mode, int jobs,
+                                        int cores) {
+  ParallelismPolicy policy;
+  policy.mode = mode;
+  policy.cores = cores > 0 ? cores
+                           : std::max(1, static_cast<int>(
+                                             getAvailableCpus().size()));
+  switch (mode) {
+  case ParallelismMode::File:
+    policy.fileWorkers = jobs > 0 ? jobs : policy.cores;
+    policy.threadsPerFile = 1;
+    break;
+  case ParallelismMode::IntraFile:
+    policy.fileWorkers = 1;
+    policy.threadsPerFile = policy.cores;
+    break;
+  case ParallelismMode::Hybrid:
+    // Scaling inside one file flattens out at a few threads, so by default
+    // run one file per four cores
+    policy.fileWorkers = jobs > 0 ? jobs : std::max(1, policy.cores / 4);
+    policy.threadsPerFile = std::max(1, policy.cores / policy.fileWorkers);
+    break;
+  }
+  return policy;
+}
+
+void setParallelismPolicy(const ParallelismPolicy &policy) {
+  std::lock_guard<std::mutex> lock(policyMutex);
+  installedPolicy = policy;
+  policySet = true;
+  // 1 runs parallel_for_ bodies on the calling thread only
+  cv::setNumThreads(policy.threadsPerFile);
+}
+
+ParallelismPolicy getParallelismPolicy() {
+  {
+    std::lock_guard<std::mutex> lock(policyMutex);
+    if (policySet)
+      return installedPolicy;
+  }
+  return makeParallelismPolicy(ParallelismMode::IntraFile);
+}
+
+bool parseParallelismMode(const std::string &text, ParallelismMode &mode) {
+  if (text == "file")
+    mode = ParallelismMode::File;
+  else if (text == "intra")
+    mode = ParallelismMode::IntraFile;
+  else if (text == "hybrid")
+    mode = ParallelismMode::Hybrid;
+  else
+    return false;
+  return true;
+}
+
+const char *parallelismModeName(ParallelismMode mode) {
+  switch (mode) {
+  case ParallelismMode::File:
+    return "file";
+  case ParallelismMode::IntraFile:
+    return "intra";
+  case ParallelismMode::Hybrid:
+    return "hybrid";
+  }
+  return "intra";
+}
+
+std::vector<int> getAvailableCpus() {
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+    // Walk NUMA nodes in order so each node's CPUs are contiguous
+    std::vector<int> nodes;
+    if (DIR *dir = opendir("/sys/devices/system/node")) {
+      while (dirent *entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.rfind("node", 0) == 0 && name.size() > 4 &&
+            std::isdigit(static_cast<unsigned char>(name[4])))
+          nodes.push_back(std::stoi(name.substr(4)));
+      }
+      closedir(dir);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    for (int node : nodes) {
+      std::ifstream list("/sys/devices/system/node/node" +
+                         std::to_string(node) + "/cpulist");
+      std::string text;
+      std::getline(list, text);
+      for (int cpu : parseCpuList(text)) {
+        if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed) &&
+            std::find(cpus.begin(), cpus.end(), cpu) == cpus.end())
+          cpus.push_back(cpu);
+      }
+    }
+    // Without NUMA information, or for CPUs it did not list
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &allowed) &&
+          std::find(cpus.begin(), cpus.end(), cpu) == cpus.end())
+        cpus.push_back(cpu);
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    int count = std::max(1u, std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < count; ++cpu)
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+bool pinCurrentThread(int workerIndex) {
+#ifdef __linux__
+  ParallelismPolicy policy = getParallelismPolicy();
+  std::vector<int> cpus = getAvailableCpus();
+  if (cpus.empty() || workerIndex < 0)
+    return false;
+  int width = std::min<int>(std::max(1, policy.threadsPerFile),
+                            static_cast<int>(cpus.size()));
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int i = 0; i < width; ++i) {
+    std::size_t slot = (static_cast<std::size_t>(workerIndex) * width + i) %
+                       cpus.size();
+    CPU_SET(cpus[slot], &set);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)workerIndex;
+  return false;
+#endif
+}
+
+} // namespace vidicant
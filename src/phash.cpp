@@ -0,0 +1,85 @@
+#include "vidicant/phash.hpp"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdio>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/opencv.hpp>
+
+namespace vidicant {
+
+PerceptualHash computePerceptualHash(const cv::Mat &image) {
+  PerceptualHash result;
+  if (image.empty())
+    return result;
+  cv::Mat gray;
+  if (image.channels() == 1) {
+    gray = image;
+  } else {
+    cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+  }
+
+  // dHash: one bit per horizontally adjacent pair in a 9x8 thumbnail
+  // (compared as floats, which works for any sample depth)
+  cv::Mat small;
+  cv::resize(gray, small, cv::Size(9, 8), 0, 0, cv::INTER_AREA);
+  small.convertTo(small, CV_32F);
+  for (int y = 0; y < 8; ++y) {
+    const float *row = small.ptr<float>(y);
+    for (int x = 0; x < 8; ++x) {
+      result.dHash <<= 1;
+      result.dHash |= row[x] > row[x + 1] ? 1u : 0u;
+    }
+  }
+
+  // pHash: sign of the 8x8 lowest DCT frequencies against their median
+  cv::Mat thumb, coefficients;
+  cv::resize(gray, thumb, cv::Size(32, 32), 0, 0, cv::INTER_AREA);
+  thumb.convertTo(thumb, CV_32F);
+  cv::dct(thumb, coefficients);
+  std::array<float, 64> low;
+  for (int y = 0; y < 8; ++y)
+    for (int x = 0; x < 8; ++x)
+      low[y * 8 + x] = coefficients.at<float>(y, x);
+  std::array<float, 64> sorted = low;
+  std::nth_element(sorted.begin(), sorted.begin() + 32, sorted.end());
+  float median = sorted[32];
+  for (float value : low) {
+    result.pHash <<= 1;
+    result.pHash |= value > median ? 1u : 0u;
+  }
+  return result;
+}
+
+int hammingDistance(std::uint64_t a, std::uint64_t b) {
+  return static_cast<int>(std::bitset<64>(a ^ b).count());
+}
+
+std::string formatHash(std::uint64_t hash) {
+  char buffer[17];
+  std::snprintf(buffer, sizeof(buffer), "%016llx",
+                static_cast<unsigned long long>(hash));
+  return buffer;
+}
+
+bool parseHash(const std::string &text, std::uint64_t &hash) {
+  if (text.empty() || text.size() > 16)
+    return false;
+  std::uint64_t value = 0;
+  for (char c : text) {
+    int digit;
+    if (c >= '0' && c <= '9')
+      digit = c - '0';
+    else if (c >= 'a' && c <= 'f')
+      digit = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      digit = c - 'A' + 10;
+    else
+      return false;
+    value = (value << 4) | static_cast<std::uint64_t>(digit);
+  }
+  hash = value;
+  return true;
+}
+
+} // namespace vidicant
@@ -0,0 +1,239 @@
+#include "vidicant/prefetch.hpp"
+#include "vidicant/trace.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Most reader threads started, however deep the read-ahead.
+constexpr std::size_t kMaxReaders = 16;
+
+// Bytes per read while warming a file.
+constexpr std::size_t kWarmChunkBytes = 1 << 20;
+
+// Gets the device holding a file, by its directory, or 0 if unknown.
+std::uint64_t getDevice(const std::string &path,
+                        std::map<std::string, std::uint64_t> &devices) {
+#ifndef _WIN32
+  std::string directory = std::filesystem::path(path).parent_path().string();
+  if (directory.empty())
+    directory = ".";
+  auto found = devices.find(directory);
+  if (found != devices.end())
+    return found->second;
+  struct stat info;
+  std::uint64_t device =
+      ::stat(directory.c_str(), &info) == 0
+          ? static_cast<std::uint64_t>(info.st_dev)
+          : 0;
+  devices.emplace(directory, device);
+  return device;
+#else
+  (void)path;
+  (void)devices;
+  return 0;
+#endif
+}
+
+// Reads a whole file into memory.
+bool readWhole(const std::string &path, std::vector<unsigned char> &bytes) {
+  std::ifstream input(path, std::ios::binary | std::ios::ate);
+  if (!input.is_open())
+    return false;
+  std::streamoff size = input.tellg();
+  if (size < 0)
+    return false;
+  bytes.resize(static_cast<std::size_t>(size));
+  input.seekg(0);
+  return input.read(reinterpret_cast<char *>(bytes.data()), size).good() ||
+         size == 0;
+}
+
+// Pulls the first and last bytes of a file into the page cache.
+// @return The number of bytes read, or -1 if the file cannot be opened.
+std::int64_t warmEnds(const std::string &path, std::uintmax_t warmBytes) {
+#ifndef _WIN32
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return -1;
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  std::uintmax_t size = static_cast<std::uintmax_t>(info.st_size);
+  std::uintmax_t head = std::min(size, warmBytes);
+  std::uintmax_t tailStart = std::max(head, size - std::min(size, warmBytes));
+  // Announce both ranges first, so the kernel queues them as large reads
+  // instead of growing its readahead window step by step; the reads below
+  // then wait for the pages to arrive
+  ::posix_fadvise(fd, 0, static_cast<off_t>(head), POSIX_FADV_WILLNEED);
+  if (tailStart < size)
+    ::posix_fadvise(fd, static_cast<off_t>(tailStart),
+                    static_cast<off_t>(size - tailStart), POSIX_FADV_WILLNEED);
+  std::vector<char> chunk(kWarmChunkBytes);
+  std::int64_t total = 0;
+  auto readRange = [&](std::uintmax_t begin, std::uintmax_t end) {
+    while (begin < end) {
+      std::size_t want = static_cast<std::size_t>(
+          std::min<std::uintmax_t>(end - begin, chunk.size()));
+      ssize_t got =
+          ::pread(fd, chunk.data(), want, static_cast<off_t>(begin));
+      if (got <= 0)
+        return;
+      begin += static_cast<std::uintmax_t>(got);
+      total += got;
+    }
+  };
+  readRange(0, head);
+  readRange(tailStart, size);
+  ::close(fd);
+  return total;
+#else
+  std::ifstream input(path, std::ios::binary);
+  if (!input.is_open())
+    return -1;
+  std::vector<char> chunk(kWarmChunkBytes);
+  std::int64_t total = 0;
+  while (static_cast<std::uintmax_t>(total) < warmBytes &&
+         input.read(chunk.data(), chunk.size()).gcount() > 0)
+    total += input.gcount();
+  return total;
+#endif
+}
+
+} // namespace
+
+Prefetcher::Prefetcher(std::vector<PrefetchRequest> files,
+                       const PrefetchOptions &options)
+    : options_(options) {
+  std::map<std::string, std::uint64_t> devices;
+  items_.resize(files.size());
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    Item &item = items_[i];
+    item.request = std::move(files[i]);
+    item.request.buffer = item.request.buffer && item.request.size > 0 &&
+                          item.request.size <= options_.maxBytes;
+    if (options_.depth > 0)
+      item.device = getDevice(item.request.path, devices);
+  }
+  options_.deviceReads = std::max<std::size_t>(options_.deviceReads, 1);
+  std::size_t readers =
+      std::min({options_.depth, items_.size(), kMaxReaders});
+  for (std::size_t i = 0; i < readers; ++i)
+    readers_.emplace_back(&Prefetcher::readerLoop, this);
+}
+
+Prefetcher::~Prefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  for (auto &reader : readers_)
+    reader.join();
+}
+
+bool Prefetcher::take(std::size_t index, std::vector<unsigned char> &bytes) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  Item &item = items_[index];
+  if (item.state == State::Taken)
+    return false;
+  ++taken_;
+  if (item.state == State::Reading) {
+    TraceSpan span("prefetch_wait", item.request.path);
+    changed_.wait(lock, [&item] { return item.state == State::Done; });
+  }
+  bool held = item.state == State::Done && item.ok && item.request.buffer;
+  if (held)
+    bytes = std::move(item.bytes);
+  item.bytes = std::vector<unsigned char>();
+  buffered_ -= item.reserved;
+  item.reserved = 0;
+  item.state = State::Taken;
+  changed_.notify_all(); // The window moved and buffer space may be free
+  return held;
+}
+
+std::uintmax_t Prefetcher::getBytesRead() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytesRead_;
+}
+
+bool Prefetcher::findReadable(std::size_t &index) {
+  while (first_ < items_.size() && items_[first_].state != State::Queued)
+    ++first_;
+  std::size_t end = std::min(items_.size(), taken_ + options_.depth);
+  for (std::size_t i = first_; i < end; ++i) {
+    const Item &item = items_[i];
+    if (item.state != State::Queued)
+      continue;
+    auto reads = deviceReads_.find(item.device);
+    if (reads != deviceReads_.end() && reads->second >= options_.deviceReads)
+      continue;
+    // One buffered file is always allowed, so a file near the cap is not
+    // held back forever
+    if (item.request.buffer && buffered_ > 0 &&
+        buffered_ + item.request.size > options_.maxBytes)
+      continue;
+    index = i;
+    return true;
+  }
+  return false;
+}
+
+void Prefetcher::readerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    std::size_t index = 0;
+    changed_.wait(lock, [&] { return stopping_ || findReadable(index); });
+    if (stopping_)
+      return;
+    Item &item = items_[index];
+    item.state = State::Reading;
+    ++deviceReads_[item.device];
+    if (item.request.buffer) {
+      item.reserved = item.request.size;
+      buffered_ += item.reserved;
+    }
+    lock.unlock();
+
+    std::vector<unsigned char> bytes;
+    std::int64_t read = 0;
+    bool ok = false;
+    {
+      TraceSpan span("prefetch", item.request.path);
+      if (item.request.buffer) {
+        ok = readWhole(item.request.path, bytes);
+        read = static_cast<std::int64_t>(bytes.size());
+      } else {
+        read = warmEnds(item.request.path, options_.warmBytes);
+        ok = read >= 0;
+      }
+    }
+
+    lock.lock();
+    if (--deviceReads_[item.device] == 0)
+      deviceReads_.erase(item.device);
+    bytesRead_ += static_cast<std::uintmax_t>(std::max<std::int64_t>(read, 0));
+    item.ok = ok;
+    if (ok && item.request.buffer) {
+      // Count what was read, in case the file changed size since listing
+      buffered_ = buffered_ - item.reserved + bytes.size();
+      item.reserved = bytes.size();
+      item.bytes = std::move(bytes);
+    } else {
+      buffered_ -= item.reserved;
+      item.reserved = 0;
+    }
+    item.state = State::Done;
+    changed_.notify_all();
+  }
+}
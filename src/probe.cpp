@@ -0,0 +1,481 @@
+#include "vidicant/probe.hpp"
+#include "vidicant/image_sequence.hpp"
+#include "vidicant/proxy.hpp"
+#include "vidicant/video.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+std::uint32_t readBE(const unsigned char *p, int bytes) {
+  std::uint32_t value = 0;
+  for (int i = 0; i < bytes; ++i)
+    value = (value << 8) | p[i];
+  return value;
+}
+
+std::uint32_t readLE(const unsigned char *p, int bytes) {
+  std::uint32_t value = 0;
+  for (int i = bytes - 1; i >= 0; --i)
+    value = (value << 8) | p[i];
+  return value;
+}
+
+// Walks JPEG marker segments up to the first start-of-frame
+bool probeJpeg(std::ifstream &input, int &width, int &height) {
+  input.seekg(2);
+  unsigned char marker[4];
+  while (input.read(reinterpret_cast<char *>(marker), 4)) {
+    if (marker[0] != 0xFF)
+      return false;
+    if (marker[1] == 0xFF) { // Fill byte; resynchronize one byte later
+      input.seekg(-3, std::ios::cur);
+      continue;
+    }
+    std::uint32_t length = readBE(marker + 2, 2);
+    bool startOfFrame = marker[1] >= 0xC0 && marker[1] <= 0xCF &&
+                        marker[1] != 0xC4 && marker[1] != 0xC8 &&
+                        marker[1] != 0xCC;
+    if (startOfFrame) {
+      unsigned char frame[5];
+      if (!input.read(reinterpret_cast<char *>(frame), 5))
+        return false;
+      height = static_cast<int>(readBE(frame + 1, 2));
+      width = static_cast<int>(readBE(frame + 3, 2));
+      return true;
+    }
+    if (length < 2)
+      return false;
+    input.seekg(length - 2, std::ios::cur);
+  }
+  return false;
+}
+
+// Reads ImageWidth, ImageLength and BitsPerSample from the first TIFF
+// directory
+bool probeTiff(std::ifstream &input, bool littleEndian, int &width,
+               int &height, int &bitDepth) {
+  auto read = [littleEndian](const unsigned char *p, int bytes) {
+    return littleEndian ? readLE(p, bytes) : readBE(p, bytes);
+  };
+  unsigned char header[8];
+  input.seekg(0);
+  if (!input.read(reinterpret_cast<char *>(header), 8))
+    return false;
+  input.seekg(read(header + 4, 4));
+  unsigned char countBytes[2];
+  if (!input.read(reinterpret_cast<char *>(countBytes), 2))
+    return false;
+  std::uint32_t count = read(countBytes, 2);
+  for (std::uint32_t i = 0; i < count; ++i) {
+    unsigned char entry[12];
+    if (!input.read(reinterpret_cast<char *>(entry), 12))
+      return false;
+    std::uint32_t tag = read(entry, 2);
+    std::uint32_t type = read(entry + 2, 2);
+    // SHORT values are left-justified in the 4-byte value field
+    std::uint32_t value = type == 3 ? read(entry + 8, 2) : read(entry + 8, 4);
+    if (tag == 256) {
+      width = static_cast<int>(value);
+    } else if (tag == 257) {
+      height = static_cast<int>(value);
+    } else if (tag == 258) {
+      // One value per channel; more than two SHORTs are stored elsewhere,
+      // and every channel has the same depth in practice
+      if (read(entry + 4, 4) > 2) {
+        auto next = input.tellg();
+        unsigned char first[2];
+        input.seekg(read(entry + 8, 4));
+        if (input.read(reinterpret_cast<char *>(first), 2))
+          value = read(first, 2);
+        input.clear();
+        input.seekg(next);
+      }
+      bitDepth = static_cast<int>(value);
+    }
+  }
+  return width > 0 && height > 0;
+}
+
+// Skips a chain of GIF data sub-blocks, up to and including the terminator
+bool skipGifSubBlocks(std::ifstream &input) {
+  int size;
+  while ((size = input.get()) > 0)
+    input.seekg(size, std::ios::cur);
+  return size == 0;
+}
+
+// Counts GIF image descriptors and sums their Graphic Control Extension
+// delays (in hundredths of a second)
+void probeGifFrames(std::ifstream &input, const unsigned char *head,
+                    int &frames, double &duration) {
+  input.seekg(13);
+  if (head[10] & 0x80) // Global color table
+    input.seekg(3 * (2 << (head[10] & 0x07)), std::ios::cur);
+  frames = 0;
+  std::uint32_t delay = 0;
+  int block;
+  while ((block = input.get()) != EOF && block != 0x3B) {
+    if (block == 0x21) { // Extension
+      int label = input.get();
+      if (label == 0xF9) {
+        unsigned char control[6];
+        if (!input.read(reinterpret_cast<char *>(control), 6))
+          break;
+        delay += readLE(control + 2, 2);
+        input.seekg(-1, std::ios::cur); // Back to the terminator
+      }
+      if (!skipGifSubBlocks(input))
+        break;
+    } else if (block == 0x2C) { // Image descriptor
+      unsigned char descriptor[9];
+      if (!input.read(reinterpret_cast<char *>(descriptor), 9))
+        break;
+      if (descriptor[8] & 0x80) // Local color table
+        input.seekg(3 * (2 << (descriptor[8] & 0x07)), std::ios::cur);
+      input.get(); // LZW minimum code size
+      if (!skipGifSubBlocks(input))
+        break;
+      ++frames;
+    } else {
+      break;
+    }
+  }
+  frames = std::max(frames, 1);
+  duration = delay / 100.0;
+}
+
+// Counts the ANMF chunks of an animated WebP and sums their durations
+void probeWebpFrames(std::ifstream &input, int &frames, double &duration) {
+  input.seekg(12);
+  frames = 0;
+  std::uint32_t milliseconds = 0;
+  unsigned char chunk[8];
+  while (input.read(reinterpret_cast<char *>(chunk), 8)) {
+    std::uint32_t size = readLE(chunk + 4, 4);
+    std::streamoff next = static_cast<std::streamoff>(input.tellg()) +
+                          static_cast<std::streamoff>(size + (size & 1));
+    if (std::memcmp(chunk, "ANMF", 4) == 0) {
+      unsigned char frame[15];
+      if (!input.read(reinterpret_cast<char *>(frame), 15))
+        break;
+      milliseconds += readLE(frame + 12, 3);
+      ++frames;
+    }
+    input.seekg(next);
+  }
+  frames = std::max(frames, 1);
+  duration = milliseconds / 1000.0;
+}
+
+// Calls visit(type, payload, length) for each box in an ISO media box
+// payload, stopping early if it returns true or a size runs past the end
+template <typename Visit>
+void forEachBox(const unsigned char *data, std::size_t size, Visit visit) {
+  std::size_t at = 0;
+  while (at + 8 <= size) {
+    std::uint64_t boxSize = readBE(data + at, 4);
+    std::size_t header = 8;
+    if (boxSize == 1 && at + 16 <= size) {
+      boxSize = (std::uint64_t{readBE(data + at + 8, 4)} << 32) |
+                readBE(data + at + 12, 4);
+      header = 16;
+    } else if (boxSize == 0) {
+      boxSize = size - at; // Runs to the end of its parent
+    }
+    if (boxSize < header || boxSize > size - at)
+      return;
+    if (visit(data + at + 4, data + at + header,
+              static_cast<std::size_t>(boxSize) - header))
+      return;
+    at += static_cast<std::size_t>(boxSize);
+  }
+}
+
+// Finds the first box of a type in an ISO media box payload
+bool findBox(const unsigned char *data, std::size_t size, const char *type,
+             const unsigned char *&payload, std::size_t &length) {
+  bool found = false;
+  forEachBox(data, size,
+             [&](const unsigned char *boxType, const unsigned char *boxData,
+                 std::size_t boxLength) {
+               if (std::memcmp(boxType, type, 4) != 0)
+                 return false;
+               payload = boxData;
+               length = boxLength;
+               found = true;
+               return true;
+             });
+  return found;
+}
+
+// Follows a path of nested boxes, e.g. "mdiaminfstbl"
+bool findBoxPath(const unsigned char *data, std::size_t size,
+                 const char *path, const unsigned char *&payload,
+                 std::size_t &length) {
+  for (; *path != '\0'; path += 4) {
+    if (!findBox(data, size, path, payload, length))
+      return false;
+    data = payload;
+    size = length;
+  }
+  return true;
+}
+
+// Reads the first video track of an MP4 or QuickTime movie box: the size
+// from its track header, the frame count from its sample sizes and the
+// duration from its media header
+bool probeMovie(const unsigned char *moov, std::size_t size, int &width,
+                int &height, int &frames, double &duration) {
+  bool found = false;
+  forEachBox(moov, size, [&](const unsigned char *type,
+                             const unsigned char *trak, std::size_t length) {
+    const unsigned char *box = nullptr;
+    std::size_t boxLength = 0;
+    if (std::memcmp(type, "trak", 4) != 0 ||
+        !findBoxPath(trak, length, "mdiahdlr", box, boxLength) ||
+        boxLength < 12 || std::memcmp(box + 8, "vide", 4) != 0)
+      return false;
+    if (!findBox(trak, length, "tkhd", box, boxLength) || boxLength < 84)
+      return false;
+    std::size_t sizeAt = box[0] == 1 ? 88 : 76; // After the 16.16 matrix
+    if (boxLength < sizeAt + 8)
+      return false;
+    width = static_cast<int>(readBE(box + sizeAt, 4) >> 16);
+    height = static_cast<int>(readBE(box + sizeAt + 4, 4) >> 16);
+    if (findBoxPath(trak, length, "mdiamdhd", box, boxLength) &&
+        boxLength > 0) {
+      bool wide = box[0] == 1; // 64-bit times
+      std::size_t scaleAt = wide ? 20 : 12;
+      if (boxLength >= scaleAt + (wide ? 12 : 8)) {
+        std::uint32_t timescale = readBE(box + scaleAt, 4);
+        std::uint64_t ticks =
+            wide ? (std::uint64_t{readBE(box + scaleAt + 4, 4)} << 32) |
+                       readBE(box + scaleAt + 8, 4)
+                 : readBE(box + scaleAt + 4, 4);
+        if (timescale > 0)
+          duration = static_cast<double>(ticks) / timescale;
+      }
+    }
+    // Fragmented files list their samples later, in the fragments
+    if (findBoxPath(trak, length, "mdiaminfstblstsz", box, boxLength) &&
+        boxLength >= 12)
+      frames = static_cast<int>(
+          std::min<std::uint32_t>(readBE(box + 8, 4), 0x7FFFFFFF));
+    found = true;
+    return true;
+  });
+  return found;
+}
+
+// Skips the top-level boxes of an ISO media file to its movie box, which
+// is read whole; the media data is never touched
+bool probeIsoMedia(std::ifstream &input, std::uintmax_t fileSize,
+                   int &width, int &height, int &frames, double &duration) {
+  constexpr std::uint64_t kMaxMovieBytes = 64u << 20;
+  std::uint64_t at = 0;
+  unsigned char header[16];
+  while (at + 8 <= fileSize) {
+    input.seekg(static_cast<std::streamoff>(at));
+    if (!input.read(reinterpret_cast<char *>(header), 8))
+      return false;
+    std::uint64_t boxSize = readBE(header, 4);
+    std::uint64_t headerSize = 8;
+    if (boxSize == 1) {
+      if (!input.read(reinterpret_cast<char *>(header + 8), 8))
+        return false;
+      boxSize = (std::uint64_t{readBE(header + 8, 4)} << 32) |
+                readBE(header + 12, 4);
+      headerSize = 16;
+    } else if (boxSize == 0) {
+      boxSize = fileSize - at; // Runs to the end of the file
+    }
+    if (boxSize < headerSize || boxSize > fileSize - at)
+      return false;
+    if (std::memcmp(header + 4, "moov", 4) == 0) {
+      if (boxSize - headerSize > kMaxMovieBytes)
+        return false;
+      std::vector<unsigned char> moov(
+          static_cast<std::size_t>(boxSize - headerSize));
+      if (!input.read(reinterpret_cast<char *>(moov.data()),
+                      static_cast<std::streamsize>(moov.size())))
+        return false;
+      return probeMovie(moov.data(), moov.size(), width, height, frames,
+                        duration);
+    }
+    at += boxSize;
+  }
+  return false;
+}
+
+// Reads the main header at the start of an AVI file. Its frame count
+// covers the first RIFF segment only, which undercounts OpenDML files
+// over 1 GB; that is close enough to order work by.
+bool probeAvi(const unsigned char *head, int &width, int &height,
+              int &frames, double &duration) {
+  if (std::memcmp(head + 12, "LIST", 4) != 0 ||
+      std::memcmp(head + 20, "hdrl", 4) != 0 ||
+      std::memcmp(head + 24, "avih", 4) != 0)
+    return false;
+  const unsigned char *avih = head + 32;
+  std::uint32_t microseconds = readLE(avih, 4);
+  std::uint32_t total = readLE(avih + 16, 4);
+  frames = static_cast<int>(std::min<std::uint32_t>(total, 0x7FFFFFFF));
+  width = static_cast<int>(readLE(avih + 32, 4));
+  height = static_cast<int>(readLE(avih + 36, 4));
+  duration = total * (microseconds / 1e6);
+  return true;
+}
+
+// Returns the size of a file in bytes, or 0 if it cannot be read
+std::uintmax_t fileSizeOf(const std::string &filename) {
+  std::error_code ec;
+  std::uintmax_t size = std::filesystem::file_size(filename, ec);
+  return ec ? 0 : size;
+}
+
+} // namespace
+
+namespace vidicant {
+
+int readExifOrientation(const unsigned char *data, std::size_t length) {
+  if (length < 14 || std::memcmp(data, "Exif\0\0", 6) != 0)
+    return 1;
+  const unsigned char *tiff = data + 6;
+  std::size_t size = length - 6;
+  bool little = tiff[0] == 'I';
+  auto read = [&](std::size_t at, int bytes) {
+    return little ? readLE(tiff + at, bytes) : readBE(tiff + at, bytes);
+  };
+  std::size_t ifd = read(4, 4);
+  if (ifd + 2 > size)
+    return 1;
+  unsigned entries = read(ifd, 2);
+  for (unsigned i = 0; i < entries; ++i) {
+    std::size_t entry = ifd + 2 + i * 12;
+    if (entry + 12 > size)
+      break;
+    if (read(entry, 2) == 0x0112)
+      return static_cast<int>(read(entry + 8, 2));
+  }
+  return 1;
+}
+
+MediaProbe probeImage(const std::string &filename) {
+  MediaProbe probe;
+  probe.fileSize = fileSizeOf(filename);
+  std::ifstream input(filename, std::ios::binary);
+  unsigned char head[32] = {};
+  if (!input.read(reinterpret_cast<char *>(head), sizeof(head)) &&
+      input.gcount() < 10)
+    return probe;
+  input.clear();
+
+  int width = -1;
+  int height = -1;
+  int frames = 1;
+  double duration = 0.0;
+  int bitDepth = 8;
+  if (head[0] == 0xFF && head[1] == 0xD8) {
+    probeJpeg(input, width, height);
+  } else if (std::memcmp(head, "\x89PNG", 4) == 0) {
+    width = static_cast<int>(readBE(head + 16, 4));
+    height = static_cast<int>(readBE(head + 20, 4));
+    bitDepth = head[24];
+  } else if (std::memcmp(head, "GIF8", 4) == 0) {
+    width = static_cast<int>(readLE(head + 6, 2));
+    height = static_cast<int>(readLE(head + 8, 2));
+    probeGifFrames(input, head, frames, duration);
+  } else if (head[0] == 'B' && head[1] == 'M') {
+    width = static_cast<std::int32_t>(readLE(head + 18, 4));
+    height = static_cast<std::int32_t>(readLE(head + 22, 4));
+    if (height < 0)
+      height = -height; // Top-down bitmap
+  } else if (std::memcmp(head, "RIFF", 4) == 0 &&
+             std::memcmp(head + 8, "WEBP", 4) == 0) {
+    if (std::memcmp(head + 12, "VP8 ", 4) == 0) {
+      width = static_cast<int>(readLE(head + 26, 2) & 0x3FFF);
+      height = static_cast<int>(readLE(head + 28, 2) & 0x3FFF);
+    } else if (std::memcmp(head + 12, "VP8L", 4) == 0) {
+      std::uint32_t bits = readLE(head + 21, 4);
+      width = static_cast<int>((bits & 0x3FFF) + 1);
+      height = static_cast<int>(((bits >> 14) & 0x3FFF) + 1);
+    } else if (std::memcmp(head + 12, "VP8X", 4) == 0) {
+      width = static_cast<int>(readLE(head + 24, 3) + 1);
+      height = static_cast<int>(readLE(head + 27, 3) + 1);
+      if (head[20] & 0x02) // Animation flag
+        probeWebpFrames(input, frames, duration);
+    }
+  } else if (std::memcmp(head, "II*\0", 4) == 0) {
+    probeTiff(input, true, width, height, bitDepth);
+  } else if (std::memcmp(head, "MM\0*", 4) == 0) {
+    probeTiff(input, false, width, height, bitDepth);
+  }
+
+  if (width > 0 && height > 0) {
+    probe.ok = true;
+    probe.width = width;
+    probe.height = height;
+    probe.frameCount = frames;
+    probe.duration = duration;
+    probe.bitDepth = bitDepth;
+  }
+  return probe;
+}
+
+MediaProbe probeVideo(const std::string &filename) {
+  MediaProbe probe;
+  probe.fileSize = fileSizeOf(filename);
+  if (isAnimatedImage(filename)) {
+    probe = probeImage(filename);
+    return probe;
+  }
+  if (isImageSequence(filename) || isVideoProxy(filename)) {
+    // Their loaders stat files or map a header rather than open a codec
+    auto loader = makeVideoLoader(filename);
+    if (!loader->open(filename))
+      return probe;
+    auto [width, height] = loader->getResolution();
+    probe.width = width;
+    probe.height = height;
+    probe.frameCount = loader->getFrameCount();
+    probe.ok = width > 0 && height > 0;
+    return probe;
+  }
+
+  std::ifstream input(filename, std::ios::binary);
+  unsigned char head[72] = {};
+  if (!input.read(reinterpret_cast<char *>(head), sizeof(head)) &&
+      input.gcount() < 12)
+    return probe;
+  input.clear();
+
+  int width = -1;
+  int height = -1;
+  int frames = 1;
+  double duration = 0.0;
+  if (std::memcmp(head, "RIFF", 4) == 0 &&
+      std::memcmp(head + 8, "AVI ", 4) == 0) {
+    probeAvi(head, width, height, frames, duration);
+  } else if (std::memcmp(head + 4, "ftyp", 4) == 0 ||
+             std::memcmp(head + 4, "moov", 4) == 0 ||
+             std::memcmp(head + 4, "mdat", 4) == 0 ||
+             std::memcmp(head + 4, "wide", 4) == 0 ||
+             std::memcmp(head + 4, "free", 4) == 0) {
+    probeIsoMedia(input, probe.fileSize, width, height, frames, duration);
+  }
+
+  if (width > 0 && height > 0) {
+    probe.ok = true;
+    probe.width = width;
+    probe.height = height;
+    probe.frameCount = std::max(frames, 1);
+    probe.duration = duration;
+  }
+  return probe;
+}
+
+} // namespace vidicant
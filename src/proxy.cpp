@@ -0,0 +1,409 @@
+#include "vidicant/proxy.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <opencv2/imgproc.hpp>
+#include <random>
+#include <system_error>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Extension of proxy files.
+const char kProxyExtension[] = ".vproxy";
+
+// Suffix of proxies being built, followed by a random number.
+const char kPartialSuffix[] = ".tmp";
+
+// Age past which a partial proxy is taken as left by a crashed build; a
+// build in progress writes to it far more often.
+constexpr std::chrono::hours kStalePartialAge(1);
+
+const char kMagic[8] = {'V', 'D', 'P', 'R', 'O', 'X', 'Y', '1'};
+
+// On-disk header; proxy.hpp describes the layout that follows it.
+struct ProxyHeader {
+  char magic[8];
+  std::uint64_t sourceBytes;
+  std::int64_t sourceTime;
+  std::int32_t sourceWidth;
+  std::int32_t sourceHeight;
+  std::int32_t width;
+  std::int32_t height;
+  std::int32_t channels;
+  std::int32_t frameCount;
+  double fps;
+  std::uint64_t framesOffset;
+  std::uint64_t timestampsOffset;
+};
+
+// Gets the bytes of one frame of a proxy.
+std::uint64_t frameBytes(const ProxyInfo &info) {
+  // In 64 bits, since the width times the height can overflow an int
+  return static_cast<std::uint64_t>(info.frameSize.width) *
+         static_cast<std::uint64_t>(info.frameSize.height) *
+         static_cast<std::uint64_t>(info.channels);
+}
+
+// Reads the size and modification time that tie a proxy to its source.
+// @return False if the source is not a regular file.
+bool sourceStamp(const std::string &source, std::uint64_t &bytes,
+                 std::int64_t &time) {
+  std::error_code ec;
+  if (!fs::is_regular_file(source, ec))
+    return false;
+  bytes = fs::file_size(source, ec);
+  if (ec)
+    return false;
+  auto modified = fs::last_write_time(source, ec);
+  if (ec)
+    return false;
+  time = static_cast<std::int64_t>(modified.time_since_epoch().count());
+  return true;
+}
+
+// Hashes a path with 64-bit FNV-1a, which is stable across builds.
+std::uint64_t hashPath(const std::string &path) {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : path) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+} // namespace
+
+bool ProxyWriter::open(const std::string &filename, const ProxyInfo &info) {
+  info_ = info;
+  info_.frameCount = 0;
+  timestamps_.clear();
+  output_.open(filename, std::ios::binary | std::ios::trunc);
+  if (!output_.is_open())
+    return false;
+  // Placeholder until finish() knows the frame count
+  ProxyHeader header{};
+  output_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  return static_cast<bool>(output_);
+}
+
+bool ProxyWriter::addFrame(const cv::Mat &frame, double timestamp) {
+  if (frame.empty() || frame.depth() != CV_8U)
+    return false;
+  if (frame.size() == info_.frameSize)
+    scaled_ = frame;
+  else
+    cv::resize(frame, scaled_, info_.frameSize, 0, 0, cv::INTER_AREA);
+
+  // Scaling first leaves fewer pixels to convert
+  const cv::Mat *pixels = &scaled_;
+  int channels = scaled_.channels();
+  if (info_.channels == 1 && channels != 1) {
+    cv::cvtColor(scaled_, gray_,
+                 channels == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+    pixels = &gray_;
+  } else if (info_.channels == 3 && channels != 3) {
+    cv::cvtColor(scaled_, gray_,
+                 channels == 4 ? cv::COLOR_BGRA2BGR : cv::COLOR_GRAY2BGR);
+    pixels = &gray_;
+  }
+
+  auto rowBytes = static_cast<std::streamsize>(pixels->cols) * info_.channels;
+  for (int y = 0; y < pixels->rows; ++y)
+    output_.write(reinterpret_cast<const char *>(pixels->ptr(y)), rowBytes);
+  timestamps_.push_back(timestamp);
+  ++info_.frameCount;
+  return static_cast<bool>(output_);
+}
+
+bool ProxyWriter::finish() {
+  ProxyHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.sourceBytes = info_.sourceBytes;
+  header.sourceTime = info_.sourceTime;
+  header.sourceWidth = info_.sourceSize.width;
+  header.sourceHeight = info_.sourceSize.height;
+  header.width = info_.frameSize.width;
+  header.height = info_.frameSize.height;
+  header.channels = info_.channels;
+  header.frameCount = info_.frameCount;
+  header.fps = info_.fps;
+  header.framesOffset = sizeof(ProxyHeader);
+  header.timestampsOffset =
+      header.framesOffset + frameBytes(info_) * timestamps_.size();
+
+  output_.write(reinterpret_cast<const char *>(timestamps_.data()),
+                static_cast<std::streamsize>(timestamps_.size() * 8));
+  output_.seekp(0);
+  output_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  output_.close();
+  return !output_.fail();
+}
+
+bool ProxyVideoLoader::open(const std::string &filename) {
+  index_ = 0;
+  info_ = ProxyInfo();
+  if (!file_.open(filename, MappedFile::Access::Sequential) ||
+      file_.size() < sizeof(ProxyHeader))
+    return false;
+  ProxyHeader header;
+  std::memcpy(&header, file_.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      (header.channels != 1 && header.channels != 3) || header.width <= 0 ||
+      header.height <= 0 || header.frameCount < 0)
+    return false;
+
+  ProxyInfo info;
+  info.sourceBytes = header.sourceBytes;
+  info.sourceTime = header.sourceTime;
+  info.sourceSize = cv::Size(header.sourceWidth, header.sourceHeight);
+  info.frameSize = cv::Size(header.width, header.height);
+  info.channels = header.channels;
+  info.frameCount = header.frameCount;
+  info.fps = header.fps;
+  // Divide rather than multiply, so a hostile header cannot wrap the
+  // sizes around and pass
+  auto count = static_cast<std::uint64_t>(header.frameCount);
+  std::uint64_t size = file_.size();
+  if (header.framesOffset < sizeof(ProxyHeader) ||
+      header.framesOffset > header.timestampsOffset ||
+      header.timestampsOffset > size ||
+      count > (header.timestampsOffset - header.framesOffset) /
+                  frameBytes(info) ||
+      count > (size - header.timestampsOffset) / 8)
+    return false;
+
+  info_ = info;
+  frames_ = file_.data() + header.framesOffset;
+  timestamps_ = file_.data() + header.timestampsOffset;
+  return true;
+}
+
+int ProxyVideoLoader::getFrameCount() { return info_.frameCount; }
+
+double ProxyVideoLoader::getFPS() { return info_.fps; }
+
+std::pair<int, int> ProxyVideoLoader::getResolution() {
+  return {info_.sourceSize.width, info_.sourceSize.height};
+}
+
+cv::Mat ProxyVideoLoader::readFrame() {
+  cv::Mat frame;
+  readFrame(frame);
+  return frame;
+}
+
+bool ProxyVideoLoader::readFrame(cv::Mat &frame) {
+  if (index_ >= info_.frameCount)
+    return false;
+  // Copied, so callers may write to the frame; the mapping is read-only
+  std::uint64_t bytes = frameBytes(info_);
+  frame.create(info_.frameSize, CV_8UC(info_.channels));
+  std::memcpy(frame.data, frames_ + bytes * index_, bytes);
+  ++index_;
+  return true;
+}
+
+bool ProxyVideoLoader::skipFrame() {
+  if (index_ >= info_.frameCount)
+    return false;
+  ++index_;
+  return true;
+}
+
+double ProxyVideoLoader::getTimestamp() {
+  if (index_ == 0)
+    return -1.0;
+  double timestamp;
+  std::memcpy(&timestamp, timestamps_ + 8 * (index_ - 1), sizeof(timestamp));
+  return timestamp;
+}
+
+bool ProxyVideoLoader::seekFrame(int index) {
+  if (index < 0 || index >= info_.frameCount)
+    return false;
+  index_ = index;
+  return true;
+}
+
+const ProxyInfo &ProxyVideoLoader::getInfo() const { return info_; }
+
+namespace vidicant {
+
+bool isVideoProxy(const std::string &filename) {
+  return fs::path(filename).extension() == kProxyExtension;
+}
+
+std::string getProxyPath(const std::string &source,
+                         const std::string &directory) {
+  std::error_code ec;
+  fs::path absolute = fs::absolute(source, ec).lexically_normal();
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx",
+                static_cast<unsigned long long>(hashPath(absolute.string())));
+  return (fs::path(directory) / (name + std::string(kProxyExtension)))
+      .string();
+}
+
+bool buildVideoProxy(const std::string &source, const std::string &proxyPath,
+                     const ProxyOptions &options, const Deadline &deadline) {
+  auto loader = makeVideoLoader(source);
+  if (!loader->open(source))
+    return false;
+  auto [width, height] = loader->getResolution();
+  if (width <= 0 || height <= 0)
+    return false;
+
+  ProxyInfo info;
+  sourceStamp(source, info.sourceBytes, info.sourceTime);
+  info.sourceSize = cv::Size(width, height);
+  int rows = options.height > 0 ? std::min(options.height, height) : height;
+  int cols = static_cast<int>(
+      std::lround(static_cast<double>(width) * rows / height));
+  info.frameSize = cv::Size(std::max(cols, 1), rows);
+  info.channels = options.color ? 3 : 1;
+  info.fps = loader->getFPS();
+
+  // Skip sources whose proxy alone would not fit the cache
+  std::uint64_t bytes = frameBytes(info);
+  std::uint64_t limit = options.maxBytes;
+  int expected = loader->getFrameCount();
+  if (limit > 0 && expected > 0 &&
+      bytes * static_cast<std::uint64_t>(expected) > limit)
+    return false;
+
+  ProxyWriter writer;
+  if (!writer.open(proxyPath, info))
+    return false;
+  cv::Mat frame;
+  int index = 0;
+  bool complete = true;
+  while (loader->readFrame(frame)) {
+    if (deadline.expired() ||
+        (limit > 0 && bytes * static_cast<std::uint64_t>(index + 1) > limit)) {
+      complete = false;
+      break;
+    }
+    double timestamp = loader->getTimestamp();
+    if (timestamp < 0.0)
+      timestamp = info.fps > 0 ? index * 1000.0 / info.fps : 0.0;
+    if (!writer.addFrame(frame, timestamp)) {
+      complete = false;
+      break;
+    }
+    ++index;
+  }
+  complete = complete && index > 0 && writer.finish();
+  if (!complete) {
+    std::error_code ec;
+    fs::remove(proxyPath, ec);
+  }
+  return complete;
+}
+
+std::string ensureVideoProxy(const std::string &source,
+                             const ProxyOptions &options,
+                             const Deadline &deadline, bool *built) {
+  if (built != nullptr)
+    *built = false;
+  std::uint64_t bytes = 0;
+  std::int64_t time = 0;
+  if (options.directory.empty() || !sourceStamp(source, bytes, time))
+    return {};
+  std::string path = getProxyPath(source, options.directory);
+
+  std::error_code ec;
+  {
+    ProxyVideoLoader cached;
+    if (cached.open(path)) {
+      const ProxyInfo &info = cached.getInfo();
+      int rows = options.height > 0
+                     ? std::min(options.height, info.sourceSize.height)
+                     : info.sourceSize.height;
+      if (info.sourceBytes == bytes && info.sourceTime == time &&
+          info.frameSize.height == rows &&
+          (info.channels == 3 || !options.color)) {
+        // The modification time records the use for eviction
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+        return path;
+      }
+    }
+  }
+
+  // Build beside the cache entry and rename it into place, so concurrent
+  // readers never see a partial proxy
+  fs::create_directories(options.directory, ec);
+  std::string partial = path + kPartialSuffix +
+                        std::to_string(std::random_device{}());
+  if (!buildVideoProxy(source, partial, options, deadline))
+    return {};
+  fs::rename(partial, path, ec);
+  if (ec) {
+    fs::remove(partial, ec);
+    return {};
+  }
+  if (built != nullptr)
+    *built = true;
+  evictVideoProxies(options.directory, options.maxBytes, path);
+  return path;
+}
+
+int evictVideoProxies(const std::string &directory, std::uintmax_t maxBytes,
+                      const std::string &keep) {
+  // Partial proxies a crashed build left behind are removed whatever the
+  // limit; those still being written are left alone
+  int removed = 0;
+  std::error_code ec;
+  auto now = fs::file_time_type::clock::now();
+  for (const auto &item : fs::directory_iterator(directory, ec)) {
+    fs::path name = item.path().filename();
+    if (name.stem().extension() != kProxyExtension ||
+        name.extension().string().rfind(kPartialSuffix, 0) != 0 ||
+        !item.is_regular_file(ec))
+      continue;
+    auto time = item.last_write_time(ec);
+    if (!ec && now - time > kStalePartialAge && fs::remove(item.path(), ec))
+      ++removed;
+  }
+
+  if (maxBytes == 0)
+    return removed;
+  struct Entry {
+    fs::path path;
+    fs::file_time_type time;
+    std::uintmax_t size;
+  };
+  std::vector<Entry> entries;
+  std::uintmax_t total = 0;
+  for (const auto &item : fs::directory_iterator(directory, ec)) {
+    if (item.path().extension() != kProxyExtension ||
+        !item.is_regular_file(ec))
+      continue;
+    Entry entry{item.path(), item.last_write_time(ec), item.file_size(ec)};
+    if (ec)
+      continue;
+    total += entry.size;
+    entries.push_back(std::move(entry));
+  }
+
+  // Least recently used first
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) { return a.time < b.time; });
+  for (const auto &entry : entries) {
+    if (total <= maxBytes)
+      break;
+    if (!keep.empty() && entry.path == fs::path(keep))
+      continue;
+    if (fs::remove(entry.path, ec)) {
+      total -= entry.size;
+      ++removed;
+    }
+  }
+  return removed;
+}
+
+} // namespace vidicant
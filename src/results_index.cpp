@@ -0,0 +1,397 @@
+#include "vidicant/results_index.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+// On-disk layout, all fields in host byte order and 8-byte aligned:
+//   header | kinds[rows] | pathOffsets[rows + 1] | columns[columnCount] |
+//   names | per column: dense[rows], sorted[present], sortedRows[present] |
+//   paths
+// Dense arrays hold NaN for missing values. Sorted values are ascending and
+// sortedRows gives the row of each, ties ordered by row.
+const char kMagic[8] = {'V', 'D', 'R', 'E', 'S', '0', '0', '1'};
+
+struct IndexHeader {
+  char magic[8];
+  std::uint64_t rowCount;
+  std::uint64_t columnCount;
+  std::uint64_t kindsOffset;
+  std::uint64_t pathOffsetsOffset;
+  std::uint64_t columnsOffset;
+  std::uint64_t namesOffset;
+  std::uint64_t pathsOffset;
+  std::uint64_t pathsSize;
+};
+
+struct ColumnEntry {
+  std::uint64_t nameOffset;
+  std::uint64_t nameSize;
+  std::uint64_t presentCount;
+  std::uint64_t denseOffset;
+  std::uint64_t sortedOffset;
+  std::uint64_t rowsOffset;
+};
+
+// Checks that an 8-byte aligned region of `count` elements of `width` bytes
+// starting at `offset` lies within a file of `size` bytes.
+bool regionFits(std::uint64_t offset, std::uint64_t count, std::uint64_t width,
+                std::uint64_t size) {
+  return offset % 8 == 0 && offset <= size && count <= (size - offset) / width;
+}
+
+// Checks that `bytes` bytes starting `offset` into a region at `start`
+// lie within a file of `size` bytes.
+bool bytesFit(std::uint64_t start, std::uint64_t offset, std::uint64_t bytes,
+              std::uint64_t size) {
+  return start <= size && offset <= size - start &&
+         bytes <= size - start - offset;
+}
+
+// Rounds a byte offset up to the next multiple of 8.
+std::uint64_t align8(std::uint64_t offset) { return (offset + 7) & ~7ULL; }
+
+// Writes zero bytes until the stream position reaches `offset`.
+void padTo(std::ofstream &output, std::uint64_t &position,
+           std::uint64_t offset) {
+  static const char zeros[8] = {};
+  output.write(zeros, static_cast<std::streamsize>(offset - position));
+  position = offset;
+}
+
+// Checks whether `value` satisfies a predicate's bounds.
+bool inBounds(double value, const ColumnPredicate &predicate) {
+  if (std::isnan(value))
+    return false;
+  bool aboveMin = predicate.minInclusive ? value >= predicate.min
+                                         : value > predicate.min;
+  bool belowMax = predicate.maxInclusive ? value <= predicate.max
+                                         : value < predicate.max;
+  return aboveMin && belowMax;
+}
+
+} // namespace
+
+std::uint32_t ResultsIndexWriter::addRow(const std::string &path,
+                                         ResultKind kind) {
+  paths_.push_back(path);
+  kinds_.push_back(kind);
+  return static_cast<std::uint32_t>(paths_.size() - 1);
+}
+
+void ResultsIndexWriter::set(std::uint32_t row, const std::string &column,
+                             double value) {
+  if (row >= paths_.size() || std::isnan(value))
+    return;
+  columns_[column].emplace_back(row, value);
+}
+
+std::size_t ResultsIndexWriter::size() const { return paths_.size(); }
+
+bool ResultsIndexWriter::write(const std::string &filename) const {
+  std::uint64_t rows = paths_.size();
+  IndexHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.rowCount = rows;
+  header.columnCount = columns_.size();
+  header.kindsOffset = sizeof(IndexHeader);
+  header.pathOffsetsOffset = align8(header.kindsOffset + rows);
+  header.columnsOffset = header.pathOffsetsOffset + (rows + 1) * 8;
+  header.namesOffset =
+      header.columnsOffset + columns_.size() * sizeof(ColumnEntry);
+
+  // Sort each column's present values, keeping the last value set per row
+  std::vector<ColumnEntry> entries;
+  std::vector<std::vector<std::pair<double, std::uint32_t>>> sorted;
+  std::uint64_t namesSize = 0;
+  for (const auto &column : columns_) {
+    std::vector<std::pair<double, std::uint32_t>> values(column.second.size());
+    std::vector<std::uint8_t> seen(rows, 0);
+    std::size_t count = 0;
+    for (auto it = column.second.rbegin(); it != column.second.rend(); ++it) {
+      if (seen[it->first])
+        continue;
+      seen[it->first] = 1;
+      values[count++] = {it->second, it->first};
+    }
+    values.resize(count);
+    std::sort(values.begin(), values.end());
+    ColumnEntry entry{};
+    entry.nameOffset = namesSize;
+    entry.nameSize = column.first.size();
+    entry.presentCount = count;
+    entries.push_back(entry);
+    sorted.push_back(std::move(values));
+    namesSize += column.first.size();
+  }
+  std::uint64_t offset = align8(header.namesOffset + namesSize);
+  for (auto &entry : entries) {
+    entry.denseOffset = offset;
+    entry.sortedOffset = entry.denseOffset + rows * 8;
+    entry.rowsOffset = entry.sortedOffset + entry.presentCount * 8;
+    offset = align8(entry.rowsOffset + entry.presentCount * 4);
+  }
+  header.pathsOffset = offset;
+
+  std::vector<std::uint64_t> pathOffsets;
+  pathOffsets.reserve(rows + 1);
+  std::uint64_t pathsSize = 0;
+  for (const auto &path : paths_) {
+    pathOffsets.push_back(pathsSize);
+    pathsSize += path.size();
+  }
+  pathOffsets.push_back(pathsSize);
+  header.pathsSize = pathsSize;
+
+  std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+  if (!output.is_open())
+    return false;
+  std::uint64_t position = 0;
+  output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  output.write(reinterpret_cast<const char *>(kinds_.data()),
+               static_cast<std::streamsize>(rows));
+  position = header.kindsOffset + rows;
+  padTo(output, position, header.pathOffsetsOffset);
+  output.write(reinterpret_cast<const char *>(pathOffsets.data()),
+               (rows + 1) * 8);
+  output.write(reinterpret_cast<const char *>(entries.data()),
+               entries.size() * sizeof(ColumnEntry));
+  for (const auto &column : columns_)
+    output.write(column.first.data(),
+                 static_cast<std::streamsize>(column.first.size()));
+  position = header.namesOffset + namesSize;
+
+  std::vector<double> dense(rows);
+  std::vector<double> values;
+  std::vector<std::uint32_t> valueRows;
+  for (std::size_t c = 0; c < entries.size(); ++c) {
+    padTo(output, position, entries[c].denseOffset);
+    std::fill(dense.begin(), dense.end(), std::nan(""));
+    values.clear();
+    valueRows.clear();
+    for (const auto &value : sorted[c]) {
+      dense[value.second] = value.first;
+      values.push_back(value.first);
+      valueRows.push_back(value.second);
+    }
+    output.write(reinterpret_cast<const char *>(dense.data()), rows * 8);
+    output.write(reinterpret_cast<const char *>(values.data()),
+                 values.size() * 8);
+    output.write(reinterpret_cast<const char *>(valueRows.data()),
+                 valueRows.size() * 4);
+    position = entries[c].rowsOffset + valueRows.size() * 4;
+  }
+  padTo(output, position, header.pathsOffset);
+  for (const auto &path : paths_)
+    output.write(path.data(), static_cast<std::streamsize>(path.size()));
+  return static_cast<bool>(output);
+}
+
+bool ResultsIndex::open(const std::string &filename) {
+  rowCount_ = 0;
+  columns_.clear();
+  if (!file_.open(filename, MappedFile::Access::Random))
+    return false;
+  std::uint64_t size = file_.size();
+  if (size < sizeof(IndexHeader))
+    return false;
+  IndexHeader header;
+  std::memcpy(&header, file_.data(), sizeof(header));
+  std::uint64_t rows = header.rowCount;
+  // Every region must lie inside the file; rows is bounded first so that
+  // rows + 1 cannot wrap. Row ids and path offsets inside the regions are
+  // checked as they are read
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      rows > size / 8 || !regionFits(header.kindsOffset, rows, 1, size) ||
+      !regionFits(header.pathOffsetsOffset, rows + 1, 8, size) ||
+      !regionFits(header.columnsOffset, header.columnCount,
+                  sizeof(ColumnEntry), size) ||
+      !bytesFit(header.pathsOffset, 0, header.pathsSize, size))
+    return false;
+
+  const unsigned char *base = file_.data();
+  std::vector<Column> columns;
+  for (std::uint64_t c = 0; c < header.columnCount; ++c) {
+    ColumnEntry entry;
+    std::memcpy(&entry,
+                base + header.columnsOffset + c * sizeof(ColumnEntry),
+                sizeof(entry));
+    if (entry.presentCount > rows ||
+        !bytesFit(header.namesOffset, entry.nameOffset, entry.nameSize,
+                  size) ||
+        !regionFits(entry.denseOffset, rows, 8, size) ||
+        !regionFits(entry.sortedOffset, entry.presentCount, 8, size) ||
+        !regionFits(entry.rowsOffset, entry.presentCount, 4, size))
+      return false;
+    Column column;
+    const char *name = reinterpret_cast<const char *>(
+        base + header.namesOffset + entry.nameOffset);
+    column.name.assign(name, entry.nameSize);
+    column.present = entry.presentCount;
+    column.dense = reinterpret_cast<const double *>(base + entry.denseOffset);
+    column.sorted = reinterpret_cast<const double *>(base + entry.sortedOffset);
+    column.rows =
+        reinterpret_cast<const std::uint32_t *>(base + entry.rowsOffset);
+    columns.push_back(std::move(column));
+  }
+  kinds_ = base + header.kindsOffset;
+  pathOffsets_ = reinterpret_cast<const std::uint64_t *>(
+      base + header.pathOffsetsOffset);
+  paths_ = reinterpret_cast<const char *>(base + header.pathsOffset);
+  pathsSize_ = header.pathsSize;
+  columns_ = std::move(columns);
+  rowCount_ = rows;
+  return true;
+}
+
+std::size_t ResultsIndex::size() const { return rowCount_; }
+
+std::vector<std::string> ResultsIndex::getColumns() const {
+  std::vector<std::string> names;
+  for (const auto &column : columns_)
+    names.push_back(column.name);
+  return names;
+}
+
+int ResultsIndex::findColumn(const std::string &name) const {
+  auto it = std::lower_bound(
+      columns_.begin(), columns_.end(), name,
+      [](const Column &column, const std::string &key) {
+        return column.name < key;
+      });
+  if (it == columns_.end() || it->name != name)
+    return -1;
+  return static_cast<int>(it - columns_.begin());
+}
+
+std::size_t ResultsIndex::getPresentCount(int column) const {
+  if (column < 0 || column >= static_cast<int>(columns_.size()))
+    return 0;
+  return columns_[column].present;
+}
+
+std::pair<std::size_t, std::size_t>
+ResultsIndex::sortedRange(const Column &column,
+                          const ColumnPredicate &predicate) const {
+  const double *first = column.sorted;
+  const double *last = column.sorted + column.present;
+  const double *begin = predicate.minInclusive
+                            ? std::lower_bound(first, last, predicate.min)
+                            : std::upper_bound(first, last, predicate.min);
+  const double *end = predicate.maxInclusive
+                          ? std::upper_bound(first, last, predicate.max)
+                          : std::lower_bound(first, last, predicate.max);
+  if (end < begin)
+    end = begin;
+  return {static_cast<std::size_t>(begin - first),
+          static_cast<std::size_t>(end - first)};
+}
+
+std::vector<std::uint32_t>
+ResultsIndex::query(const std::vector<ColumnPredicate> &predicates) const {
+  std::vector<std::uint32_t> rows;
+  if (predicates.empty()) {
+    rows.resize(rowCount_);
+    for (std::uint64_t row = 0; row < rowCount_; ++row)
+      rows[row] = static_cast<std::uint32_t>(row);
+    return rows;
+  }
+
+  // Collect the narrowest predicate's rows, then check the others against
+  // the dense arrays instead of intersecting every range
+  std::vector<int> columns;
+  std::size_t narrowest = 0;
+  std::pair<std::size_t, std::size_t> narrowestRange{0, 0};
+  for (std::size_t p = 0; p < predicates.size(); ++p) {
+    int column = findColumn(predicates[p].column);
+    if (column < 0)
+      return rows;
+    columns.push_back(column);
+    auto range = sortedRange(columns_[column], predicates[p]);
+    if (p == 0 || range.second - range.first <
+                      narrowestRange.second - narrowestRange.first) {
+      narrowest = p;
+      narrowestRange = range;
+    }
+  }
+  const Column &driver = columns_[columns[narrowest]];
+  for (std::size_t i = narrowestRange.first; i < narrowestRange.second; ++i) {
+    std::uint32_t row = driver.rows[i];
+    if (row >= rowCount_)
+      continue; // Corrupt row id
+    bool matches = true;
+    for (std::size_t p = 0; p < predicates.size() && matches; ++p) {
+      if (p != narrowest)
+        matches = inBounds(columns_[columns[p]].dense[row], predicates[p]);
+    }
+    if (matches)
+      rows.push_back(row);
+  }
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+std::vector<std::uint32_t>
+ResultsIndex::top(int column, std::size_t k, bool largest,
+                  const std::vector<std::uint32_t> *candidates) const {
+  std::vector<std::uint32_t> rows;
+  if (column < 0 || column >= static_cast<int>(columns_.size()) || k == 0)
+    return rows;
+  const Column &data = columns_[column];
+
+  // Few candidates: rank them directly by their dense values
+  if (candidates && candidates->size() < data.present / 8) {
+    std::vector<std::pair<double, std::uint32_t>> ranked;
+    for (std::uint32_t row : *candidates) {
+      if (row < rowCount_ && !std::isnan(data.dense[row]))
+        ranked.emplace_back(data.dense[row], row);
+    }
+    std::size_t count = std::min(k, ranked.size());
+    auto better = [largest](const std::pair<double, std::uint32_t> &a,
+                            const std::pair<double, std::uint32_t> &b) {
+      return largest ? b < a : a < b;
+    };
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                      better);
+    for (std::size_t i = 0; i < count; ++i)
+      rows.push_back(ranked[i].second);
+    return rows;
+  }
+
+  // Otherwise walk the sorted column from the wanted end
+  for (std::uint64_t i = 0; i < data.present && rows.size() < k; ++i) {
+    std::uint32_t row =
+        data.rows[largest ? data.present - 1 - i : i];
+    if (row >= rowCount_)
+      continue; // Corrupt row id
+    if (!candidates ||
+        std::binary_search(candidates->begin(), candidates->end(), row))
+      rows.push_back(row);
+  }
+  return rows;
+}
+
+double ResultsIndex::getValue(std::uint32_t row, int column) const {
+  if (row >= rowCount_ || column < 0 ||
+      column >= static_cast<int>(columns_.size()))
+    return std::nan("");
+  return columns_[column].dense[row];
+}
+
+std::string ResultsIndex::getPath(std::uint32_t row) const {
+  if (row >= rowCount_)
+    return "";
+  std::uint64_t begin = pathOffsets_[row];
+  std::uint64_t end = pathOffsets_[row + 1];
+  if (begin > end || end > pathsSize_)
+    return ""; // Corrupt path offsets
+  return std::string(paths_ + begin, paths_ + end);
+}
+
+ResultKind ResultsIndex::getKind(std::uint32_t row) const {
+  if (row >= rowCount_)
+    return ResultKind::Image;
+  return static_cast<ResultKind>(kinds_[row]);
+}
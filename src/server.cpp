@@ -0,0 +1,414 @@
+// server.cpp
+// Implementation file for the vidicant_cli analysis daemon.
+//
+// This file contains the request handler and the socket server.
+// One reader thread per connection splits the stream into lines and
+// submits each request to a shared, bounded ThreadPool; when the
+// queue is full the reader blocks, so a client sending faster than
+// the workers can analyze is slowed down by TCP flow control rather
+// than growing the daemon's memory. Responses are written as they
+// complete and carry the request's "id", so they may arrive out of
+// order.
+
+#include "server.hpp"
+#include "vidicant/image.hpp"
+#include "vidicant/parallelism.hpp"
+#include "vidicant/thread_pool.hpp"
+#include "vidicant/trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/opencv.hpp>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Largest request line accepted, which bounds base64 image payloads
+static const std::size_t kMaxRequestBytes = 64 * 1024 * 1024;
+
+// Function to decode standard base64, ignoring whitespace
+static bool decodeBase64(const std::string &text,
+                         std::vector<unsigned char> &bytes) {
+  bytes.clear();
+  bytes.reserve(text.size() / 4 * 3);
+  std::uint32_t accumulator = 0;
+  int bits = 0;
+  bool padding = false;
+  for (char c : text) {
+    int value;
+    if (c >= 'A' && c <= 'Z')
+      value = c - 'A';
+    else if (c >= 'a' && c <= 'z')
+      value = c - 'a' + 26;
+    else if (c >= '0' && c <= '9')
+      value = c - '0' + 52;
+    else if (c == '+')
+      value = 62;
+    else if (c == '/')
+      value = 63;
+    else if (c == '=') {
+      padding = true;
+      continue;
+    } else if (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+      continue;
+    else
+      return false;
+    if (padding)
+      return false; // Data after padding
+    accumulator = (accumulator << 6) | static_cast<std::uint32_t>(value);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      bytes.push_back(static_cast<unsigned char>(accumulator >> bits));
+    }
+  }
+  return true;
+}
+
+// Function to check a requested metric list against the known names
+static bool validateMetrics(const std::vector<std::string> &metrics,
+                            std::string &unknown) {
+  std::vector<std::string> known = getImageMetricNames();
+  std::vector<std::string> videoNames = getVideoMetricNames();
+  known.insert(known.end(), videoNames.begin(), videoNames.end());
+  for (const auto &metric : metrics) {
+    if (std::find(known.begin(), known.end(), metric) == known.end()) {
+      unknown = metric;
+      return false;
+    }
+  }
+  return true;
+}
+
+nlohmann::json handleServerRequest(const nlohmann::json &request,
+                                   const ProcessOptions &defaults) {
+  nlohmann::json response;
+  if (!request.is_object()) {
+    response["error"] = "Request must be a JSON object";
+    return response;
+  }
+  if (request.contains("id"))
+    response["id"] = request["id"];
+
+  // Malformed field types surface as json exceptions; report them
+  // instead of letting one bad request take down the daemon
+  try {
+    ProcessOptions options = defaults;
+    options.tiled = request.value("tiled", options.tiled);
+    options.tileRows = request.value("tile_rows", options.tileRows);
+    options.perceptualHashes =
+        request.value("hashes", options.perceptualHashes);
+    if (request.contains("metrics"))
+      options.metrics = request["metrics"].get<std::vector<std::string>>();
+    options.histogramBins =
+        request.value("histogram_bins", options.histogramBins);
+    if (request.contains("scene_thresholds"))
+      options.sceneThresholds =
+          request["scene_thresholds"].get<std::vector<double>>();
+    options.seriesWindow = request.value("series_window", options.seriesWindow);
+    options.scenePalettes =
+        request.value("scene_palettes", options.scenePalettes);
+    options.cropBars = request.value("crop_bars", options.cropBars);
+    options.qcEvents = request.value("qc", options.qcEvents);
+    options.timeBudget = request.value("time_budget", options.timeBudget);
+    options.jpegDct = request.value("jpeg_dct", options.jpegDct);
+    options.memoryStats = request.value("memory_stats", options.memoryStats);
+    std::string invalid = checkProcessOptions(options);
+    if (!invalid.empty()) {
+      response["error"] = invalid;
+      return response;
+    }
+    std::string unknown;
+    if (!validateMetrics(options.metrics, unknown)) {
+      response["error"] = "Unknown metric: " + unknown;
+      return response;
+    }
+
+    std::string kind = request.value("kind", "");
+    if (request.contains("data")) {
+      if (kind == "video") {
+        response["error"] = "Video payloads must be sent by path";
+        return response;
+      }
+      std::vector<unsigned char> bytes;
+      if (!decodeBase64(request["data"].get<std::string>(), bytes)) {
+        response["error"] = "Invalid base64 in data";
+        return response;
+      }
+      ImageHandler handler(
+          std::make_unique<MemoryImageLoader>(std::move(bytes)));
+      response["result"] =
+          processImage(handler, request.value("name", "<memory>"), options);
+      return response;
+    }
+
+    if (!request.contains("path")) {
+      response["error"] = "Request needs a path or data";
+      return response;
+    }
+    std::string path = request["path"].get<std::string>();
+    if (kind.empty())
+      kind = isMultiFrameImage(path) ? "video"
+             : isImageFile(path)     ? "image"
+             : isVideoFile(path)     ? "video"
+                                     : "";
+    if (kind == "image") {
+      response["result"] = processImage(path, options);
+    } else if (kind == "video") {
+      response["result"] = processVideo(path, options);
+    } else {
+      response["error"] = "Unsupported file type: " + path;
+    }
+  } catch (const std::exception &e) {
+    response.erase("result");
+    response["error"] = e.what();
+  }
+  return response;
+}
+
+#ifdef _WIN32
+
+int runServer(const std::string & /*endpoint*/,
+              const ServerOptions & /*options*/) {
+  std::cerr << "Error: --serve is not supported on this platform"
+            << std::endl;
+  return 1;
+}
+
+#else
+
+namespace {
+
+std::atomic<bool> stopRequested{false};
+
+void onStopSignal(int) { stopRequested = true; }
+
+// One client connection; the socket closes when the reader and every
+// in-flight request holding it have finished
+struct Connection {
+  explicit Connection(int socket) : fd(socket) {}
+  ~Connection() { ::close(fd); }
+
+  // Writes one response line; workers may call this concurrently
+  void send(const std::string &line) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    const char *data = line.data();
+    std::size_t left = line.size();
+    while (left > 0) {
+      ssize_t sent = ::send(fd, data, left, 0);
+      if (sent < 0 && errno == EINTR)
+        continue;
+      if (sent <= 0)
+        return; // Client went away; its remaining responses are dropped
+      data += sent;
+      left -= static_cast<std::size_t>(sent);
+    }
+  }
+
+  int fd;
+  std::mutex writeMutex;
+};
+
+// A reader thread and what is needed to stop and reap it
+struct Reader {
+  std::thread thread;
+  std::shared_ptr<std::atomic<bool>> done;
+  std::weak_ptr<Connection> connection;
+};
+
+// Function to read request lines from one client until it disconnects
+void serveConnection(std::shared_ptr<Connection> connection,
+                     ThreadPool &pool, const ProcessOptions &defaults,
+                     std::shared_ptr<std::atomic<bool>> done) {
+  std::string buffer;
+  std::vector<char> chunk(64 * 1024);
+  while (true) {
+    ssize_t received = ::recv(connection->fd, chunk.data(), chunk.size(), 0);
+    if (received < 0 && errno == EINTR)
+      continue;
+    if (received <= 0)
+      break;
+    buffer.append(chunk.data(), static_cast<std::size_t>(received));
+
+    std::size_t start = 0;
+    std::size_t newline;
+    while ((newline = buffer.find('\n', start)) != std::string::npos) {
+      std::string line = buffer.substr(start, newline - start);
+      start = newline + 1;
+      if (line.empty() || line == "\r")
+        continue;
+      // Blocks while the queue is full, which stops reading this client
+      pool.submit([connection, line = std::move(line), &defaults] {
+        nlohmann::json request = nlohmann::json::parse(line, nullptr, false);
+        nlohmann::json response;
+        if (request.is_discarded())
+          response["error"] = "Invalid JSON";
+        else
+          response = handleServerRequest(request, defaults);
+        TraceSpan span("serialize");
+        connection->send(response.dump() + "\n");
+      });
+    }
+    buffer.erase(0, start);
+    if (buffer.size() > kMaxRequestBytes) {
+      connection->send("{\"error\":\"Request too large\"}\n");
+      break;
+    }
+  }
+  *done = true;
+}
+
+// Function to bind and listen on an endpoint, returning the socket or -1
+int openListener(const std::string &endpoint, std::string &unixPath) {
+  if (endpoint.rfind("unix:", 0) == 0) {
+    unixPath = endpoint.substr(5);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (unixPath.empty() || unixPath.size() >= sizeof(address.sun_path)) {
+      std::cerr << "Error: Invalid socket path: " << unixPath << std::endl;
+      return -1;
+    }
+    unixPath.copy(address.sun_path, unixPath.size());
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+      return -1;
+    ::unlink(unixPath.c_str()); // Remove a stale socket from a previous run
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) !=
+            0 ||
+        ::listen(fd, SOMAXCONN) != 0) {
+      ::close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  std::string host = "127.0.0.1";
+  std::string port = endpoint;
+  std::size_t colon = endpoint.rfind(':');
+  if (colon != std::string::npos) {
+    host = endpoint.substr(0, colon);
+    port = endpoint.substr(colon + 1);
+  }
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  addrinfo *addresses = nullptr;
+  if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0)
+    return -1;
+  int fd = -1;
+  for (addrinfo *ai = addresses; ai != nullptr; ai = ai->ai_next) {
+    fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0)
+      continue;
+    int reuse = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (::bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 &&
+        ::listen(fd, SOMAXCONN) == 0)
+      break;
+    ::close(fd);
+    fd = -1;
+  }
+  ::freeaddrinfo(addresses);
+  return fd;
+}
+
+// Function to load the image codecs and analysis kernels once up front,
+// so the first request does not pay for lazy initialization
+void warmUp() {
+  cv::Mat pattern(32, 32, CV_8UC3, cv::Scalar(0, 0, 0));
+  cv::rectangle(pattern, cv::Rect(8, 8, 16, 16), cv::Scalar(255, 255, 255),
+                cv::FILLED);
+  for (const char *extension : {".jpg", ".png"}) {
+    std::vector<unsigned char> bytes;
+    if (!cv::imencode(extension, pattern, bytes))
+      continue;
+    ImageHandler handler(std::make_unique<MemoryImageLoader>(bytes));
+    processImage(handler, "warm-up");
+  }
+}
+
+} // namespace
+
+int runServer(const std::string &endpoint, const ServerOptions &options) {
+  std::string unixPath;
+  int listener = openListener(endpoint, unixPath);
+  if (listener < 0) {
+    std::cerr << "Error: Could not listen on: " << endpoint << std::endl;
+    return 1;
+  }
+
+  std::signal(SIGPIPE, SIG_IGN); // Failed sends are handled per connection
+  std::signal(SIGINT, onStopSignal);
+  std::signal(SIGTERM, onStopSignal);
+
+  warmUp();
+  // Workers come from the parallelism policy unless set explicitly
+  ParallelismPolicy policy = vidicant::getParallelismPolicy();
+  std::size_t workers = options.workers > 0
+                            ? options.workers
+                            : static_cast<std::size_t>(policy.fileWorkers);
+  std::function<void(std::size_t)> onStart;
+  if (policy.pinThreads)
+    onStart = [](std::size_t worker) {
+      vidicant::pinCurrentThread(static_cast<int>(worker));
+    };
+  ThreadPool pool(workers, options.queueCapacity, onStart);
+  std::vector<Reader> readers;
+  std::cout << "Listening on " << endpoint << " with " << pool.size()
+            << " workers" << std::endl;
+
+  while (!stopRequested) {
+    // Reap readers whose clients have disconnected
+    readers.erase(std::remove_if(readers.begin(), readers.end(),
+                                 [](Reader &reader) {
+                                   if (!*reader.done)
+                                     return false;
+                                   reader.thread.join();
+                                   return true;
+                                 }),
+                  readers.end());
+
+    // Wake up periodically to notice a stop signal
+    pollfd pending{listener, POLLIN, 0};
+    if (::poll(&pending, 1, 200) <= 0)
+      continue;
+    int client = ::accept(listener, nullptr, nullptr);
+    if (client < 0)
+      continue;
+    auto connection = std::make_shared<Connection>(client);
+    auto done = std::make_shared<std::atomic<bool>>(false);
+    std::thread thread(serveConnection, connection, std::ref(pool),
+                       std::cref(options.defaults), done);
+    readers.push_back({std::move(thread), done, connection});
+  }
+
+  std::cout << "Shutting down" << std::endl;
+  ::close(listener);
+  if (!unixPath.empty())
+    ::unlink(unixPath.c_str());
+  // Stop reading new requests, but let queued ones finish and reply
+  for (auto &reader : readers) {
+    if (auto connection = reader.connection.lock())
+      ::shutdown(connection->fd, SHUT_RD);
+    reader.thread.join();
+  }
+  pool.wait();
+  return 0;
+}
+
+#endif
@@ -0,0 +1,67 @@
+#include "vidicant/shard.hpp"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <filesystem>
+
+namespace {
+
+// Parses a whole decimal int, without sign or surrounding text.
+bool parseCount(const std::string &text, int &value) {
+  if (text.empty() || text.find_first_not_of("0123456789") != text.npos)
+    return false;
+  errno = 0;
+  long parsed = std::strtol(text.c_str(), nullptr, 10);
+  if (errno == ERANGE || parsed > INT_MAX)
+    return false;
+  value = static_cast<int>(parsed);
+  return true;
+}
+
+} // namespace
+
+namespace vidicant {
+
+bool parseShard(const std::string &text, Shard &shard) {
+  std::size_t slash = text.find('/');
+  if (slash == std::string::npos)
+    return false;
+  Shard parsed;
+  if (!parseCount(text.substr(0, slash), parsed.index) ||
+      !parseCount(text.substr(slash + 1), parsed.count) || parsed.count < 1 ||
+      parsed.index >= parsed.count)
+    return false;
+  shard = parsed;
+  return true;
+}
+
+std::uint64_t hashShardPath(const std::string &path) {
+  std::string normal =
+      std::filesystem::path(path).lexically_normal().generic_string();
+  // FNV-1a over the bytes, then a finalizer so that the low bits, which
+  // pick the shard, depend on every byte of the path.
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : normal) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+int getPathShard(const std::string &path, int count) {
+  if (count <= 1)
+    return 0;
+  return static_cast<int>(hashShardPath(path) %
+                          static_cast<std::uint64_t>(count));
+}
+
+bool isInShard(const std::string &path, const Shard &shard) {
+  return getPathShard(path, shard.count) == shard.index;
+}
+
+} // namespace vidicant
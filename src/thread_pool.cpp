@@ -0,0 +1,90 @@
+#include "vidicant/thread_pool.hpp"
+#include "vidicant/trace.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::size_t workers, std::size_t queueCapacity,
+                       std::function<void(std::size_t)> onStart)
+    : onStart_(std::move(onStart)), capacity_(queueCapacity) {
+  if (workers == 0)
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  workers_.reserve(workers);
+  for (std::size_t i = 0; i < workers; ++i)
+    workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  taskReady_.notify_all();
+  for (auto &worker : workers_)
+    worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto hasSpace = [this] {
+      return capacity_ == 0 || queue_.size() < capacity_;
+    };
+    if (!hasSpace()) {
+      TraceSpan span("submit_wait");
+      spaceReady_.wait(lock, hasSpace);
+    }
+    queue_.push_back(std::move(task));
+  }
+  taskReady_.notify_one();
+}
+
+bool ThreadPool::trySubmit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ != 0 && queue_.size() >= capacity_)
+      return false;
+    queue_.push_back(std::move(task));
+  }
+  taskReady_.notify_one();
+  return true;
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this] { return queue_.empty() && active_ == 0; });
+}
+
+std::size_t ThreadPool::size() const { return workers_.size(); }
+
+std::size_t ThreadPool::pending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size();
+}
+
+void ThreadPool::workerLoop(std::size_t index) {
+  if (onStart_)
+    onStart_(index);
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      auto hasTask = [this] { return stopping_ || !queue_.empty(); };
+      if (!hasTask()) {
+        TraceSpan span("queue_wait");
+        taskReady_.wait(lock, hasTask);
+      }
+      if (queue_.empty())
+        return; // Stopping and drained
+      task = std::move(queue_.front());
+      queue_.pop_front();
+      ++active_;
+    }
+    spaceReady_.notify_one();
+    task();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --active_;
+      if (queue_.empty() && active_ == 0)
+        idle_.notify_all();
+    }
+  }
+}
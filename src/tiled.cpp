@@ -0,0 +1,664 @@
+#include "vidicant/tiled.hpp"
+#include "vidicant/color_model.hpp"
+#include "vidicant/probe.hpp"
+#include <algorithm>
+#include <cmath>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/opencv.hpp>
+
+#ifdef VIDICANT_WITH_TIFF
+#include <tiffio.h>
+#endif
+
+#ifdef VIDICANT_WITH_JPEG
+#include <jpeglib.h>
+#endif
+
+#ifdef VIDICANT_WITH_PNG
+#include <png.h>
+#endif
+
+void ImageTileStats::merge(const ImageTileStats &other) {
+  if (channels == 0) {
+    channels = other.channels;
+    histogram.assign(other.histogram.size(), {});
+  }
+  pixelCount += other.pixelCount;
+  for (size_t c = 0; c < channelSums.size(); ++c)
+    channelSums[c] += other.channelSums[c];
+  for (size_t c = 0; c < histogram.size() && c < other.histogram.size(); ++c)
+    for (size_t i = 0; i < 256; ++i)
+      histogram[c][i] += other.histogram[c][i];
+  for (size_t i = 0; i < 256; ++i)
+    grayHistogram[i] += other.grayHistogram[i];
+  saturationSum += other.saturationSum;
+  laplacianSum += other.laplacianSum;
+  laplacianSumSq += other.laplacianSumSq;
+  edgeCount += other.edgeCount;
+  colorSamples.insert(colorSamples.end(), other.colorSamples.begin(),
+                      other.colorSamples.end());
+}
+
+double ImageTileStats::getCoverage() const {
+  double pixels = static_cast<double>(width) * height;
+  return pixels > 0 ? std::min(1.0, pixelCount / pixels) : 0.0;
+}
+
+double ImageTileStats::getAverageBrightness() const {
+  if (pixelCount == 0)
+    return -1.0;
+  if (channels == 1)
+    return channelSums[0] / pixelCount;
+  return (channelSums[0] + channelSums[1] + channelSums[2]) /
+         (3.0 * pixelCount);
+}
+
+double ImageTileStats::getBlurScore() const {
+  if (pixelCount == 0)
+    return -1.0;
+  double mean = laplacianSum / pixelCount;
+  return std::max(0.0, laplacianSumSq / pixelCount - mean * mean); // Variance
+}
+
+double ImageTileStats::getContrastRatio() const {
+  if (pixelCount == 0)
+    return -1.0;
+  int minVal = 0;
+  while (minVal < 255 && grayHistogram[minVal] == 0)
+    ++minVal;
+  int maxVal = 255;
+  while (maxVal > 0 && grayHistogram[maxVal] == 0)
+    --maxVal;
+  return maxVal > 0 ? maxVal / (minVal + 1e-6) : 0.0; // Avoid division by zero
+}
+
+double ImageTileStats::getSaturationLevel() const {
+  if (pixelCount == 0 || channels < 3)
+    return -1.0;
+  return saturationSum / pixelCount;
+}
+
+double ImageTileStats::getEntropy() const {
+  if (pixelCount == 0)
+    return -1.0;
+  double entropy = 0.0;
+  for (std::uint64_t count : grayHistogram) {
+    if (count > 0) {
+      double p = static_cast<double>(count) / pixelCount;
+      entropy -= p * std::log2(p);
+    }
+  }
+  return entropy;
+}
+
+std::vector<std::vector<int>> ImageTileStats::getHistogram(int bins) const {
+  bins = std::max(1, bins);
+  std::vector<std::vector<int>> histograms;
+  for (const auto &channel : histogram) {
+    std::vector<int> counts(static_cast<std::size_t>(bins));
+    for (int value = 0; value < 256; ++value) // Same binning as 8-bit pixels
+      counts[value * bins >> 8] += static_cast<int>(channel[value]);
+    histograms.push_back(std::move(counts));
+  }
+  return histograms;
+}
+
+std::vector<std::array<double, 3>>
+ImageTileStats::getDominantColors(int k, const Deadline &deadline) const {
+  if (k <= 0 || colorSamples.size() < static_cast<size_t>(k))
+    return {};
+  cv::Mat data(static_cast<int>(colorSamples.size()), 3, CV_32F);
+  for (int i = 0; i < data.rows; ++i) {
+    float *row = data.ptr<float>(i);
+    row[0] = colorSamples[i][0];
+    row[1] = colorSamples[i][1];
+    row[2] = colorSamples[i][2];
+  }
+
+  return vidicant::clusterColors(data, k, deadline);
+}
+
+OpenCVImageStripReader::OpenCVImageStripReader(int stripRows)
+    : image_(std::make_unique<cv::Mat>()),
+      stripRows_(std::max(1, stripRows)) {}
+
+OpenCVImageStripReader::~OpenCVImageStripReader() = default;
+
+bool OpenCVImageStripReader::open(const std::string &filename) {
+  *image_ = cv::imread(filename);
+  nextRow_ = 0;
+  return !image_->empty();
+}
+
+std::pair<int, int> OpenCVImageStripReader::getDimensions() {
+  return {image_->cols, image_->rows};
+}
+
+bool OpenCVImageStripReader::readStrip(cv::Mat &strip) {
+  if (nextRow_ >= image_->rows)
+    return false;
+  int endRow = std::min(image_->rows, nextRow_ + stripRows_);
+  strip = image_->rowRange(nextRow_, endRow); // View, no copy
+  nextRow_ = endRow;
+  return true;
+}
+
+struct TiffImageStripReader::State {
+#ifdef VIDICANT_WITH_TIFF
+  TIFF *tif = nullptr;
+  std::vector<uint32_t> raster; // RGBA block from libtiff
+#endif
+  int width = 0;
+  int height = 0;
+  int blockRows = 0; // Rows per TIFF strip or tile
+  int tileWidth = 0; // Tile width, 0 for stripped TIFFs
+  int nextRow = 0;   // First row of the next strip
+
+  void close() {
+#ifdef VIDICANT_WITH_TIFF
+    if (tif)
+      TIFFClose(tif);
+    tif = nullptr;
+#endif
+  }
+};
+
+TiffImageStripReader::TiffImageStripReader()
+    : state_(std::make_unique<State>()) {}
+
+TiffImageStripReader::~TiffImageStripReader() { state_->close(); }
+
+bool TiffImageStripReader::open(const std::string &filename) {
+  state_->close();
+  state_->nextRow = 0;
+#ifdef VIDICANT_WITH_TIFF
+  TIFFSetWarningHandler(nullptr); // Keep unknown tags from spamming stderr
+  state_->tif = TIFFOpen(filename.c_str(), "r");
+  if (!state_->tif)
+    return false;
+  uint32_t width = 0, height = 0;
+  TIFFGetField(state_->tif, TIFFTAG_IMAGEWIDTH, &width);
+  TIFFGetField(state_->tif, TIFFTAG_IMAGELENGTH, &height);
+  state_->width = static_cast<int>(width);
+  state_->height = static_cast<int>(height);
+  if (TIFFIsTiled(state_->tif)) {
+    uint32_t tileWidth = 0, tileLength = 0;
+    TIFFGetField(state_->tif, TIFFTAG_TILEWIDTH, &tileWidth);
+    TIFFGetField(state_->tif, TIFFTAG_TILELENGTH, &tileLength);
+    state_->tileWidth = static_cast<int>(tileWidth);
+    state_->blockRows = static_cast<int>(tileLength);
+  } else {
+    uint32_t rowsPerStrip = height;
+    TIFFGetFieldDefaulted(state_->tif, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+    state_->tileWidth = 0;
+    state_->blockRows =
+        static_cast<int>(std::min<uint32_t>(rowsPerStrip, height));
+  }
+  if (state_->width <= 0 || state_->height <= 0 || state_->blockRows <= 0) {
+    state_->close();
+    return false;
+  }
+  return true;
+#else
+  (void)filename;
+  return false;
+#endif
+}
+
+std::pair<int, int> TiffImageStripReader::getDimensions() {
+  return {state_->width, state_->height};
+}
+
+bool TiffImageStripReader::readStrip(cv::Mat &strip) {
+#ifdef VIDICANT_WITH_TIFF
+  State &s = *state_;
+  if (!s.tif || s.nextRow >= s.height)
+    return false;
+  int rows = std::min(s.blockRows, s.height - s.nextRow);
+  strip.create(rows, s.width, CV_8UC3);
+
+  // libtiff's RGBA readers produce bottom-up rasters; copy them top-down
+  // into the BGR strip.
+  auto copyBlock = [&](int rasterWidth, int rasterRows, int validCols,
+                       int xOffset) {
+    for (int y = 0; y < rows; ++y) {
+      const uint32_t *src =
+          s.raster.data() + static_cast<size_t>(rasterRows - 1 - y) *
+                                rasterWidth;
+      cv::Vec3b *dst = strip.ptr<cv::Vec3b>(y) + xOffset;
+      for (int x = 0; x < validCols; ++x) {
+        dst[x][0] = static_cast<uchar>(TIFFGetB(src[x]));
+        dst[x][1] = static_cast<uchar>(TIFFGetG(src[x]));
+        dst[x][2] = static_cast<uchar>(TIFFGetR(src[x]));
+      }
+    }
+  };
+
+  if (s.tileWidth > 0) {
+    s.raster.resize(static_cast<size_t>(s.tileWidth) * s.blockRows);
+    for (int x = 0; x < s.width; x += s.tileWidth) {
+      if (!TIFFReadRGBATile(s.tif, x, s.nextRow, s.raster.data()))
+        return false;
+      copyBlock(s.tileWidth, s.blockRows, std::min(s.tileWidth, s.width - x),
+                x);
+    }
+  } else {
+    s.raster.resize(static_cast<size_t>(s.width) * s.blockRows);
+    if (!TIFFReadRGBAStrip(s.tif, s.nextRow, s.raster.data()))
+      return false;
+    copyBlock(s.width, rows, s.width, 0);
+  }
+  s.nextRow += rows;
+  return true;
+#else
+  (void)strip;
+  return false;
+#endif
+}
+
+#ifdef VIDICANT_WITH_JPEG
+namespace {
+
+// libjpeg reports fatal errors through error_exit, which must not return.
+// Jump back to the setjmp in the calling reader method instead.
+struct JpegErrorManager {
+  jpeg_error_mgr pub;
+  std::jmp_buf jump;
+};
+
+void jpegErrorExit(j_common_ptr cinfo) {
+  auto *err = reinterpret_cast<JpegErrorManager *>(cinfo->err);
+  std::longjmp(err->jump, 1);
+}
+
+// Reads the EXIF orientation tag from the saved APP1 markers, 1 if absent.
+int exifOrientation(jpeg_saved_marker_ptr marker) {
+  for (; marker; marker = marker->next) {
+    int orientation =
+        marker->marker == JPEG_APP0 + 1
+            ? vidicant::readExifOrientation(marker->data, marker->data_length)
+            : 1;
+    if (orientation != 1)
+      return orientation;
+  }
+  return 1;
+}
+
+} // namespace
+#endif
+
+struct JpegImageStripReader::State {
+#ifdef VIDICANT_WITH_JPEG
+  jpeg_decompress_struct cinfo{};
+  JpegErrorManager err{};
+  bool created = false;
+  cv::Mat decoded; // Scanlines in libjpeg's output color space
+#endif
+  FILE *file = nullptr;
+  int width = 0;
+  int height = 0;
+
+  void close() {
+#ifdef VIDICANT_WITH_JPEG
+    if (created)
+      jpeg_destroy_decompress(&cinfo);
+    created = false;
+#endif
+    if (file)
+      std::fclose(file);
+    file = nullptr;
+  }
+};
+
+JpegImageStripReader::JpegImageStripReader(int stripRows)
+    : state_(std::make_unique<State>()), stripRows_(std::max(1, stripRows)) {}
+
+JpegImageStripReader::~JpegImageStripReader() { state_->close(); }
+
+bool JpegImageStripReader::open(const std::string &filename) {
+  state_->close();
+#ifdef VIDICANT_WITH_JPEG
+  State &s = *state_;
+  s.file = std::fopen(filename.c_str(), "rb");
+  if (!s.file)
+    return false;
+  s.cinfo.err = jpeg_std_error(&s.err.pub);
+  s.err.pub.error_exit = jpegErrorExit;
+  if (setjmp(s.err.jump)) {
+    s.close();
+    return false;
+  }
+  jpeg_create_decompress(&s.cinfo);
+  s.created = true;
+  jpeg_stdio_src(&s.cinfo, s.file);
+  jpeg_save_markers(&s.cinfo, JPEG_APP0 + 1, 0xFFFF);
+  jpeg_read_header(&s.cinfo, TRUE);
+  if (s.cinfo.num_components != 1 && s.cinfo.num_components != 3) {
+    s.close(); // CMYK/YCCK: leave color management to OpenCV
+    return false;
+  }
+  if (exifOrientation(s.cinfo.marker_list) != 1) {
+    s.close(); // cv::imread rotates these; strips cannot
+    return false;
+  }
+  s.cinfo.out_color_space =
+      s.cinfo.num_components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+  jpeg_start_decompress(&s.cinfo);
+  s.width = static_cast<int>(s.cinfo.output_width);
+  s.height = static_cast<int>(s.cinfo.output_height);
+  return true;
+#else
+  (void)filename;
+  return false;
+#endif
+}
+
+std::pair<int, int> JpegImageStripReader::getDimensions() {
+  return {state_->width, state_->height};
+}
+
+bool JpegImageStripReader::readStrip(cv::Mat &strip) {
+#ifdef VIDICANT_WITH_JPEG
+  State &s = *state_;
+  if (!s.created || s.cinfo.output_scanline >= s.cinfo.output_height)
+    return false;
+  int decodedRows = static_cast<int>(s.cinfo.output_scanline);
+  int rows = std::min(stripRows_, s.height - decodedRows);
+  int components = s.cinfo.output_components;
+  s.decoded.create(rows, s.width, CV_8UC(components));
+  if (setjmp(s.err.jump)) {
+    s.close();
+    return false;
+  }
+  for (int y = 0; y < rows; ++y) {
+    JSAMPROW row = s.decoded.ptr<uchar>(y);
+    jpeg_read_scanlines(&s.cinfo, &row, 1);
+  }
+  cv::cvtColor(s.decoded, strip,
+               components == 1 ? cv::COLOR_GRAY2BGR : cv::COLOR_RGB2BGR);
+  if (s.cinfo.output_scanline >= s.cinfo.output_height)
+    jpeg_finish_decompress(&s.cinfo);
+  return true;
+#else
+  (void)strip;
+  return false;
+#endif
+}
+
+struct PngImageStripReader::State {
+#ifdef VIDICANT_WITH_PNG
+  png_structp png = nullptr;
+  png_infop info = nullptr;
+#endif
+  FILE *file = nullptr;
+  int width = 0;
+  int height = 0;
+  int nextRow = 0; // First row of the next strip
+
+  void close() {
+#ifdef VIDICANT_WITH_PNG
+    if (png)
+      png_destroy_read_struct(&png, info ? &info : nullptr, nullptr);
+    png = nullptr;
+    info = nullptr;
+#endif
+    if (file)
+      std::fclose(file);
+    file = nullptr;
+  }
+};
+
+PngImageStripReader::PngImageStripReader(int stripRows)
+    : state_(std::make_unique<State>()), stripRows_(std::max(1, stripRows)) {}
+
+PngImageStripReader::~PngImageStripReader() { state_->close(); }
+
+bool PngImageStripReader::open(const std::string &filename) {
+  state_->close();
+  state_->nextRow = 0;
+#ifdef VIDICANT_WITH_PNG
+  State &s = *state_;
+  s.file = std::fopen(filename.c_str(), "rb");
+  if (!s.file)
+    return false;
+  png_byte signature[8];
+  if (std::fread(signature, 1, 8, s.file) != 8 ||
+      png_sig_cmp(signature, 0, 8) != 0) {
+    s.close();
+    return false;
+  }
+  s.png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr,
+                                 nullptr);
+  if (s.png)
+    s.info = png_create_info_struct(s.png);
+  if (!s.png || !s.info) {
+    s.close();
+    return false;
+  }
+  if (setjmp(png_jmpbuf(s.png))) {
+    s.close();
+    return false;
+  }
+  png_init_io(s.png, s.file);
+  png_set_sig_bytes(s.png, 8);
+  png_read_info(s.png, s.info);
+  if (png_get_interlace_type(s.png, s.info) != PNG_INTERLACE_NONE) {
+    s.close(); // Adam7 rows are not available in order
+    return false;
+  }
+
+  // Normalize every color type to 8-bit BGR, matching cv::imread defaults.
+  int bitDepth = png_get_bit_depth(s.png, s.info);
+  int colorType = png_get_color_type(s.png, s.info);
+  if (bitDepth == 16)
+    png_set_strip_16(s.png);
+  if (colorType == PNG_COLOR_TYPE_PALETTE)
+    png_set_palette_to_rgb(s.png);
+  if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8)
+    png_set_expand_gray_1_2_4_to_8(s.png);
+  if (colorType & PNG_COLOR_MASK_ALPHA)
+    png_set_strip_alpha(s.png);
+  if (colorType == PNG_COLOR_TYPE_GRAY ||
+      colorType == PNG_COLOR_TYPE_GRAY_ALPHA)
+    png_set_gray_to_rgb(s.png);
+  png_set_bgr(s.png);
+  png_read_update_info(s.png, s.info);
+
+  s.width = static_cast<int>(png_get_image_width(s.png, s.info));
+  s.height = static_cast<int>(png_get_image_height(s.png, s.info));
+  return true;
+#else
+  (void)filename;
+  return false;
+#endif
+}
+
+std::pair<int, int> PngImageStripReader::getDimensions() {
+  return {state_->width, state_->height};
+}
+
+bool PngImageStripReader::readStrip(cv::Mat &strip) {
+#ifdef VIDICANT_WITH_PNG
+  State &s = *state_;
+  if (!s.png || s.nextRow >= s.height)
+    return false;
+  int rows = std::min(stripRows_, s.height - s.nextRow);
+  strip.create(rows, s.width, CV_8UC3);
+  if (setjmp(png_jmpbuf(s.png))) {
+    s.close();
+    return false;
+  }
+  for (int y = 0; y < rows; ++y)
+    png_read_row(s.png, strip.ptr<png_byte>(y), nullptr);
+  s.nextRow += rows;
+  return true;
+#else
+  (void)strip;
+  return false;
+#endif
+}
+
+TiledImageHandler::TiledImageHandler(std::unique_ptr<IImageStripReader> reader)
+    : reader_(std::move(reader)) {}
+
+ImageTileStats TiledImageHandler::analyze(const std::string &filename,
+                                          int maxColorSamples,
+                                          const Deadline &deadline) {
+  ImageTileStats stats;
+  if (!reader_->open(filename)) {
+    std::cerr << "Could not open or find the image: " << filename << std::endl;
+    stats.width = -1;
+    stats.height = -1;
+    return stats;
+  }
+  auto [width, height] = reader_->getDimensions();
+  stats.width = width;
+  stats.height = height;
+
+  // Sample every n-th pixel in both directions so at most maxColorSamples
+  // pixels are kept for k-means.
+  double pixels = static_cast<double>(width) * height;
+  int sampleStep = std::max(
+      1, static_cast<int>(std::ceil(
+             std::sqrt(pixels / std::max(1, maxColorSamples)))));
+
+  // The window holds the rows not yet folded plus kHaloRows of already
+  // folded context above them. Rows are folded once kHaloRows of context
+  // below them have been decoded too.
+  cv::Mat strip, window;
+  int windowTop = 0; // Image row of the window's first row
+  int nextRow = 0;   // First image row not yet folded
+  while (!deadline.expired() && reader_->readStrip(strip)) {
+    if (window.empty()) {
+      window = strip.clone();
+    } else {
+      cv::vconcat(window, strip, window);
+    }
+    int foldEnd = windowTop + window.rows - kHaloRows;
+    if (foldEnd > nextRow) {
+      foldRows(window, windowTop, nextRow, foldEnd, sampleStep, stats);
+      nextRow = foldEnd;
+    }
+    int keepFrom = std::max(windowTop, nextRow - kHaloRows);
+    window = window.rowRange(keepFrom - windowTop, window.rows).clone();
+    windowTop = keepFrom;
+  }
+  if (windowTop + window.rows > nextRow)
+    foldRows(window, windowTop, nextRow, windowTop + window.rows, sampleStep,
+             stats);
+  return stats;
+}
+
+void TiledImageHandler::foldRows(const cv::Mat &band, int bandTop, int begin,
+                                 int end, int sampleStep,
+                                 ImageTileStats &stats) {
+  if (end <= begin)
+    return;
+  int channels = band.channels();
+  if (stats.channels == 0) {
+    stats.channels = channels;
+    stats.histogram.assign(channels, {});
+  }
+
+  // Context rows give the neighborhood filters real pixels across the strip
+  // boundary; only rows [begin, end) are counted.
+  int contextTop = std::max(bandTop, begin - kHaloRows);
+  int contextBottom = std::min(bandTop + band.rows, end + kHaloRows);
+  cv::Mat context =
+      band.rowRange(contextTop - bandTop, contextBottom - bandTop);
+  cv::Mat rows = band.rowRange(begin - bandTop, end - bandTop);
+  int inner = begin - contextTop;
+  int count = end - begin;
+
+  // Per-channel histograms, value sums and color samples
+  for (int y = 0; y < rows.rows; ++y) {
+    const uchar *p = rows.ptr<uchar>(y);
+    std::array<std::uint64_t, 3> rowSums{};
+    for (int x = 0; x < rows.cols; ++x) {
+      for (int c = 0; c < channels && c < 3; ++c) {
+        uchar v = p[x * channels + c];
+        stats.histogram[c][v]++;
+        rowSums[c] += v;
+      }
+    }
+    for (int c = 0; c < 3; ++c)
+      stats.channelSums[c] += static_cast<double>(rowSums[c]);
+    if ((begin + y) % sampleStep == 0) {
+      for (int x = 0; x < rows.cols; x += sampleStep) {
+        const uchar *px = p + x * channels;
+        float b = px[0];
+        float g = channels >= 3 ? px[1] : b;
+        float r = channels >= 3 ? px[2] : b;
+        stats.colorSamples.push_back({b, g, r});
+      }
+    }
+  }
+  stats.pixelCount += static_cast<std::uint64_t>(rows.total());
+
+  cv::Mat gray;
+  if (channels == 1) {
+    gray = context;
+  } else {
+    cv::cvtColor(context, gray, cv::COLOR_BGR2GRAY);
+  }
+  cv::Mat grayRows = gray.rowRange(inner, inner + count);
+  for (int y = 0; y < grayRows.rows; ++y) {
+    const uchar *p = grayRows.ptr<uchar>(y);
+    for (int x = 0; x < grayRows.cols; ++x)
+      stats.grayHistogram[p[x]]++;
+  }
+
+  cv::Mat laplacian;
+  cv::Laplacian(gray, laplacian, CV_64F);
+  for (int y = inner; y < inner + count; ++y) {
+    const double *p = laplacian.ptr<double>(y);
+    for (int x = 0; x < laplacian.cols; ++x) {
+      stats.laplacianSum += p[x];
+      stats.laplacianSumSq += p[x] * p[x];
+    }
+  }
+
+  cv::Mat edges;
+  cv::Canny(gray, edges, 100, 200);
+  stats.edgeCount += cv::countNonZero(edges.rowRange(inner, inner + count));
+
+  if (channels >= 3) {
+    cv::Mat hsv;
+    cv::cvtColor(rows, hsv, cv::COLOR_BGR2HSV);
+    stats.saturationSum += cv::sum(hsv)[1];
+  }
+}
+
+namespace vidicant {
+
+std::unique_ptr<IImageStripReader>
+makeImageStripReader(const std::string &filename, int stripRows) {
+  std::string ext = std::filesystem::path(filename).extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  std::unique_ptr<IImageStripReader> reader;
+  if (ext == ".tif" || ext == ".tiff") {
+    reader = std::make_unique<TiffImageStripReader>();
+  } else if (ext == ".jpg" || ext == ".jpeg") {
+    reader = std::make_unique<JpegImageStripReader>(stripRows);
+  } else if (ext == ".png") {
+    reader = std::make_unique<PngImageStripReader>(stripRows);
+  }
+  // Native readers only know a subset of each format; probe before
+  // committing to one.
+  if (reader && reader->open(filename))
+    return reader;
+  return std::make_unique<OpenCVImageStripReader>(stripRows);
+}
+
+ImageTileStats analyzeImageTiled(const std::string &filename, int stripRows,
+                                 const Deadline &deadline) {
+  TiledImageHandler handler(makeImageStripReader(filename, stripRows));
+  return handler.analyze(filename, 65536, deadline);
+}
+
+} // namespace vidicant
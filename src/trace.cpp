@@ -0,0 +1,212 @@
+#include "vidicant/trace.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Events per chunk of a thread's buffer.
+constexpr std::size_t kChunkEvents = 1024;
+
+// One closed span.
+struct TraceEvent {
+  const char *name = nullptr; // Event name.
+  std::string detail;         // Text shown with the event.
+  std::int64_t start = 0;     // Nanoseconds since tracing started.
+  std::int64_t duration = 0;  // Nanoseconds.
+};
+
+// A block of events. Only the owning thread writes; it fills an event,
+// then publishes it by raising the count, so a writer of the trace can
+// read the chunk at the same time.
+struct TraceChunk {
+  std::array<TraceEvent, kChunkEvents> events;
+  std::atomic<std::size_t> count{0};
+  std::atomic<TraceChunk *> next{nullptr};
+};
+
+// The events of one thread, as a list of chunks.
+struct TraceBuffer {
+  explicit TraceBuffer(int tid) : tid(tid) {}
+
+  ~TraceBuffer() {
+    TraceChunk *chunk = head.next.load();
+    while (chunk != nullptr) {
+      TraceChunk *next = chunk->next.load();
+      delete chunk;
+      chunk = next;
+    }
+  }
+
+  int tid;                   // Thread number in the trace.
+  TraceChunk head;           // First chunk.
+  TraceChunk *tail = &head;  // Chunk being filled; owner only.
+};
+
+// Whether spans are recorded.
+std::atomic<bool> tracingEnabled{false};
+
+// Time zero of the timeline.
+std::chrono::steady_clock::time_point traceEpoch;
+
+// Every thread's buffer; they live until the process exits, so a trace can
+// be written after the threads that recorded it have ended.
+std::mutex registryMutex;
+std::vector<std::unique_ptr<TraceBuffer>> registry;
+
+// The calling thread's buffer, once it has recorded an event.
+thread_local TraceBuffer *localBuffer = nullptr;
+
+// Gets the time since tracing started.
+std::int64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - traceEpoch)
+      .count();
+}
+
+// Creates and registers the calling thread's buffer.
+TraceBuffer *registerThread() {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  int tid = static_cast<int>(registry.size()) + 1;
+  registry.push_back(std::make_unique<TraceBuffer>(tid));
+  localBuffer = registry.back().get();
+  return localBuffer;
+}
+
+// Appends an event to the calling thread's buffer.
+void record(const char *name, std::string detail, std::int64_t start,
+            std::int64_t duration) {
+  TraceBuffer *buffer =
+      localBuffer != nullptr ? localBuffer : registerThread();
+  TraceChunk *chunk = buffer->tail;
+  std::size_t count = chunk->count.load(std::memory_order_relaxed);
+  if (count == kChunkEvents) {
+    auto *next = new TraceChunk;
+    chunk->next.store(next, std::memory_order_release);
+    buffer->tail = chunk = next;
+    count = 0;
+  }
+  TraceEvent &event = chunk->events[count];
+  event.name = name;
+  event.detail = std::move(detail);
+  event.start = start;
+  event.duration = duration;
+  chunk->count.store(count + 1, std::memory_order_release);
+}
+
+// Writes a string as a JSON string literal.
+void writeJsonString(std::ostream &out, const char *text) {
+  out << '"';
+  for (const char *c = text; *c != '\0'; ++c) {
+    unsigned char byte = static_cast<unsigned char>(*c);
+    if (byte == '"' || byte == '\\') {
+      out << '\\' << *c;
+    } else if (byte < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", byte);
+      out << escaped;
+    } else {
+      out << *c;
+    }
+  }
+  out << '"';
+}
+
+// Writes nanoseconds as the microseconds trace events count in.
+void writeMicroseconds(std::ostream &out, std::int64_t nanoseconds) {
+  char text[32];
+  std::snprintf(text, sizeof(text), "%.3f",
+                static_cast<double>(nanoseconds) / 1000.0);
+  out << text;
+}
+
+} // namespace
+
+TraceSpan::TraceSpan(const char *name, const std::string &detail)
+    : name_(name), start_(0),
+      active_(tracingEnabled.load(std::memory_order_relaxed)) {
+  if (!active_)
+    return;
+  detail_ = detail;
+  start_ = now();
+}
+
+TraceSpan::~TraceSpan() {
+  if (active_)
+    record(name_, std::move(detail_), start_, now() - start_);
+}
+
+namespace vidicant {
+
+void startTracing() {
+  static std::once_flag started;
+  std::call_once(started, [] {
+    traceEpoch = std::chrono::steady_clock::now();
+    tracingEnabled = true;
+  });
+}
+
+bool isTracingEnabled() {
+  return tracingEnabled.load(std::memory_order_relaxed);
+}
+
+std::size_t getTraceEventCount() {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  std::size_t total = 0;
+  for (const auto &buffer : registry) {
+    for (const TraceChunk *chunk = &buffer->head; chunk != nullptr;
+         chunk = chunk->next.load(std::memory_order_acquire))
+      total += chunk->count.load(std::memory_order_acquire);
+  }
+  return total;
+}
+
+bool writeTrace(const std::string &path) {
+  std::ofstream out(path);
+  if (!out.is_open())
+    return false;
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto separate = [&] {
+    out << (first ? "\n" : ",\n");
+    first = false;
+  };
+  for (const auto &buffer : registry) {
+    separate();
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << buffer->tid << ",\"args\":{\"name\":\"thread " << buffer->tid
+        << "\"}}";
+    for (const TraceChunk *chunk = &buffer->head; chunk != nullptr;
+         chunk = chunk->next.load(std::memory_order_acquire)) {
+      std::size_t count = chunk->count.load(std::memory_order_acquire);
+      for (std::size_t i = 0; i < count; ++i) {
+        const TraceEvent &event = chunk->events[i];
+        separate();
+        out << "{\"name\":";
+        writeJsonString(out, event.name);
+        out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"ts\":";
+        writeMicroseconds(out, event.start);
+        out << ",\"dur\":";
+        writeMicroseconds(out, event.duration);
+        if (!event.detail.empty()) {
+          out << ",\"args\":{\"detail\":";
+          writeJsonString(out, event.detail.c_str());
+          out << '}';
+        }
+        out << '}';
+      }
+    }
+  }
+  out << "\n]}\n";
+  return static_cast<bool>(out);
+}
+
+} // namespace vidicant
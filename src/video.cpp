@@ -1,5 +1,13 @@
 #include "vidicant/video.hpp"
+#include "vidicant/image_sequence.hpp"
+#include "vidicant/kernels.hpp"
+#include "vidicant/parallelism.hpp"
+#include "vidicant/proxy.hpp"
+#include "vidicant/trace.hpp"
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <numeric>
 #include <opencv2/imgproc.hpp>
@@ -7,6 +15,13 @@
 #include <vector>
 
 bool OpenCVVideoLoader::open(const std::string &filename) {
+  TraceSpan span("open", filename);
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 6)
+  // Size the decoder's thread pool from the process-wide policy
+  int threads = vidicant::getParallelismPolicy().threadsPerFile;
+  if (cap_.open(filename, cv::CAP_FFMPEG, {cv::CAP_PROP_N_THREADS, threads}))
+    return true;
+#endif
   cap_.open(filename, cv::CAP_FFMPEG);
   return cap_.isOpened();
 }
@@ -24,11 +39,146 @@ std::pair<int, int> OpenCVVideoLoader::getResolution() {
 }
 
 cv::Mat OpenCVVideoLoader::readFrame() {
+  TraceSpan span("decode");
   cv::Mat frame;
   cap_ >> frame;
   return frame;
 }
 
+bool OpenCVVideoLoader::readFrame(cv::Mat &frame) {
+  TraceSpan span("decode");
+  return cap_.read(frame);
+}
+
+bool OpenCVVideoLoader::skipFrame() {
+  TraceSpan span("grab");
+  return cap_.grab();
+}
+
+double OpenCVVideoLoader::getTimestamp() {
+  return cap_.get(cv::CAP_PROP_POS_MSEC);
+}
+
+bool OpenCVVideoLoader::seekFrame(int index) {
+  TraceSpan span("seek");
+  return index >= 0 && cap_.set(cv::CAP_PROP_POS_FRAMES, index);
+}
+
+bool IVideoLoader::readFrame(cv::Mat &frame) {
+  frame = readFrame();
+  return !frame.empty();
+}
+
+bool IVideoLoader::skipFrame() { return !readFrame().empty(); }
+
+double IVideoLoader::getTimestamp() { return -1.0; }
+
+bool IVideoLoader::seekFrame(int /*index*/) { return false; }
+
+namespace {
+
+// Converts a frame to grayscale into a reusable buffer.
+void toGray(const cv::Mat &frame, cv::Mat &gray) {
+  if (frame.channels() == 1) {
+    frame.copyTo(gray);
+  } else {
+    cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+  }
+}
+
+// Gets the mean absolute difference of two gray frames of one size. 8-bit
+// frames, the usual case, run through the SIMD kernel a row at a time.
+// @param diff Scratch for the difference image of other depths.
+double meanAbsDiff(const cv::Mat &a, const cv::Mat &b, cv::Mat &diff) {
+  if (a.type() != CV_8UC1 || a.total() == 0) {
+    cv::absdiff(a, b, diff);
+    return cv::mean(diff)[0];
+  }
+  const KernelTable &kernels = vidicant::kernels();
+  auto cols = static_cast<std::size_t>(a.cols);
+  std::uint64_t sum = 0;
+  for (int y = 0; y < a.rows; ++y)
+    sum += kernels.sumAbsDiff(a.ptr<uchar>(y), b.ptr<uchar>(y), cols);
+  return static_cast<double>(sum) / static_cast<double>(a.total());
+}
+
+// Averages the channel means of a frame into one brightness value.
+double frameBrightness(const cv::Mat &frame) {
+  cv::Scalar mean = cv::mean(frame);
+  return (frame.channels() == 1) ? mean[0]
+                                 : (mean[0] + mean[1] + mean[2]) / 3.0;
+}
+
+// Bins of the gray histograms compared by the frame series.
+constexpr int kSeriesHistogramBins = 32;
+
+// Computes the normalized gray histogram of a frame.
+void grayHistogram(const cv::Mat &gray, cv::Mat &hist,
+                   std::array<float, kSeriesHistogramBins> &normalized) {
+  const int channels[] = {0};
+  const int bins[] = {kSeriesHistogramBins};
+  const float range[] = {0.0f, 256.0f};
+  const float *ranges[] = {range};
+  cv::calcHist(&gray, 1, channels, cv::Mat(), hist, 1, bins, ranges);
+  float total = static_cast<float>(gray.total());
+  for (int i = 0; i < kSeriesHistogramBins; ++i)
+    normalized[i] = total > 0 ? hist.at<float>(i) / total : 0.0f;
+}
+
+// Frames sampled for the whole-video palette, spread evenly over its length.
+constexpr int kPaletteSampleFrames = 100;
+
+// Pixels sampled per frame for palettes, before striding rounds it up.
+constexpr int kPaletteSamplesPerFrame = 65536;
+
+// Gets the row and column stride that samples about
+// kPaletteSamplesPerFrame pixels of a frame.
+int paletteStride(const cv::Mat &frame) {
+  double ratio = static_cast<double>(frame.total()) / kPaletteSamplesPerFrame;
+  return std::max(1, static_cast<int>(std::sqrt(ratio)));
+}
+
+// Converts a palette to the color arrays returned by getDominantColors.
+std::vector<std::array<double, 3>>
+paletteColors(const std::vector<PaletteColor> &palette) {
+  std::vector<std::array<double, 3>> colors;
+  for (const auto &entry : palette)
+    colors.push_back(entry.color);
+  return colors;
+}
+
+// Orders the positions 0..count-1 coarse to fine: by the bit reversal of
+// each position, so every prefix of the order is spread over the range.
+std::vector<int> spreadOrder(int count) {
+  int bits = 0;
+  while ((1 << bits) < count)
+    ++bits;
+  std::vector<int> order;
+  order.reserve(static_cast<std::size_t>(std::max(count, 0)));
+  for (int i = 0; i < (1 << bits); ++i) {
+    int reversed = 0;
+    for (int b = 0; b < bits; ++b)
+      reversed |= ((i >> b) & 1) << (bits - 1 - b);
+    if (reversed < count)
+      order.push_back(reversed);
+  }
+  return order;
+}
+
+// Gets the frames a loop reads from a video without a deadline.
+// @param limit Frames the loop stops at, 0 for none.
+int plannedFrames(IVideoLoader &loader, int limit = 0) {
+  int count = loader.getFrameCount();
+  if (limit <= 0)
+    return count;
+  return count > 0 ? std::min(count, limit) : limit;
+}
+
+// Seconds from the start of a video over which bar detection samples.
+constexpr double kActiveAreaSeconds = 30.0;
+
+} // namespace
+
 VideoHandler::VideoHandler(std::unique_ptr<IVideoLoader> loader)
     : loader_(std::move(loader)) {}
 
@@ -55,29 +205,27 @@ double VideoHandler::getDuration() {
 
 cv::Mat VideoHandler::extractFirstFrame() {
   // Create a temporary loader to read the first frame
-  auto tempLoader = std::make_unique<OpenCVVideoLoader>();
+  auto tempLoader = vidicant::makeVideoLoader(filename_);
   if (!tempLoader->open(filename_))
     return cv::Mat();
   return tempLoader->readFrame();
 }
 
 double VideoHandler::getAverageBrightness() {
-  auto tempLoader = std::make_unique<OpenCVVideoLoader>();
+  auto tempLoader = vidicant::makeVideoLoader(filename_);
   if (!tempLoader->open(filename_))
     return -1.0;
-  cv::Mat frame;
+  arena_.beginPass();
+  cv::Mat &frame = arena_.slot(FrameSlot::Frame);
   double totalBrightness = 0.0;
   int frameCount = 0;
-  frame = tempLoader->readFrame();
-  while (!frame.empty()) {
-    cv::Scalar mean = cv::mean(frame);
-    double brightness =
-        (frame.channels() == 1) ? mean[0] : (mean[0] + mean[1] + mean[2]) / 3.0;
-    totalBrightness += brightness;
+  int planned = plannedFrames(*tempLoader, 101);
+  while (!outOfTime(frameCount, planned) && tempLoader->readFrame(frame)) {
+    totalBrightness += frameBrightness(activeView(frame));
     frameCount++;
+    arena_.endFrame();
     if (frameCount > 100)
       break; // Limit to first 100 frames for speed
-    frame = tempLoader->readFrame();
   }
   return frameCount > 0 ? totalBrightness / frameCount : -1.0;
 }
@@ -95,100 +243,141 @@ bool VideoHandler::saveFirstFrameAsImage(const std::string &imagePath) {
 }
 
 double VideoHandler::getMotionScore() {
-  auto tempLoader = std::make_unique<OpenCVVideoLoader>();
+  auto tempLoader = vidicant::makeVideoLoader(filename_);
   if (!tempLoader->open(filename_))
     return -1.0;
-  cv::Mat prevFrame, currFrame;
-  prevFrame = tempLoader->readFrame();
-  if (prevFrame.empty())
+  arena_.beginPass();
+  cv::Mat &frame = arena_.slot(FrameSlot::Frame);
+  cv::Mat &prevGray = arena_.slot(FrameSlot::PreviousGray);
+  cv::Mat &grayCurr = arena_.slot(FrameSlot::Gray);
+  cv::Mat &diff = arena_.slot(FrameSlot::Diff);
+  if (!tempLoader->readFrame(frame))
     return 0.0;
-  cv::cvtColor(prevFrame, prevFrame, cv::COLOR_BGR2GRAY);
+  toGray(activeView(frame), prevGray);
+  arena_.endFrame();
 
   double totalMotion = 0.0;
   int frameCount = 1;
-  currFrame = tempLoader->readFrame();
-  while (!currFrame.empty() && frameCount < 50) { // Limit to 50 frames
-    cv::Mat grayCurr;
-    cv::cvtColor(currFrame, grayCurr, cv::COLOR_BGR2GRAY);
-    cv::Mat diff;
-    cv::absdiff(prevFrame, grayCurr, diff);
-    cv::Scalar meanDiff = cv::mean(diff);
-    totalMotion += meanDiff[0];
-    prevFrame = grayCurr;
+  int planned = plannedFrames(*tempLoader, 50); // Limit to 50
+  while (frameCount < 50 && !outOfTime(frameCount, planned) &&
+         tempLoader->readFrame(frame)) {
+    toGray(activeView(frame), grayCurr);
+    totalMotion += meanAbsDiff(prevGray, grayCurr, diff);
+    std::swap(prevGray, grayCurr);
     frameCount++;
-    currFrame = tempLoader->readFrame();
+    arena_.endFrame();
   }
   return frameCount > 1 ? totalMotion / (frameCount - 1) : 0.0;
 }
 
 std::vector<std::array<double, 3>> VideoHandler::getDominantColors() {
-  auto tempLoader = std::make_unique<OpenCVVideoLoader>();
+  auto tempLoader = vidicant::makeVideoLoader(filename_);
   if (!tempLoader->open(filename_))
     return {};
-  std::vector<cv::Mat> frames;
-  cv::Mat frame;
-  int count = 0;
-  frame = tempLoader->readFrame();
-  while (!frame.empty() && count < 10) { // Sample first 10 frames
-    frames.push_back(frame.clone());
-    count++;
-    frame = tempLoader->readFrame();
+  // Decode only every frameStep-th frame; the rest are skipped undecoded
+  int frameCount = tempLoader->getFrameCount();
+  int frameStep = std::max(1, frameCount / kPaletteSampleFrames);
+  ColorHistogramModel model;
+  arena_.beginPass();
+  cv::Mat &frame = arena_.slot(FrameSlot::Frame);
+
+  // Under a budget, seek to the samples coarse to fine instead, so the
+  // palette spans the video whenever the budget runs out
+  if (deadline_.isSet() && frameCount > 0 && tempLoader->seekFrame(0)) {
+    std::vector<int> order = spreadOrder((frameCount - 1) / frameStep + 1);
+    int sampled = static_cast<int>(order.size());
+    for (int i = 0; i < sampled && !outOfTime(i, sampled); ++i) {
+      if (!tempLoader->seekFrame(order[i] * frameStep) ||
+          !tempLoader->readFrame(frame))
+        continue; // Past the real end of a video whose count overstates it
+      cv::Mat view = activeView(frame);
+      model.addFrame(view, paletteStride(view));
+      arena_.endFrame();
+    }
+    return paletteColors(model.getPalette(3, deadline_));
   }
-  if (frames.empty())
-    return {};
 
-  // Concatenate all frames into one big image for k-means
-  cv::Mat data;
-  for (const auto &f : frames) {
-    cv::Mat temp;
-    f.convertTo(temp, CV_32F);
-    temp = temp.reshape(1, temp.total());
-    if (data.empty()) {
-      data = temp;
-    } else {
-      cv::vconcat(data, temp, data);
+  int planned = plannedFrames(*tempLoader);
+  for (int frameIndex = 0; !outOfTime(frameIndex, planned); ++frameIndex) {
+    if (frameIndex % frameStep != 0) {
+      if (!tempLoader->skipFrame())
+        break;
+      continue;
     }
+    if (!tempLoader->readFrame(frame))
+      break;
+    cv::Mat view = activeView(frame);
+    model.addFrame(view, paletteStride(view));
+    arena_.endFrame();
   }
+  return paletteColors(model.getPalette(3, deadline_));
+}
 
-  std::vector<int> labels;
-  cv::Mat centers;
-  cv::kmeans(data, 3, labels,
-             cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT,
-                              10, 1.0),
-             3, cv::KMEANS_PP_CENTERS, centers);
-
-  std::vector<std::array<double, 3>> dominantColors;
-  for (int i = 0; i < 3; ++i) {
-    dominantColors.push_back({centers.at<float>(i, 0), centers.at<float>(i, 1),
-                              centers.at<float>(i, 2)});
+std::vector<ScenePalette> VideoHandler::getScenePalettes(double threshold,
+                                                         int colors) {
+  auto tempLoader = vidicant::makeVideoLoader(filename_);
+  if (!tempLoader->open(filename_))
+    return {};
+  int frameStep = std::max(1, tempLoader->getFrameCount() /
+                                  kPaletteSampleFrames);
+  arena_.beginPass();
+  cv::Mat &frame = arena_.slot(FrameSlot::Frame);
+  cv::Mat &prevGray = arena_.slot(FrameSlot::PreviousGray);
+  cv::Mat &grayCurr = arena_.slot(FrameSlot::Gray);
+  cv::Mat &diff = arena_.slot(FrameSlot::Diff);
+  ColorHistogramModel model;
+  std::vector<ScenePalette> palettes;
+  int sceneStart = 0;
+  int frameIndex = 0;
+  int planned = plannedFrames(*tempLoader);
+  while (!outOfTime(frameIndex, planned) && tempLoader->readFrame(frame)) {
+    cv::Mat view = activeView(frame);
+    toGray(view, grayCurr);
+    if (frameIndex > 0) {
+      if (meanAbsDiff(prevGray, grayCurr, diff) > threshold) {
+        palettes.push_back(
+            {sceneStart, frameIndex, model.getPalette(colors, deadline_)});
+        model.clear();
+        sceneStart = frameIndex;
+      }
+    }
+    // Every scene contributes at least its first frame
+    if (frameIndex == sceneStart || frameIndex % frameStep == 0)
+      model.addFrame(view, paletteStride(view));
+    std::swap(prevGray, grayCurr);
+    frameIndex++;
+    arena_.endFrame();
   }
-  return dominantColors;
+  if (frameIndex > sceneStart)
+    palettes.push_back(
+        {sceneStart, frameIndex, model.getPalette(colors, deadline_)});
+  return palettes;
 }
 
 std::vector<int> VideoHandler::detectSceneChanges(double threshold) {
-  auto tempLoader = std::make_unique<OpenCVVideoLoader>();
+  auto tempLoader = vidicant::makeVideoLoader(filename_);
   if (!tempLoader->open(filename_))
     return {};
-  cv::Mat prevFrame, currFrame;
-  prevFrame = tempLoader->readFrame();
-  if (prevFrame.empty())
+  arena_.beginPass();
+  cv::Mat &frame = arena_.slot(FrameSlot::Frame);
+  cv::Mat &prevGray = arena_.slot(FrameSlot::PreviousGray);
+  cv::Mat &grayCurr = arena_.slot(FrameSlot::Gray);
+  cv::Mat &diff = arena_.slot(FrameSlot::Diff);
+  if (!tempLoader->readFrame(frame))
     return {};
-  cv::cvtColor(prevFrame, prevFrame, cv::COLOR_BGR2GRAY);
+  toGray(activeView(frame), prevGray);
+  arena_.endFrame();
   std::vector<int> sceneChanges;
   int frameIndex = 1;
-  currFrame = tempLoader->readFrame();
-  while (!currFrame.empty()) {
-    cv::Mat grayCurr;
-    cv::cvtColor(currFrame, grayCurr, cv::COLOR_BGR2GRAY);
-    cv::Mat diff;
-    cv::absdiff(prevFrame, grayCurr, diff);
-    cv::Scalar meanDiff = cv::mean(diff);
-    if (meanDiff[0] > threshold) {
+  int planned = plannedFrames(*tempLoader, 1001);
+  while (!outOfTime(frameIndex, planned) && tempLoader->readFrame(frame)) {
+    toGray(activeView(frame), grayCurr);
+    if (meanAbsDiff(prevGray, grayCurr, diff) > threshold) {
       sceneChanges.push_back(frameIndex);
     }
-    prevFrame = grayCurr;
+    std::swap(prevGray, grayCurr);
     frameIndex++;
-    currFrame = tempLoader->readFrame();
+    arena_.endFrame();
     if (frameIndex > 1000) // Limit to first 1000 frames for performance
       break;
   }
@@ -207,20 +396,20 @@ double VideoHandler::getFrameRateStability() {
 }
 
 double VideoHandler::getColorConsistency() {
-  auto tempLoader = std::make_unique<OpenCVVideoLoader>();
+  auto tempLoader = vidicant::makeVideoLoader(filename_);
   if (!tempLoader->open(filename_))
     return -1.0;
-  cv::Mat frame;
+  arena_.beginPass();
+  cv::Mat &frame = arena_.slot(FrameSlot::Frame);
   std::vector<double> brightnesses;
-  int count = 0;
-  frame = tempLoader->readFrame();
-  while (!frame.empty() && count < 50) { // Sample 50 frames
-    cv::Scalar mean = cv::mean(frame);
-    double brightness =
-        (frame.channels() == 1) ? mean[0] : (mean[0] + mean[1] + mean[2]) / 3.0;
-    brightnesses.push_back(brightness);
-    count++;
-    frame = tempLoader->readFrame();
+  brightnesses.reserve(50);
+  int planned = plannedFrames(*tempLoader, 50);
+  while (brightnesses.size() < 50 &&
+         !outOfTime(static_cast<int>(brightnesses.size()), planned) &&
+         tempLoader->readFrame(frame)) {
+    // Sample 50 frames
+    brightnesses.push_back(frameBrightness(activeView(frame)));
+    arena_.endFrame();
   }
   if (brightnesses.empty())
     return -1.0;
@@ -236,51 +425,212 @@ double VideoHandler::getColorConsistency() {
   return mean > 0 ? (stddev / mean) : 0.0; // Coefficient of variation
 }
 
+std::vector<FrameHash> VideoHandler::getKeyframeHashes(double threshold,
+                                                       int keyframeInterval) {
+  auto tempLoader = vidicant::makeVideoLoader(filename_);
+  if (!tempLoader->open(filename_))
+    return {};
+  arena_.beginPass();
+  cv::Mat &frame = arena_.slot(FrameSlot::Frame);
+  cv::Mat &prevGray = arena_.slot(FrameSlot::PreviousGray);
+  cv::Mat &grayCurr = arena_.slot(FrameSlot::Gray);
+  cv::Mat &diff = arena_.slot(FrameSlot::Diff);
+  if (!tempLoader->readFrame(frame))
+    return {};
+  toGray(activeView(frame), prevGray);
+  std::vector<FrameHash> keyframes;
+  keyframes.push_back({0, true, vidicant::computePerceptualHash(prevGray)});
+  arena_.endFrame();
+
+  int frameIndex = 1;
+  int lastKeyframe = 0;
+  int planned = plannedFrames(*tempLoader);
+  while (!outOfTime(frameIndex, planned) && tempLoader->readFrame(frame)) {
+    toGray(activeView(frame), grayCurr);
+    bool sceneStart = meanAbsDiff(prevGray, grayCurr, diff) > threshold;
+    bool periodic =
+        keyframeInterval > 0 && frameIndex - lastKeyframe >= keyframeInterval;
+    if (sceneStart || periodic) {
+      keyframes.push_back(
+          {frameIndex, sceneStart, vidicant::computePerceptualHash(grayCurr)});
+      lastKeyframe = frameIndex;
+    }
+    std::swap(prevGray, grayCurr);
+    frameIndex++;
+    arena_.endFrame();
+  }
+  return keyframes;
+}
+
+FrameSeries VideoHandler::getFrameSeries(int maxFrames,
+                                         std::vector<FrameHash> *keyframes,
+                                         double threshold,
+                                         int keyframeInterval) {
+  FrameSeries series(getFPS());
+  auto tempLoader = vidicant::makeVideoLoader(filename_);
+  if (!tempLoader->open(filename_))
+    return series;
+  arena_.beginPass();
+  cv::Mat &frame = arena_.slot(FrameSlot::Frame);
+  cv::Mat &prevGray = arena_.slot(FrameSlot::PreviousGray);
+  cv::Mat &grayCurr = arena_.slot(FrameSlot::Gray);
+  cv::Mat &diff = arena_.slot(FrameSlot::Diff);
+  cv::Mat &hsv = arena_.slot(FrameSlot::Hsv);
+  cv::Mat &hist = arena_.slot(FrameSlot::Scratch);
+  std::array<float, kSeriesHistogramBins> prevHist{};
+  std::array<float, kSeriesHistogramBins> currHist{};
+  int frameIndex = 0;
+  int lastKeyframe = 0;
+  int planned = plannedFrames(*tempLoader, maxFrames);
+  while ((maxFrames <= 0 || frameIndex < maxFrames) &&
+         !outOfTime(frameIndex, planned) && tempLoader->readFrame(frame)) {
+    cv::Mat view = activeView(frame);
+    FrameSample sample;
+    sample.frame = frameIndex;
+    sample.brightness = static_cast<float>(frameBrightness(view));
+    if (view.channels() == 3) {
+      cv::cvtColor(view, hsv, cv::COLOR_BGR2HSV);
+      sample.saturation = static_cast<float>(cv::mean(hsv)[1]);
+    }
+    toGray(view, grayCurr);
+    grayHistogram(grayCurr, hist, currHist);
+    bool sceneStart = frameIndex == 0;
+    if (frameIndex > 0) {
+      double meanDiff = meanAbsDiff(prevGray, grayCurr, diff);
+      sample.meanDiff = static_cast<float>(meanDiff);
+      sceneStart = meanDiff > threshold;
+      float distance = 0.0f;
+      for (int i = 0; i < kSeriesHistogramBins; ++i)
+        distance += std::abs(currHist[i] - prevHist[i]);
+      sample.histogramDistance = 0.5f * distance;
+    }
+    // Keyframes as getKeyframeHashes picks them
+    bool periodic =
+        keyframeInterval > 0 && frameIndex - lastKeyframe >= keyframeInterval;
+    if (keyframes != nullptr && (frameIndex == 0 || sceneStart || periodic)) {
+      keyframes->push_back(
+          {frameIndex, sceneStart, vidicant::computePerceptualHash(grayCurr)});
+      lastKeyframe = frameIndex;
+    }
+    series.add(sample);
+    std::swap(prevGray, grayCurr);
+    prevHist = currHist;
+    frameIndex++;
+    arena_.endFrame();
+  }
+  return series;
+}
+
+ActiveArea VideoHandler::detectActiveArea(int samples) {
+  ActiveAreaDetector detector;
+  auto tempLoader = vidicant::makeVideoLoader(filename_);
+  if (!tempLoader->open(filename_) || samples <= 0)
+    return detector.getArea();
+  // Spread the samples over the opening seconds; past titles and credits
+  // the bars of a film do not change
+  int frameCount = tempLoader->getFrameCount();
+  int span = static_cast<int>(std::lround(getFPS() * kActiveAreaSeconds));
+  if (frameCount > 0 && (span <= 0 || frameCount < span))
+    span = frameCount;
+  int frameStep = std::max(1, span / samples);
+  arena_.beginPass();
+  cv::Mat &frame = arena_.slot(FrameSlot::Frame);
+  for (int sampled = 0; sampled < samples; ++sampled) {
+    if (!tempLoader->readFrame(frame))
+      break;
+    detector.addFrame(frame);
+    arena_.endFrame();
+    bool more = true;
+    for (int i = 1; more && i < frameStep; ++i)
+      more = tempLoader->skipFrame();
+    if (!more)
+      break;
+  }
+  return detector.getArea();
+}
+
+void VideoHandler::setActiveArea(const cv::Rect &area) { area_ = area; }
+
+cv::Mat VideoHandler::activeView(const cv::Mat &frame) const {
+  cv::Rect area = area_ & cv::Rect(0, 0, frame.cols, frame.rows);
+  return area.empty() ? frame : frame(area);
+}
+
+void VideoHandler::setDeadline(const Deadline &deadline) {
+  deadline_ = deadline;
+}
+
+bool VideoHandler::isInterrupted() const { return interrupted_; }
+
+double VideoHandler::getCoverage() const { return coverage_; }
+
+bool VideoHandler::outOfTime(int done, int planned) {
+  if (!deadline_.expired())
+    return false;
+  interrupted_ = true;
+  double reached =
+      planned > 0 ? std::min(1.0, static_cast<double>(done) / planned) : 0.0;
+  coverage_ = std::min(coverage_, reached);
+  return true;
+}
+
+const FrameArena &VideoHandler::getFrameArena() const { return arena_; }
+
 namespace vidicant {
+std::unique_ptr<IVideoLoader> makeVideoLoader(const std::string &filename) {
+  if (isImageSequence(filename))
+    return std::make_unique<ImageSequenceLoader>();
+  if (isAnimatedImage(filename))
+    return std::make_unique<AnimatedImageLoader>();
+  if (isVideoProxy(filename))
+    return std::make_unique<ProxyVideoLoader>();
+  return std::make_unique<OpenCVVideoLoader>();
+}
+
 int getVideoFrameCount(const std::string &filename) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return -1;
   return handler.getFrameCount();
 }
 
 double getVideoFPS(const std::string &filename) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return -1.0;
   return handler.getFPS();
 }
 
 std::pair<int, int> getVideoResolution(const std::string &filename) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return {-1, -1};
   return handler.getResolution();
 }
 
 double getVideoDuration(const std::string &filename) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return -1.0;
   return handler.getDuration();
 }
 
 cv::Mat extractFirstFrame(const std::string &filename) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return cv::Mat();
   return handler.extractFirstFrame();
 }
 
 double getVideoAverageBrightness(const std::string &filename) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return -1.0;
   return handler.getAverageBrightness();
 }
 
 bool isVideoGrayscale(const std::string &filename) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return false;
   return handler.isGrayscale();
@@ -288,14 +638,14 @@ bool isVideoGrayscale(const std::string &filename) {
 
 bool saveFirstFrameAsImage(const std::string &videoPath,
                            const std::string &imagePath) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(videoPath));
   if (!handler.open(videoPath))
     return false;
   return handler.saveFirstFrameAsImage(imagePath);
 }
 
 double getVideoMotionScore(const std::string &filename) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return -1.0;
   return handler.getMotionScore();
@@ -303,32 +653,56 @@ double getVideoMotionScore(const std::string &filename) {
 
 std::vector<std::array<double, 3>>
 getVideoDominantColors(const std::string &filename) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return {};
   return handler.getDominantColors();
 }
 
+std::vector<ScenePalette> getVideoScenePalettes(const std::string &filename,
+                                                double threshold, int colors) {
+  VideoHandler handler(makeVideoLoader(filename));
+  if (!handler.open(filename))
+    return {};
+  return handler.getScenePalettes(threshold, colors);
+}
+
 std::vector<int> detectVideoSceneChanges(const std::string &filename,
                                          double threshold) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return {};
   return handler.detectSceneChanges(threshold);
 }
 
 double getVideoFrameRateStability(const std::string &filename) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return -1.0;
   return handler.getFrameRateStability();
 }
 
 double getVideoColorConsistency(const std::string &filename) {
-  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  VideoHandler handler(makeVideoLoader(filename));
   if (!handler.open(filename))
     return -1.0;
   return handler.getColorConsistency();
 }
 
+std::vector<FrameHash> getVideoKeyframeHashes(const std::string &filename,
+                                              double threshold,
+                                              int keyframeInterval) {
+  VideoHandler handler(makeVideoLoader(filename));
+  if (!handler.open(filename))
+    return {};
+  return handler.getKeyframeHashes(threshold, keyframeInterval);
+}
+
+FrameSeries getVideoFrameSeries(const std::string &filename, int maxFrames) {
+  VideoHandler handler(makeVideoLoader(filename));
+  if (!handler.open(filename))
+    return FrameSeries();
+  return handler.getFrameSeries(maxFrames);
+}
+
 } // namespace vidicant
@@ -5,6 +5,8 @@
 // to Python, allowing the library to be used as a pip package.
 
 #include "controller.hpp"
+#include "vidicant/kernels.hpp"
+#include "vidicant/parallelism.hpp"
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -41,17 +43,118 @@ py::object json_to_python(const nlohmann::json &j) {
 }
 
 // Wrapper for processImage that returns Python dict
-py::object process_image_wrapper(const std::string &filename) {
-  nlohmann::json result = processImage(filename);
+py::object process_image_wrapper(const std::string &filename, bool tiled,
+                                 int tileRows, bool hashes,
+                                 const std::vector<std::string> &metrics,
+                                 int histogramBins, bool cropBars,
+                                 double timeBudget, bool jpegDct,
+                                 bool memoryStats) {
+  ProcessOptions options;
+  options.tiled = tiled;
+  options.tileRows = tileRows;
+  options.perceptualHashes = hashes;
+  options.metrics = metrics;
+  options.histogramBins = histogramBins;
+  options.cropBars = cropBars;
+  options.timeBudget = timeBudget;
+  options.jpegDct = jpegDct;
+  options.memoryStats = memoryStats;
+  std::string invalid = checkProcessOptions(options);
+  if (!invalid.empty())
+    throw py::value_error(invalid);
+  nlohmann::json result;
+  {
+    // Let other Python threads analyze files concurrently
+    py::gil_scoped_release release;
+    result = processImage(filename, options);
+  }
   return json_to_python(result);
 }
 
 // Wrapper for processVideo that returns Python dict
-py::object process_video_wrapper(const std::string &filename) {
-  nlohmann::json result = processVideo(filename);
+py::object process_video_wrapper(const std::string &filename, bool hashes,
+                                 const std::vector<std::string> &metrics,
+                                 const std::string &series, int seriesWindow,
+                                 const std::vector<double> &sceneThresholds,
+                                 bool scenePalettes, bool cropBars,
+                                 bool qc, double timeBudget,
+                                 bool memoryStats,
+                                 const std::string &proxyCache,
+                                 int proxyHeight,
+                                 std::uintmax_t proxyCacheLimit) {
+  if (!series.empty() && series != "csv" && series != "binary")
+    throw py::value_error("series must be 'csv' or 'binary'");
+  ProcessOptions options;
+  options.perceptualHashes = hashes;
+  options.metrics = metrics;
+  options.seriesFormat = series;
+  options.seriesWindow = seriesWindow;
+  options.sceneThresholds = sceneThresholds;
+  options.scenePalettes = scenePalettes;
+  options.cropBars = cropBars;
+  options.qcEvents = qc;
+  options.timeBudget = timeBudget;
+  options.memoryStats = memoryStats;
+  options.proxyCache = proxyCache;
+  options.proxyHeight = proxyHeight;
+  options.proxyCacheLimit = proxyCacheLimit;
+  std::string invalid = checkProcessOptions(options);
+  if (!invalid.empty())
+    throw py::value_error(invalid);
+  nlohmann::json result;
+  {
+    py::gil_scoped_release release;
+    result = processVideo(filename, options);
+  }
+  return json_to_python(result);
+}
+
+// Wrapper for processSeries that returns Python dict
+py::object process_series_wrapper(const std::string &filename,
+                                  int seriesWindow,
+                                  const std::vector<double> &sceneThresholds,
+                                  double qcBlack, double qcFreeze,
+                                  double qcFlash) {
+  ProcessOptions options;
+  options.seriesWindow = seriesWindow;
+  options.sceneThresholds = sceneThresholds;
+  options.qc.blackBrightness = qcBlack;
+  options.qc.freezeDiff = qcFreeze;
+  options.qc.flashBrightness = qcFlash;
+  std::string invalid = checkProcessOptions(options);
+  if (!invalid.empty())
+    throw py::value_error(invalid);
+  nlohmann::json result;
+  {
+    py::gil_scoped_release release;
+    result = processSeries(filename, options);
+  }
   return json_to_python(result);
 }
 
+// Wrapper that installs a parallelism policy from Python arguments
+void set_parallelism_wrapper(const std::string &mode, int jobs,
+                             bool pinThreads) {
+  ParallelismMode parsed;
+  if (!vidicant::parseParallelismMode(mode, parsed))
+    throw py::value_error("mode must be 'file', 'intra' or 'hybrid'");
+  ParallelismPolicy policy = vidicant::makeParallelismPolicy(parsed, jobs);
+  policy.pinThreads = pinThreads;
+  vidicant::setParallelismPolicy(policy);
+}
+
+// Wrapper that returns the installed parallelism policy as a dict
+py::dict get_parallelism_wrapper() {
+  ParallelismPolicy policy = vidicant::getParallelismPolicy();
+  py::dict result;
+  result["mode"] = vidicant::parallelismModeName(policy.mode);
+  result["cores"] = policy.cores;
+  result["jobs"] = policy.fileWorkers;
+  result["threads_per_file"] = policy.threadsPerFile;
+  result["pin_threads"] = policy.pinThreads;
+  return result;
+}
+
 PYBIND11_MODULE(vidicant_py, m) {
   m.doc() = "Vidicant Python bindings for cross-platform media analysis";
 
@@ -62,12 +165,94 @@ PYBIND11_MODULE(vidicant_py, m) {
   m.def("is_video_file", &isVideoFile,
         "Check if a file is a supported video format", py::arg("filename"));
 
+  m.def(
+      "available_metrics",
+      [] {
+        py::dict metrics;
+        metrics["image"] = getImageMetricNames();
+        metrics["video"] = getVideoMetricNames();
+        return metrics;
+      },
+      "Names accepted by the metrics= argument, keyed by media type");
+
+  m.def(
+      "simd_kernels",
+      [] {
+        py::dict kernels;
+        kernels["isa"] = vidicant::kernels().isa;
+        kernels["available"] = vidicant::getAvailableIsas();
+        return kernels;
+      },
+      "The instruction set of the SIMD kernels in use, and every variant "
+      "this build and CPU can run, best first. Set the VIDICANT_ISA "
+      "environment variable before the first analysis to force a variant");
+
+  m.def("set_parallelism", &set_parallelism_wrapper,
+        "Divide cores between concurrent files and the work inside each "
+        "file: mode is 'file', 'intra' or 'hybrid', jobs is the number of "
+        "files you will analyze at once (0 for the mode's default). Sets "
+        "OpenCV's and the video decoders' thread counts to match",
+        py::arg("mode") = "hybrid", py::arg("jobs") = 0,
+        py::arg("pin_threads") = false);
+
+  m.def("get_parallelism", &get_parallelism_wrapper,
+        "Return the installed parallelism policy as a dictionary");
+
+  m.def("pin_current_thread", &vidicant::pinCurrentThread,
+        "Pin the calling thread to the CPU set of file worker `worker` "
+        "under the installed policy; returns False where unsupported",
+        py::arg("worker"));
+
   // Bind main processing functions with wrappers that convert JSON to Python
   m.def("process_image", &process_image_wrapper,
-        "Process an image file and return analysis results as a dictionary",
-        py::arg("filename"));
+        "Process an image file and return analysis results as a dictionary. "
+        "Set tiled=True to decode large images in strips of tile_rows rows "
+        "with bounded memory. Set hashes=True to add dHash/pHash fingerprints. "
+        "Pass metrics=[...] to compute only the named metrics, and "
+        "histogram_bins to set the bins per channel of the histogram. Set "
+        "crop_bars=True to analyze only the picture inside black bars, "
+        "time_budget to stop after that many seconds with partial results, "
+        "jpeg_dct=True to estimate JPEG metrics from DCT coefficients, and "
+        "memory_stats=True to report the Mat memory taken per stage",
+        py::arg("filename"), py::arg("tiled") = false,
+        py::arg("tile_rows") = 256, py::arg("hashes") = false,
+        py::arg("metrics") = std::vector<std::string>(),
+        py::arg("histogram_bins") = 256, py::arg("crop_bars") = false,
+        py::arg("time_budget") = 0.0, py::arg("jpeg_dct") = false,
+        py::arg("memory_stats") = false);
+
+  m.def("process_series", &process_series_wrapper,
+        "Analyze a per-frame series saved with series='binary' without "
+        "decoding its video again: window summaries of series_window "
+        "frames, scene changes at scene_thresholds=[...] (or 30), and QC "
+        "events with the qc_black, qc_freeze and qc_flash thresholds",
+        py::arg("filename"), py::arg("series_window") = 0,
+        py::arg("scene_thresholds") = std::vector<double>(),
+        py::arg("qc_black") = QcOptions().blackBrightness,
+        py::arg("qc_freeze") = QcOptions().freezeDiff,
+        py::arg("qc_flash") = QcOptions().flashBrightness);
 
   m.def("process_video", &process_video_wrapper,
-        "Process a video file and return analysis results as a dictionary",
-        py::arg("filename"));
+        "Process a video file and return analysis results as a dictionary. "
+        "Set hashes=True to fingerprint scene and periodic keyframes. "
+        "Pass metrics=[...] to compute only the named metrics. Set "
+        "series='csv' or 'binary' to save per-frame measurements and "
+        "series_window frames per summary, and scene_thresholds=[...] to "
+        "detect scene changes at several thresholds from one decode. Set "
+        "scene_palettes=True to add the dominant colors of each scene, "
+        "crop_bars=True to analyze only the picture inside black bars, "
+        "qc=True to report black, frozen and flash frame ranges, "
+        "time_budget to stop after that many seconds with partial results, "
+        "and memory_stats=True to report the Mat memory taken per pass. Pass "
+        "proxy_cache=dir to analyze cached frames of proxy_height rows "
+        "instead of decoding the video again, keeping at most "
+        "proxy_cache_limit bytes of proxies (0 for no limit)",
+        py::arg("filename"), py::arg("hashes") = false,
+        py::arg("metrics") = std::vector<std::string>(),
+        py::arg("series") = "", py::arg("series_window") = 0,
+        py::arg("scene_thresholds") = std::vector<double>(),
+        py::arg("scene_palettes") = false, py::arg("crop_bars") = false,
+        py::arg("qc") = false, py::arg("time_budget") = 0.0,
+        py::arg("memory_stats") = false, py::arg("proxy_cache") = "",
+        py::arg("proxy_height") = 144, py::arg("proxy_cache_limit") = 0);
 }
@@ -0,0 +1,318 @@
+// watcher.cpp
+// Implementation file for continuous ingest of watched directories.
+//
+// This file contains the inotify-based watch loop. Every directory
+// of the watched trees gets one watch, added once at startup and
+// whenever a directory is created or moved in. A file becomes a
+// candidate when it is closed after writing or moved into a watched
+// directory, and is analyzed once it has been quiet for the settle
+// time with an unchanged size, so uploaders that reopen a file or
+// write it in several passes are analyzed once, after the last pass.
+// Candidates are handed to a ThreadPool with an unbounded queue, so
+// the loop never blocks on analysis and keeps draining the kernel's
+// event queue.
+
+#include "watcher.hpp"
+#include "crawler.hpp"
+#include "vidicant/parallelism.hpp"
+#include "vidicant/thread_pool.hpp"
+#include "vidicant/trace.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <unordered_map>
+#endif
+
+void SettleQueue::arm(const std::string &path, Clock::time_point now) {
+  std::error_code ec;
+  std::uintmax_t size = std::filesystem::file_size(path, ec);
+  if (!ec)
+    pending_[path] = {now + settle_, size};
+}
+
+std::vector<std::pair<std::string, std::uintmax_t>>
+SettleQueue::takeSettled(Clock::time_point now, Clock::time_point &next) {
+  std::vector<std::pair<std::string, std::uintmax_t>> settled;
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    if (it->second.deadline > now) {
+      next = std::min(next, it->second.deadline);
+      ++it;
+      continue;
+    }
+    std::error_code ec;
+    std::uintmax_t size = std::filesystem::file_size(it->first, ec);
+    if (ec) {
+      it = pending_.erase(it); // Removed or renamed away meanwhile
+      continue;
+    }
+    if (size != it->second.size) {
+      // Still growing without a new event (e.g. written through mmap)
+      it->second = {now + settle_, size};
+      next = std::min(next, it->second.deadline);
+      ++it;
+      continue;
+    }
+    settled.emplace_back(it->first, size);
+    it = pending_.erase(it);
+  }
+  return settled;
+}
+
+#ifndef __linux__
+
+int runWatch(const std::vector<std::string> & /*roots*/,
+             const std::string & /*outputFile*/,
+             const WatchOptions & /*options*/) {
+  std::cerr << "Error: --watch is not supported on this platform"
+            << std::endl;
+  return 1;
+}
+
+#else
+
+namespace {
+
+using Clock = SettleQueue::Clock;
+
+// Events that make a file a candidate, push back its deadline, or
+// add a subdirectory
+const std::uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MODIFY |
+                                 IN_CREATE | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+// Longest sleep between checks for a stop signal
+const int kPollMilliseconds = 500;
+
+std::atomic<bool> stopRequested{false};
+
+void onStopSignal(int) { stopRequested = true; }
+
+// Appends result lines to the streaming output; workers call this
+// concurrently
+class ResultLog {
+public:
+  bool open(const std::string &filename) {
+    output_.open(filename, std::ios::app);
+    return output_.is_open();
+  }
+
+  void write(const std::string &path, MediaKind kind,
+             const nlohmann::json &result) {
+    TraceSpan span("serialize", path);
+    nlohmann::json record = {
+        {"path", path},
+        {"kind", kind == MediaKind::Video ? "video" : "image"},
+        {"result", result}};
+    std::lock_guard<std::mutex> lock(mutex_);
+    output_ << record.dump() << '\n' << std::flush;
+  }
+
+private:
+  std::mutex mutex_;
+  std::ofstream output_;
+};
+
+// State of the watch loop
+class Watcher {
+public:
+  Watcher(int fd, const WatchOptions &options, ThreadPool &pool,
+          ResultLog &log)
+      : fd_(fd), options_(options), pool_(pool), log_(log),
+        pending_(std::chrono::milliseconds(
+            std::max(options.settleMilliseconds, 0))) {}
+
+  // Function to watch a directory and its subdirectories, optionally
+  // arming the files already in them
+  void addTree(const std::string &root, bool armFiles) {
+    addDirectory(root);
+    std::error_code ec;
+    auto options = std::filesystem::directory_options::skip_permission_denied;
+    std::filesystem::recursive_directory_iterator it(root, options, ec), end;
+    for (; !ec && it != end; it.increment(ec)) {
+      if (it->is_directory(ec) && !it->is_symlink(ec))
+        addDirectory(it->path().string());
+      else if (armFiles && it->is_regular_file(ec))
+        arm(it->path().string());
+    }
+  }
+
+  // Function to read and handle the events available on the inotify fd
+  void readEvents() {
+    alignas(inotify_event) char buffer[64 * 1024];
+    while (true) {
+      ssize_t length = ::read(fd_, buffer, sizeof(buffer));
+      if (length < 0 && errno == EINTR)
+        continue;
+      if (length <= 0)
+        return; // EAGAIN: drained
+      for (char *p = buffer; p < buffer + length;) {
+        auto *event = reinterpret_cast<inotify_event *>(p);
+        handleEvent(*event);
+        p += sizeof(inotify_event) + event->len;
+      }
+    }
+  }
+
+  // Function to dispatch every file whose settle time has passed, and
+  // return how long until the next deadline (capped)
+  int dispatchSettled() {
+    auto now = Clock::now();
+    auto next = now + std::chrono::milliseconds(kPollMilliseconds);
+    for (const auto &file : pending_.takeSettled(now, next))
+      dispatch(file.first, file.second);
+    auto wait =
+        std::chrono::duration_cast<std::chrono::milliseconds>(next - now);
+    return static_cast<int>(std::max<std::int64_t>(wait.count(), 0));
+  }
+
+private:
+  // Function to add one directory watch
+  void addDirectory(const std::string &path) {
+    int wd = ::inotify_add_watch(fd_, path.c_str(), kWatchMask);
+    if (wd < 0) {
+      std::cerr << "Warning: Could not watch directory: " << path << std::endl;
+      return;
+    }
+    directories_[wd] = path;
+  }
+
+  // Function to make a file a candidate, or restart its settle time
+  void arm(const std::string &path) {
+    // Without sniffing, only media extensions can ever be analyzed
+    if (!options_.sniff &&
+        classifyMediaFile(path, false) == MediaKind::Unknown)
+      return;
+    pending_.arm(path, Clock::now());
+  }
+
+  // Function to handle one inotify event
+  void handleEvent(const inotify_event &event) {
+    if (event.mask & IN_Q_OVERFLOW) {
+      std::cerr << "Warning: Watch event queue overflowed; files landing now "
+                   "may be missed"
+                << std::endl;
+      return;
+    }
+    auto directory = directories_.find(event.wd);
+    if (directory == directories_.end())
+      return;
+    if (event.mask & IN_IGNORED) {
+      directories_.erase(directory);
+      return;
+    }
+    if (event.len == 0)
+      return;
+    std::string path =
+        (std::filesystem::path(directory->second) / event.name).string();
+    if (event.mask & IN_ISDIR) {
+      // A moved-in tree brings files that produced no events of their own
+      if (event.mask & (IN_CREATE | IN_MOVED_TO))
+        addTree(path, true);
+    } else if (event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+      arm(path);
+    } else if ((event.mask & IN_MODIFY) && pending_.contains(path)) {
+      arm(path);
+    }
+  }
+
+  // Function to queue a settled file for analysis
+  void dispatch(const std::string &path, std::uintmax_t size) {
+    MediaKind kind = classifyMediaFile(path, options_.sniff);
+    if (kind == MediaKind::Unknown || size == 0)
+      return;
+    bool image = kind == MediaKind::Image;
+    std::cout << (image ? "Processing image: " : "Processing video: ")
+              << path << std::endl;
+    const ProcessOptions &process = options_.process;
+    ResultLog &log = log_;
+    pool_.submit([path, kind, image, &process, &log] {
+      // A throwing file is logged as failed instead of ending the watch
+      nlohmann::json result;
+      try {
+        result = image ? processImage(path, process)
+                       : processVideo(path, process);
+      } catch (const std::exception &e) {
+        std::cerr << "Error: Could not analyze " << path << ": " << e.what()
+                  << std::endl;
+        result = {{"filename", path}, {"error", e.what()}};
+      }
+      log.write(path, kind, result);
+    });
+  }
+
+  int fd_;
+  const WatchOptions &options_;
+  ThreadPool &pool_;
+  ResultLog &log_;
+  std::unordered_map<int, std::string> directories_;
+  SettleQueue pending_;
+};
+
+} // namespace
+
+int runWatch(const std::vector<std::string> &roots,
+             const std::string &outputFile, const WatchOptions &options) {
+  ResultLog log;
+  if (!log.open(outputFile)) {
+    std::cerr << "Error: Could not open output file: " << outputFile
+              << std::endl;
+    return 1;
+  }
+  int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    std::cerr << "Error: Could not initialize inotify" << std::endl;
+    return 1;
+  }
+
+  std::signal(SIGINT, onStopSignal);
+  std::signal(SIGTERM, onStopSignal);
+
+  // Workers come from the parallelism policy; the queue is unbounded so
+  // the event loop never waits for analysis
+  ParallelismPolicy policy = vidicant::getParallelismPolicy();
+  std::function<void(std::size_t)> onStart;
+  if (policy.pinThreads)
+    onStart = [](std::size_t worker) {
+      vidicant::pinCurrentThread(static_cast<int>(worker));
+    };
+  ThreadPool pool(static_cast<std::size_t>(policy.fileWorkers), 0, onStart);
+  Watcher watcher(fd, options, pool, log);
+
+  for (const auto &root : roots) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(root, ec)) {
+      std::cerr << "Error: Not a directory: " << root << std::endl;
+      ::close(fd);
+      return 1;
+    }
+    watcher.addTree(root, options.existing);
+    std::cout << "Watching directory: " << root << std::endl;
+  }
+  std::cout << "Appending results to: " << outputFile << std::endl;
+
+  while (!stopRequested) {
+    int timeout = watcher.dispatchSettled();
+    pollfd events{fd, POLLIN, 0};
+    if (::poll(&events, 1, timeout) > 0)
+      watcher.readEvents();
+  }
+
+  // Files still settling are dropped; queued ones finish and are logged
+  std::cout << "Shutting down" << std::endl;
+  ::close(fd);
+  pool.wait();
+  return 0;
+}
+
+#endif
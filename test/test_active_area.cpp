@@ -0,0 +1,75 @@
+#include "vidicant/active_area.hpp"
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+
+// Draws a picture of noise inside black bars.
+static cv::Mat makeBarredFrame(cv::Size size, cv::Rect picture, int type) {
+  cv::Mat frame(size, type, cv::Scalar::all(0));
+  cv::Mat noise(picture.size(), type);
+  cv::randu(noise, cv::Scalar::all(64), cv::Scalar::all(256));
+  cv::Mat view = frame(picture);
+  noise.copyTo(view);
+  return frame;
+}
+
+TEST(ActiveAreaTest, FindsLetterbox) {
+  cv::Rect picture(0, 60, 640, 360);
+  ActiveArea area = vidicant::detectActiveArea(
+      makeBarredFrame({640, 480}, picture, CV_8UC3));
+  EXPECT_EQ(area.rect, picture);
+  EXPECT_EQ(area.frameSize, cv::Size(640, 480));
+  EXPECT_TRUE(area.isCropped());
+}
+
+TEST(ActiveAreaTest, FindsPillarbox) {
+  cv::Rect picture(80, 0, 480, 480);
+  ActiveArea area = vidicant::detectActiveArea(
+      makeBarredFrame({640, 480}, picture, CV_8UC1));
+  EXPECT_EQ(area.rect, picture);
+}
+
+TEST(ActiveAreaTest, UnbarredAndDarkFramesKeepTheFullFrame) {
+  cv::Rect full(0, 0, 320, 240);
+  ActiveArea area =
+      vidicant::detectActiveArea(makeBarredFrame({320, 240}, full, CV_8UC3));
+  EXPECT_EQ(area.rect, full);
+  EXPECT_FALSE(area.isCropped());
+
+  cv::Mat dark(240, 320, CV_8UC3, cv::Scalar::all(10));
+  EXPECT_EQ(vidicant::detectActiveArea(dark).rect, full);
+}
+
+TEST(ActiveAreaTest, UnevenBarsCropTheNarrowerWidth) {
+  // A subtitle line lights the bottom bar
+  cv::Mat frame = makeBarredFrame({640, 480}, {0, 60, 640, 360}, CV_8UC3);
+  frame(cv::Rect(0, 440, 640, 8)).setTo(cv::Scalar::all(255));
+  ActiveArea area = vidicant::detectActiveArea(frame);
+  EXPECT_EQ(area.rect, cv::Rect(0, 32, 640, 416));
+}
+
+TEST(ActiveAreaTest, DetectorKeepsTheUnionOfFrames) {
+  ActiveAreaDetector detector;
+  detector.addFrame(makeBarredFrame({640, 480}, {0, 60, 640, 360}, CV_8UC3));
+  detector.addFrame(cv::Mat(480, 640, CV_8UC3, cv::Scalar::all(0)));
+  detector.addFrame(makeBarredFrame({640, 480}, {0, 40, 640, 400}, CV_8UC3));
+  EXPECT_EQ(detector.getFrameCount(), 2);
+  EXPECT_EQ(detector.getArea().rect, cv::Rect(0, 40, 640, 400));
+
+  ActiveAreaDetector empty;
+  EXPECT_EQ(empty.getArea().rect, cv::Rect());
+}
+
+TEST(ActiveAreaTest, ThresholdIsOnTheEightBitScale) {
+  cv::Rect picture(0, 60, 640, 360);
+  cv::Mat narrow = makeBarredFrame({640, 480}, picture, CV_8UC3);
+  cv::Mat wide;
+  narrow.convertTo(wide, CV_16U, 257.0);
+  EXPECT_EQ(vidicant::detectActiveArea(wide).rect, picture);
+
+  // Gray bars at 16 are dark by default but not under a lower threshold
+  wide(cv::Rect(0, 0, 640, 60)).setTo(cv::Scalar::all(16 * 257));
+  wide(cv::Rect(0, 420, 640, 60)).setTo(cv::Scalar::all(16 * 257));
+  EXPECT_EQ(vidicant::detectActiveArea(wide).rect, picture);
+  EXPECT_EQ(vidicant::detectActiveArea(wide, 8.0).rect,
+            cv::Rect(0, 0, 640, 480));
+}
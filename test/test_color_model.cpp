@@ -0,0 +1,105 @@
+#include "vidicant/color_model.hpp"
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+#include <thread>
+
+TEST(ColorModelTest, EmptyModelHasNoPalette) {
+  ColorHistogramModel model;
+  EXPECT_EQ(model.getSampleCount(), 0u);
+  EXPECT_TRUE(model.getPalette(3).empty());
+}
+
+TEST(ColorModelTest, PaletteIsHeaviestFirstWithExactMeans) {
+  ColorHistogramModel model;
+  model.addColor({10, 200, 30}, 1);
+  model.addColor({240, 5, 100}, 3);
+  auto palette = model.getPalette(3); // Only two occupied bins
+  ASSERT_EQ(palette.size(), 2u);
+  EXPECT_DOUBLE_EQ(palette[0].color[0], 240.0);
+  EXPECT_DOUBLE_EQ(palette[0].color[1], 5.0);
+  EXPECT_DOUBLE_EQ(palette[0].color[2], 100.0);
+  EXPECT_DOUBLE_EQ(palette[0].weight, 0.75);
+  EXPECT_DOUBLE_EQ(palette[1].color[1], 200.0);
+  EXPECT_DOUBLE_EQ(palette[1].weight, 0.25);
+}
+
+TEST(ColorModelTest, NearbyColorsShareACluster) {
+  ColorHistogramModel model;
+  model.addColor({250, 0, 0}, 100);
+  model.addColor({230, 20, 10}, 100);
+  model.addColor({0, 0, 250}, 50);
+  auto palette = model.getPalette(2);
+  ASSERT_EQ(palette.size(), 2u);
+  EXPECT_DOUBLE_EQ(palette[0].color[0], 240.0);
+  EXPECT_DOUBLE_EQ(palette[0].color[1], 10.0);
+  EXPECT_DOUBLE_EQ(palette[0].weight, 0.8);
+  EXPECT_DOUBLE_EQ(palette[1].color[2], 250.0);
+}
+
+TEST(ColorModelTest, AddFrameSamplesWithStride) {
+  ColorHistogramModel model;
+  cv::Mat frame(4, 6, CV_8UC3, cv::Scalar(10, 20, 200));
+  model.addFrame(frame, 2);
+  EXPECT_EQ(model.getSampleCount(), 6u); // 2 rows x 3 columns
+
+  cv::Mat gray(2, 2, CV_8UC1, cv::Scalar(90));
+  model.addFrame(gray);
+  auto palette = model.getPalette(2);
+  ASSERT_EQ(palette.size(), 2u);
+  EXPECT_DOUBLE_EQ(palette[0].color[2], 200.0);
+  EXPECT_DOUBLE_EQ(palette[1].color[0], 90.0);
+  EXPECT_DOUBLE_EQ(palette[1].color[1], 90.0);
+  EXPECT_DOUBLE_EQ(palette[1].color[2], 90.0);
+
+  cv::Mat floats(2, 2, CV_32FC3, cv::Scalar(1, 1, 1));
+  model.addFrame(floats); // Ignored: not 8-bit
+  EXPECT_EQ(model.getSampleCount(), 10u);
+}
+
+TEST(ColorModelTest, MergeMatchesSingleModelAndClearResets) {
+  ColorHistogramModel first;
+  ColorHistogramModel second;
+  ColorHistogramModel combined;
+  first.addColor({1, 2, 3}, 5);
+  second.addColor({200, 100, 50}, 7);
+  combined.addColor({1, 2, 3}, 5);
+  combined.addColor({200, 100, 50}, 7);
+  first.merge(second);
+  EXPECT_EQ(first.getSampleCount(), combined.getSampleCount());
+  auto merged = first.getPalette(2);
+  auto expected = combined.getPalette(2);
+  ASSERT_EQ(merged.size(), expected.size());
+  for (std::size_t i = 0; i < merged.size(); ++i) {
+    EXPECT_EQ(merged[i].color, expected[i].color);
+    EXPECT_DOUBLE_EQ(merged[i].weight, expected[i].weight);
+  }
+
+  first.clear();
+  EXPECT_EQ(first.getSampleCount(), 0u);
+  EXPECT_TRUE(first.getPalette(2).empty());
+}
+
+TEST(ColorModelTest, ClusteringStopsAtTheDeadline) {
+  cv::Mat samples(200, 3, CV_32F);
+  for (int i = 0; i < samples.rows; ++i) {
+    float value = i < 100 ? 20.0f : 220.0f;
+    samples.row(i).setTo(cv::Scalar::all(value + i % 5));
+  }
+  auto unbounded = vidicant::clusterColors(samples, 2);
+  auto bounded = vidicant::clusterColors(samples, 2, Deadline(60.0));
+  ASSERT_EQ(unbounded.size(), 2u);
+  ASSERT_EQ(bounded.size(), 2u);
+  std::sort(unbounded.begin(), unbounded.end());
+  std::sort(bounded.begin(), bounded.end());
+  for (std::size_t i = 0; i < 2; ++i)
+    EXPECT_NEAR(bounded[i][0], unbounded[i][0], 1e-3);
+
+  // An expired deadline still gives the centers of a first iteration
+  Deadline expired(1e-6);
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  auto seeded = vidicant::clusterColors(samples, 2, expired);
+  ASSERT_EQ(seeded.size(), 2u);
+  EXPECT_TRUE(vidicant::clusterColors(samples.rowRange(0, 1), 2).empty());
+}
@@ -0,0 +1,76 @@
+#include "controller.hpp"
+#include <filesystem>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+std::string tempPath(const std::string &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Saves one second of dark frames followed by one of bright ones, cut
+// between them, at 10 frames per second.
+std::string saveSeries() {
+  FrameSeries series(10.0);
+  for (int i = 0; i < 20; ++i) {
+    FrameSample sample;
+    sample.frame = i;
+    sample.brightness = i < 10 ? 5.0f : 100.0f;
+    sample.meanDiff = i == 10 ? 50.0f : i > 0 ? 2.0f : 0.0f;
+    series.add(sample);
+  }
+  std::string path = tempPath("vidicant_controller_series.bin");
+  series.writeBinary(path);
+  return path;
+}
+
+} // namespace
+
+TEST(ControllerTest, RetunesASavedSeriesWithoutItsVideo) {
+  std::string path = saveSeries();
+  ProcessOptions options;
+  options.seriesWindow = 5;
+  options.sceneThresholds = {20.0, 60.0};
+  nlohmann::json result = processSeries(path, options);
+
+  EXPECT_EQ(result["frame_count"], 20);
+  EXPECT_DOUBLE_EQ(result["fps"].get<double>(), 10.0);
+  EXPECT_EQ(result["series_windows"].size(), 4u);
+  ASSERT_EQ(result["scene_thresholds"].size(), 2u);
+  EXPECT_EQ(result["scene_thresholds"][0]["scene_changes"],
+            nlohmann::json::array({10}));
+  EXPECT_TRUE(result["scene_thresholds"][1]["scene_changes"].empty());
+  EXPECT_FALSE(result.contains("series_path")); // Not written again
+  ASSERT_EQ(result["qc_events"].size(), 1u);
+  EXPECT_EQ(result["qc_events"][0]["type"], "black");
+  EXPECT_EQ(result["qc_events"][0]["end_frame"], 10);
+
+  // A lower black threshold no longer counts the dark frames
+  options.qc.blackBrightness = 4.0;
+  EXPECT_TRUE(processSeries(path, options)["qc_events"].empty());
+  std::filesystem::remove(path);
+
+  EXPECT_EQ(processSeries(tempPath("vidicant_missing_series.bin"))["error"],
+            "Failed to read series");
+}
+
+TEST(ControllerTest, ChecksOptionRanges) {
+  EXPECT_EQ(checkProcessOptions({}), "");
+  ProcessOptions options;
+  options.histogramBins = 0;
+  EXPECT_EQ(checkProcessOptions(options), "Invalid histogram bins: 0");
+  options = {};
+  options.qc.freezeDiff = -1.0;
+  EXPECT_EQ(checkProcessOptions(options), "Invalid QC freeze threshold: -1");
+  options = {};
+  options.tiled = true;
+  options.histogramBins = 16;
+  EXPECT_EQ(checkProcessOptions(options), "");
+  options.cropBars = true;
+  EXPECT_THAT(checkProcessOptions(options), ::testing::HasSubstr("tiled"));
+  options.cropBars = false;
+  options.jpegDct = true;
+  EXPECT_THAT(checkProcessOptions(options), ::testing::HasSubstr("tiled"));
+}
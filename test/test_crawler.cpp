@@ -0,0 +1,172 @@
+#include "crawler.hpp"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Gives each test an empty directory.
+class CrawlerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    directory_ =
+        std::filesystem::path(testing::TempDir()) / "vidicant_crawler_test";
+    std::filesystem::remove_all(directory_);
+    std::filesystem::create_directories(directory_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory_); }
+
+  // Writes a file, creating its directories, and returns its path.
+  std::string write(const std::string &name, const std::string &contents) {
+    std::filesystem::path path = directory_ / name;
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::binary) << contents;
+    return path.string();
+  }
+
+  // Reads the lines of a file.
+  static std::vector<std::string> lines(const std::string &path) {
+    std::ifstream input(path);
+    std::vector<std::string> result;
+    std::string line;
+    while (std::getline(input, line))
+      result.push_back(line);
+    return result;
+  }
+
+  std::filesystem::path directory_;
+};
+
+} // namespace
+
+TEST_F(CrawlerTest, SniffsMagicBytes) {
+  EXPECT_EQ(sniffMediaKind(write("a", std::string("\xFF\xD8\xFF\xE0", 4) +
+                                          std::string(12, '\0'))),
+            MediaKind::Image);
+  EXPECT_EQ(sniffMediaKind(write("b", "\x89PNG\r\n\x1a\n")), MediaKind::Image);
+  EXPECT_EQ(sniffMediaKind(write("c", std::string("II*\0", 4))),
+            MediaKind::Image);
+  EXPECT_EQ(sniffMediaKind(write("d", std::string("RIFF\x10\0\0\0", 8) +
+                                          "WEBPVP8 ")),
+            MediaKind::Image);
+  EXPECT_EQ(sniffMediaKind(write("e", std::string("\0\0\0\x18", 4) +
+                                          "ftypmp42")),
+            MediaKind::Video);
+  EXPECT_EQ(sniffMediaKind(write("f", "\x1A\x45\xDF\xA3")), MediaKind::Video);
+  EXPECT_EQ(sniffMediaKind(write("g", std::string("RIFF\x10\0\0\0", 8) +
+                                          "AVI LIST")),
+            MediaKind::Video);
+  EXPECT_EQ(sniffMediaKind(write("h", "just some text")), MediaKind::Unknown);
+  EXPECT_EQ(sniffMediaKind(write("i", "BM")), MediaKind::Unknown); // Short
+  EXPECT_EQ(sniffMediaKind((directory_ / "missing").string()),
+            MediaKind::Unknown);
+}
+
+TEST_F(CrawlerTest, SniffingOverridesExtensions) {
+  std::string jpeg = std::string("\xFF\xD8\xFF\xE0", 4) + std::string(12, 0);
+  std::string renamed = write("photo.dat", jpeg);
+  std::string fake = write("notes.jpg", "not an image at all");
+
+  EXPECT_EQ(classifyMediaFile(renamed, false), MediaKind::Unknown);
+  EXPECT_EQ(classifyMediaFile(renamed, true), MediaKind::Image);
+  EXPECT_EQ(classifyMediaFile(fake, false), MediaKind::Image);
+  EXPECT_EQ(classifyMediaFile(fake, true), MediaKind::Unknown);
+}
+
+TEST_F(CrawlerTest, WalkFindsNestedMedia) {
+  write("top.jpg", "1");
+  write("a/b/c/deep.mp4", "12");
+  write("a/b/middle.mkv", "123");
+  write("a/readme.txt", "text");
+  write("d/e/empty/.keep", "");
+
+  CrawlOptions options;
+  options.threads = 4;
+  auto entries = crawlDirectory(directory_.string(), options);
+
+  ASSERT_EQ(entries.size(), 3u);
+  EXPECT_EQ(entries[0].path, (directory_ / "a/b/c/deep.mp4").string());
+  EXPECT_EQ(entries[0].kind, MediaKind::Video);
+  EXPECT_EQ(entries[0].size, 2u);
+  EXPECT_EQ(entries[1].path, (directory_ / "a/b/middle.mkv").string());
+  EXPECT_EQ(entries[1].kind, MediaKind::Video);
+  EXPECT_EQ(entries[2].path, (directory_ / "top.jpg").string());
+  EXPECT_EQ(entries[2].kind, MediaKind::Image);
+  EXPECT_EQ(entries[2].size, 1u);
+}
+
+TEST_F(CrawlerTest, ReadsInputLists) {
+  std::istringstream input("a.jpg\n\n# comment\nb.mp4\r\n");
+  EXPECT_EQ(readInputList(input), (std::vector<std::string>{"a.jpg", "b.mp4"}));
+}
+
+TEST_F(CrawlerTest, ResumeSkipsDoneFilesAndATruncatedLine) {
+  std::string manifest = write(
+      "checkpoint.ndjson",
+      R"({"path":"a.jpg","kind":"image","result":{"filename":"a.jpg"}})"
+      "\n"
+      R"({"path":"b.mp4","kind":"video","result":{"filename":"b.mp4"}})"
+      "\n"
+      R"({"path":"c.jpg","kind":"image","res)");
+
+  Checkpoint checkpoint;
+  ASSERT_TRUE(checkpoint.open(manifest, true));
+  EXPECT_TRUE(checkpoint.isDone("a.jpg"));
+  EXPECT_TRUE(checkpoint.isDone("b.mp4"));
+  EXPECT_FALSE(checkpoint.isDone("c.jpg"));
+  const auto &resumed = checkpoint.getResumedResults();
+  ASSERT_EQ(resumed["images"].size(), 1u);
+  EXPECT_EQ(resumed["images"][0]["filename"], "a.jpg");
+  ASSERT_EQ(resumed["videos"].size(), 1u);
+  EXPECT_EQ(resumed["videos"][0]["filename"], "b.mp4");
+
+  // The next record starts on a line of its own, so a second resume
+  // reads it
+  checkpoint.record("c.jpg", MediaKind::Image, {{"filename", "c.jpg"}});
+  EXPECT_TRUE(checkpoint.isDone("c.jpg"));
+  auto written = lines(manifest);
+  ASSERT_EQ(written.size(), 4u);
+  EXPECT_EQ(nlohmann::json::parse(written[3])["path"], "c.jpg");
+
+  Checkpoint again;
+  ASSERT_TRUE(again.open(manifest, true));
+  EXPECT_TRUE(again.isDone("c.jpg"));
+  EXPECT_EQ(again.getResumedResults()["images"].size(), 2u);
+}
+
+TEST_F(CrawlerTest, FreshRunTruncatesTheManifest) {
+  std::string manifest = write(
+      "checkpoint.ndjson",
+      R"({"path":"a.jpg","kind":"image","result":{}})"
+      "\n");
+
+  Checkpoint checkpoint;
+  ASSERT_TRUE(checkpoint.open(manifest, false));
+  EXPECT_FALSE(checkpoint.isDone("a.jpg"));
+  EXPECT_TRUE(lines(manifest).empty());
+}
+
+TEST_F(CrawlerTest, ShardedManifestStartsWithItsShard) {
+  std::string manifest = write("checkpoint.ndjson", "");
+  Shard shard{2, 5};
+
+  Checkpoint checkpoint;
+  ASSERT_TRUE(checkpoint.open(manifest, false, &shard));
+  auto written = lines(manifest);
+  ASSERT_EQ(written.size(), 1u); // Even before any file is recorded
+  nlohmann::json header = nlohmann::json::parse(written[0]);
+  EXPECT_EQ(header["shard"]["index"], 2);
+  EXPECT_EQ(header["shard"]["count"], 5);
+
+  // Resuming reads past the shard line and does not write it again
+  checkpoint.record("a.jpg", MediaKind::Image, {{"filename", "a.jpg"}});
+  Checkpoint again;
+  ASSERT_TRUE(again.open(manifest, true, &shard));
+  EXPECT_TRUE(again.isDone("a.jpg"));
+  EXPECT_EQ(again.getResumedResults()["images"].size(), 1u);
+  EXPECT_EQ(lines(manifest).size(), 2u);
+}
@@ -0,0 +1,41 @@
+#include "vidicant/deadline.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+
+TEST(DeadlineTest, UnsetDeadlineNeverPasses) {
+  Deadline none;
+  EXPECT_FALSE(none.isSet());
+  EXPECT_FALSE(none.expired());
+  Deadline zero(0.0);
+  EXPECT_FALSE(zero.isSet());
+  EXPECT_FALSE(zero.expired());
+}
+
+TEST(DeadlineTest, PassesAfterTheBudget) {
+  Deadline shortBudget(0.001);
+  EXPECT_TRUE(shortBudget.isSet());
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_TRUE(shortBudget.expired());
+
+  Deadline longBudget(3600.0);
+  EXPECT_FALSE(longBudget.expired());
+  EXPECT_FALSE(Deadline(1e300).expired());
+}
+
+TEST(DeadlineTest, ParsesDurations) {
+  double seconds = -1.0;
+  EXPECT_TRUE(vidicant::parseDuration("2s", seconds));
+  EXPECT_DOUBLE_EQ(seconds, 2.0);
+  EXPECT_TRUE(vidicant::parseDuration("3", seconds));
+  EXPECT_DOUBLE_EQ(seconds, 3.0);
+  EXPECT_TRUE(vidicant::parseDuration("250ms", seconds));
+  EXPECT_DOUBLE_EQ(seconds, 0.25);
+  EXPECT_TRUE(vidicant::parseDuration("1.5m", seconds));
+  EXPECT_DOUBLE_EQ(seconds, 90.0);
+
+  EXPECT_FALSE(vidicant::parseDuration("", seconds));
+  EXPECT_FALSE(vidicant::parseDuration("s", seconds));
+  EXPECT_FALSE(vidicant::parseDuration("-1s", seconds));
+  EXPECT_FALSE(vidicant::parseDuration("2h", seconds));
+  EXPECT_DOUBLE_EQ(seconds, 90.0);
+}
@@ -0,0 +1,177 @@
+#include "vidicant/frame_series.hpp"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+// Builds a series whose frame differences are given and whose other
+// measurements are derived from the frame index.
+FrameSeries makeSeries(const std::vector<float> &diffs, double fps = 25.0) {
+  FrameSeries series(fps);
+  for (std::size_t i = 0; i < diffs.size(); ++i) {
+    FrameSample sample;
+    sample.frame = static_cast<int>(i);
+    sample.brightness = static_cast<float>(i);
+    sample.meanDiff = diffs[i];
+    sample.histogramDistance = diffs[i] / 100.0f;
+    sample.saturation = 2.0f * static_cast<float>(i);
+    series.add(sample);
+  }
+  return series;
+}
+
+std::string tempPath(const std::string &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+} // namespace
+
+TEST(FrameSeriesTest, SceneChangesForSeveralThresholdsInOneScan) {
+  FrameSeries series = makeSeries({0, 10, 50, 5, 35, 80});
+  auto changes = series.detectSceneChanges(std::vector<double>{30, 60, 100});
+  ASSERT_EQ(changes.size(), 3u);
+  EXPECT_EQ(changes[0], (std::vector<int>{2, 4, 5}));
+  EXPECT_EQ(changes[1], (std::vector<int>{5}));
+  EXPECT_TRUE(changes[2].empty());
+  EXPECT_EQ(series.detectSceneChanges(30.0), changes[0]);
+}
+
+TEST(FrameSeriesTest, SceneChangesStopAtMaxFrame) {
+  FrameSeries series = makeSeries({0, 50, 50, 50});
+  EXPECT_EQ(series.detectSceneChanges(30.0, 2), (std::vector<int>{1, 2}));
+}
+
+TEST(FrameSeriesTest, SummarizesWindowsWithShortLastWindow) {
+  FrameSeries series = makeSeries({0, 10, 20, 30, 40});
+  auto windows = series.summarize(2);
+  ASSERT_EQ(windows.size(), 3u);
+  EXPECT_EQ(windows[0].startFrame, 0);
+  EXPECT_EQ(windows[0].endFrame, 2);
+  EXPECT_DOUBLE_EQ(windows[0].meanDiff, 5.0);
+  EXPECT_DOUBLE_EQ(windows[1].maxDiff, 30.0);
+  EXPECT_DOUBLE_EQ(windows[1].brightness, 2.5);
+  EXPECT_DOUBLE_EQ(windows[1].saturation, 5.0);
+  EXPECT_EQ(windows[2].startFrame, 4);
+  EXPECT_EQ(windows[2].endFrame, 5);
+  EXPECT_NEAR(windows[2].maxHistogramDistance, 0.4, 1e-6);
+  EXPECT_TRUE(series.summarize(0).empty());
+}
+
+TEST(FrameSeriesTest, BinaryRoundTrip) {
+  FrameSeries series = makeSeries({0, 12.5f, 40, 3.25f}, 29.97);
+  std::string path = tempPath("vidicant_series_test.bin");
+  ASSERT_TRUE(series.writeBinary(path));
+  EXPECT_EQ(std::filesystem::file_size(path), 16u + 4u * 20u);
+
+  FrameSeries loaded;
+  ASSERT_TRUE(loaded.readBinary(path));
+  EXPECT_DOUBLE_EQ(loaded.getFPS(), 29.97);
+  ASSERT_EQ(loaded.size(), series.size());
+  for (std::size_t i = 0; i < series.size(); ++i) {
+    EXPECT_EQ(loaded.getSamples()[i].frame, series.getSamples()[i].frame);
+    EXPECT_EQ(loaded.getSamples()[i].meanDiff,
+              series.getSamples()[i].meanDiff);
+    EXPECT_EQ(loaded.getSamples()[i].histogramDistance,
+              series.getSamples()[i].histogramDistance);
+  }
+
+  // A truncated file is rejected and leaves the series untouched
+  std::filesystem::resize_file(path, 16 + 20 + 10);
+  EXPECT_FALSE(loaded.readBinary(path));
+  EXPECT_EQ(loaded.size(), series.size());
+  std::filesystem::remove(path);
+}
+
+TEST(FrameSeriesTest, WritesCsvWithTimestamps) {
+  FrameSeries series = makeSeries({0, 10}, 2.0);
+  std::string path = tempPath("vidicant_series_test.csv");
+  ASSERT_TRUE(series.writeCsv(path));
+  std::ifstream input(path);
+  std::string header, first, second;
+  std::getline(input, header);
+  std::getline(input, first);
+  std::getline(input, second);
+  EXPECT_EQ(header,
+            "frame,time,brightness,mean_diff,histogram_distance,saturation");
+  EXPECT_EQ(first, "0,0,0,0,0,0");
+  EXPECT_EQ(second, "1,0.5,1,10,0.1,2");
+  std::filesystem::remove(path);
+}
+
+TEST(FrameSeriesTest, QcEventsFindBlackFrozenAndFlashRanges) {
+  // 10 fps: black needs 5 frames, a freeze 20 and a flash ends within 3
+  FrameSeries series(10.0);
+  auto addFrames = [&series](int count, float brightness, float diff) {
+    for (int i = 0; i < count; ++i) {
+      FrameSample sample;
+      sample.frame = static_cast<int>(series.size());
+      sample.brightness = brightness;
+      sample.meanDiff = sample.frame == 0 ? 0.0f : diff;
+      series.add(sample);
+    }
+  };
+  addFrames(6, 5.0f, 0.0f);    // 0-5: black
+  addFrames(1, 100.0f, 50.0f); // 6: cut
+  addFrames(1, 100.0f, 1.0f);  // 7
+  addFrames(22, 100.0f, 0.1f); // 8-29: repeats of frame 7
+  addFrames(1, 200.0f, 80.0f); // 30: flash
+  addFrames(1, 100.0f, 80.0f); // 31
+  addFrames(2, 3.0f, 60.0f);   // 32-33: too short to report as black
+  addFrames(6, 180.0f, 50.0f); // 34-39: a brighter scene, not a flash
+
+  auto events = series.detectQcEvents();
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0].type, QcEventType::Black);
+  EXPECT_EQ(events[0].startFrame, 0);
+  EXPECT_EQ(events[0].endFrame, 6);
+  EXPECT_EQ(events[1].type, QcEventType::Freeze);
+  EXPECT_EQ(events[1].startFrame, 7);
+  EXPECT_EQ(events[1].endFrame, 30);
+  EXPECT_EQ(events[2].type, QcEventType::Flash);
+  EXPECT_EQ(events[2].startFrame, 30);
+  EXPECT_EQ(events[2].endFrame, 31);
+
+  QcOptions options;
+  options.blackMinSeconds = 0.2;
+  events = series.detectQcEvents(options);
+  ASSERT_EQ(events.size(), 4u);
+  EXPECT_EQ(events[3].type, QcEventType::Black);
+  EXPECT_EQ(events[3].startFrame, 32);
+  EXPECT_EQ(events[3].endFrame, 34);
+}
+
+TEST(FrameSeriesTest, QcRangesCloseAtTheEndOfTheSeries) {
+  FrameSeries series = makeSeries(std::vector<float>(30, 0.0f), 10.0);
+  auto events = series.detectQcEvents();
+  // Brightness is the frame index: frames 0-10 are black
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0].type, QcEventType::Black);
+  EXPECT_EQ(events[0].endFrame, 11);
+  EXPECT_EQ(events[1].type, QcEventType::Freeze);
+  EXPECT_EQ(events[1].startFrame, 0);
+  EXPECT_EQ(events[1].endFrame, 30);
+  EXPECT_TRUE(FrameSeries().detectQcEvents().empty());
+}
+
+TEST(FrameSeriesTest, OpeningFrameScoresMatchTheVideoPasses) {
+  // Brightness is the frame index, so the means are easy to check
+  FrameSeries series = makeSeries(std::vector<float>(200, 4.0f));
+  EXPECT_DOUBLE_EQ(series.getAverageBrightness(), 50.0); // Frames 0-100
+  EXPECT_DOUBLE_EQ(series.getMotionScore(), 4.0);
+  // Frames 0-49: mean 24.5, population deviation sqrt((50^2 - 1) / 12)
+  EXPECT_NEAR(series.getColorConsistency(), std::sqrt(2499.0 / 12) / 24.5,
+              1e-12);
+
+  FrameSeries single = makeSeries({0});
+  EXPECT_DOUBLE_EQ(single.getAverageBrightness(), 0.0);
+  EXPECT_DOUBLE_EQ(single.getMotionScore(), 0.0);
+  EXPECT_DOUBLE_EQ(single.getColorConsistency(), 0.0);
+
+  FrameSeries empty;
+  EXPECT_DOUBLE_EQ(empty.getAverageBrightness(), -1.0);
+  EXPECT_DOUBLE_EQ(empty.getMotionScore(), 0.0);
+  EXPECT_DOUBLE_EQ(empty.getColorConsistency(), -1.0);
+}
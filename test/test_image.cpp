@@ -226,4 +226,26 @@ TEST(ImageGlobalTest, GetImageEntropyReal) {
       vidicant::getImageEntropy("/workspaces/vidicant/examples/sample.jpg");
   EXPECT_GE(entropy, 0.0);
   EXPECT_LE(entropy, 8.0);
-}
\ No newline at end of file
+}
+
+TEST(MemoryImageLoaderTest, DecodesEncodedBytes) {
+  cv::Mat image(40, 60, CV_8UC3, cv::Scalar(10, 120, 240));
+  std::vector<unsigned char> bytes;
+  ASSERT_TRUE(cv::imencode(".png", image, bytes));
+
+  ImageHandler handler(std::make_unique<MemoryImageLoader>(bytes));
+  auto dims = handler.getDimensions("ignored");
+  EXPECT_EQ(dims.first, 60);
+  EXPECT_EQ(dims.second, 40);
+  EXPECT_EQ(handler.getNumberOfChannels("ignored"), 3);
+  EXPECT_NEAR(handler.getAverageBrightness("ignored"), (10 + 120 + 240) / 3.0,
+              1e-6);
+}
+
+TEST(MemoryImageLoaderTest, InvalidBytes) {
+  std::vector<unsigned char> bytes = {'n', 'o', 't', ' ', 'a', 'n'};
+  ImageHandler handler(std::make_unique<MemoryImageLoader>(bytes));
+  auto dims = handler.getDimensions("ignored");
+  EXPECT_EQ(dims.first, -1);
+  EXPECT_EQ(dims.second, -1);
+}
@@ -0,0 +1,89 @@
+#include "vidicant/image_sequence.hpp"
+#include "vidicant/video.hpp"
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+
+namespace {
+
+// Writes a numbered PNG sequence whose brightness jumps halfway through.
+class ImageSequenceTest : public ::testing::Test {
+protected:
+  static constexpr int kFrames = 37;
+
+  void SetUp() override {
+    directory_ = std::filesystem::path(testing::TempDir()) /
+                 "vidicant_image_sequence_test";
+    std::filesystem::create_directories(directory_);
+    pattern_ = (directory_ / "frame_%04d.png").string();
+    for (int i = 0; i < kFrames; ++i) {
+      int level = i < kFrames / 2 ? 20 + i : 200;
+      cv::Mat frame(24, 32, CV_8UC3, cv::Scalar(level, level, level));
+      // Numbering starts at 1, like most exporters
+      cv::imwrite(vidicant::formatSequencePath(pattern_, i + 1), frame);
+    }
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory_); }
+
+  std::filesystem::path directory_;
+  std::string pattern_;
+};
+
+} // namespace
+
+TEST(ImageSequencePatternTest, RecognizesPatterns) {
+  EXPECT_TRUE(vidicant::isImageSequence("shots/frame_%05d.png"));
+  EXPECT_TRUE(vidicant::isImageSequence("%d.JPG"));
+  EXPECT_FALSE(vidicant::isImageSequence("shots/frame.png"));
+  EXPECT_FALSE(vidicant::isImageSequence("clip_%05d.mp4"));
+  EXPECT_FALSE(vidicant::isImageSequence("%s_%d.png"));
+  EXPECT_FALSE(vidicant::isImageSequence("100%.png"));
+  EXPECT_FALSE(vidicant::isImageSequence("a_%d_%d.png"));
+}
+
+TEST(ImageSequencePatternTest, FormatsFramePaths) {
+  EXPECT_EQ(vidicant::formatSequencePath("f_%05d.png", 42), "f_00042.png");
+  EXPECT_EQ(vidicant::formatSequencePath("%d.png", 7), "7.png");
+  EXPECT_EQ(vidicant::formatSequencePath("f_%02d.png", 123), "f_123.png");
+}
+
+TEST_F(ImageSequenceTest, StreamsFramesInOrder) {
+  ImageSequenceLoader loader(30.0, 3);
+  ASSERT_TRUE(loader.open(pattern_));
+  EXPECT_EQ(loader.getFrameCount(), kFrames);
+  EXPECT_DOUBLE_EQ(loader.getFPS(), 30.0);
+  EXPECT_EQ(loader.getResolution(), std::make_pair(32, 24));
+
+  cv::Mat frame;
+  for (int i = 0; i < kFrames; ++i) {
+    if (i == 5) {
+      EXPECT_TRUE(loader.skipFrame());
+      continue;
+    }
+    ASSERT_TRUE(loader.readFrame(frame)) << "frame " << i;
+    int level = i < kFrames / 2 ? 20 + i : 200;
+    EXPECT_EQ(frame.at<cv::Vec3b>(0, 0)[0], level) << "frame " << i;
+  }
+  EXPECT_FALSE(loader.readFrame(frame));
+}
+
+TEST_F(ImageSequenceTest, RunsThroughTheVideoPipeline) {
+  EXPECT_EQ(vidicant::getVideoFrameCount(pattern_), kFrames);
+  std::vector<int> changes = vidicant::detectVideoSceneChanges(pattern_);
+  ASSERT_EQ(changes.size(), 1u);
+  EXPECT_EQ(changes[0], kFrames / 2);
+  EXPECT_GT(vidicant::getVideoMotionScore(pattern_), 0.0);
+}
+
+TEST_F(ImageSequenceTest, OpenFailsWithoutFirstFrame) {
+  ImageSequenceLoader loader;
+  EXPECT_FALSE(loader.open((directory_ / "missing_%04d.png").string()));
+  EXPECT_FALSE(loader.open((directory_ / "frame_0001.png").string()));
+}
+
+TEST(AnimatedImageTest, StillImagesAreNotAnimated) {
+  EXPECT_FALSE(
+      vidicant::isAnimatedImage("/workspaces/vidicant/examples/sample.jpg"));
+  EXPECT_FALSE(vidicant::isAnimatedImage("nonexistent_animation.gif"));
+}
@@ -0,0 +1,103 @@
+#include "vidicant/image.hpp"
+#include "vidicant/jpeg_dct.hpp"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+
+namespace {
+
+std::string tempPath(const std::string &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Squares that do not line up with the 8x8 blocks, with a ripple on top;
+// every value stays within 20-210
+cv::Mat makeTexture(int channels) {
+  cv::Mat image(120, 160, CV_8UC(channels));
+  for (int y = 0; y < image.rows; ++y) {
+    for (int x = 0; x < image.cols; ++x) {
+      for (int c = 0; c < channels; ++c) {
+        double value = ((x / 12 + y / 12) % 2 ? 170.0 : 60.0) +
+                       40.0 * std::sin(x * 0.3 + c) * std::cos(y * 0.2);
+        image.ptr<uchar>(y)[x * channels + c] =
+            static_cast<uchar>(std::lround(value));
+      }
+    }
+  }
+  return image;
+}
+
+} // namespace
+
+TEST(JpegDctTest, AgreesWithPixelMetrics) {
+  for (int channels : {1, 3}) {
+    std::string path = tempPath("vidicant_dct_" + std::to_string(channels) +
+                                ".jpg");
+    ASSERT_TRUE(cv::imwrite(path, makeTexture(channels)));
+    JpegDctStats stats;
+    if (!vidicant::analyzeJpegDct(path, stats)) {
+      std::filesystem::remove(path);
+      GTEST_SKIP() << "built without libjpeg";
+    }
+    ImageHandler handler(std::make_unique<OpenCVImageLoader>());
+
+    EXPECT_EQ(stats.width, 160);
+    EXPECT_EQ(stats.height, 120);
+    EXPECT_EQ(stats.channels, handler.getNumberOfChannels(path));
+    EXPECT_NEAR(stats.averageBrightness, handler.getAverageBrightness(path),
+                0.5);
+    double blur = handler.getBlurScore(path);
+    EXPECT_NEAR(stats.blurScore, blur, blur * 0.1);
+    // Block means span less than the pixels do
+    EXPECT_GT(stats.contrastRatio, 1.0);
+    EXPECT_LE(stats.contrastRatio, handler.getContrastRatio(path));
+    EXPECT_GT(stats.entropy, 0.0);
+    EXPECT_LE(stats.entropy, 8.0);
+    std::filesystem::remove(path);
+  }
+}
+
+TEST(JpegDctTest, RejectsOtherFiles) {
+  std::string path = tempPath("vidicant_dct.png");
+  ASSERT_TRUE(cv::imwrite(path, makeTexture(3)));
+  JpegDctStats stats;
+  EXPECT_FALSE(vidicant::analyzeJpegDct(path, stats));
+  EXPECT_FALSE(vidicant::analyzeJpegDct(tempPath("vidicant_missing.jpg"),
+                                        stats));
+  std::filesystem::remove(path);
+}
+
+TEST(JpegDctTest, ReadsBytesInMemoryLikeTheFile) {
+  std::vector<unsigned char> bytes;
+  ASSERT_TRUE(cv::imencode(".jpg", makeTexture(3), bytes));
+  std::string path = tempPath("vidicant_dct_memory.jpg");
+  std::ofstream(path, std::ios::binary)
+      .write(reinterpret_cast<const char *>(bytes.data()),
+             static_cast<std::streamsize>(bytes.size()));
+  JpegDctStats fromFile;
+  if (!vidicant::analyzeJpegDct(path, fromFile)) {
+    std::filesystem::remove(path);
+    GTEST_SKIP() << "built without libjpeg";
+  }
+  std::filesystem::remove(path);
+
+  JpegDctStats fromBytes;
+  ASSERT_TRUE(vidicant::analyzeJpegDct(bytes.data(), bytes.size(), fromBytes));
+  EXPECT_EQ(fromBytes.width, fromFile.width);
+  EXPECT_EQ(fromBytes.height, fromFile.height);
+  EXPECT_DOUBLE_EQ(fromBytes.averageBrightness, fromFile.averageBrightness);
+  EXPECT_DOUBLE_EQ(fromBytes.blurScore, fromFile.blurScore);
+
+  std::vector<unsigned char> truncated(bytes.begin(), bytes.begin() + 20);
+  EXPECT_FALSE(vidicant::analyzeJpegDct(truncated.data(), truncated.size(),
+                                        fromBytes));
+  EXPECT_FALSE(vidicant::analyzeJpegDct(nullptr, 0, fromBytes));
+
+  ImageHandler handler(std::make_unique<MemoryImageLoader>(bytes));
+  ASSERT_NE(handler.getEncodedBytes(), nullptr);
+  EXPECT_EQ(*handler.getEncodedBytes(), bytes);
+  ImageHandler files(std::make_unique<OpenCVImageLoader>());
+  EXPECT_EQ(files.getEncodedBytes(), nullptr);
+}
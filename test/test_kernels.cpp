@@ -0,0 +1,54 @@
+#include "vidicant/kernels.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+TEST(KernelsTest, SelectedVariantIsAvailable) {
+  auto available = vidicant::getAvailableIsas();
+  ASSERT_FALSE(available.empty());
+  EXPECT_EQ(available.back(), "baseline");
+  EXPECT_NE(std::find(available.begin(), available.end(),
+                      std::string(vidicant::kernels().isa)),
+            available.end());
+  EXPECT_EQ(vidicant::findKernels("baseline"),
+            &vidicant::getBaselineKernels());
+  EXPECT_EQ(vidicant::findKernels("mmx"), nullptr);
+}
+
+TEST(KernelsTest, EveryVariantMatchesBaseline) {
+  std::mt19937 rng(7);
+  std::vector<unsigned char> a(1100), b(1100);
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    a[i] = static_cast<unsigned char>(rng());
+    b[i] = static_cast<unsigned char>(rng());
+  }
+  const KernelTable &baseline = vidicant::getBaselineKernels();
+  // Lengths around each register width, from unaligned starts
+  for (const auto &isa : vidicant::getAvailableIsas()) {
+    ASSERT_NE(vidicant::findKernels(isa), nullptr) << isa;
+    const KernelTable &table = *vidicant::findKernels(isa);
+    for (std::size_t count : {0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 1000}) {
+      for (std::size_t offset : {0, 1, 7}) {
+        const unsigned char *pa = a.data() + offset;
+        EXPECT_EQ(table.sumBytes(pa, count), baseline.sumBytes(pa, count))
+            << isa << " " << count;
+        EXPECT_EQ(table.sumAbsDiff(pa, b.data(), count),
+                  baseline.sumAbsDiff(pa, b.data(), count))
+            << isa << " " << count;
+      }
+    }
+  }
+}
+
+TEST(KernelsTest, LongRowsDoNotOverflow) {
+  std::vector<unsigned char> white(1 << 20, 255), black(1 << 20, 0);
+  for (const auto &isa : vidicant::getAvailableIsas()) {
+    ASSERT_NE(vidicant::findKernels(isa), nullptr) << isa;
+    const KernelTable &table = *vidicant::findKernels(isa);
+    EXPECT_EQ(table.sumBytes(white.data(), white.size()), 255u << 20) << isa;
+    EXPECT_EQ(table.sumAbsDiff(black.data(), white.data(), white.size()),
+              255u << 20)
+        << isa;
+  }
+}
@@ -0,0 +1,75 @@
+#include "vidicant/memory_stats.hpp"
+#include <gtest/gtest.h>
+#include <opencv2/core.hpp>
+
+class MemoryStatsTest : public ::testing::Test {
+protected:
+  void SetUp() override { vidicant::enableMemoryTracking(); }
+};
+
+TEST_F(MemoryStatsTest, ScopeCountsMatAllocations) {
+  MemoryScope scope("file");
+  cv::Mat image(100, 200, CV_8UC3);
+  MemoryUsage usage = scope.getUsage();
+  EXPECT_EQ(usage.allocatedBytes, 100u * 200u * 3u);
+  EXPECT_EQ(usage.peakBytes, 100u * 200u * 3u);
+  EXPECT_EQ(usage.allocations, 1u);
+}
+
+TEST_F(MemoryStatsTest, MatsWrappingCallerMemoryAreNotCounted) {
+  unsigned char pixels[64] = {};
+  MemoryScope scope("file");
+  cv::Mat view(8, 8, CV_8UC1, pixels);
+  EXPECT_EQ(scope.getUsage().allocations, 0u);
+  EXPECT_EQ(scope.getUsage().allocatedBytes, 0u);
+}
+
+TEST_F(MemoryStatsTest, PeakOutlivesReleasedMats) {
+  MemoryScope scope("file");
+  {
+    cv::Mat a(10, 10, CV_32FC1);
+    cv::Mat b(10, 10, CV_32FC1);
+  }
+  cv::Mat c(10, 10, CV_8UC1);
+  MemoryUsage usage = scope.getUsage();
+  EXPECT_EQ(usage.allocatedBytes, 400u + 400u + 100u);
+  EXPECT_EQ(usage.peakBytes, 800u);
+  EXPECT_EQ(usage.allocations, 3u);
+}
+
+TEST_F(MemoryStatsTest, NestedStagesReportPathsAndMerge) {
+  MemoryScope file("file");
+  for (int i = 0; i < 2; ++i) {
+    MemoryScope analyze("analyze");
+    cv::Mat frame(10, 10, CV_8UC1);
+    {
+      MemoryScope metric("blur_score");
+      cv::Mat laplacian(10, 10, CV_64FC1);
+    }
+  }
+  const auto &stages = file.getStages();
+  ASSERT_EQ(stages.size(), 2u);
+  EXPECT_EQ(stages[0].first, "analyze");
+  EXPECT_EQ(stages[0].second.allocatedBytes, 2u * (100u + 800u));
+  EXPECT_EQ(stages[0].second.peakBytes, 900u);
+  EXPECT_EQ(stages[1].first, "analyze/blur_score");
+  EXPECT_EQ(stages[1].second.allocations, 2u);
+  EXPECT_EQ(stages[1].second.peakBytes, 800u);
+  EXPECT_EQ(file.getUsage().allocations, 4u);
+}
+
+TEST_F(MemoryStatsTest, ProcessTotalsGrow) {
+  MemoryUsage before = vidicant::getProcessMatUsage();
+  cv::Mat image(32, 32, CV_16UC1);
+  MemoryUsage after = vidicant::getProcessMatUsage();
+  EXPECT_EQ(after.allocatedBytes - before.allocatedBytes, 32u * 32u * 2u);
+  EXPECT_EQ(after.allocations - before.allocations, 1u);
+  EXPECT_GE(after.peakBytes, 32u * 32u * 2u);
+  EXPECT_TRUE(vidicant::isMemoryTrackingEnabled());
+}
+
+TEST_F(MemoryStatsTest, PeakRssIsReported) {
+#if defined(__linux__) || defined(__APPLE__)
+  EXPECT_GT(vidicant::getPeakRss(), 0u);
+#endif
+}
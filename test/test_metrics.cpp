@@ -0,0 +1,222 @@
+#include "vidicant/image.hpp"
+#include "vidicant/metrics.hpp"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <opencv2/opencv.hpp>
+#include <thread>
+
+class MockImageLoader : public IImageLoader {
+public:
+  MOCK_METHOD(cv::Mat, imread, (const std::string &), (override));
+};
+
+static cv::Mat makeNoise(int rows, int cols, int type) {
+  cv::Mat image(rows, cols, type);
+  cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(256));
+  return image;
+}
+
+TEST(MetricEngineTest, MatchesImageHandler) {
+  cv::Mat image = makeNoise(48, 64, CV_8UC3);
+  auto mockLoader = std::make_unique<MockImageLoader>();
+  EXPECT_CALL(*mockLoader, imread("noise.png"))
+      .WillRepeatedly(::testing::Return(image));
+  ImageHandler handler(std::move(mockLoader));
+
+  ImageMetricEngine engine;
+  ASSERT_TRUE(handler.analyze("noise.png", engine));
+  auto results = engine.finish();
+
+  EXPECT_EQ(engine.getFrameSize(), cv::Size(64, 48));
+  EXPECT_EQ(*std::get<0>(results), handler.isGrayscale("noise.png"));
+  EXPECT_NEAR(*std::get<1>(results), handler.getAverageBrightness("noise.png"),
+              1e-9);
+  EXPECT_EQ(*std::get<2>(results), handler.getNumberOfChannels("noise.png"));
+  EXPECT_EQ(*std::get<3>(results), handler.getEdgeCount("noise.png"));
+  EXPECT_EQ(std::get<4>(results)->size(), 3u);
+  EXPECT_NEAR(*std::get<5>(results), handler.getBlurScore("noise.png"), 1e-6);
+  EXPECT_NEAR(*std::get<6>(results), handler.getContrastRatio("noise.png"),
+              1e-9);
+  EXPECT_NEAR(*std::get<7>(results), handler.getSaturationLevel("noise.png"),
+              1e-9);
+  EXPECT_EQ(*std::get<8>(results), handler.getHistogram("noise.png"));
+  EXPECT_NEAR(*std::get<9>(results), handler.getAspectRatio("noise.png"),
+              1e-12);
+  EXPECT_NEAR(*std::get<10>(results), handler.getImageEntropy("noise.png"),
+              1e-4);
+}
+
+TEST(MetricEngineTest, ExpiredDeadlineKeepsThePreviewResults) {
+  cv::Mat image = makeNoise(768, 1024, CV_8UC3);
+  auto mockLoader = std::make_unique<MockImageLoader>();
+  EXPECT_CALL(*mockLoader, imread("noise.png"))
+      .WillRepeatedly(::testing::Return(image));
+  ImageHandler handler(std::move(mockLoader));
+
+  ImageMetricEngine whole;
+  AnalysisProgress progress;
+  ASSERT_TRUE(handler.analyze("noise.png", whole, nullptr, Deadline(60.0),
+                              &progress));
+  EXPECT_EQ(whole.getFrameSize(), image.size());
+  EXPECT_DOUBLE_EQ(progress.coverage, 1.0);
+  EXPECT_FALSE(progress.interrupted);
+
+  Deadline deadline(1e-6);
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  ImageMetricEngine preview;
+  ASSERT_TRUE(
+      handler.analyze("noise.png", preview, nullptr, deadline, &progress));
+  EXPECT_EQ(progress.frameSize, image.size());
+  EXPECT_TRUE(progress.interrupted);
+  EXPECT_LT(progress.coverage, 1.0);
+  EXPECT_GT(progress.coverage, 0.0);
+  EXPECT_LT(preview.getFrameSize().area(), image.size().area());
+  auto results = preview.finish();
+  EXPECT_EQ(std::get<4>(results)->size(), 3u); // Clustering keeps its seeds
+  EXPECT_NEAR(*std::get<1>(results), *std::get<1>(whole.finish()), 1.0);
+}
+
+TEST(MetricEngineTest, RunsOnlySelectedMetrics) {
+  ImageMetricEngine::Selection selection;
+  ASSERT_TRUE(ImageMetricEngine::select({"blur_score", "entropy"}, selection));
+  ImageMetricEngine engine(selection);
+  EXPECT_EQ(engine.requiredInputs(), static_cast<unsigned>(kInputGray));
+
+  engine.addFrame(makeNoise(16, 16, CV_8UC3));
+  std::vector<std::string> reported;
+  ImageMetricEngine::forEach(engine.finish(),
+                             [&reported](const char *name, const auto &) {
+                               reported.push_back(name);
+                             });
+  EXPECT_EQ(reported, (std::vector<std::string>{"blur_score", "entropy"}));
+}
+
+TEST(MetricEngineTest, SelectRejectsUnknownNames) {
+  ImageMetricEngine::Selection selection;
+  std::string unknown;
+  EXPECT_FALSE(ImageMetricEngine::select({"entropy", "sharpness"}, selection,
+                                         &unknown));
+  EXPECT_EQ(unknown, "sharpness");
+  EXPECT_TRUE(ImageMetricEngine::select({}, selection));
+  EXPECT_TRUE(selection.all());
+}
+
+TEST(MetricEngineTest, GrayscaleImageHasNoSaturation) {
+  ImageMetricEngine engine;
+  engine.addFrame(makeNoise(16, 16, CV_8UC1));
+  auto results = engine.finish();
+  EXPECT_TRUE(*std::get<0>(results));
+  EXPECT_EQ(std::get<8>(results)->size(), 1u);
+  EXPECT_DOUBLE_EQ(*std::get<7>(results), -1.0);
+  ASSERT_EQ(std::get<4>(results)->size(), 3u);
+  for (const auto &color : *std::get<4>(results)) {
+    EXPECT_DOUBLE_EQ(color[1], color[0]);
+    EXPECT_DOUBLE_EQ(color[2], color[0]);
+    EXPECT_GE(color[0], 0.0);
+    EXPECT_LE(color[0], 255.0);
+  }
+}
+
+TEST(MetricEngineTest, EmptyEngineReportsNothing) {
+  ImageMetricEngine engine;
+  engine.addFrame(cv::Mat());
+  EXPECT_EQ(engine.getFrameCount(), 0);
+  int reported = 0;
+  ImageMetricEngine::forEach(engine.finish(),
+                             [&reported](const char *, const auto &) {
+                               ++reported;
+                             });
+  EXPECT_EQ(reported, 0);
+}
+
+TEST(MetricEngineTest, NamesFollowRegistryOrder) {
+  auto names = ImageMetricEngine::names();
+  ASSERT_EQ(names.size(), ImageMetricEngine::kCount);
+  EXPECT_EQ(names.front(), "is_grayscale");
+  EXPECT_EQ(names.back(), "perceptual_hash");
+}
+
+TEST(MetricEngineTest, PerceptualHashComesFromTheGrayView) {
+  cv::Mat image = makeNoise(64, 48, CV_8UC3);
+  ImageMetricEngine::Selection selection;
+  ASSERT_TRUE(ImageMetricEngine::select({"perceptual_hash"}, selection));
+  ImageMetricEngine engine(selection);
+  EXPECT_EQ(engine.requiredInputs(), static_cast<unsigned>(kInputGray));
+  engine.addFrame(image);
+
+  auto hash = std::get<ImageMetricEngine::indexOf<PerceptualHashMetric>()>(
+      engine.finish());
+  ASSERT_TRUE(hash.has_value());
+  PerceptualHash expected = vidicant::computePerceptualHash(image);
+  EXPECT_EQ(hash->dHash, expected.dHash);
+  EXPECT_EQ(hash->pHash, expected.pHash);
+}
+
+TEST(MetricEngineTest, SixteenBitImagesReportOnTheEightBitScale) {
+  // v * 257 spans 0-65535 exactly as v spans 0-255
+  cv::Mat narrow = makeNoise(32, 48, CV_8UC3);
+  cv::Mat wide;
+  narrow.convertTo(wide, CV_16U, 257.0);
+
+  ImageMetricEngine a, b;
+  a.addFrame(narrow);
+  b.addFrame(wide);
+  auto expected = a.finish();
+  auto actual = b.finish();
+  EXPECT_NEAR(*std::get<1>(actual), *std::get<1>(expected), 1e-9);
+  EXPECT_EQ(*std::get<2>(actual), 3);
+  EXPECT_NEAR(*std::get<7>(actual), *std::get<7>(expected), 1.0);
+  EXPECT_EQ(*std::get<8>(actual), *std::get<8>(expected));
+
+  // Single-channel frames skip the gray conversion, so these match too
+  cv::Mat narrowGray = makeNoise(32, 48, CV_8UC1);
+  cv::Mat wideGray;
+  narrowGray.convertTo(wideGray, CV_16U, 257.0);
+  ImageMetricEngine c, d;
+  c.addFrame(narrowGray);
+  d.addFrame(wideGray);
+  expected = c.finish();
+  actual = d.finish();
+  EXPECT_EQ(*std::get<3>(actual), *std::get<3>(expected));
+  EXPECT_NEAR(*std::get<5>(actual), *std::get<5>(expected), 1e-6);
+  EXPECT_NEAR(*std::get<6>(actual), *std::get<6>(expected),
+              *std::get<6>(expected) * 1e-9);
+  EXPECT_NEAR(*std::get<10>(actual), *std::get<10>(expected), 1e-9);
+}
+
+TEST(MetricEngineTest, FloatImagesReportOnTheEightBitScale) {
+  cv::Mat narrow = makeNoise(32, 48, CV_8UC3);
+  cv::Mat unit;
+  narrow.convertTo(unit, CV_32F, 1.0 / 255.0);
+
+  ImageMetricEngine a, b;
+  a.addFrame(narrow);
+  b.addFrame(unit);
+  auto expected = a.finish();
+  auto actual = b.finish();
+  EXPECT_NEAR(*std::get<1>(actual), *std::get<1>(expected), 1e-3);
+  EXPECT_NEAR(*std::get<7>(actual), *std::get<7>(expected), 1.0);
+  EXPECT_EQ(std::get<8>(actual)->size(), 3u);
+}
+
+TEST(MetricEngineTest, HistogramBinsAreConfigurable) {
+  cv::Mat image(4, 4, CV_8UC1, cv::Scalar(0));
+  image.at<uchar>(0, 0) = 255;
+  image.at<uchar>(0, 1) = 16;
+  MetricOptions options;
+  options.histogramBins = 16;
+  ImageMetricEngine engine(ImageMetricEngine::Selection().set(), options);
+  engine.addFrame(image);
+  auto histogram = *std::get<8>(engine.finish());
+  ASSERT_EQ(histogram.size(), 1u);
+  ASSERT_EQ(histogram[0].size(), 16u);
+  EXPECT_EQ(histogram[0][0], 14);
+  EXPECT_EQ(histogram[0][1], 1);
+  EXPECT_EQ(histogram[0][15], 1);
+
+  cv::Mat wide(2, 2, CV_16UC1, cv::Scalar(65535));
+  ImageMetricEngine deep(ImageMetricEngine::Selection().set(), options);
+  deep.addFrame(wide);
+  EXPECT_EQ((*std::get<8>(deep.finish()))[0][15], 4);
+}
@@ -0,0 +1,62 @@
+#include "vidicant/parallelism.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+
+TEST(ParallelismTest, FileModeRunsOneSingleThreadedFilePerCore) {
+  ParallelismPolicy policy =
+      vidicant::makeParallelismPolicy(ParallelismMode::File, 0, 16);
+  EXPECT_EQ(policy.fileWorkers, 16);
+  EXPECT_EQ(policy.threadsPerFile, 1);
+}
+
+TEST(ParallelismTest, IntraModeUsesEveryCoreInOneFile) {
+  ParallelismPolicy policy =
+      vidicant::makeParallelismPolicy(ParallelismMode::IntraFile, 8, 16);
+  EXPECT_EQ(policy.fileWorkers, 1); // jobs is ignored
+  EXPECT_EQ(policy.threadsPerFile, 16);
+}
+
+TEST(ParallelismTest, HybridModeSplitsCores) {
+  ParallelismPolicy policy =
+      vidicant::makeParallelismPolicy(ParallelismMode::Hybrid, 0, 16);
+  EXPECT_EQ(policy.fileWorkers, 4);
+  EXPECT_EQ(policy.threadsPerFile, 4);
+
+  policy = vidicant::makeParallelismPolicy(ParallelismMode::Hybrid, 3, 16);
+  EXPECT_EQ(policy.fileWorkers, 3);
+  EXPECT_EQ(policy.threadsPerFile, 5);
+  EXPECT_LE(policy.fileWorkers * policy.threadsPerFile, 16);
+
+  policy = vidicant::makeParallelismPolicy(ParallelismMode::Hybrid, 0, 2);
+  EXPECT_EQ(policy.fileWorkers, 1);
+  EXPECT_EQ(policy.threadsPerFile, 2);
+}
+
+TEST(ParallelismTest, ParseAndNameRoundTrip) {
+  for (ParallelismMode mode :
+       {ParallelismMode::File, ParallelismMode::IntraFile,
+        ParallelismMode::Hybrid}) {
+    ParallelismMode parsed;
+    ASSERT_TRUE(vidicant::parseParallelismMode(
+        vidicant::parallelismModeName(mode), parsed));
+    EXPECT_EQ(parsed, mode);
+  }
+  ParallelismMode parsed;
+  EXPECT_FALSE(vidicant::parseParallelismMode("numa", parsed));
+}
+
+TEST(ParallelismTest, SetPolicyIsReturnedByGet) {
+  ParallelismPolicy policy =
+      vidicant::makeParallelismPolicy(ParallelismMode::Hybrid, 1, 2);
+  vidicant::setParallelismPolicy(policy);
+  EXPECT_EQ(vidicant::getParallelismPolicy().fileWorkers, 1);
+  EXPECT_EQ(vidicant::getParallelismPolicy().threadsPerFile, 2);
+}
+
+TEST(ParallelismTest, AvailableCpusAreUnique) {
+  std::vector<int> cpus = vidicant::getAvailableCpus();
+  ASSERT_FALSE(cpus.empty());
+  std::vector<int> sorted = cpus;
+  std::sort(sorted.begin(), sorted.end());
+  EXPECT_EQ(std::unique(sorted.begin(), sorted.end()), sorted.end());
+}
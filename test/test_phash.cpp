@@ -0,0 +1,141 @@
+#include "vidicant/hash_index.hpp"
+#include "vidicant/image.hpp"
+#include "vidicant/phash.hpp"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+#include <random>
+
+static cv::Mat makePattern() {
+  cv::Mat image(120, 160, CV_8UC3, cv::Scalar(30, 30, 30));
+  cv::rectangle(image, cv::Rect(10, 10, 60, 40), cv::Scalar(240, 240, 240),
+                cv::FILLED);
+  cv::circle(image, cv::Point(110, 80), 25, cv::Scalar(0, 128, 255),
+             cv::FILLED);
+  return image;
+}
+
+TEST(PerceptualHashTest, EmptyImage) {
+  PerceptualHash hash = vidicant::computePerceptualHash(cv::Mat());
+  EXPECT_EQ(hash.dHash, 0u);
+  EXPECT_EQ(hash.pHash, 0u);
+}
+
+TEST(PerceptualHashTest, StableUnderResize) {
+  cv::Mat image = makePattern();
+  cv::Mat resized;
+  cv::resize(image, resized, cv::Size(320, 240));
+
+  PerceptualHash a = vidicant::computePerceptualHash(image);
+  PerceptualHash b = vidicant::computePerceptualHash(resized);
+
+  EXPECT_LE(vidicant::hammingDistance(a.dHash, b.dHash), 4);
+  EXPECT_LE(vidicant::hammingDistance(a.pHash, b.pHash), 4);
+}
+
+TEST(PerceptualHashTest, DiffersForDifferentImages) {
+  cv::Mat image = makePattern();
+  cv::Mat flipped;
+  cv::flip(image, flipped, 1);
+
+  PerceptualHash a = vidicant::computePerceptualHash(image);
+  PerceptualHash b = vidicant::computePerceptualHash(flipped);
+
+  EXPECT_GT(vidicant::hammingDistance(a.pHash, b.pHash), 10);
+}
+
+TEST(PerceptualHashTest, FormatAndParseRoundTrip) {
+  std::uint64_t hash = 0x0123456789abcdefULL;
+  std::uint64_t parsed = 0;
+
+  EXPECT_EQ(vidicant::formatHash(hash), "0123456789abcdef");
+  EXPECT_TRUE(vidicant::parseHash("0123456789ABCDEF", parsed));
+  EXPECT_EQ(parsed, hash);
+  EXPECT_FALSE(vidicant::parseHash("xyz", parsed));
+  EXPECT_FALSE(vidicant::parseHash("0123456789abcdef0", parsed));
+}
+
+TEST(HashIndexTest, QueryMatchesBruteForce) {
+  std::mt19937_64 rng(42);
+  std::vector<std::uint64_t> hashes;
+  HashIndexWriter writer;
+  for (int i = 0; i < 5000; ++i) {
+    std::uint64_t hash = rng();
+    // Plant near-duplicates of the first hash
+    if (i % 500 == 0 && !hashes.empty())
+      hash = hashes[0] ^ (std::uint64_t{1} << (i % 64)) ^
+             (std::uint64_t{1} << ((i / 7) % 64));
+    hashes.push_back(hash);
+    writer.add(hash, "file" + std::to_string(i) + ".jpg");
+  }
+  std::string path = testing::TempDir() + "vidicant_hash_index_test.vdx";
+  ASSERT_TRUE(writer.write(path));
+
+  HashIndex index;
+  ASSERT_TRUE(index.open(path));
+  EXPECT_EQ(index.size(), hashes.size());
+
+  for (int distance : {0, 3, 6, 10}) {
+    auto matches = index.query(hashes[0], distance);
+    size_t expected = 0;
+    for (std::uint64_t hash : hashes)
+      if (vidicant::hammingDistance(hash, hashes[0]) <= distance)
+        ++expected;
+    EXPECT_EQ(matches.size(), expected) << "distance " << distance;
+    for (const auto &match : matches)
+      EXPECT_LE(match.distance, distance);
+  }
+  auto exact = index.query(hashes[0], 0);
+  ASSERT_FALSE(exact.empty());
+  EXPECT_EQ(exact[0].path, "file0.jpg");
+  std::remove(path.c_str());
+}
+
+TEST(HashIndexTest, OpenRejectsOtherFiles) {
+  std::string path = testing::TempDir() + "vidicant_not_an_index.vdx";
+  FILE *file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  std::fputs("definitely not an index", file);
+  std::fclose(file);
+
+  HashIndex index;
+  EXPECT_FALSE(index.open(path));
+  EXPECT_FALSE(index.open(path + ".missing"));
+  std::remove(path.c_str());
+}
+
+TEST(HashIndexTest, OpenRejectsRegionsOutsideTheFile) {
+  HashIndexWriter writer;
+  for (int i = 0; i < 10; ++i)
+    writer.add(static_cast<std::uint64_t>(i) * 0x9e3779b97f4a7c15ULL,
+               "file" + std::to_string(i) + ".jpg");
+  std::string path = testing::TempDir() + "vidicant_corrupt_index.vdx";
+  ASSERT_TRUE(writer.write(path));
+  HashIndex index;
+  ASSERT_TRUE(index.open(path));
+
+  // Header fields after the 8-byte magic: count, hashesOffset,
+  // pathOffsetsOffset, then the table offsets
+  auto patch = [&path](long position, std::uint64_t value) {
+    FILE *file = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    std::fseek(file, position, SEEK_SET);
+    std::fwrite(&value, sizeof(value), 1, file);
+    std::fclose(file);
+  };
+  patch(8, std::uint64_t{1} << 40);
+  EXPECT_FALSE(index.open(path));
+  EXPECT_EQ(index.size(), 0u);
+  patch(8, 10);
+  patch(24, std::uint64_t{1} << 40);
+  EXPECT_FALSE(index.open(path));
+  patch(24, ~std::uint64_t{0} - 7);
+  EXPECT_FALSE(index.open(path));
+  std::remove(path.c_str());
+}
+
+TEST(PerceptualHashGlobalTest, GetImagePerceptualHashReal) {
+  PerceptualHash hash = vidicant::getImagePerceptualHash(
+      "/workspaces/vidicant/examples/sample.jpg");
+  EXPECT_NE(hash.pHash, 0u);
+}
@@ -0,0 +1,120 @@
+#include "vidicant/prefetch.hpp"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Gives each test a directory of small files.
+class PrefetchTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    directory_ =
+        std::filesystem::path(testing::TempDir()) / "vidicant_prefetch_test";
+    std::filesystem::remove_all(directory_);
+    std::filesystem::create_directories(directory_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory_); }
+
+  // Writes a file of the given size and returns its request.
+  PrefetchRequest write(const std::string &name, std::size_t size,
+                        bool buffer = true) {
+    std::string path = (directory_ / name).string();
+    std::string contents(size, '\0');
+    for (std::size_t i = 0; i < size; ++i)
+      contents[i] = static_cast<char>('a' + (i + name.size()) % 26);
+    std::ofstream(path, std::ios::binary) << contents;
+    return {path, size, buffer};
+  }
+
+  // Reads a file back for comparison.
+  static std::vector<unsigned char> contents(const std::string &path) {
+    std::ifstream input(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(input),
+            std::istreambuf_iterator<char>()};
+  }
+
+  std::filesystem::path directory_;
+};
+
+} // namespace
+
+TEST_F(PrefetchTest, BuffersFilesAheadOfTheirWorkers) {
+  std::vector<PrefetchRequest> files;
+  for (int i = 0; i < 12; ++i)
+    files.push_back(write("file" + std::to_string(i) + ".jpg", 1000 + i));
+  PrefetchOptions options;
+  options.depth = 3;
+  options.deviceReads = 1;
+  Prefetcher prefetcher(files, options);
+
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    std::vector<unsigned char> bytes;
+    // A file not yet reached is left to the caller rather than waited for
+    if (prefetcher.take(i, bytes))
+      EXPECT_EQ(bytes, contents(files[i].path)) << files[i].path;
+    else
+      EXPECT_TRUE(bytes.empty());
+  }
+  std::vector<unsigned char> bytes;
+  EXPECT_FALSE(prefetcher.take(0, bytes));
+}
+
+TEST_F(PrefetchTest, ReturnsFilesTakenOutOfOrder) {
+  std::vector<PrefetchRequest> files = {write("a.jpg", 4096),
+                                        write("b.jpg", 8192)};
+  PrefetchOptions options;
+  options.depth = 2;
+  Prefetcher prefetcher(files, options);
+  // Both files are within the window from the start; once the readers
+  // have read them, taking either returns its contents
+  while (prefetcher.getBytesRead() < 4096 + 8192)
+    std::this_thread::yield();
+  std::vector<unsigned char> bytes;
+  ASSERT_TRUE(prefetcher.take(1, bytes));
+  EXPECT_EQ(bytes, contents(files[1].path));
+  ASSERT_TRUE(prefetcher.take(0, bytes));
+  EXPECT_EQ(bytes, contents(files[0].path));
+}
+
+TEST_F(PrefetchTest, WarmsFilesThatAreNotBuffered) {
+  std::vector<PrefetchRequest> files = {
+      write("clip.mp4", 5000, false), write("large.jpg", 5000),
+      {(directory_ / "missing.jpg").string(), 100, true}};
+  PrefetchOptions options;
+  options.depth = 3;
+  options.maxBytes = 4000; // Too small to buffer large.jpg
+  options.warmBytes = 1024;
+  Prefetcher prefetcher(files, options);
+  // clip.mp4 and large.jpg are warmed at both ends
+  while (prefetcher.getBytesRead() < 2 * 2048)
+    std::this_thread::yield();
+
+  std::vector<unsigned char> bytes;
+  EXPECT_FALSE(prefetcher.take(0, bytes));
+  EXPECT_FALSE(prefetcher.take(1, bytes));
+  EXPECT_FALSE(prefetcher.take(2, bytes));
+  EXPECT_TRUE(bytes.empty());
+}
+
+TEST_F(PrefetchTest, StopsWithFilesNotTaken) {
+  std::vector<PrefetchRequest> files;
+  for (int i = 0; i < 50; ++i)
+    files.push_back(write("file" + std::to_string(i) + ".png", 100));
+  PrefetchOptions options;
+  options.depth = 8;
+  {
+    Prefetcher prefetcher(files, options);
+    std::vector<unsigned char> bytes;
+    prefetcher.take(0, bytes);
+  }
+  // Without read-ahead nothing is read
+  Prefetcher idle(files, PrefetchOptions());
+  std::vector<unsigned char> bytes;
+  EXPECT_FALSE(idle.take(0, bytes));
+  EXPECT_EQ(idle.getBytesRead(), 0u);
+}
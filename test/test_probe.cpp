@@ -0,0 +1,289 @@
+#include "vidicant/probe.hpp"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+// Writes crafted headers to temporary files and removes them afterwards.
+class ProbeTest : public ::testing::Test {
+protected:
+  void TearDown() override {
+    for (const auto &path : paths_)
+      std::filesystem::remove(path);
+  }
+
+  std::string write(const std::string &name,
+                    const std::vector<unsigned char> &bytes) {
+    std::string path =
+        (std::filesystem::temp_directory_path() / ("vidicant_probe_" + name))
+            .string();
+    std::ofstream output(path, std::ios::binary);
+    output.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    paths_.push_back(path);
+    return path;
+  }
+
+private:
+  std::vector<std::string> paths_;
+};
+
+TEST_F(ProbeTest, ReadsPngHeader) {
+  std::vector<unsigned char> png = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A,
+                                    0x0A, 0,   0,   0,   13,   'I',  'H',
+                                    'D',  'R', 0,   0,   0x0F, 0xA0, 0,
+                                    0,    0x0B, 0xB8, 8,   2,    0,    0};
+  MediaProbe probe = vidicant::probeImage(write("a.png", png));
+  EXPECT_TRUE(probe.ok);
+  EXPECT_EQ(probe.width, 4000);
+  EXPECT_EQ(probe.height, 3000);
+  EXPECT_EQ(probe.frameCount, 1);
+  EXPECT_EQ(probe.bitDepth, 8);
+  EXPECT_EQ(probe.fileSize, png.size());
+}
+
+TEST_F(ProbeTest, ReadsGifAndTopDownBmpHeaders) {
+  std::vector<unsigned char> gif = {'G', 'I', 'F', '8', '9', 'a', 123, 0,
+                                    45,  0,   0,   0,   0,   0,   0,   0};
+  MediaProbe probe = vidicant::probeImage(write("a.gif", gif));
+  EXPECT_TRUE(probe.ok);
+  EXPECT_EQ(probe.width, 123);
+  EXPECT_EQ(probe.height, 45);
+
+  std::vector<unsigned char> bmp(54, 0);
+  bmp[0] = 'B';
+  bmp[1] = 'M';
+  bmp[18] = 123;                      // Width 123
+  bmp[22] = 0xD3;                     // Height -45 (top-down rows)
+  bmp[23] = bmp[24] = bmp[25] = 0xFF;
+  probe = vidicant::probeImage(write("a.bmp", bmp));
+  EXPECT_TRUE(probe.ok);
+  EXPECT_EQ(probe.width, 123);
+  EXPECT_EQ(probe.height, 45);
+}
+
+TEST_F(ProbeTest, SkipsJpegSegmentsToStartOfFrame) {
+  std::vector<unsigned char> jpeg = {0xFF, 0xD8, 0xFF, 0xE1, 0x04, 0x02};
+  jpeg.resize(jpeg.size() + 1024, 0); // APP1 payload, e.g. EXIF
+  std::vector<unsigned char> frame = {0xFF, 0xC2, 0, 17, 8, 0x02,
+                                      0xD0, 0x05, 0x00};
+  jpeg.insert(jpeg.end(), frame.begin(), frame.end());
+  jpeg.resize(jpeg.size() + 16, 0);
+  MediaProbe probe = vidicant::probeImage(write("a.jpg", jpeg));
+  EXPECT_TRUE(probe.ok);
+  EXPECT_EQ(probe.width, 1280);
+  EXPECT_EQ(probe.height, 720);
+}
+
+TEST_F(ProbeTest, ReadsBigEndianTiffDirectory) {
+  std::vector<unsigned char> tiff = {
+      'M', 'M', 0, 42, 0, 0, 0, 8, // Header, first directory at 8
+      0,   2,                      // Two entries
+      1,   0,   0, 3,  0, 0, 0, 1, 0x01, 0x00, 0, 0, // Width: SHORT 256
+      1,   1,   0, 4,  0, 0, 0, 1, 0,    0,    0, 200, // Height: LONG 200
+      0,   0,   0, 0};
+  MediaProbe probe = vidicant::probeImage(write("a.tiff", tiff));
+  EXPECT_TRUE(probe.ok);
+  EXPECT_EQ(probe.width, 256);
+  EXPECT_EQ(probe.height, 200);
+}
+
+TEST_F(ProbeTest, ReadsTiffBitsPerSample) {
+  std::vector<unsigned char> tiff = {
+      'I', 'I', 42, 0, 8, 0, 0, 0, // Header, first directory at 8
+      3,   0,                      // Three entries
+      0,   1,   3,  0, 1, 0, 0, 0, 0x40, 0, 0, 0, // Width: SHORT 64
+      1,   1,   3,  0, 1, 0, 0, 0, 0x30, 0, 0, 0, // Height: SHORT 48
+      2,   1,   3,  0, 3, 0, 0, 0, 50,   0, 0, 0, // BitsPerSample at 50
+      0,   0,   0,  0,                             // No next directory
+      16,  0,   16, 0, 16, 0};
+  MediaProbe probe = vidicant::probeImage(write("deep.tif", tiff));
+  EXPECT_TRUE(probe.ok);
+  EXPECT_EQ(probe.width, 64);
+  EXPECT_EQ(probe.height, 48);
+  EXPECT_EQ(probe.bitDepth, 16);
+}
+
+TEST_F(ProbeTest, ReadsLosslessWebpHeader) {
+  // 14-bit width-1 and height-1 fields packed after the 0x2F signature
+  std::uint32_t bits = (640 - 1) | ((480 - 1) << 14);
+  std::vector<unsigned char> webp = {'R', 'I', 'F', 'F', 0,   0,   0,
+                                     0,   'W', 'E', 'B', 'P', 'V', 'P',
+                                     '8', 'L', 0,   0,   0,   0,   0x2F};
+  for (int i = 0; i < 4; ++i)
+    webp.push_back(static_cast<unsigned char>(bits >> (8 * i)));
+  webp.resize(webp.size() + 8, 0);
+  MediaProbe probe = vidicant::probeImage(write("a.webp", webp));
+  EXPECT_TRUE(probe.ok);
+  EXPECT_EQ(probe.width, 640);
+  EXPECT_EQ(probe.height, 480);
+}
+
+TEST_F(ProbeTest, CountsAnimatedGifFrames) {
+  // Header with a 2-entry global color table, then three frames of 80 ms
+  std::vector<unsigned char> gif = {'G', 'I', 'F', '8', '9', 'a', 16, 0,
+                                    16,  0,   0x80, 0,  0,   0,   0,   0,
+                                    255, 255, 255};
+  for (int frame = 0; frame < 3; ++frame) {
+    std::vector<unsigned char> control = {0x21, 0xF9, 4, 0, 8, 0, 0, 0};
+    std::vector<unsigned char> image = {0x2C, 0, 0, 0, 0, 16, 0, 16,
+                                        0,    0, 2, 2, 0x4C, 0x01, 0};
+    gif.insert(gif.end(), control.begin(), control.end());
+    gif.insert(gif.end(), image.begin(), image.end());
+  }
+  gif.push_back(0x3B);
+  MediaProbe probe = vidicant::probeImage(write("anim.gif", gif));
+  EXPECT_TRUE(probe.ok);
+  EXPECT_EQ(probe.width, 16);
+  EXPECT_EQ(probe.frameCount, 3);
+  EXPECT_DOUBLE_EQ(probe.duration, 0.24);
+}
+
+TEST_F(ProbeTest, CountsAnimatedWebpFrames) {
+  // VP8X with the animation flag, an ANIM chunk and two 100 ms ANMF frames
+  std::vector<unsigned char> webp = {'R', 'I', 'F', 'F', 0,   0,   0,   0,
+                                     'W', 'E', 'B', 'P', 'V', 'P', '8', 'X',
+                                     10,  0,   0,   0,   0x02, 0,  0,   0,
+                                     99,  0,   0,   49,  0,   0,   'A', 'N',
+                                     'I', 'M', 6,   0,   0,   0,   0,   0,
+                                     0,   0,   0,   0};
+  for (int frame = 0; frame < 2; ++frame) {
+    std::vector<unsigned char> anmf = {'A', 'N', 'M', 'F', 16, 0, 0, 0,
+                                       0,   0,   0,   0,   0,  0, 99, 0,
+                                       0,   49,  0,   0,   100, 0, 0, 0};
+    webp.insert(webp.end(), anmf.begin(), anmf.end());
+  }
+  MediaProbe probe = vidicant::probeImage(write("anim.webp", webp));
+  EXPECT_TRUE(probe.ok);
+  EXPECT_EQ(probe.width, 100);
+  EXPECT_EQ(probe.height, 50);
+  EXPECT_EQ(probe.frameCount, 2);
+  EXPECT_DOUBLE_EQ(probe.duration, 0.2);
+}
+
+TEST(ExifTest, ReadsOrientationInEitherByteOrder) {
+  // "Exif\0\0", TIFF header, IFD with one orientation entry
+  std::vector<unsigned char> little = {'E', 'x', 'i', 'f', 0, 0, 'I', 'I', 42,
+                                       0,   8,   0,   0,   0,   1, 0,  0x12,
+                                       0x01, 3,  0,   1,   0,   0, 0,  6,
+                                       0,   0,   0};
+  EXPECT_EQ(vidicant::readExifOrientation(little.data(), little.size()), 6);
+
+  std::vector<unsigned char> big = {'E', 'x', 'i', 'f', 0, 0, 'M', 'M', 0,
+                                    42,  0,   0,   0,   8, 0, 1,   0x01, 0x12,
+                                    0,   3,   0,   0,   0, 1, 0,   8,   0,
+                                    0};
+  EXPECT_EQ(vidicant::readExifOrientation(big.data(), big.size()), 8);
+
+  std::vector<unsigned char> xmp(40, 'x');
+  EXPECT_EQ(vidicant::readExifOrientation(xmp.data(), xmp.size()), 1);
+  EXPECT_EQ(vidicant::readExifOrientation(little.data(), 20), 1);
+}
+
+TEST_F(ProbeTest, ReportsSizeOfUnrecognizedFiles) {
+  std::vector<unsigned char> text(100, 'x');
+  MediaProbe probe = vidicant::probeImage(write("a.txt", text));
+  EXPECT_FALSE(probe.ok);
+  EXPECT_EQ(probe.fileSize, 100u);
+
+  probe = vidicant::probeImage("nonexistent_probe_file.png");
+  EXPECT_FALSE(probe.ok);
+  EXPECT_EQ(probe.fileSize, 0u);
+}
+
+TEST_F(ProbeTest, FailsOnUnopenableVideo) {
+  MediaProbe probe = vidicant::probeVideo("nonexistent_probe_file.mp4");
+  EXPECT_FALSE(probe.ok);
+}
+
+// Wraps a payload in an ISO media box
+static std::vector<unsigned char> box(const char *type,
+                                      std::vector<unsigned char> payload) {
+  std::uint32_t size = static_cast<std::uint32_t>(payload.size() + 8);
+  std::vector<unsigned char> bytes = {
+      static_cast<unsigned char>(size >> 24),
+      static_cast<unsigned char>(size >> 16),
+      static_cast<unsigned char>(size >> 8), static_cast<unsigned char>(size)};
+  bytes.insert(bytes.end(), type, type + 4);
+  bytes.insert(bytes.end(), payload.begin(), payload.end());
+  return bytes;
+}
+
+static void putBE(std::vector<unsigned char> &bytes, std::size_t at,
+                  std::uint32_t value) {
+  for (int i = 0; i < 4; ++i)
+    bytes[at + i] = static_cast<unsigned char>(value >> (24 - 8 * i));
+}
+
+static std::vector<unsigned char>
+concat(std::initializer_list<std::vector<unsigned char>> parts) {
+  std::vector<unsigned char> bytes;
+  for (const auto &part : parts)
+    bytes.insert(bytes.end(), part.begin(), part.end());
+  return bytes;
+}
+
+TEST_F(ProbeTest, ReadsMp4VideoTrackAfterItsMediaData) {
+  auto track = [](const char *handler, std::uint32_t width,
+                  std::uint32_t height) {
+    std::vector<unsigned char> tkhd(84, 0);
+    putBE(tkhd, 76, width << 16);
+    putBE(tkhd, 80, height << 16);
+    std::vector<unsigned char> mdhd(24, 0);
+    putBE(mdhd, 12, 600);  // Timescale
+    putBE(mdhd, 16, 6000); // Duration in ticks
+    std::vector<unsigned char> hdlr(24, 0);
+    std::copy(handler, handler + 4, hdlr.begin() + 8);
+    std::vector<unsigned char> stsz(12, 0);
+    putBE(stsz, 8, 250); // Sample count
+    std::vector<unsigned char> minf = box("stbl", box("stsz", stsz));
+    std::vector<unsigned char> mdia = concat(
+        {box("mdhd", mdhd), box("hdlr", hdlr), box("minf", minf)});
+    return box("trak", concat({box("tkhd", tkhd), box("mdia", mdia)}));
+  };
+  std::vector<unsigned char> mp4 =
+      concat({box("ftyp", {'i', 's', 'o', 'm', 0, 0, 2, 0}),
+              box("mdat", std::vector<unsigned char>(64, 0xAB)),
+              box("moov", concat({track("soun", 0, 0),
+                                  track("vide", 1920, 1080)}))});
+
+  MediaProbe probe = vidicant::probeVideo(write("a.mp4", mp4));
+  EXPECT_TRUE(probe.ok);
+  EXPECT_EQ(probe.width, 1920);
+  EXPECT_EQ(probe.height, 1080);
+  EXPECT_EQ(probe.frameCount, 250);
+  EXPECT_DOUBLE_EQ(probe.duration, 10.0);
+  EXPECT_EQ(probe.fileSize, mp4.size());
+}
+
+TEST_F(ProbeTest, ReadsAviMainHeader) {
+  std::vector<unsigned char> avi = {'R', 'I', 'F', 'F', 0,   0,   0,   0,
+                                    'A', 'V', 'I', ' ', 'L', 'I', 'S', 'T',
+                                    0,   0,   0,   0,   'h', 'd', 'r', 'l',
+                                    'a', 'v', 'i', 'h', 56,  0,   0,   0};
+  avi.resize(avi.size() + 56, 0);
+  auto putLE = [&avi](std::size_t at, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i)
+      avi[32 + at + i] = static_cast<unsigned char>(value >> (8 * i));
+  };
+  putLE(0, 40000); // Microseconds per frame
+  putLE(16, 100);  // Total frames
+  putLE(32, 640);
+  putLE(36, 360);
+
+  MediaProbe probe = vidicant::probeVideo(write("a.avi", avi));
+  EXPECT_TRUE(probe.ok);
+  EXPECT_EQ(probe.width, 640);
+  EXPECT_EQ(probe.height, 360);
+  EXPECT_EQ(probe.frameCount, 100);
+  EXPECT_DOUBLE_EQ(probe.duration, 4.0);
+}
+
+TEST_F(ProbeTest, LeavesOtherContainersUnprobed) {
+  // A Matroska EBML header; reading it would take a demuxer
+  std::vector<unsigned char> mkv = {0x1A, 0x45, 0xDF, 0xA3};
+  mkv.resize(200, 0);
+  MediaProbe probe = vidicant::probeVideo(write("a.mkv", mkv));
+  EXPECT_FALSE(probe.ok);
+  EXPECT_EQ(probe.fileSize, 200u);
+}
@@ -0,0 +1,215 @@
+#include "vidicant/image_sequence.hpp"
+#include "vidicant/proxy.hpp"
+#include "vidicant/video.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+
+namespace {
+
+// Gives each test an empty cache directory.
+class ProxyTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    directory_ =
+        std::filesystem::path(testing::TempDir()) / "vidicant_proxy_test";
+    std::filesystem::remove_all(directory_);
+    std::filesystem::create_directories(directory_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory_); }
+
+  std::string path(const std::string &name) const {
+    return (directory_ / name).string();
+  }
+
+  std::filesystem::path directory_;
+};
+
+} // namespace
+
+TEST_F(ProxyTest, ReadsBackWrittenFrames) {
+  ProxyInfo info;
+  info.sourceBytes = 1234;
+  info.sourceTime = 42;
+  info.sourceSize = cv::Size(64, 48);
+  info.frameSize = cv::Size(32, 24);
+  info.channels = 1;
+  info.fps = 25.0;
+
+  ProxyWriter writer;
+  ASSERT_TRUE(writer.open(path("clip.vproxy"), info));
+  for (int i = 0; i < 5; ++i) {
+    cv::Mat frame(48, 64, CV_8UC3, cv::Scalar(10 * i, 10 * i, 10 * i));
+    ASSERT_TRUE(writer.addFrame(frame, i * 40.0));
+  }
+  ASSERT_TRUE(writer.finish());
+
+  ProxyVideoLoader loader;
+  ASSERT_TRUE(loader.open(path("clip.vproxy")));
+  EXPECT_EQ(loader.getFrameCount(), 5);
+  EXPECT_DOUBLE_EQ(loader.getFPS(), 25.0);
+  EXPECT_EQ(loader.getResolution(), std::make_pair(64, 48));
+  EXPECT_EQ(loader.getInfo().sourceBytes, 1234u);
+  EXPECT_EQ(loader.getInfo().sourceTime, 42);
+  EXPECT_DOUBLE_EQ(loader.getTimestamp(), -1.0);
+
+  cv::Mat frame;
+  ASSERT_TRUE(loader.readFrame(frame));
+  EXPECT_EQ(frame.size(), cv::Size(32, 24));
+  EXPECT_EQ(frame.type(), CV_8UC1);
+  EXPECT_EQ(frame.at<uchar>(12, 16), 0);
+  ASSERT_TRUE(loader.skipFrame());
+  ASSERT_TRUE(loader.readFrame(frame));
+  EXPECT_EQ(frame.at<uchar>(0, 0), 20);
+  EXPECT_DOUBLE_EQ(loader.getTimestamp(), 80.0);
+  ASSERT_TRUE(loader.skipFrame());
+  ASSERT_TRUE(loader.readFrame(frame));
+  EXPECT_FALSE(loader.readFrame(frame));
+  EXPECT_FALSE(loader.skipFrame());
+}
+
+TEST_F(ProxyTest, RejectsTruncatedProxies) {
+  ProxyInfo info;
+  info.sourceSize = cv::Size(16, 16);
+  info.frameSize = cv::Size(16, 16);
+  info.channels = 3;
+  ProxyWriter writer;
+  ASSERT_TRUE(writer.open(path("clip.vproxy"), info));
+  for (int i = 0; i < 3; ++i)
+    ASSERT_TRUE(writer.addFrame(cv::Mat(16, 16, CV_8UC3, cv::Scalar(i)), i));
+  ASSERT_TRUE(writer.finish());
+  std::filesystem::resize_file(path("clip.vproxy"), 200);
+
+  ProxyVideoLoader loader;
+  EXPECT_FALSE(loader.open(path("clip.vproxy")));
+  EXPECT_FALSE(loader.open(path("missing.vproxy")));
+}
+
+TEST_F(ProxyTest, RejectsHeadersWhoseSizesWrapAround) {
+  ProxyInfo info;
+  info.sourceSize = cv::Size(16, 16);
+  info.frameSize = cv::Size(16, 16);
+  info.channels = 3;
+  ProxyWriter writer;
+  ASSERT_TRUE(writer.open(path("clip.vproxy"), info));
+  ASSERT_TRUE(writer.addFrame(cv::Mat(16, 16, CV_8UC3, cv::Scalar(1)), 0));
+  ASSERT_TRUE(writer.finish());
+  ProxyVideoLoader loader;
+  ASSERT_TRUE(loader.open(path("clip.vproxy")));
+
+  // Offsets of fields in the header that proxy.cpp writes
+  const std::streamoff kWidth = 32, kHeight = 36, kFrameCount = 44,
+                       kFramesOffset = 56, kTimestampsOffset = 64;
+  std::fstream file(path("clip.vproxy"),
+                    std::ios::in | std::ios::out | std::ios::binary);
+  auto patch = [&file](std::streamoff offset, auto value) {
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    file.flush();
+  };
+
+  // A width times height that overflows an int to zero
+  patch(kWidth, std::int32_t{65536});
+  patch(kHeight, std::int32_t{65536});
+  EXPECT_FALSE(loader.open(path("clip.vproxy")));
+
+  // A frame count whose bytes wrap 64 bits around to zero, with the
+  // timestamps moved to where the frames start so they still fit
+  std::uint64_t framesOffset = 0;
+  file.seekg(kFramesOffset);
+  file.read(reinterpret_cast<char *>(&framesOffset), sizeof(framesOffset));
+  patch(kWidth, std::int32_t{1 << 30});
+  patch(kHeight, std::int32_t{1 << 30});
+  patch(kFrameCount, std::int32_t{16});
+  patch(kTimestampsOffset, framesOffset);
+  EXPECT_FALSE(loader.open(path("clip.vproxy")));
+}
+
+TEST_F(ProxyTest, BuildsProxyThatMakeVideoLoaderOpens) {
+  // A numbered sequence whose brightness jumps at frame 6
+  std::string pattern = path("frame_%03d.png");
+  for (int i = 0; i < 12; ++i) {
+    int level = i < 6 ? 30 : 220;
+    cv::Mat frame(48, 64, CV_8UC3, cv::Scalar(level, level / 2, level));
+    cv::imwrite(vidicant::formatSequencePath(pattern, i), frame);
+  }
+
+  ProxyOptions options;
+  options.height = 24;
+  options.color = true;
+  std::string proxyPath = path("sequence.vproxy");
+  ASSERT_TRUE(vidicant::buildVideoProxy(pattern, proxyPath, options));
+  EXPECT_TRUE(vidicant::isVideoProxy(proxyPath));
+  auto loader = vidicant::makeVideoLoader(proxyPath);
+  ASSERT_NE(dynamic_cast<ProxyVideoLoader *>(loader.get()), nullptr);
+
+  VideoHandler proxy(std::move(loader));
+  ASSERT_TRUE(proxy.open(proxyPath));
+  EXPECT_EQ(proxy.getFrameCount(), 12);
+  EXPECT_EQ(proxy.getResolution(), std::make_pair(64, 48));
+  EXPECT_EQ(proxy.extractFirstFrame().size(), cv::Size(32, 24));
+  EXPECT_EQ(proxy.detectSceneChanges(), (std::vector<int>{6}));
+  EXPECT_NEAR(proxy.getAverageBrightness(),
+              vidicant::getVideoAverageBrightness(pattern), 0.5);
+
+  // A proxy that would not fit the cache is not built
+  options.maxBytes = 1000;
+  EXPECT_FALSE(vidicant::buildVideoProxy(pattern, path("big.vproxy"),
+                                         options));
+  EXPECT_FALSE(std::filesystem::exists(path("big.vproxy")));
+}
+
+TEST_F(ProxyTest, EnsureSkipsSourcesThatAreNotFiles) {
+  ProxyOptions options;
+  options.directory = path("cache");
+  bool built = true;
+  EXPECT_EQ(vidicant::ensureVideoProxy(path("frame_%03d.png"), options,
+                                       Deadline(), &built),
+            "");
+  EXPECT_FALSE(built);
+}
+
+TEST_F(ProxyTest, NamesProxiesAfterTheNormalizedSourcePath) {
+  std::string a = vidicant::getProxyPath("videos/clip.mp4", "cache");
+  std::string b = vidicant::getProxyPath("videos/../videos/clip.mp4", "cache");
+  std::string c = vidicant::getProxyPath("videos/other.mp4", "cache");
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  EXPECT_EQ(std::filesystem::path(a).parent_path(), "cache");
+  EXPECT_EQ(std::filesystem::path(a).extension(), ".vproxy");
+}
+
+TEST_F(ProxyTest, EvictsLeastRecentlyUsedProxies) {
+  auto now = std::filesystem::file_time_type::clock::now();
+  const char *names[] = {"old.vproxy", "mid.vproxy", "new.vproxy"};
+  for (int i = 0; i < 3; ++i) {
+    std::ofstream(path(names[i])) << std::string(100, 'x');
+    std::filesystem::last_write_time(path(names[i]),
+                                     now - std::chrono::hours(3 - i));
+  }
+  // Proxies being built are never evicted, but stale ones are swept
+  std::ofstream(path("new.vproxy.tmp1")) << std::string(100, 'x');
+  std::ofstream(path("crashed.vproxy.tmp2")) << std::string(100, 'x');
+  std::filesystem::last_write_time(path("crashed.vproxy.tmp2"),
+                                   now - std::chrono::hours(2));
+  std::ofstream(path("notes.tmp3")) << "x";
+  std::filesystem::last_write_time(path("notes.tmp3"),
+                                   now - std::chrono::hours(2));
+
+  EXPECT_EQ(vidicant::evictVideoProxies(directory_.string(), 0), 1);
+  EXPECT_FALSE(std::filesystem::exists(path("crashed.vproxy.tmp2")));
+  EXPECT_TRUE(std::filesystem::exists(path("notes.tmp3")));
+  EXPECT_EQ(vidicant::evictVideoProxies(directory_.string(), 0), 0);
+  EXPECT_EQ(vidicant::evictVideoProxies(directory_.string(), 250,
+                                        path("old.vproxy")),
+            1);
+  EXPECT_TRUE(std::filesystem::exists(path("old.vproxy")));
+  EXPECT_FALSE(std::filesystem::exists(path("mid.vproxy")));
+  EXPECT_EQ(vidicant::evictVideoProxies(directory_.string(), 100), 1);
+  EXPECT_FALSE(std::filesystem::exists(path("old.vproxy")));
+  EXPECT_TRUE(std::filesystem::exists(path("new.vproxy")));
+  EXPECT_TRUE(std::filesystem::exists(path("new.vproxy.tmp1")));
+}
@@ -0,0 +1,181 @@
+#include "vidicant/results_index.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+// Builds an index of random rows and keeps the values for brute force checks.
+struct Fixture {
+  std::vector<double> motion;
+  std::vector<double> blur;
+  std::string path;
+};
+
+Fixture writeRandomIndex(int rows) {
+  Fixture fixture;
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> motion(0.0, 100.0);
+  std::uniform_int_distribution<int> blur(0, 200);
+  ResultsIndexWriter writer;
+  for (int i = 0; i < rows; ++i) {
+    bool video = i % 3 == 0;
+    std::uint32_t row = writer.addRow("file" + std::to_string(i),
+                                      video ? ResultKind::Video
+                                            : ResultKind::Image);
+    // Only videos have motion; blur has many ties
+    fixture.motion.push_back(video ? motion(rng) : std::nan(""));
+    fixture.blur.push_back(blur(rng));
+    writer.set(row, "motion_score", fixture.motion.back());
+    writer.set(row, "blur_score", fixture.blur.back());
+  }
+  fixture.path = testing::TempDir() + "vidicant_results_index_test.vdr";
+  EXPECT_TRUE(writer.write(fixture.path));
+  return fixture;
+}
+
+} // namespace
+
+TEST(ResultsIndexTest, ColumnsAndRows) {
+  Fixture fixture = writeRandomIndex(300);
+  ResultsIndex index;
+  ASSERT_TRUE(index.open(fixture.path));
+
+  EXPECT_EQ(index.size(), 300u);
+  EXPECT_EQ(index.getColumns(),
+            (std::vector<std::string>{"blur_score", "motion_score"}));
+  int motion = index.findColumn("motion_score");
+  ASSERT_GE(motion, 0);
+  EXPECT_EQ(index.findColumn("missing"), -1);
+  EXPECT_EQ(index.getPresentCount(motion), 100u);
+
+  EXPECT_EQ(index.getPath(4), "file4");
+  EXPECT_EQ(index.getKind(3), ResultKind::Video);
+  EXPECT_EQ(index.getKind(4), ResultKind::Image);
+  EXPECT_DOUBLE_EQ(index.getValue(3, motion), fixture.motion[3]);
+  EXPECT_TRUE(std::isnan(index.getValue(4, motion)));
+  std::remove(fixture.path.c_str());
+}
+
+TEST(ResultsIndexTest, QueryMatchesBruteForce) {
+  Fixture fixture = writeRandomIndex(5000);
+  ResultsIndex index;
+  ASSERT_TRUE(index.open(fixture.path));
+
+  ColumnPredicate fast{"motion_score", 20.0};
+  ColumnPredicate sharp{"blur_score"};
+  sharp.max = 50.0;
+  sharp.maxInclusive = false;
+  std::vector<std::uint32_t> expected;
+  for (std::uint32_t row = 0; row < fixture.blur.size(); ++row) {
+    if (fixture.motion[row] >= 20.0 && fixture.blur[row] < 50.0)
+      expected.push_back(row);
+  }
+  EXPECT_EQ(index.query({fast, sharp}), expected);
+
+  ColumnPredicate exact{"blur_score", 100.0, 100.0};
+  expected.clear();
+  for (std::uint32_t row = 0; row < fixture.blur.size(); ++row) {
+    if (fixture.blur[row] == 100.0)
+      expected.push_back(row);
+  }
+  EXPECT_EQ(index.query({exact}), expected);
+
+  EXPECT_EQ(index.query({}).size(), 5000u);
+  EXPECT_TRUE(index.query({{"unknown"}}).empty());
+  std::remove(fixture.path.c_str());
+}
+
+TEST(ResultsIndexTest, TopMatchesBruteForce) {
+  Fixture fixture = writeRandomIndex(5000);
+  ResultsIndex index;
+  ASSERT_TRUE(index.open(fixture.path));
+  int motion = index.findColumn("motion_score");
+  int blur = index.findColumn("blur_score");
+
+  std::vector<double> sorted;
+  for (double value : fixture.motion)
+    if (!std::isnan(value))
+      sorted.push_back(value);
+  std::sort(sorted.rbegin(), sorted.rend());
+  auto rows = index.top(motion, 10, true);
+  ASSERT_EQ(rows.size(), 10u);
+  for (std::size_t i = 0; i < rows.size(); ++i)
+    EXPECT_DOUBLE_EQ(fixture.motion[rows[i]], sorted[i]);
+
+  // Both ranking strategies must agree with brute force on a filter
+  for (double limit : {2.0, 150.0}) {
+    ColumnPredicate filter{"blur_score"};
+    filter.max = limit;
+    auto candidates = index.query({filter});
+    std::vector<double> expected;
+    for (std::uint32_t row : candidates)
+      expected.push_back(fixture.blur[row]);
+    std::sort(expected.begin(), expected.end());
+    auto bottom = index.top(blur, 25, false, &candidates);
+    ASSERT_EQ(bottom.size(), std::min<std::size_t>(25, expected.size()));
+    for (std::size_t i = 0; i < bottom.size(); ++i) {
+      EXPECT_DOUBLE_EQ(fixture.blur[bottom[i]], expected[i]);
+      EXPECT_LE(fixture.blur[bottom[i]], limit);
+    }
+  }
+  EXPECT_TRUE(index.top(-1, 5, true).empty());
+  std::remove(fixture.path.c_str());
+}
+
+TEST(ResultsIndexTest, OpenRejectsOtherFiles) {
+  std::string path = testing::TempDir() + "vidicant_not_a_results_index.vdr";
+  FILE *file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  std::fputs("definitely not an index", file);
+  std::fclose(file);
+
+  ResultsIndex index;
+  EXPECT_FALSE(index.open(path));
+  EXPECT_FALSE(index.open(path + ".missing"));
+  std::remove(path.c_str());
+}
+
+TEST(ResultsIndexTest, CorruptRowIdsAndPathOffsetsStayInRange) {
+  ResultsIndexWriter writer;
+  for (int i = 0; i < 4; ++i)
+    writer.set(writer.addRow("file" + std::to_string(i), ResultKind::Image),
+               "score", i);
+  std::string path = testing::TempDir() + "vidicant_corrupt_results.vdr";
+  ASSERT_TRUE(writer.write(path));
+
+  // Header fields after the 8-byte magic: rowCount, columnCount,
+  // kindsOffset, pathOffsetsOffset, columnsOffset; a column entry's
+  // rowsOffset is its sixth field
+  FILE *file = std::fopen(path.c_str(), "r+b");
+  ASSERT_NE(file, nullptr);
+  auto read = [file](long position) {
+    std::uint64_t value = 0;
+    std::fseek(file, position, SEEK_SET);
+    EXPECT_EQ(std::fread(&value, sizeof(value), 1, file), 1u);
+    return value;
+  };
+  std::uint64_t pathOffsets = read(32);
+  std::uint64_t rowsOffset = read(static_cast<long>(read(40)) + 40);
+  std::uint32_t badRow = 1000;
+  std::fseek(file, static_cast<long>(rowsOffset) + 3 * 4, SEEK_SET);
+  std::fwrite(&badRow, sizeof(badRow), 1, file);
+  std::uint64_t badOffset = std::uint64_t{1} << 40;
+  std::fseek(file, static_cast<long>(pathOffsets) + 2 * 8, SEEK_SET);
+  std::fwrite(&badOffset, sizeof(badOffset), 1, file);
+  std::fclose(file);
+
+  ResultsIndex index;
+  ASSERT_TRUE(index.open(path));
+  int score = index.findColumn("score");
+  EXPECT_EQ(index.query({{"score", 0.0, 10.0}}),
+            (std::vector<std::uint32_t>{0, 1, 2}));
+  EXPECT_EQ(index.top(score, 2, true), (std::vector<std::uint32_t>{2, 1}));
+  EXPECT_EQ(index.getPath(0), "file0");
+  EXPECT_EQ(index.getPath(1), "");
+  EXPECT_EQ(index.getPath(2), "");
+  EXPECT_EQ(index.getPath(3), "file3");
+  std::remove(path.c_str());
+}
@@ -0,0 +1,123 @@
+#include "server.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Encodes bytes as standard base64 with padding.
+std::string encodeBase64(const std::vector<unsigned char> &bytes) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string text;
+  for (std::size_t i = 0; i < bytes.size(); i += 3) {
+    std::uint32_t group = bytes[i] << 16;
+    if (i + 1 < bytes.size())
+      group |= bytes[i + 1] << 8;
+    if (i + 2 < bytes.size())
+      group |= bytes[i + 2];
+    text += kAlphabet[group >> 18 & 63];
+    text += kAlphabet[group >> 12 & 63];
+    text += i + 1 < bytes.size() ? kAlphabet[group >> 6 & 63] : '=';
+    text += i + 2 < bytes.size() ? kAlphabet[group & 63] : '=';
+  }
+  return text;
+}
+
+// Encodes a small image as PNG bytes.
+std::vector<unsigned char> makePng() {
+  cv::Mat image(20, 30, CV_8UC3, cv::Scalar(10, 120, 240));
+  std::vector<unsigned char> bytes;
+  cv::imencode(".png", image, bytes);
+  return bytes;
+}
+
+} // namespace
+
+TEST(ServerRequestTest, AnalyzesImageDataAndEchoesTheId) {
+  nlohmann::json request = {
+      {"id", "req-1"}, {"data", encodeBase64(makePng())}, {"name", "a.png"}};
+  nlohmann::json response = handleServerRequest(request, ProcessOptions());
+
+  EXPECT_EQ(response["id"], "req-1");
+  ASSERT_TRUE(response.contains("result")) << response.dump();
+  EXPECT_FALSE(response.contains("error"));
+  EXPECT_EQ(response["result"]["filename"], "a.png");
+  EXPECT_EQ(response["result"]["width"], 30);
+  EXPECT_EQ(response["result"]["height"], 20);
+}
+
+TEST(ServerRequestTest, EchoesTheIdOnErrors) {
+  nlohmann::json response =
+      handleServerRequest({{"id", 42}, {"path", "notes.txt"}}, {});
+  EXPECT_EQ(response["id"], 42);
+  EXPECT_EQ(response["error"], "Unsupported file type: notes.txt");
+  EXPECT_FALSE(response.contains("result"));
+}
+
+TEST(ServerRequestTest, RejectsUnknownMetrics) {
+  nlohmann::json metrics = nlohmann::json::array({"entropy", "sharpness"});
+  nlohmann::json response =
+      handleServerRequest({{"path", "a.jpg"}, {"metrics", metrics}}, {});
+  EXPECT_EQ(response["error"], "Unknown metric: sharpness");
+}
+
+TEST(ServerRequestTest, RejectsInvalidBase64) {
+  nlohmann::json response =
+      handleServerRequest({{"data", "not base64!"}}, {});
+  EXPECT_EQ(response["error"], "Invalid base64 in data");
+}
+
+TEST(ServerRequestTest, NeedsAPathOrData) {
+  nlohmann::json response = handleServerRequest({{"id", 1}}, {});
+  EXPECT_EQ(response["error"], "Request needs a path or data");
+}
+
+TEST(ServerRequestTest, RejectsVideoData) {
+  nlohmann::json response =
+      handleServerRequest({{"data", "AAAA"}, {"kind", "video"}}, {});
+  EXPECT_EQ(response["error"], "Video payloads must be sent by path");
+}
+
+TEST(ServerRequestTest, ReportsMalformedFieldTypes) {
+  const std::vector<nlohmann::json> requests = {
+      {{"id", 3}, {"path", "a.jpg"}, {"tiled", "yes"}},
+      {{"id", 3}, {"path", "a.jpg"}, {"metrics", "entropy"}},
+      {{"id", 3},
+       {"path", "a.jpg"},
+       {"scene_thresholds", nlohmann::json::array({"high"})}},
+      {{"id", 3}, {"path", 17}},
+      {{"id", 3}, {"data", 17}},
+  };
+  for (const auto &request : requests) {
+    nlohmann::json response = handleServerRequest(request, {});
+    EXPECT_EQ(response["id"], 3) << request.dump();
+    EXPECT_TRUE(response["error"].is_string()) << request.dump();
+    EXPECT_FALSE(response.contains("result")) << request.dump();
+  }
+  EXPECT_EQ(handleServerRequest(nlohmann::json::array(), {})["error"],
+            "Request must be a JSON object");
+}
+
+TEST(ServerRequestTest, RejectsOutOfRangeOptions) {
+  const std::vector<std::pair<nlohmann::json, std::string>> cases = {
+      {{{"tile_rows", 0}}, "Invalid tile rows: 0"},
+      {{{"histogram_bins", -4}}, "Invalid histogram bins: -4"},
+      {{{"series_window", -1}}, "Invalid series window: -1"},
+      {{{"time_budget", -0.5}}, "Invalid time budget: -0.5"},
+      {{{"scene_thresholds", nlohmann::json::array({10.0, -2.0})}},
+       "Invalid scene threshold: -2"},
+  };
+  for (const auto &[fields, error] : cases) {
+    nlohmann::json request = fields;
+    request["id"] = 5;
+    request["data"] = encodeBase64(makePng());
+    nlohmann::json response = handleServerRequest(request, {});
+    EXPECT_EQ(response["id"], 5) << request.dump();
+    EXPECT_EQ(response["error"], error) << request.dump();
+    EXPECT_FALSE(response.contains("result")) << request.dump();
+  }
+}
@@ -0,0 +1,63 @@
+#include "vidicant/shard.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+TEST(ShardTest, ParsesShards) {
+  Shard shard;
+  EXPECT_TRUE(vidicant::parseShard("3/50", shard));
+  EXPECT_EQ(shard.index, 3);
+  EXPECT_EQ(shard.count, 50);
+  EXPECT_TRUE(vidicant::parseShard("0/1", shard));
+  EXPECT_EQ(shard.index, 0);
+  EXPECT_EQ(shard.count, 1);
+
+  EXPECT_FALSE(vidicant::parseShard("", shard));
+  EXPECT_FALSE(vidicant::parseShard("3", shard));
+  EXPECT_FALSE(vidicant::parseShard("50/50", shard));
+  EXPECT_FALSE(vidicant::parseShard("0/0", shard));
+  EXPECT_FALSE(vidicant::parseShard("-1/4", shard));
+  EXPECT_FALSE(vidicant::parseShard("1/4x", shard));
+  EXPECT_FALSE(vidicant::parseShard("1/99999999999", shard));
+  EXPECT_EQ(shard.index, 0);
+  EXPECT_EQ(shard.count, 1);
+}
+
+TEST(ShardTest, HashIsFixedAcrossBuilds) {
+  // Changing this value reshuffles every sharded corpus
+  EXPECT_EQ(vidicant::hashShardPath("videos/clip.mp4"),
+            0x3952c8543b884fcaULL);
+  EXPECT_EQ(vidicant::getPathShard("videos/clip.mp4", 50), 24);
+  EXPECT_EQ(vidicant::getPathShard("videos/clip.mp4", 1), 0);
+}
+
+TEST(ShardTest, NormalizesPathsLexically) {
+  EXPECT_EQ(vidicant::hashShardPath("./videos/clip.mp4"),
+            vidicant::hashShardPath("videos/clip.mp4"));
+  EXPECT_EQ(vidicant::hashShardPath("videos/old/../clip.mp4"),
+            vidicant::hashShardPath("videos/clip.mp4"));
+  EXPECT_NE(vidicant::hashShardPath("/videos/clip.mp4"),
+            vidicant::hashShardPath("videos/clip.mp4"));
+}
+
+TEST(ShardTest, SplitsPathsEvenlyAndDisjointly) {
+  const int count = 8;
+  const int files = 16000;
+  std::vector<int> sizes(count, 0);
+  for (int i = 0; i < files; ++i) {
+    std::string path = "corpus/" + std::to_string(i / 100) + "/frame_" +
+                       std::to_string(i) + ".jpg";
+    int inShards = 0;
+    for (int index = 0; index < count; ++index) {
+      if (vidicant::isInShard(path, {index, count})) {
+        ++inShards;
+        ++sizes[index];
+      }
+    }
+    EXPECT_EQ(inShards, 1) << path;
+  }
+  for (int size : sizes) {
+    EXPECT_GT(size, files / count * 9 / 10);
+    EXPECT_LT(size, files / count * 11 / 10);
+  }
+}
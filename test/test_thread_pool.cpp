@@ -0,0 +1,52 @@
+#include "vidicant/thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+
+TEST(ThreadPoolTest, RunsAllTasks) {
+  std::atomic<int> count{0};
+  ThreadPool pool(4);
+  EXPECT_EQ(pool.size(), 4u);
+  for (int i = 0; i < 1000; ++i)
+    pool.submit([&count] { ++count; });
+  pool.wait();
+  EXPECT_EQ(count.load(), 1000);
+}
+
+TEST(ThreadPoolTest, TasksMaySubmitTasks) {
+  std::atomic<int> count{0};
+  ThreadPool pool(2);
+  pool.submit([&] {
+    for (int i = 0; i < 10; ++i)
+      pool.submit([&count] { ++count; });
+  });
+  pool.wait();
+  EXPECT_EQ(count.load(), 10);
+}
+
+TEST(ThreadPoolTest, BoundedQueueRejectsWhenFull) {
+  std::atomic<bool> release{false};
+  ThreadPool pool(1, 1);
+  // Occupy the only worker, then fill the single queue slot
+  pool.submit([&release] {
+    while (!release.load())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  });
+  while (pool.pending() != 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_TRUE(pool.trySubmit([] {}));
+  EXPECT_FALSE(pool.trySubmit([] {}));
+  release = true;
+  pool.wait();
+  EXPECT_EQ(pool.pending(), 0u);
+}
+
+TEST(ThreadPoolTest, DestructorDrainsQueue) {
+  std::atomic<int> count{0};
+  {
+    ThreadPool pool(2);
+    for (int i = 0; i < 100; ++i)
+      pool.submit([&count] { ++count; });
+  }
+  EXPECT_EQ(count.load(), 100);
+}
@@ -0,0 +1,171 @@
+#include "vidicant/image.hpp"
+#include "vidicant/tiled.hpp"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+#include <thread>
+
+class MockImageLoader : public IImageLoader {
+public:
+  MOCK_METHOD(cv::Mat, imread, (const std::string &), (override));
+};
+
+// Strip reader that hands out fixed-height views of an in-memory image.
+class MatStripReader : public IImageStripReader {
+public:
+  MatStripReader(cv::Mat image, int stripRows)
+      : image_(std::move(image)), stripRows_(stripRows) {}
+
+  bool open(const std::string &) override {
+    nextRow_ = 0;
+    return !image_.empty();
+  }
+
+  std::pair<int, int> getDimensions() override {
+    return {image_.cols, image_.rows};
+  }
+
+  bool readStrip(cv::Mat &strip) override {
+    if (nextRow_ >= image_.rows)
+      return false;
+    int endRow = std::min(image_.rows, nextRow_ + stripRows_);
+    strip = image_.rowRange(nextRow_, endRow);
+    nextRow_ = endRow;
+    return true;
+  }
+
+private:
+  cv::Mat image_;
+  int stripRows_;
+  int nextRow_ = 0;
+};
+
+static cv::Mat makeTestImage() {
+  cv::Mat image(203, 157, CV_8UC3);
+  cv::randu(image, cv::Scalar(0, 0, 0), cv::Scalar(256, 256, 256));
+  cv::rectangle(image, cv::Rect(20, 30, 80, 120), cv::Scalar(10, 200, 40),
+                cv::FILLED);
+  return image;
+}
+
+static ImageHandler makeHandler(const cv::Mat &image) {
+  auto mockLoader = std::make_unique<MockImageLoader>();
+  EXPECT_CALL(*mockLoader, imread("test.jpg"))
+      .WillRepeatedly(::testing::Return(image));
+  return ImageHandler(std::move(mockLoader));
+}
+
+TEST(TiledImageHandlerTest, MatchesFullImageMetrics) {
+  cv::Mat image = makeTestImage();
+  ImageHandler full = makeHandler(image);
+  TiledImageHandler tiled(std::make_unique<MatStripReader>(image, 17));
+
+  ImageTileStats stats = tiled.analyze("test.jpg");
+
+  EXPECT_EQ(stats.width, 157);
+  EXPECT_EQ(stats.height, 203);
+  EXPECT_EQ(stats.channels, 3);
+  EXPECT_EQ(stats.pixelCount, 157u * 203u);
+  EXPECT_EQ(stats.getHistogram(), full.getHistogram("test.jpg"));
+  EXPECT_NEAR(stats.getAverageBrightness(),
+              full.getAverageBrightness("test.jpg"), 1e-9);
+  EXPECT_NEAR(stats.getBlurScore(), full.getBlurScore("test.jpg"), 1e-6);
+  EXPECT_NEAR(stats.getContrastRatio(), full.getContrastRatio("test.jpg"),
+              1e-6);
+  EXPECT_NEAR(stats.getSaturationLevel(), full.getSaturationLevel("test.jpg"),
+              1e-6);
+  EXPECT_NEAR(stats.getEntropy(), full.getImageEntropy("test.jpg"), 1e-6);
+  // Hysteresis is only followed kHaloRows across strip boundaries
+  int fullEdges = full.getEdgeCount("test.jpg");
+  EXPECT_NEAR(static_cast<double>(stats.edgeCount), fullEdges,
+              0.01 * fullEdges);
+}
+
+TEST(TiledImageHandlerTest, BinsHistogramsLikeTheFullImage) {
+  cv::Mat image = makeTestImage();
+  ImageHandler full = makeHandler(image);
+  TiledImageHandler tiled(std::make_unique<MatStripReader>(image, 17));
+
+  ImageTileStats stats = tiled.analyze("test.jpg");
+
+  EXPECT_EQ(stats.getHistogram(16), full.getHistogram("test.jpg", 16));
+  EXPECT_EQ(stats.getHistogram(100), full.getHistogram("test.jpg", 100));
+}
+
+TEST(TiledImageHandlerTest, StripSizeDoesNotChangeExactMetrics) {
+  cv::Mat image = makeTestImage();
+  TiledImageHandler small(std::make_unique<MatStripReader>(image, 3));
+  TiledImageHandler large(std::make_unique<MatStripReader>(image, 1000));
+
+  ImageTileStats a = small.analyze("test.jpg");
+  ImageTileStats b = large.analyze("test.jpg");
+
+  EXPECT_EQ(a.getHistogram(), b.getHistogram());
+  EXPECT_EQ(a.grayHistogram, b.grayHistogram);
+  EXPECT_NEAR(a.getBlurScore(), b.getBlurScore(), 1e-6);
+  EXPECT_NEAR(a.getSaturationLevel(), b.getSaturationLevel(), 1e-9);
+}
+
+TEST(TiledImageHandlerTest, MergeCombinesDisjointRows) {
+  cv::Mat image = makeTestImage();
+  ImageTileStats top, bottom, whole;
+  TiledImageHandler::foldRows(image, 0, 0, 100, 4, top);
+  TiledImageHandler::foldRows(image, 0, 100, image.rows, 4, bottom);
+  TiledImageHandler::foldRows(image, 0, 0, image.rows, 4, whole);
+
+  top.merge(bottom);
+
+  EXPECT_EQ(top.pixelCount, whole.pixelCount);
+  EXPECT_EQ(top.getHistogram(), whole.getHistogram());
+  EXPECT_EQ(top.colorSamples.size(), whole.colorSamples.size());
+  EXPECT_NEAR(top.getAverageBrightness(), whole.getAverageBrightness(), 1e-9);
+  EXPECT_NEAR(top.getBlurScore(), whole.getBlurScore(), 1e-6);
+}
+
+TEST(TiledImageHandlerTest, DominantColors) {
+  cv::Mat image(64, 64, CV_8UC3, cv::Scalar(255, 0, 0));
+  image.rowRange(32, 64).setTo(cv::Scalar(0, 0, 255));
+  TiledImageHandler tiled(std::make_unique<MatStripReader>(image, 10));
+
+  auto colors = tiled.analyze("test.jpg").getDominantColors(2);
+
+  ASSERT_EQ(colors.size(), 2);
+  for (const auto &color : colors) {
+    EXPECT_GE(color[0], 0.0);
+    EXPECT_LE(color[0], 255.0);
+  }
+}
+
+TEST(TiledImageHandlerTest, StopsReadingStripsAtTheDeadline) {
+  cv::Mat image = makeTestImage();
+  TiledImageHandler tiled(std::make_unique<MatStripReader>(image, 10));
+  EXPECT_DOUBLE_EQ(tiled.analyze("test.jpg").getCoverage(), 1.0);
+
+  Deadline deadline(1e-6);
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  ImageTileStats stats = tiled.analyze("test.jpg", 65536, deadline);
+  EXPECT_EQ(stats.width, image.cols);
+  EXPECT_EQ(stats.pixelCount, 0u);
+  EXPECT_DOUBLE_EQ(stats.getCoverage(), 0.0);
+}
+
+TEST(TiledImageHandlerTest, OpenFail) {
+  TiledImageHandler tiled(std::make_unique<MatStripReader>(cv::Mat(), 10));
+
+  ImageTileStats stats = tiled.analyze("bad.jpg");
+
+  EXPECT_EQ(stats.width, -1);
+  EXPECT_EQ(stats.height, -1);
+}
+
+TEST(TiledGlobalTest, AnalyzeImageTiledReal) {
+  ImageTileStats stats =
+      vidicant::analyzeImageTiled("/workspaces/vidicant/examples/sample.jpg");
+  auto [width, height] =
+      vidicant::getImageDimensions("/workspaces/vidicant/examples/sample.jpg");
+  EXPECT_EQ(stats.width, width);
+  EXPECT_EQ(stats.height, height);
+  EXPECT_GT(stats.getAverageBrightness(), 0.0);
+  EXPECT_GE(stats.getEntropy(), 0.0);
+  EXPECT_LE(stats.getEntropy(), 8.0);
+}
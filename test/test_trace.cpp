@@ -0,0 +1,75 @@
+#include "vidicant/trace.hpp"
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+static std::string readFile(const std::string &path) {
+  std::ifstream input(path);
+  std::stringstream text;
+  text << input.rdbuf();
+  return text.str();
+}
+
+static std::size_t countOf(const std::string &text, const std::string &part) {
+  std::size_t count = 0;
+  for (std::size_t at = text.find(part); at != std::string::npos;
+       at = text.find(part, at + part.size()))
+    ++count;
+  return count;
+}
+
+// Runs first: tracing cannot be stopped once started
+TEST(TraceTest, SpansRecordNothingUntilStarted) {
+  EXPECT_FALSE(vidicant::isTracingEnabled());
+  { TraceSpan span("decode"); }
+  EXPECT_EQ(vidicant::getTraceEventCount(), 0u);
+}
+
+TEST(TraceTest, RecordsSpansOfEveryThread) {
+  vidicant::startTracing();
+  ASSERT_TRUE(vidicant::isTracingEnabled());
+  std::size_t before = vidicant::getTraceEventCount();
+
+  // More events per thread than one buffer chunk holds
+  const int perThread = 3000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 3; ++t) {
+    threads.emplace_back([] {
+      for (int i = 0; i < perThread; ++i)
+        TraceSpan span("blur_score");
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  { TraceSpan span("file", "photo.jpg"); }
+  EXPECT_EQ(vidicant::getTraceEventCount(), before + 3 * perThread + 1);
+
+  std::string path = "test_trace_output.json";
+  ASSERT_TRUE(vidicant::writeTrace(path));
+  std::string trace = readFile(path);
+  std::remove(path.c_str());
+  EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0),
+            0u);
+  EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+  EXPECT_EQ(countOf(trace, "\"name\":\"blur_score\""), 3u * perThread);
+  EXPECT_EQ(countOf(trace, "\"args\":{\"detail\":\"photo.jpg\"}"), 1u);
+  EXPECT_GE(countOf(trace, "\"ph\":\"M\""), 4u);
+}
+
+TEST(TraceTest, EscapesDetails) {
+  vidicant::startTracing();
+  { TraceSpan span("open", "dir\\\"quoted\"\n.mp4"); }
+  std::string path = "test_trace_escape.json";
+  ASSERT_TRUE(vidicant::writeTrace(path));
+  std::string trace = readFile(path);
+  std::remove(path.c_str());
+  EXPECT_NE(trace.find("\"detail\":\"dir\\\\\\\"quoted\\\"\\u000a.mp4\""),
+            std::string::npos);
+}
+
+TEST(TraceTest, FailsOnUnwritablePath) {
+  EXPECT_FALSE(vidicant::writeTrace("no_such_dir/trace.json"));
+}
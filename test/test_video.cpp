@@ -1,7 +1,9 @@
+#include "vidicant/memory_stats.hpp"
 #include "vidicant/video.hpp"
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <opencv2/opencv.hpp>
+#include <thread>
 
 class MockVideoLoader : public IVideoLoader {
 public:
@@ -73,6 +75,67 @@ TEST(VideoHandlerTest, OpenFail) {
   EXPECT_FALSE(opened);
 }
 
+TEST(VideoHandlerTest, ReadFrameIntoBufferFallsBackToReadFrame) {
+  auto mockLoader = std::make_unique<MockVideoLoader>();
+  cv::Mat fakeFrame(4, 6, CV_8UC3, cv::Scalar(1, 2, 3));
+  EXPECT_CALL(*mockLoader, readFrame())
+      .WillOnce(::testing::Return(fakeFrame))
+      .WillOnce(::testing::Return(cv::Mat()));
+
+  IVideoLoader &loader = *mockLoader;
+  cv::Mat frame;
+  EXPECT_TRUE(loader.readFrame(frame));
+  EXPECT_EQ(frame.cols, 6);
+  EXPECT_EQ(frame.rows, 4);
+  EXPECT_FALSE(loader.readFrame(frame));
+}
+
+class FrameArenaTest : public ::testing::Test {
+protected:
+  void SetUp() override { vidicant::enableMemoryTracking(); }
+};
+
+TEST_F(FrameArenaTest, ReusedBuffersDoNotCountAsAllocations) {
+  FrameArena arena;
+  arena.beginPass();
+  for (int i = 0; i < 5; ++i) {
+    arena.slot(FrameSlot::Gray).create(8, 8, CV_8UC1);
+    arena.slot(FrameSlot::PreviousGray).create(8, 8, CV_8UC1);
+    std::swap(arena.slot(FrameSlot::Gray), arena.slot(FrameSlot::PreviousGray));
+    arena.endFrame();
+  }
+
+  EXPECT_EQ(arena.getAllocationCount(), 2);
+  EXPECT_EQ(arena.getSteadyStateAllocationCount(), 0);
+}
+
+TEST_F(FrameArenaTest, ReallocationAfterWarmupIsCounted) {
+  FrameArena arena;
+  arena.beginPass();
+  arena.slot(FrameSlot::Frame).create(8, 8, CV_8UC3);
+  arena.endFrame();
+  arena.slot(FrameSlot::Frame).create(16, 16, CV_8UC3);
+  arena.endFrame();
+
+  EXPECT_EQ(arena.getAllocationCount(), 2);
+  EXPECT_EQ(arena.getSteadyStateAllocationCount(), 1);
+}
+
+TEST_F(FrameArenaTest, TemporariesOutsideSlotsAreCounted) {
+  FrameArena arena;
+  arena.beginPass();
+  for (int i = 0; i < 3; ++i) {
+    cv::Mat &frame = arena.slot(FrameSlot::Frame);
+    frame.create(8, 8, CV_8UC3);
+    cv::Mat gray;
+    cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+    arena.endFrame();
+  }
+
+  EXPECT_EQ(arena.getAllocationCount(), 4);
+  EXPECT_EQ(arena.getSteadyStateAllocationCount(), 2);
+}
+
 // Tests using real files for methods that need frame reading
 TEST(VideoGlobalTest, GetVideoFrameCountReal) {
   int frameCount =
@@ -195,4 +258,106 @@ TEST(VideoGlobalTest, GetVideoColorConsistencyConvenienceReal) {
       "/workspaces/vidicant/examples/sample.mp4");
   EXPECT_GE(consistency, 0.0); // Should be non-negative
   EXPECT_LE(consistency, 1.0); // Coefficient of variation should be <= 1.0
-}
\ No newline at end of file
+}
+
+TEST(VideoGlobalTest, SteadyStateFrameLoopsDoNotAllocate) {
+  vidicant::enableMemoryTracking();
+  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  ASSERT_TRUE(handler.open("/workspaces/vidicant/examples/sample.mp4"));
+  handler.getAverageBrightness();
+  handler.getMotionScore();
+  handler.getDominantColors();
+  handler.detectSceneChanges();
+  handler.getColorConsistency();
+
+  EXPECT_GT(handler.getFrameArena().getAllocationCount(), 0);
+  EXPECT_EQ(handler.getFrameArena().getSteadyStateAllocationCount(), 0);
+}
+
+TEST(VideoGlobalTest, FrameSeriesMatchesSceneChangeDetection) {
+  const std::string path = "/workspaces/vidicant/examples/sample.mp4";
+  FrameSeries series = vidicant::getVideoFrameSeries(path);
+  ASSERT_GT(series.size(), 0u);
+  EXPECT_EQ(series.getSamples()[0].meanDiff, 0.0f);
+  for (double threshold : {5.0, 30.0}) {
+    EXPECT_EQ(series.detectSceneChanges(threshold, 1000),
+              vidicant::detectVideoSceneChanges(path, threshold));
+  }
+}
+
+TEST(VideoGlobalTest, FrameSeriesHashesTheSameKeyframes) {
+  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  ASSERT_TRUE(handler.open("/workspaces/vidicant/examples/sample.mp4"));
+  std::vector<FrameHash> keyframes;
+  FrameSeries series = handler.getFrameSeries(0, &keyframes, 30.0, 25);
+  auto expected = handler.getKeyframeHashes(30.0, 25);
+  ASSERT_GT(series.size(), 0u);
+  ASSERT_EQ(keyframes.size(), expected.size());
+  for (std::size_t i = 0; i < keyframes.size(); ++i) {
+    EXPECT_EQ(keyframes[i].frameIndex, expected[i].frameIndex);
+    EXPECT_EQ(keyframes[i].sceneStart, expected[i].sceneStart);
+    EXPECT_EQ(keyframes[i].hash.dHash, expected[i].hash.dHash);
+    EXPECT_EQ(keyframes[i].hash.pHash, expected[i].hash.pHash);
+  }
+}
+
+TEST(VideoGlobalTest, FrameSeriesScoresMatchTheirPasses) {
+  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  ASSERT_TRUE(handler.open("/workspaces/vidicant/examples/sample.mp4"));
+  FrameSeries series = handler.getFrameSeries();
+  ASSERT_GT(series.size(), 0u);
+  // Samples hold floats, so allow for their rounding
+  EXPECT_NEAR(series.getAverageBrightness(), handler.getAverageBrightness(),
+              1e-3);
+  EXPECT_NEAR(series.getMotionScore(), handler.getMotionScore(), 1e-3);
+  EXPECT_NEAR(series.getColorConsistency(), handler.getColorConsistency(),
+              1e-5);
+}
+
+TEST(VideoGlobalTest, ScenePalettesCoverTheVideo) {
+  auto palettes = vidicant::getVideoScenePalettes(
+      "/workspaces/vidicant/examples/sample.mp4");
+  ASSERT_FALSE(palettes.empty());
+  EXPECT_EQ(palettes.front().startFrame, 0);
+  for (std::size_t i = 1; i < palettes.size(); ++i)
+    EXPECT_EQ(palettes[i].startFrame, palettes[i - 1].endFrame);
+  for (const auto &scene : palettes) {
+    EXPECT_FALSE(scene.colors.empty());
+    double total = 0.0;
+    for (const auto &entry : scene.colors)
+      total += entry.weight;
+    EXPECT_NEAR(total, 1.0, 1e-9);
+  }
+}
+
+TEST(VideoGlobalTest, ActiveAreaRestrictsFramePasses) {
+  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  ASSERT_TRUE(handler.open("/workspaces/vidicant/examples/sample.mp4"));
+  auto [width, height] = handler.getResolution();
+  ActiveArea area = handler.detectActiveArea();
+  EXPECT_EQ(area.frameSize, cv::Size(width, height));
+  EXPECT_EQ(area.rect & cv::Rect(0, 0, width, height), area.rect);
+  EXPECT_FALSE(area.rect.empty());
+
+  // The full frame as area matches no area; a smaller one changes results
+  double brightness = handler.getAverageBrightness();
+  handler.setActiveArea({0, 0, width, height});
+  EXPECT_DOUBLE_EQ(handler.getAverageBrightness(), brightness);
+  handler.setActiveArea({0, 0, width / 2, height / 2});
+  EXPECT_NE(handler.getAverageBrightness(), brightness);
+  EXPECT_EQ(handler.extractFirstFrame().size(), cv::Size(width, height));
+}
+
+TEST(VideoGlobalTest, FrameLoopsStopAtTheDeadline) {
+  VideoHandler handler(std::make_unique<OpenCVVideoLoader>());
+  ASSERT_TRUE(handler.open("/workspaces/vidicant/examples/sample.mp4"));
+  handler.getMotionScore();
+  EXPECT_FALSE(handler.isInterrupted());
+  EXPECT_DOUBLE_EQ(handler.getCoverage(), 1.0);
+
+  handler.setDeadline(Deadline(1e-6));
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_EQ(handler.getFrameSeries().size(), 0u);
+  EXPECT_TRUE(handler.isInterrupted());
+  EXPECT_DOUBLE_EQ(handler.getCoverage(), 0.0);
+}
@@ -0,0 +1,89 @@
+#include "watcher.hpp"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+using Clock = SettleQueue::Clock;
+using std::chrono::milliseconds;
+
+// Gives each test an empty directory.
+class SettleQueueTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    directory_ =
+        std::filesystem::path(testing::TempDir()) / "vidicant_watcher_test";
+    std::filesystem::remove_all(directory_);
+    std::filesystem::create_directories(directory_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory_); }
+
+  // Appends to a file, creating it, and returns its path.
+  std::string append(const std::string &name, const std::string &contents) {
+    std::filesystem::path path = directory_ / name;
+    std::ofstream(path, std::ios::binary | std::ios::app) << contents;
+    return path.string();
+  }
+
+  std::filesystem::path directory_;
+};
+
+} // namespace
+
+TEST_F(SettleQueueTest, TakesAFileOnceItsSettleTimeHasPassed) {
+  SettleQueue queue(milliseconds(200));
+  std::string path = append("a.jpg", "1234");
+  Clock::time_point start = Clock::now();
+  queue.arm(path, start);
+
+  Clock::time_point next = start + milliseconds(500);
+  EXPECT_TRUE(queue.takeSettled(start + milliseconds(100), next).empty());
+  EXPECT_EQ(next, start + milliseconds(200));
+
+  auto settled = queue.takeSettled(start + milliseconds(200), next);
+  ASSERT_EQ(settled.size(), 1u);
+  EXPECT_EQ(settled[0].first, path);
+  EXPECT_EQ(settled[0].second, 4u);
+  EXPECT_FALSE(queue.contains(path));
+  EXPECT_TRUE(queue.takeSettled(start + milliseconds(400), next).empty());
+}
+
+TEST_F(SettleQueueTest, ASizeChangeArmsTheFileAgain) {
+  SettleQueue queue(milliseconds(200));
+  std::string path = append("a.mp4", "12");
+  Clock::time_point start = Clock::now();
+  queue.arm(path, start);
+  append("a.mp4", "345");
+
+  Clock::time_point next = start + milliseconds(1000);
+  EXPECT_TRUE(queue.takeSettled(start + milliseconds(200), next).empty());
+  EXPECT_TRUE(queue.contains(path));
+  EXPECT_EQ(next, start + milliseconds(400));
+
+  auto settled = queue.takeSettled(start + milliseconds(400), next);
+  ASSERT_EQ(settled.size(), 1u);
+  EXPECT_EQ(settled[0].second, 5u);
+}
+
+TEST_F(SettleQueueTest, DropsRemovedFiles) {
+  SettleQueue queue(milliseconds(200));
+  std::string path = append("a.jpg", "1234");
+  Clock::time_point start = Clock::now();
+  queue.arm(path, start);
+  std::filesystem::remove(path);
+
+  Clock::time_point next = start + milliseconds(500);
+  EXPECT_TRUE(queue.takeSettled(start + milliseconds(200), next).empty());
+  EXPECT_FALSE(queue.contains(path));
+  EXPECT_EQ(next, start + milliseconds(500));
+}
+
+TEST_F(SettleQueueTest, IgnoresFilesThatCannotBeSized) {
+  SettleQueue queue(milliseconds(200));
+  std::string path = (directory_ / "missing.jpg").string();
+  queue.arm(path, Clock::now());
+  EXPECT_FALSE(queue.contains(path));
+}
@@ -15,6 +15,11 @@ process_image = vidicant_py.process_image
 process_video = vidicant_py.process_video
 is_image_file = vidicant_py.is_image_file
 is_video_file = vidicant_py.is_video_file
+available_metrics = vidicant_py.available_metrics
+set_parallelism = vidicant_py.set_parallelism
+get_parallelism = vidicant_py.get_parallelism
+pin_current_thread = vidicant_py.pin_current_thread
+simd_kernels = vidicant_py.simd_kernels
 
 __version__ = "0.1.0"
 __all__ = [
@@ -22,4 +27,9 @@ __all__ = [
     "process_video",
     "is_image_file",
     "is_video_file",
+    "available_metrics",
+    "set_parallelism",
+    "get_parallelism",
+    "pin_current_thread",
+    "simd_kernels",
 ]